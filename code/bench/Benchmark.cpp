@@ -0,0 +1,161 @@
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include "Benchmark.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		Options options;
+		std::vector<Result> all;
+		volatile unsigned char sinkByte;
+
+		double elapsedNs(const std::function<void()>& body, long long iterations)
+		{
+			Clock::time_point t0 = Clock::now();
+			for (long long i = 0; i < iterations; i++)
+				body();
+			return std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+		}
+
+		double median(std::vector<double> values)
+		{
+			std::sort(values.begin(), values.end());
+			size_t n = values.size();
+			return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+		}
+
+		void writeString(FILE* out, const std::string& s)
+		{
+			fputc('"', out);
+			for (size_t i = 0; i < s.size(); i++)
+			{
+				if (s[i] == '"' || s[i] == '\\')
+					fputc('\\', out);
+				fputc(s[i], out);
+			}
+			fputc('"', out);
+		}
+	}
+
+	void configure(const Options& o)
+	{
+		options = o;
+	}
+
+	bool enabled(const char* name)
+	{
+		return options.filter.empty() || strstr(name, options.filter.c_str()) != NULL;
+	}
+
+	bool run(const char* name, const std::function<void()>& body)
+	{
+		if (!enabled(name))
+			return false;
+
+		// Calibrate: grow the iterations until a repetition is long enough to time reliably
+		long long iterations = 1;
+		const double minNs = options.minRepetitionMs * 1e6;
+		double ns = elapsedNs(body, iterations);
+		while (ns < minNs && iterations < (1ll << 40))
+		{
+			iterations = ns > minNs / 64 ? (long long)std::ceil(iterations * minNs / ns) : iterations * 2;
+			ns = elapsedNs(body, iterations);
+		}
+
+		for (int i = 0; i < options.warmup; i++)
+			elapsedNs(body, iterations);
+
+		std::vector<double> samples(std::max(1, options.repetitions));
+		for (size_t i = 0; i < samples.size(); i++)
+			samples[i] = elapsedNs(body, iterations) / iterations;
+
+		Result result;
+		result.name = name;
+		result.iterations = iterations;
+		result.repetitions = (int)samples.size();
+		result.medianNs = median(samples);
+		std::vector<double> deviations(samples.size());
+		for (size_t i = 0; i < samples.size(); i++)
+			deviations[i] = std::fabs(samples[i] - result.medianNs);
+		result.madNs = median(deviations);
+		result.minNs = *std::min_element(samples.begin(), samples.end());
+		result.maxNs = *std::max_element(samples.begin(), samples.end());
+		result.itemsPerSecond = 0.0;
+		all.push_back(result);
+
+		fprintf(stderr, "%-40s %12.1f ns  +- %8.1f  (%lld x %d)\n", name, result.medianNs, result.madNs, iterations, result.repetitions);
+		return true;
+	}
+
+	void items(double perIteration)
+	{
+		if (!all.empty() && all.back().medianNs > 0.0)
+			all.back().itemsPerSecond = perIteration * 1e9 / all.back().medianNs;
+	}
+
+	void counter(const char* name, double value)
+	{
+		if (all.empty())
+			return;
+		Counter c = { name, value };
+		all.back().counters.push_back(c);
+	}
+
+	const std::vector<Result>& results()
+	{
+		return all;
+	}
+
+	bool writeJSON(const char* path)
+	{
+		FILE* out = path ? fopen(path, "w") : stdout;
+		if (out == NULL)
+			return false;
+
+		char date[32];
+		time_t now = time(NULL);
+		strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+		fprintf(out, "{\n  \"context\": {\"date\": \"%s\", \"hardwareThreads\": %u, \"warmup\": %d, \"repetitions\": %d, \"minRepetitionMs\": %.2f},\n",
+			date, std::thread::hardware_concurrency(), options.warmup, options.repetitions, options.minRepetitionMs);
+		fprintf(out, "  \"benchmarks\": [\n");
+		for (size_t i = 0; i < all.size(); i++)
+		{
+			const Result& r = all[i];
+			fprintf(out, "    {\"name\": ");
+			writeString(out, r.name);
+			fprintf(out, ", \"iterations\": %lld, \"repetitions\": %d, \"medianNs\": %.3f, \"madNs\": %.3f, \"minNs\": %.3f, \"maxNs\": %.3f",
+				r.iterations, r.repetitions, r.medianNs, r.madNs, r.minNs, r.maxNs);
+			if (r.itemsPerSecond > 0.0)
+				fprintf(out, ", \"itemsPerSecond\": %.1f", r.itemsPerSecond);
+			for (size_t c = 0; c < r.counters.size(); c++)
+			{
+				fprintf(out, ", ");
+				writeString(out, r.counters[c].name);
+				fprintf(out, ": %.6g", r.counters[c].value);
+			}
+			fprintf(out, "}%s\n", i + 1 < all.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+		if (path)
+			fclose(out);
+		return true;
+	}
+
+	void sink(const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		unsigned char x = 0;
+		for (size_t i = 0; i < size; i++)
+			x ^= bytes[i];
+		sinkByte = x;
+	}
+}
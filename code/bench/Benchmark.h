@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <functional>
+
+// Microbenchmark runner. Each benchmark is calibrated until one repetition takes at least
+// minRepetitionMs, then run for the warmup repetitions and timed for the measured ones. Results are
+// the median and median absolute deviation of the time per iteration, written as JSON.
+namespace Benchmark
+{
+	struct Options
+	{
+		int warmup;
+		int repetitions;
+		double minRepetitionMs;
+		std::string filter;     // substring of the names to run, empty runs everything
+
+		Options() : warmup(3), repetitions(15), minRepetitionMs(5.0) {}
+	};
+
+	struct Counter
+	{
+		std::string name;
+		double value;
+	};
+
+	struct Result
+	{
+		std::string name;
+		long long iterations;   // per repetition
+		int repetitions;
+		double medianNs, madNs, minNs, maxNs;
+		double itemsPerSecond;  // items() per iteration over the median, 0 if not set
+		std::vector<Counter> counters;
+	};
+
+	void configure(const Options& options);
+	bool enabled(const char* name);
+
+	// Times 'body' (one iteration) if the name passes the filter
+	bool run(const char* name, const std::function<void()>& body);
+	// Attach to the last run benchmark
+	void items(double perIteration);
+	void counter(const char* name, double value);
+
+	const std::vector<Result>& results();
+	// Machine-readable report; 'path' NULL writes to stdout
+	bool writeJSON(const char* path);
+
+	// Keeps the compiler from dropping computations whose result is otherwise unused
+	void sink(const void* data, size_t size);
+}
@@ -0,0 +1,239 @@
+#include <GL\glew.h>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "GLStub.h"
+
+// Every stubbed entry point, GL 1.1 first
+#define GL_STUB_FUNCTIONS(X) \
+	X(glBindTexture) X(glBlendFunc) X(glClear) X(glClearColor) X(glClearDepth) X(glDeleteTextures) \
+	X(glDepthFunc) X(glDisable) X(glDrawArrays) X(glDrawElements) X(glEnable) X(glGenTextures) \
+	X(glGetIntegerv) X(glIsEnabled) X(glPixelStorei) X(glPointSize) X(glPolygonMode) X(glScissor) \
+	X(glTexImage2D) X(glTexParameteri) X(glTexParameteriv) X(glTexSubImage2D) X(glViewport) \
+	X(glActiveTexture) X(glAttachShader) X(glBindAttribLocation) X(glBindBuffer) X(glBindBufferBase) \
+	X(glBindSampler) X(glBindVertexArray) X(glBlendEquation) X(glBlendEquationSeparate) X(glBlendFuncSeparate) \
+	X(glBufferData) X(glClearBufferfv) X(glCompileShader) X(glCreateProgram) X(glCreateShader) \
+	X(glDeleteBuffers) X(glDeleteProgram) X(glDeleteShader) X(glDeleteVertexArrays) X(glDetachShader) \
+	X(glDrawElementsInstanced) X(glEnableVertexAttribArray) X(glGenBuffers) X(glGenVertexArrays) \
+	X(glGetAttribLocation) X(glGetProgramInfoLog) X(glGetProgramiv) X(glGetShaderInfoLog) X(glGetShaderiv) \
+	X(glGetUniformBlockIndex) X(glGetUniformLocation) X(glLinkProgram) X(glMapBufferRange) \
+	X(glPrimitiveRestartIndex) X(glShaderSource) X(glTexBuffer) X(glUniform1i) X(glUniform2f) X(glUniform3i) \
+	X(glUniform4f) X(glUniformBlockBinding) X(glUniformMatrix4fv) X(glUnmapBuffer) X(glUseProgram) X(glVertexAttribDivisor) \
+	X(glVertexAttribIPointer) X(glVertexAttribPointer)
+
+namespace GLStub
+{
+	namespace
+	{
+#define GL_STUB_ENUM(name) F_##name,
+		enum Function { GL_STUB_FUNCTIONS(GL_STUB_ENUM) functionCount };
+#undef GL_STUB_ENUM
+#define GL_STUB_NAME(name) #name,
+		const char* names[] = { GL_STUB_FUNCTIONS(GL_STUB_NAME) };
+#undef GL_STUB_NAME
+
+		int counts[functionCount];
+		int total = 0, draws = 0;
+		GLuint nextName = 1;
+		std::map<GLenum, GLuint> bound;                             // buffer target -> buffer
+		std::map<GLuint, std::vector<unsigned char> > mapped;       // buffer -> glMapBufferRange memory
+
+		inline void count(Function f)
+		{
+			counts[f]++;
+			total++;
+		}
+
+		void generate(GLsizei n, GLuint* out)
+		{
+			for (GLsizei i = 0; i < n; i++)
+				out[i] = nextName++;
+		}
+
+		void writeLog(GLsizei bufSize, GLsizei* length, GLchar* log)
+		{
+			if (length)
+				*length = 0;
+			if (log && bufSize > 0)
+				log[0] = '\0';
+		}
+	}
+}
+
+using namespace GLStub;
+
+// GL 1.1, exported by opengl32 in the app
+void GLAPIENTRY glBindTexture(GLenum, GLuint) { count(F_glBindTexture); }
+void GLAPIENTRY glBlendFunc(GLenum, GLenum) { count(F_glBlendFunc); }
+void GLAPIENTRY glClear(GLbitfield) { count(F_glClear); }
+void GLAPIENTRY glClearColor(GLclampf, GLclampf, GLclampf, GLclampf) { count(F_glClearColor); }
+void GLAPIENTRY glClearDepth(GLclampd) { count(F_glClearDepth); }
+void GLAPIENTRY glDeleteTextures(GLsizei, const GLuint*) { count(F_glDeleteTextures); }
+void GLAPIENTRY glDepthFunc(GLenum) { count(F_glDepthFunc); }
+void GLAPIENTRY glDisable(GLenum) { count(F_glDisable); }
+void GLAPIENTRY glDrawArrays(GLenum, GLint, GLsizei) { count(F_glDrawArrays); draws++; }
+void GLAPIENTRY glDrawElements(GLenum, GLsizei, GLenum, const void*) { count(F_glDrawElements); draws++; }
+void GLAPIENTRY glEnable(GLenum) { count(F_glEnable); }
+void GLAPIENTRY glGenTextures(GLsizei n, GLuint* textures) { count(F_glGenTextures); generate(n, textures); }
+void GLAPIENTRY glGetIntegerv(GLenum pname, GLint* params)
+{
+	count(F_glGetIntegerv);
+	int n = (pname == GL_VIEWPORT || pname == GL_SCISSOR_BOX) ? 4 : (pname == GL_POLYGON_MODE ? 2 : 1);
+	for (int i = 0; i < n; i++)
+		params[i] = 0;
+}
+GLboolean GLAPIENTRY glIsEnabled(GLenum) { count(F_glIsEnabled); return GL_FALSE; }
+void GLAPIENTRY glPixelStorei(GLenum, GLint) { count(F_glPixelStorei); }
+void GLAPIENTRY glPointSize(GLfloat) { count(F_glPointSize); }
+void GLAPIENTRY glPolygonMode(GLenum, GLenum) { count(F_glPolygonMode); }
+void GLAPIENTRY glScissor(GLint, GLint, GLsizei, GLsizei) { count(F_glScissor); }
+void GLAPIENTRY glTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void*) { count(F_glTexImage2D); }
+void GLAPIENTRY glTexParameteri(GLenum, GLenum, GLint) { count(F_glTexParameteri); }
+void GLAPIENTRY glTexParameteriv(GLenum, GLenum, const GLint*) { count(F_glTexParameteriv); }
+void GLAPIENTRY glTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, const void*) { count(F_glTexSubImage2D); }
+void GLAPIENTRY glViewport(GLint, GLint, GLsizei, GLsizei) { count(F_glViewport); }
+
+namespace GLStub
+{
+	namespace
+	{
+		// Loaded through GLEW in the app
+		void GLAPIENTRY stubActiveTexture(GLenum) { count(F_glActiveTexture); }
+		void GLAPIENTRY stubAttachShader(GLuint, GLuint) { count(F_glAttachShader); }
+		void GLAPIENTRY stubBindAttribLocation(GLuint, GLuint, const GLchar*) { count(F_glBindAttribLocation); }
+		void GLAPIENTRY stubBindBuffer(GLenum target, GLuint buffer) { count(F_glBindBuffer); bound[target] = buffer; }
+		void GLAPIENTRY stubBindBufferBase(GLenum, GLuint, GLuint) { count(F_glBindBufferBase); }
+		void GLAPIENTRY stubBindSampler(GLuint, GLuint) { count(F_glBindSampler); }
+		void GLAPIENTRY stubBindVertexArray(GLuint) { count(F_glBindVertexArray); }
+		void GLAPIENTRY stubBlendEquation(GLenum) { count(F_glBlendEquation); }
+		void GLAPIENTRY stubBlendEquationSeparate(GLenum, GLenum) { count(F_glBlendEquationSeparate); }
+		void GLAPIENTRY stubBlendFuncSeparate(GLenum, GLenum, GLenum, GLenum) { count(F_glBlendFuncSeparate); }
+		void GLAPIENTRY stubBufferData(GLenum, GLsizeiptr, const void*, GLenum) { count(F_glBufferData); }
+		void GLAPIENTRY stubClearBufferfv(GLenum, GLint, const GLfloat*) { count(F_glClearBufferfv); }
+		void GLAPIENTRY stubCompileShader(GLuint) { count(F_glCompileShader); }
+		GLuint GLAPIENTRY stubCreateProgram() { count(F_glCreateProgram); return nextName++; }
+		GLuint GLAPIENTRY stubCreateShader(GLenum) { count(F_glCreateShader); return nextName++; }
+		void GLAPIENTRY stubDeleteBuffers(GLsizei n, const GLuint* buffers)
+		{
+			count(F_glDeleteBuffers);
+			for (GLsizei i = 0; i < n; i++)
+				mapped.erase(buffers[i]);
+		}
+		void GLAPIENTRY stubDeleteProgram(GLuint) { count(F_glDeleteProgram); }
+		void GLAPIENTRY stubDeleteShader(GLuint) { count(F_glDeleteShader); }
+		void GLAPIENTRY stubDeleteVertexArrays(GLsizei, const GLuint*) { count(F_glDeleteVertexArrays); }
+		void GLAPIENTRY stubDetachShader(GLuint, GLuint) { count(F_glDetachShader); }
+		void GLAPIENTRY stubDrawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei) { count(F_glDrawElementsInstanced); draws++; }
+		void GLAPIENTRY stubEnableVertexAttribArray(GLuint) { count(F_glEnableVertexAttribArray); }
+		void GLAPIENTRY stubGenBuffers(GLsizei n, GLuint* buffers) { count(F_glGenBuffers); generate(n, buffers); }
+		void GLAPIENTRY stubGenVertexArrays(GLsizei n, GLuint* arrays) { count(F_glGenVertexArrays); generate(n, arrays); }
+		GLint GLAPIENTRY stubGetAttribLocation(GLuint, const GLchar*) { count(F_glGetAttribLocation); return 0; }
+		void GLAPIENTRY stubGetProgramInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* log) { count(F_glGetProgramInfoLog); writeLog(bufSize, length, log); }
+		void GLAPIENTRY stubGetProgramiv(GLuint, GLenum pname, GLint* param) { count(F_glGetProgramiv); *param = pname == GL_LINK_STATUS ? GL_TRUE : 0; }
+		void GLAPIENTRY stubGetShaderInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* log) { count(F_glGetShaderInfoLog); writeLog(bufSize, length, log); }
+		void GLAPIENTRY stubGetShaderiv(GLuint, GLenum pname, GLint* param) { count(F_glGetShaderiv); *param = pname == GL_COMPILE_STATUS ? GL_TRUE : 0; }
+		GLuint GLAPIENTRY stubGetUniformBlockIndex(GLuint, const GLchar*) { count(F_glGetUniformBlockIndex); return 0; }
+		GLint GLAPIENTRY stubGetUniformLocation(GLuint, const GLchar*) { count(F_glGetUniformLocation); return 0; }
+		void GLAPIENTRY stubLinkProgram(GLuint) { count(F_glLinkProgram); }
+		void* GLAPIENTRY stubMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield)
+		{
+			count(F_glMapBufferRange);
+			std::vector<unsigned char>& memory = mapped[bound[target]];
+			if (memory.size() < (size_t)(offset + length))
+				memory.resize((size_t)(offset + length));
+			return &memory[(size_t)offset];
+		}
+		void GLAPIENTRY stubPrimitiveRestartIndex(GLuint) { count(F_glPrimitiveRestartIndex); }
+		void GLAPIENTRY stubShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) { count(F_glShaderSource); }
+		void GLAPIENTRY stubTexBuffer(GLenum, GLenum, GLuint) { count(F_glTexBuffer); }
+		void GLAPIENTRY stubUniform1i(GLint, GLint) { count(F_glUniform1i); }
+		void GLAPIENTRY stubUniform2f(GLint, GLfloat, GLfloat) { count(F_glUniform2f); }
+		void GLAPIENTRY stubUniform3i(GLint, GLint, GLint, GLint) { count(F_glUniform3i); }
+		void GLAPIENTRY stubUniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) { count(F_glUniform4f); }
+		void GLAPIENTRY stubUniformBlockBinding(GLuint, GLuint, GLuint) { count(F_glUniformBlockBinding); }
+		void GLAPIENTRY stubUniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*) { count(F_glUniformMatrix4fv); }
+		GLboolean GLAPIENTRY stubUnmapBuffer(GLenum) { count(F_glUnmapBuffer); return GL_TRUE; }
+		void GLAPIENTRY stubUseProgram(GLuint) { count(F_glUseProgram); }
+		void GLAPIENTRY stubVertexAttribDivisor(GLuint, GLuint) { count(F_glVertexAttribDivisor); }
+		void GLAPIENTRY stubVertexAttribIPointer(GLuint, GLint, GLenum, GLsizei, const void*) { count(F_glVertexAttribIPointer); }
+		void GLAPIENTRY stubVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) { count(F_glVertexAttribPointer); }
+	}
+
+	void install()
+	{
+		__glewActiveTexture = stubActiveTexture;
+		__glewAttachShader = stubAttachShader;
+		__glewBindAttribLocation = stubBindAttribLocation;
+		__glewBindBuffer = stubBindBuffer;
+		__glewBindBufferBase = stubBindBufferBase;
+		__glewBindSampler = stubBindSampler;
+		__glewBindVertexArray = stubBindVertexArray;
+		__glewBlendEquation = stubBlendEquation;
+		__glewBlendEquationSeparate = stubBlendEquationSeparate;
+		__glewBlendFuncSeparate = stubBlendFuncSeparate;
+		__glewBufferData = stubBufferData;
+		__glewClearBufferfv = stubClearBufferfv;
+		__glewCompileShader = stubCompileShader;
+		__glewCreateProgram = stubCreateProgram;
+		__glewCreateShader = stubCreateShader;
+		__glewDeleteBuffers = stubDeleteBuffers;
+		__glewDeleteProgram = stubDeleteProgram;
+		__glewDeleteShader = stubDeleteShader;
+		__glewDeleteVertexArrays = stubDeleteVertexArrays;
+		__glewDetachShader = stubDetachShader;
+		__glewDrawElementsInstanced = stubDrawElementsInstanced;
+		__glewEnableVertexAttribArray = stubEnableVertexAttribArray;
+		__glewGenBuffers = stubGenBuffers;
+		__glewGenVertexArrays = stubGenVertexArrays;
+		__glewGetAttribLocation = stubGetAttribLocation;
+		__glewGetProgramInfoLog = stubGetProgramInfoLog;
+		__glewGetProgramiv = stubGetProgramiv;
+		__glewGetShaderInfoLog = stubGetShaderInfoLog;
+		__glewGetShaderiv = stubGetShaderiv;
+		__glewGetUniformBlockIndex = stubGetUniformBlockIndex;
+		__glewGetUniformLocation = stubGetUniformLocation;
+		__glewLinkProgram = stubLinkProgram;
+		__glewMapBufferRange = stubMapBufferRange;
+		__glewPrimitiveRestartIndex = stubPrimitiveRestartIndex;
+		__glewShaderSource = stubShaderSource;
+		__glewTexBuffer = stubTexBuffer;
+		__glewUniform1i = stubUniform1i;
+		__glewUniform2f = stubUniform2f;
+		__glewUniform3i = stubUniform3i;
+		__glewUniform4f = stubUniform4f;
+		__glewUniformBlockBinding = stubUniformBlockBinding;
+		__glewUniformMatrix4fv = stubUniformMatrix4fv;
+		__glewUnmapBuffer = stubUnmapBuffer;
+		__glewUseProgram = stubUseProgram;
+		__glewVertexAttribDivisor = stubVertexAttribDivisor;
+		__glewVertexAttribIPointer = stubVertexAttribIPointer;
+		__glewVertexAttribPointer = stubVertexAttribPointer;
+		reset();
+	}
+
+	void reset()
+	{
+		memset(counts, 0, sizeof(counts));
+		total = 0;
+		draws = 0;
+	}
+
+	int calls()
+	{
+		return total;
+	}
+
+	int drawCalls()
+	{
+		return draws;
+	}
+
+	int calls(const char* function)
+	{
+		for (int i = 0; i < functionCount; i++)
+			if (strcmp(names[i], function) == 0)
+				return counts[i];
+		return 0;
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// GL without a context: every entry point the framework and the ImGui binding use, counting calls and
+// doing nothing else. The GL 1.1 functions are defined in GLStub.cpp (the bench target doesn't link
+// opengl32 and builds with GLAPI=extern); the rest replace GLEW's function pointers in install().
+// Shaders always compile, names come from a counter and mapped buffers point at CPU memory.
+namespace GLStub
+{
+	void install();
+
+	void reset();
+	int calls();        // since reset()
+	int drawCalls();    // glDraw* since reset()
+	// Calls of one entry point since reset(), by GL name ("glBindBuffer")
+	int calls(const char* function);
+}
@@ -0,0 +1,1099 @@
+#include <GL\glew.h>
+#include <SDL2\SDL.h>
+#include <glm\gtc\matrix_transform.hpp>
+#include <glm\gtc\type_ptr.hpp>
+#include <imgui\imgui.h>
+#include <imgui\imgui_impl_sdl_gl3.h>
+#include <imgui\imgui_internal.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+
+#include "GL_framework.h"
+#include "LoadOBJ.h"
+#include "JobSystem.h"
+#include "Benchmark.h"
+#include "GLStub.h"
+#include "FontCache.h"
+#include "FramePipeline.h"
+#include "LogConsole.h"
+#include "MemorySystem.h"
+#include "MemoryTracker.h"
+
+extern void GUI();
+extern void GLinit(int width, int height);
+extern void GLcleanup();
+extern void GLprepare(SceneView& view, float dt);
+extern void GLsubmit(const SceneView& view);
+
+namespace CubeField
+{
+	extern bool enabled;
+	extern int count;
+}
+
+// Hot paths of the framework: OBJ loading, the glm chains of a frame, ImGui frames and draw lists,
+// and render submission against GLStub. Run from the code directory (shaders are loaded relative to it).
+namespace Loader
+{
+	// n x n vertex grid with uvs and normals, 2 * (n - 1)^2 triangles. Returns the file size.
+	long writeGrid(const char* path, int n)
+	{
+		FILE* file = fopen(path, "w");
+		if (file == NULL)
+			return 0;
+		for (int y = 0; y < n; y++)
+			for (int x = 0; x < n; x++)
+				fprintf(file, "v %f %f %f\n", (float)x, 0.25f * sinf(0.3f * x) * cosf(0.2f * y), (float)y);
+		for (int y = 0; y < n; y++)
+			for (int x = 0; x < n; x++)
+				fprintf(file, "vt %f %f\n", (float)x / (n - 1), (float)y / (n - 1));
+		fprintf(file, "vn 0.000000 1.000000 0.000000\n");
+		for (int y = 0; y + 1 < n; y++)
+			for (int x = 0; x + 1 < n; x++)
+			{
+				int a = y * n + x + 1, b = a + 1, c = a + n, d = c + 1;
+				fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, c, c, b, b);
+				fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1\n", b, b, c, c, d, d);
+			}
+		long size = ftell(file);
+		fclose(file);
+		return size;
+	}
+
+	void run()
+	{
+		const int sizes[] = { 65, 257 };
+		for (int s = 0; s < 2; s++)
+		{
+			const int n = sizes[s];
+			const int triangles = 2 * (n - 1) * (n - 1);
+			char name[64];
+			snprintf(name, sizeof(name), "loadOBJ/grid_%dk_triangles", triangles / 1000);
+			if (!Benchmark::enabled(name))
+				continue;
+
+			const char* path = "bench_grid.obj";
+			long bytes = writeGrid(path, n);
+			std::vector<glm::vec3> vertices, normals;
+			std::vector<glm::vec2> uvs;
+			Benchmark::run(name, [&]()
+			{
+				vertices.clear();
+				uvs.clear();
+				normals.clear();
+				loadObject::loadOBJ(path, vertices, uvs, normals);
+			});
+			Benchmark::items(triangles);
+			Benchmark::counter("bytes", (double)bytes);
+			Benchmark::counter("vertices", (double)vertices.size());
+			remove(path);
+		}
+	}
+}
+
+namespace Math
+{
+	const int batch = 1024;
+
+	void run()
+	{
+		std::vector<glm::vec3> pans(batch);
+		std::vector<glm::vec2> rotations(batch);
+		for (int i = 0; i < batch; i++)
+		{
+			pans[i] = glm::vec3(0.01f * i, -5.f + 0.001f * i, -15.f);
+			rotations[i] = glm::vec2(0.003f * i, 0.002f * i);
+		}
+		const glm::mat4 projection = glm::perspective(glm::radians(65.f), 800.f / 600.f, 1.f, 50.f);
+		std::vector<glm::mat4> out(batch);
+
+		// GLprepare: camera translate, two rotations, projection
+		Benchmark::run("glm/camera_chain", [&]()
+		{
+			for (int i = 0; i < batch; i++)
+			{
+				glm::mat4 modelView = glm::translate(glm::mat4(1.f), pans[i]);
+				modelView = glm::rotate(modelView, rotations[i].y, glm::vec3(1.f, 0.f, 0.f));
+				modelView = glm::rotate(modelView, rotations[i].x, glm::vec3(0.f, 1.f, 0.f));
+				out[i] = projection * modelView;
+			}
+			Benchmark::sink(&out[batch - 1], sizeof(glm::mat4));
+		});
+		Benchmark::items(batch);
+
+		// Cube::prepare/drawCube: orbiting parent, scaled child, world and MVP of both
+		Benchmark::run("glm/cube_chain", [&]()
+		{
+			for (int i = 0; i < batch; i++)
+			{
+				float time = 0.01f * i;
+				glm::mat4 translate = glm::translate(glm::mat4(), glm::vec3(0.0f, cos(time) * 2.0f + 2.0f, 2.0f));
+				glm::mat4 parent = glm::rotate(translate, time, glm::vec3(0.0f, 1.0f, 0.0f));
+				float scale = ((sin(time) * 2.0f + 2.0f) + 1) / 2;
+				glm::mat4 child = parent * glm::scale(glm::translate(glm::mat4(), glm::vec3(1.0f, 0.0f, 3.0f)), glm::vec3(scale));
+				out[i] = projection * parent + projection * child;
+			}
+			Benchmark::sink(&out[batch - 1], sizeof(glm::mat4));
+		});
+		Benchmark::items(batch);
+
+		Benchmark::run("glm/inverse_transpose", [&]()
+		{
+			for (int i = 0; i < batch; i++)
+				out[i] = glm::transpose(glm::inverse(out[i] + glm::mat4(1.f)));
+			Benchmark::sink(&out[batch - 1], sizeof(glm::mat4));
+		});
+		Benchmark::items(batch);
+	}
+}
+
+namespace Gui
+{
+	void init()
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		io.DisplaySize = ImVec2(1280.f, 720.f);
+		io.DeltaTime = 1.f / 60.f;
+		io.IniFilename = NULL;
+		io.RenderDrawListsFn = NULL;
+		unsigned char* pixels;
+		int width, height;
+		io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+		io.Fonts->TexID = (void*)(intptr_t)1;
+	}
+
+	// Typical tool windows: text, a few widgets and a plot each
+	void syntheticWindows(int count)
+	{
+		static float values[64];
+		for (int i = 0; i < 64; i++)
+			values[i] = sinf(0.2f * i);
+		for (int i = 0; i < count; i++)
+		{
+			char title[32];
+			snprintf(title, sizeof(title), "Window %d", i);
+			ImGui::SetNextWindowPos(ImVec2((float)((i * 37) % 1040), (float)((i * 53) % 560)), ImGuiCond_Always);
+			ImGui::SetNextWindowSize(ImVec2(240.f, 160.f), ImGuiCond_Always);
+			ImGui::Begin(title);
+			ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 16.6f, 60.f);
+			static float slider = 0.5f;
+			ImGui::SliderFloat("Value", &slider, 0.f, 1.f);
+			static bool check = true;
+			ImGui::Checkbox("Enabled", &check);
+			ImGui::Button("Run benchmark");
+			ImGui::PlotLines("Frame times", values, 64, 0, NULL, -1.f, 1.f, ImVec2(0, 40));
+			ImGui::End();
+		}
+	}
+
+	void counters()
+	{
+		ImDrawData* data = ImGui::GetDrawData();
+		Benchmark::counter("vertices", data ? data->TotalVtxCount : 0);
+		Benchmark::counter("indices", data ? data->TotalIdxCount : 0);
+	}
+
+	void run()
+	{
+		const int windows[] = { 10, 100 };
+		for (int w = 0; w < 2; w++)
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "imgui/frame_%d_windows", windows[w]);
+			const int count = windows[w];
+			if (Benchmark::run(name, [&]() { ImGui::NewFrame(); syntheticWindows(count); ImGui::Render(); }))
+				counters();
+		}
+		if (Benchmark::run("imgui/frame_demo_window", []() { ImGui::NewFrame(); ImGui::ShowTestWindow(); ImGui::Render(); }))
+			counters();
+		if (Benchmark::run("imgui/frame_app_gui", []() { ImGui::NewFrame(); GUI(); ImGui::Render(); }))
+			counters();
+
+		// Text layout cache off and on: a dashboard of 2400 static labels (the visible ones drawn, all measured) and the demo window
+		std::vector<std::string> labels;
+		char label[64];
+		for (int i = 0; i < 2400; i++)
+		{
+			if (i % 2)
+				snprintf(label, sizeof(label), "%.2f kPa", i * 0.37f);
+			else
+				snprintf(label, sizeof(label), "Sensor %d inlet pressure", i);
+			labels.push_back(label);
+		}
+		auto dashboard = [&]()
+		{
+			ImGui::SetNextWindowPos(ImVec2(0.f, 0.f), ImGuiCond_Always);
+			ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+			ImGui::Begin("Dashboard");
+			ImGui::Columns(8, NULL, false);
+			for (size_t i = 0; i < labels.size(); i++)
+			{
+				ImGui::TextUnformatted(labels[i].c_str());
+				ImGui::NextColumn();
+			}
+			ImGui::Columns(1);
+			ImGui::End();
+		};
+		ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+		for (int cached = 0; cached < 2; cached++)
+		{
+			atlas->TextLayoutCache = cached != 0;
+			char name[64];
+			snprintf(name, sizeof(name), "imgui/dashboard_2400_labels%s", cached ? "_cached" : "");
+			if (Benchmark::run(name, [&]() { ImGui::NewFrame(); dashboard(); ImGui::Render(); }))
+				counters();
+			snprintf(name, sizeof(name), "imgui/frame_demo_window%s", cached ? "_cached" : "");
+			if (cached && Benchmark::run(name, []() { ImGui::NewFrame(); ImGui::ShowTestWindow(); ImGui::Render(); }))
+				counters();
+		}
+		atlas->TextLayoutCache = false;
+
+		// What the idle mode (--idle) adds to a frame to tell whether the UI changed
+		if (Benchmark::enabled("imgui/draw_data_hash"))
+		{
+			ImGui::NewFrame();
+			syntheticWindows(100);
+			ImGui::Render();
+			ImDrawData* data = ImGui::GetDrawData();
+			ImU32 hash = 0;
+			if (Benchmark::run("imgui/draw_data_hash_100_windows", [&]() { hash = FramePipeline::hashDrawData(data); }))
+				counters();
+			Benchmark::sink(&hash, sizeof(hash));
+		}
+
+		// Draw data of the last 100-window frame through the GL3 binding
+		if (Benchmark::enabled("imgui/render_draw_data"))
+		{
+			ImGui_ImplSdlGL3_CreateDeviceObjects();
+			ImGui::NewFrame();
+			syntheticWindows(100);
+			ImGui::Render();
+			ImDrawData* data = ImGui::GetDrawData();
+			Benchmark::run("imgui/render_draw_data", [&]()
+			{
+				ImGui_ImplSdlGL3_RenderDrawData(data, ImGui::GetIO().DisplaySize, ImVec2(1.f, 1.f));
+			});
+			GLStub::reset();
+			ImGui_ImplSdlGL3_RenderDrawData(data, ImGui::GetIO().DisplaySize, ImVec2(1.f, 1.f));
+			Benchmark::counter("glCalls", GLStub::calls());
+			Benchmark::counter("drawCalls", GLStub::drawCalls());
+			ImGui_ImplSdlGL3_InvalidateDeviceObjects();
+		}
+	}
+}
+
+namespace DrawList
+{
+	void run()
+	{
+		// AddPolyline needs the white pixel of the current font: keep a frame open
+		ImGui::NewFrame();
+		ImDrawList list;
+		ImTextureID texture = ImGui::GetIO().Fonts->TexID;
+
+		const int pointCount = 1000;
+		std::vector<ImVec2> circle(pointCount), wave(pointCount);
+		for (int i = 0; i < pointCount; i++)
+		{
+			float a = 6.2831853f * i / pointCount;
+			circle[i] = ImVec2(640.f + 300.f * cosf(a), 360.f + 300.f * sinf(a));
+			wave[i] = ImVec2(1.2f * i, 360.f + 100.f * sinf(0.05f * i));
+		}
+
+		// The anti-aliased paths run once per tessellation level the CPU has, checked against the scalar vertices
+		struct Shape { const char* name; const std::vector<ImVec2>* points; bool closed; float thickness; bool antiAliased; bool fill; };
+		const Shape shapes[] = {
+			{ "drawlist/polyline_1000_aa_1px", &wave, false, 1.f, true, false },
+			{ "drawlist/polyline_1000_aa_4px", &wave, false, 4.f, true, false },
+			{ "drawlist/polyline_1000_closed_aa_1px", &circle, true, 1.f, true, false },
+			{ "drawlist/polyline_1000_no_aa_2px", &wave, false, 2.f, false, false },
+			{ "drawlist/convex_fill_1000_aa", &circle, true, 1.f, true, true },
+		};
+		const char* levelNames[] = { "scalar", "sse2", "avx2" };
+		const int maxLevel = ImGui::GetDrawSimdLevel();
+		for (int i = 0; i < 5; i++)
+		{
+			const Shape& shape = shapes[i];
+			auto tessellate = [&]()
+			{
+				list.Clear();
+				list.PushClipRectFullScreen();
+				list.PushTextureID(texture);
+				if (shape.fill)
+					list.AddConvexPolyFilled(&(*shape.points)[0], pointCount, 0xFFFFFFFF, shape.antiAliased);
+				else
+					list.AddPolyline(&(*shape.points)[0], pointCount, 0xFFFFFFFF, shape.closed, shape.thickness, shape.antiAliased);
+			};
+
+			std::vector<ImDrawVert> reference;
+			for (int level = ImDrawSimd_Scalar; level <= (shape.antiAliased ? maxLevel : ImDrawSimd_Scalar); level++)
+			{
+				ImGui::SetDrawSimdLevel(level);
+				char name[96];
+				if (shape.antiAliased)
+					snprintf(name, sizeof(name), "%s/%s", shape.name, levelNames[level]);
+				else
+					snprintf(name, sizeof(name), "%s", shape.name);
+				if (!Benchmark::run(name, tessellate))
+					continue;
+				Benchmark::items(pointCount);
+				Benchmark::counter("vertices", list.VtxBuffer.Size);
+				if (level == ImDrawSimd_Scalar)
+					reference.assign(list.VtxBuffer.begin(), list.VtxBuffer.end());
+				else if (!reference.empty())
+					Benchmark::counter("matchesScalar", reference.size() == (size_t)list.VtxBuffer.Size &&
+						memcmp(&reference[0], list.VtxBuffer.Data, reference.size() * sizeof(ImDrawVert)) == 0);
+			}
+			ImGui::SetDrawSimdLevel(maxLevel);
+		}
+
+		std::string text;
+		while (text.size() < 1000)
+			text += "The quick brown fox jumps over the lazy dog 0123456789. ";
+		text.resize(1000);
+		ImFont* font = ImGui::GetFont();
+		if (Benchmark::run("drawlist/text_1000_chars", [&]()
+		{
+			list.Clear();
+			list.PushClipRectFullScreen();
+			list.PushTextureID(texture);
+			list.AddText(font, font->FontSize, ImVec2(10.f, 10.f), 0xFFFFFFFF, text.c_str(), text.c_str() + text.size(), 600.f);
+		}))
+		{
+			Benchmark::items((double)text.size());
+			Benchmark::counter("vertices", list.VtxBuffer.Size);
+		}
+		ImGui::Render();
+	}
+}
+
+// ImGuiStorage as built (IMGUI_STORAGE_HASH in imconfig.h or not), with random IDs like ImHash gives
+namespace Storage
+{
+#ifdef IMGUI_STORAGE_HASH
+	const char* backend = "hash";
+#else
+	const char* backend = "sorted";
+#endif
+
+	void randomKeys(std::vector<ImGuiID>& keys, int count, unsigned seed)
+	{
+		keys.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			keys[i] = seed ^ (seed >> 16);
+		}
+	}
+
+	void run()
+	{
+		const int sizes[] = { 1000, 10000, 100000, 1000000 };
+		const char* labels[] = { "1k", "10k", "100k", "1m" };
+		std::vector<ImGuiID> keys, lookups;
+		for (int s = 0; s < 4; s++)
+		{
+			const int count = sizes[s];
+			randomKeys(keys, count, 1234u + s);
+			char name[64];
+
+			// Sorted inserts move half the array each: 100k keys would take seconds per repetition
+			snprintf(name, sizeof(name), "storage/%s/insert_%s", backend, labels[s]);
+			if (strcmp(backend, "sorted") != 0 || count <= 10000)
+			{
+				ImGuiStorage storage;
+				if (Benchmark::run(name, [&]() { storage.Clear(); for (int i = 0; i < count; i++) storage.SetInt(keys[i], i); }))
+					Benchmark::items(count);
+			}
+
+			// 1000 lookups of present keys, in random order. Filled in bulk, as SetInt() would be quadratic for the sorted one
+			snprintf(name, sizeof(name), "storage/%s/get_%s", backend, labels[s]);
+			if (!Benchmark::enabled(name))
+				continue;
+			ImGuiStorage storage;
+			for (int i = 0; i < count; i++)
+				storage.Data.push_back(ImGuiStorage::Pair(keys[i], i));
+			storage.BuildSortByKey();
+			lookups.resize(1000);
+			for (int i = 0; i < 1000; i++)
+				lookups[i] = keys[(i * 7919) % count];
+			int sum = storage.GetInt(lookups[0]); // Outside the timing: the hash one indexes the bulk-added pairs on first lookup
+			if (Benchmark::run(name, [&]() { for (int i = 0; i < 1000; i++) sum += storage.GetInt(lookups[i]); }))
+			{
+				Benchmark::items(1000);
+				Benchmark::counter("bytes", storage.Data.Size * (int)sizeof(ImGuiStorage::Pair)
+#ifdef IMGUI_STORAGE_HASH
+					+ storage.Index.Size * (int)sizeof(int)
+#endif
+				);
+			}
+			Benchmark::sink(&sum, sizeof(sum));
+		}
+	}
+}
+
+namespace Hash
+{
+	// The byte-at-a-time CRC32 ImHash() used before the CRC32-C paths, as the baseline
+	ImU32 crc32Bytewise(const char* label, ImU32 seed)
+	{
+		static ImU32 table[256];
+		if (!table[1])
+			for (ImU32 i = 0; i < 256; i++)
+			{
+				ImU32 crc = i;
+				for (int j = 0; j < 8; j++)
+					crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+				table[i] = crc;
+			}
+		seed = ~seed;
+		ImU32 crc = seed;
+		const unsigned char* current = (const unsigned char*)label;
+		while (unsigned char c = *current++)
+		{
+			if (c == '#' && current[0] == '#' && current[1] == '#')
+				crc = seed;
+			crc = (crc >> 8) ^ table[(crc & 0xFF) ^ c];
+		}
+		return ~crc;
+	}
+
+	void run()
+	{
+		// Labels as the demo and GUI() pass them to GetID(), seeded with a window id like the ID stack
+		std::vector<std::string> labels;
+		const char* fixed[] = { "Button", "##slider", "Application average", "Checkbox", "Color", "Show demo window",
+			"Camera##settings", "##combo", "Widgets", "Fill mode", "Anti-aliased lines", "Style Editor" };
+		for (int i = 0; i < 12; i++)
+			labels.push_back(fixed[i]);
+		char label[64];
+		for (int i = 0; i < 52; i++)
+		{
+			snprintf(label, sizeof(label), i & 1 ? "Node %d###node%d" : "Window %d", i * 37, i);
+			labels.push_back(label);
+		}
+		const ImU32 seed = ImHash("Debug", 0, 0);
+		ImU32 sum = 0;
+
+		if (Benchmark::run("hash/crc32_bytewise", [&]() { for (size_t i = 0; i < labels.size(); i++) sum += crc32Bytewise(labels[i].c_str(), seed); }))
+			Benchmark::items((int)labels.size());
+		const bool hardware = ImGui::GetHashHardware();
+		ImGui::SetHashHardware(false);
+		if (Benchmark::run("hash/crc32c_table", [&]() { for (size_t i = 0; i < labels.size(); i++) sum += ImHash(labels[i].c_str(), 0, seed); }))
+			Benchmark::items((int)labels.size());
+		ImGui::SetHashHardware(true);
+		if (ImGui::GetHashHardware() && Benchmark::run("hash/crc32c_sse42", [&]() { for (size_t i = 0; i < labels.size(); i++) sum += ImHash(labels[i].c_str(), 0, seed); }))
+			Benchmark::items((int)labels.size());
+		ImGui::SetHashHardware(hardware);
+		Benchmark::sink(&sum, sizeof(sum));
+	}
+}
+
+namespace Hover
+{
+#ifdef IMGUI_WINDOW_HOVER_GRID
+	const char* backend = "grid";
+#else
+	const char* backend = "linear";
+#endif
+
+	// A node editor: 10k child windows on a 100 x 100 lattice, panned so the display shows its middle. Children outside
+	// the canvas are clipped away, the visible ones leave gaps of canvas between them.
+	std::vector<ImVec2> nodes;
+
+	void nodeEditor()
+	{
+		ImGui::SetNextWindowPos(ImVec2(0.f, 0.f), ImGuiCond_Always);
+		ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+		ImGui::Begin("Canvas", NULL, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoScrollbar);
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			ImGui::SetCursorPos(nodes[i]);
+			ImGui::PushID((int)i);
+			ImGui::BeginChild("node", ImVec2(120.f, 60.f), true);
+			ImGui::EndChild();
+			ImGui::PopID();
+		}
+		ImGui::End();
+	}
+
+	void run()
+	{
+		char find[64], frames[64];
+		snprintf(find, sizeof(find), "hover/%s/find_10k", backend);
+		snprintf(frames, sizeof(frames), "hover/%s/frame_10k", backend);
+		if (!Benchmark::enabled(find) && !Benchmark::enabled(frames))
+			return;
+		const ImVec2 display = ImGui::GetIO().DisplaySize;
+		unsigned seed = 42u;
+		auto random = [&seed](float range) { seed = seed * 1664525u + 1013904223u; return range * (float)(seed >> 8) / 16777216.f; };
+		nodes.resize(10000);
+		for (int i = 0; i < 10000; i++)
+			nodes[i] = ImVec2((i % 100) * 160.f - 8000.f + display.x * 0.5f, (i / 100) * 90.f - 4500.f + display.y * 0.5f);
+		for (int i = 0; i < 2; i++)
+		{
+			ImGui::NewFrame();
+			nodeEditor();
+			ImGui::Render();
+		}
+
+		// 1000 mouse positions against the windows of the last frame
+		std::vector<ImVec2> mouse(1000);
+		for (size_t i = 0; i < mouse.size(); i++)
+			mouse[i] = ImVec2(random(display.x), random(display.y));
+		size_t hits = 0;
+		if (Benchmark::run(find, [&]() { for (size_t i = 0; i < mouse.size(); i++) hits += ImGui::FindHoveredWindow(mouse[i]) != NULL; }))
+			Benchmark::items((int)mouse.size());
+		Benchmark::sink(&hits, sizeof(hits));
+
+		// Whole frames dragging a selection of 100 nodes around, the grid relinks those only
+		size_t frame = 0;
+		Benchmark::run(frames, [&]()
+		{
+			ImGui::GetIO().MousePos = mouse[frame % mouse.size()];
+			const ImVec2 delta = (frame++ & 1) ? ImVec2(-4.f, -4.f) : ImVec2(4.f, 4.f);
+			for (int i = 4545; i < 4555; i++)
+				for (int j = 0; j < 1000; j += 100)
+					nodes[i + j] = ImVec2(nodes[i + j].x + delta.x, nodes[i + j].y + delta.y);
+			ImGui::NewFrame();
+			nodeEditor();
+			ImGui::Render();
+		});
+	}
+}
+
+namespace Plot
+{
+	// A 10M-sample frame time history: noise around 16 ms and 100 single-sample hitches of 50 ms
+	const int sampleCount = 10000000;
+	std::vector<float> samples;
+
+	// Columns of the last plot that reach above the noise, i.e. the hitches it shows
+	int hitchesShown(ImDrawList* drawList, float threshold)
+	{
+		const ImU32 col = ImGui::GetColorU32(ImGuiCol_PlotLines);
+		std::vector<bool> columns(4096, false);
+		for (int i = 0; i < drawList->VtxBuffer.Size; i++)
+			if (drawList->VtxBuffer[i].col == col && drawList->VtxBuffer[i].pos.y < threshold)
+				columns[ImClamp((int)(drawList->VtxBuffer[i].pos.x + 0.5f), 0, 4095)] = true;
+		int runs = 0;
+		for (int x = 1; x < 4096; x++)
+			runs += columns[x] && !columns[x - 1];
+		return runs;
+	}
+
+	// One plot in a fixed window, 100 px high and 600 px wide
+	void plot(const ImGuiPlotSeries* series, int count)
+	{
+		ImGui::NewFrame();
+		ImGui::SetNextWindowPos(ImVec2(0.f, 0.f), ImGuiCond_Always);
+		ImGui::SetNextWindowSize(ImVec2(640.f, 200.f), ImGuiCond_Always);
+		ImGui::Begin("Plot", NULL, ImGuiWindowFlags_NoTitleBar);
+		if (series)
+			ImGui::PlotLines("##series", *series, series->Size() - count, count, NULL, FLT_MAX, FLT_MAX, ImVec2(600.f, 100.f));
+		else
+			ImGui::PlotLines("##array", &samples[samples.size() - count], count, 0, NULL, FLT_MAX, FLT_MAX, ImVec2(600.f, 100.f));
+		ImGui::End();
+		ImGui::Render();
+	}
+
+	void run()
+	{
+		const char* names[] = { "plot/series_append_10M", "plot/lines_10M_array", "plot/lines_10M_series", "plot/lines_last_100k_array", "plot/lines_last_100k_series" };
+		bool any = false;
+		for (int i = 0; i < 5; i++)
+			any |= Benchmark::enabled(names[i]);
+		if (!any)
+			return;
+		unsigned seed = 7u;
+		samples.resize(sampleCount);
+		for (int i = 0; i < sampleCount; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			samples[i] = 16.f + 2.f * (float)(seed >> 8) / 16777216.f;
+		}
+		for (int i = 0; i < 100; i++)
+			samples[(size_t)i * 99991 + 12345] = 50.f;
+
+		ImGuiPlotSeries series;
+		if (Benchmark::run("plot/series_append_10M", [&]()
+		{
+			series.Clear();
+			series.Reserve(sampleCount);
+			for (int i = 0; i < sampleCount; i++)
+				series.Append(samples[i]);
+		}))
+			Benchmark::items(sampleCount);
+		if (series.Size() != sampleCount)
+			for (int i = 0; i < sampleCount; i++)
+				series.Append(samples[i]);
+
+		// Whole history and the last 100k samples: PlotLines() over the array (one value per column, auto scale reads them all) and over the series
+		const int counts[] = { sampleCount, 100000 };
+		for (int c = 0; c < 2; c++)
+		{
+			for (int backend = 0; backend < 2; backend++)
+			{
+				char name[64];
+				snprintf(name, sizeof(name), "plot/lines_%s_%s", c == 0 ? "10M" : "last_100k", backend ? "series" : "array");
+				const ImGuiPlotSeries* source = backend ? &series : NULL;
+				if (!Benchmark::run(name, [&]() { plot(source, counts[c]); }))
+					continue;
+				ImDrawList* drawList = ImGui::GetDrawData()->CmdLists[0];
+				Benchmark::counter("hitches_shown", hitchesShown(drawList, 60.f));
+			}
+		}
+	}
+}
+
+namespace Fonts
+{
+	const char* ttf = NULL; // --font: TTF merged in for the CJK benchmarks
+
+	// The default font at the sizes a HiDPI setup loads, oversampled like a TTF font
+	void addFonts(ImFontAtlas& atlas)
+	{
+		const float sizes[] = { 13.f, 16.f, 20.f, 26.f, 32.f };
+		for (int i = 0; i < 5; i++)
+		{
+			ImFontConfig config;
+			config.SizePixels = sizes[i];
+			config.OversampleH = 3;
+			atlas.AddFontDefault(&config);
+		}
+	}
+
+	// The default font with the CJK ranges of the TTF merged in, as the app does with --font
+	void addCjkFonts(ImFontAtlas& atlas, bool dynamic)
+	{
+		atlas.AddFontDefault();
+		ImFontConfig config;
+		config.MergeMode = true;
+		atlas.AddFontFromFileTTF(ttf, 13.f, &config, atlas.GetGlyphRangesChinese() + 2);
+		atlas.DynamicGlyphs = dynamic;
+	}
+
+	void runCjk()
+	{
+		ImFontAtlas atlas;
+		const char* names[] = { "fonts/cjk_build_eager", "fonts/cjk_build_dynamic" };
+		for (int dynamic = 0; dynamic < 2; dynamic++)
+			if (Benchmark::run(names[dynamic], [&]() { atlas.Clear(); addCjkFonts(atlas, dynamic != 0); atlas.Build(); }))
+			{
+				Benchmark::counter("alpha8Bytes", atlas.TexWidth * atlas.TexHeight);
+				Benchmark::counter("glyphs", atlas.Fonts[0]->Glyphs.Size);
+			}
+
+		// A frame drawing 64 ideographs it has not drawn before, the texture wraps around and evicts once full
+		atlas.Clear();
+		addCjkFonts(atlas, true);
+		atlas.Build();
+		ImFont* font = atlas.Fonts[0];
+		int next = 0;
+		if (Benchmark::run("fonts/cjk_first_use_64", [&]()
+			{
+				ImGui::NewFrame();
+				for (int i = 0; i < 64; i++, next = (next + 1) % (0x9FAF - 0x4E00 + 1))
+					font->FindGlyph((ImWchar)(0x4E00 + next));
+				ImGui::Render();
+			}))
+		{
+			int resident, rasterized, evicted;
+			atlas.GetGlyphCacheStats(&resident, &rasterized, &evicted);
+			Benchmark::items(64);
+			Benchmark::counter("resident", resident);
+			Benchmark::counter("evicted", evicted);
+		}
+	}
+
+	void run()
+	{
+		// Both include adding the fonts (decompressing the embedded TTF)
+		ImFontAtlas atlas;
+		if (Benchmark::run("fonts/atlas_build", [&]() { atlas.Clear(); addFonts(atlas); atlas.Build(); }))
+		{
+			Benchmark::counter("alpha8Bytes", atlas.TexWidth * atlas.TexHeight);
+			Benchmark::counter("rgba32Bytes", atlas.TexWidth * atlas.TexHeight * 4);
+		}
+
+		atlas.Clear();
+		addFonts(atlas);
+		FontCache::build(&atlas);
+		bool cached = false;
+		if (Benchmark::run("fonts/atlas_cache_load", [&]() { atlas.Clear(); addFonts(atlas); cached = FontCache::build(&atlas); }))
+			Benchmark::counter("cacheHit", cached);
+
+		if (ttf)
+			runCjk();
+	}
+}
+
+namespace Submit
+{
+	void measure(const char* name, const SceneView& view)
+	{
+		if (!Benchmark::run(name, [&]() { GLsubmit(view); }))
+			return;
+		GLStub::reset();
+		GLsubmit(view);
+		Benchmark::counter("glCalls", GLStub::calls());
+		Benchmark::counter("drawCalls", GLStub::drawCalls());
+		Benchmark::counter("uniformCalls", GLStub::calls("glUniformMatrix4fv") + GLStub::calls("glUniform4f") + GLStub::calls("glUniform1i"));
+	}
+
+	void run()
+	{
+		if (!Benchmark::enabled("submit/") && !Benchmark::enabled("prepare/"))
+			return;
+		GLinit(800, 600);
+		SceneView view;
+		// Lets pending texture decodes and uploads finish
+		for (int i = 0; i < 8; i++)
+		{
+			GLprepare(view, 1.f / 30.f);
+			GLsubmit(view);
+		}
+		measure("submit/scene", view);
+
+		const bool fieldWasEnabled = CubeField::enabled;
+		CubeField::enabled = true;
+		CubeField::count = 10000;
+		if (Benchmark::run("prepare/cubefield_10k", [&]() { GLprepare(view, 1.f / 30.f); }))
+			Benchmark::items(CubeField::count);
+		GLprepare(view, 1.f / 30.f);
+		measure("submit/cubefield_10k", view);
+		CubeField::enabled = fieldWasEnabled;
+
+		GLcleanup();
+	}
+}
+namespace Alloc
+{
+	// Random sizes, mostly small like ImGui's (16 B .. 2 KB), through a ring of 4096 live blocks
+	const int opCount = 100000;
+	const int liveCount = 4096;
+
+	template <typename AllocFn, typename FreeFn>
+	void churn(std::vector<void*>& live, unsigned& seed, AllocFn allocFn, FreeFn freeFn)
+	{
+		for (int i = 0; i < opCount; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			const size_t size = (size_t)16 << ((seed >> 8) % 8);
+			void*& slot = live[(seed >> 16) & (liveCount - 1)];
+			freeFn(slot);
+			slot = allocFn(size - (seed >> 24) % 16);
+		}
+	}
+
+	// The app's frame: arena reset, ImGui frame, counters of that frame
+	void frame(void (*ui)())
+	{
+		MemorySystem::beginFrame();
+		MemoryTracker::beginFrame();
+		ImGui::NewFrame();
+		ui();
+		ImGui::Render();
+	}
+
+	void hundredWindows()
+	{
+		Gui::syntheticWindows(100);
+	}
+
+	void frameCounters()
+	{
+		MemorySystem::Stats stats = MemorySystem::getStats();
+		Benchmark::counter("pool_allocs", stats.poolAllocs);
+		Benchmark::counter("frame_allocs", stats.frameAllocs);
+		Benchmark::counter("heap_allocs", stats.heapAllocs);
+		Benchmark::counter("tracked_allocs", MemoryTracker::total().allocsPerFrame);
+	}
+
+	void run()
+	{
+		std::vector<void*> live(liveCount, (void*)NULL);
+		unsigned seed = 1;
+		if (Benchmark::run("alloc/malloc_mixed_100k", [&]() { churn(live, seed, malloc, free); }))
+			Benchmark::items(opCount);
+		for (int i = 0; i < liveCount; i++)
+			free(live[i]);
+		live.assign(liveCount, (void*)NULL);
+		if (Benchmark::run("alloc/pool_mixed_100k", [&]() { churn(live, seed, MemorySystem::poolAlloc, MemorySystem::poolFree); }))
+			Benchmark::items(opCount);
+		for (int i = 0; i < liveCount; i++)
+			MemorySystem::poolFree(live[i]);
+		live.assign(liveCount, (void*)NULL);
+		// operator new is the tracker's: header, site and per-thread counters on top of malloc
+		if (Benchmark::run("alloc/new_delete_mixed_100k", [&]()
+		{
+			churn(live, seed, [](size_t size) { return ::operator new(size); }, [](void* ptr) { ::operator delete(ptr); });
+		}))
+			Benchmark::items(opCount);
+		for (int i = 0; i < liveCount; i++)
+			::operator delete(live[i]);
+
+		// A scope per job or subsystem call, and the per-frame report over every site
+		if (Benchmark::run("alloc/tracker_scope_100k", [&]()
+		{
+			for (int i = 0; i < opCount; i++)
+			{
+				MemoryTracker::Scope memory(MemoryTracker::Other, "bench scope");
+				Benchmark::sink(&memory, 1);
+			}
+		}))
+			Benchmark::items(opCount);
+		Benchmark::run("alloc/tracker_begin_frame", []() { MemoryTracker::beginFrame(); });
+
+		if (Benchmark::run("alloc/frame_arena_100k", [&]()
+		{
+			MemorySystem::beginFrame();
+			for (int i = 0; i < opCount; i++)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				Benchmark::sink(MemorySystem::frameAlloc((size_t)16 << ((seed >> 8) % 8)), 1);
+			}
+		}))
+			Benchmark::items(opCount);
+		MemorySystem::beginFrame();
+
+		// Steady state of UI frames: what the frame after the timed ones allocated
+		void (*uis[2])() = { hundredWindows, GUI };
+		const char* names[2] = { "alloc/imgui_frame_100_windows", "alloc/imgui_frame_app_gui" };
+		for (int u = 0; u < 2; u++)
+		{
+			if (!Benchmark::run(names[u], [&]() { frame(uis[u]); }))
+				continue;
+			frame(uis[u]);
+			MemorySystem::beginFrame();
+			MemoryTracker::beginFrame();
+			frameCounters();
+		}
+	}
+}
+
+namespace Ini
+{
+#ifdef IMGUI_ASYNC_INI_SAVE
+	const char* backend = "async";
+#else
+	const char* backend = "sync";
+#endif
+
+	// 5000 persisted windows, as a session that opened them all once. A frame shows 100 of them and moves one.
+	const int windowCount = 5000;
+	const int shownCount = 100;
+	const char* path = "bench_imgui.ini";
+
+	void frame(int moved, int count)
+	{
+		ImGui::NewFrame();
+		for (int i = 0; i < count; i++)
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "Settings %d", i);
+			if (i == moved % count)
+				ImGui::SetNextWindowPos(ImVec2((float)(moved % 600), 40.f));
+			ImGui::Begin(name);
+			ImGui::End();
+		}
+		ImGui::Render();
+	}
+
+	void run()
+	{
+		char plain[64], save[64], written[64];
+		snprintf(plain, sizeof(plain), "ini/%s/frame_5k_windows", backend);
+		snprintf(save, sizeof(save), "ini/%s/save_frame_5k_windows", backend);
+		snprintf(written, sizeof(written), "ini/%s/save_written_5k_windows", backend);
+		if (!Benchmark::enabled(plain) && !Benchmark::enabled(save) && !Benchmark::enabled(written))
+			return;
+		ImGuiIO& io = ImGui::GetIO();
+		const float savingRate = io.IniSavingRate;
+		io.IniFilename = path;
+		io.IniSavingRate = 1e-6f; // a marked save happens in the next NewFrame()
+		int moved = 0;
+		frame(moved++, windowCount);
+		ImGui::MarkIniSettingsDirty();
+		frame(moved++, shownCount);
+		ImGui::WaitIniSettingsSaved();
+
+		// Without a save, with one (the frame the dirty timer fires), and with one waited for until the file is written
+		Benchmark::run(plain, [&]() { frame(moved++, shownCount); });
+		Benchmark::run(save, [&]()
+		{
+			ImGui::MarkIniSettingsDirty();
+			frame(moved++, shownCount);
+		});
+		ImGui::WaitIniSettingsSaved();
+		if (Benchmark::run(written, [&]()
+		{
+			ImGui::MarkIniSettingsDirty();
+			frame(moved++, shownCount);
+			ImGui::WaitIniSettingsSaved();
+		}))
+		{
+			FILE* f = fopen(path, "rb");
+			if (f)
+			{
+				fseek(f, 0, SEEK_END);
+				Benchmark::counter("ini_bytes", (double)ftell(f));
+				fclose(f);
+			}
+		}
+
+		io.IniFilename = NULL;
+		io.IniSavingRate = savingRate;
+		remove(path);
+	}
+}
+
+namespace Console
+{
+	// The console window, full size, as a frame of the app draws it
+	void frame()
+	{
+		ImGui::NewFrame();
+		ImGui::SetNextWindowPos(ImVec2(0.f, 0.f), ImGuiCond_Always);
+		ImGui::SetNextWindowSize(ImVec2(1280.f, 720.f), ImGuiCond_Always);
+		LogConsole::draw();
+		ImGui::Render();
+	}
+
+	void run()
+	{
+		const char* names[] = { "console/log_1M_4_threads", "console/frame_10M_lines", "console/refilter_10M_lines", "console/frame_10M_lines_filtered" };
+		bool any = false;
+		for (int i = 0; i < 4; i++)
+			any |= Benchmark::enabled(names[i]);
+		if (!any)
+			return;
+		LogConsole::echo = false;
+
+		// 4 producers, the main thread drains as the app would every frame
+		const int threadLines = 250000;
+		if (Benchmark::run("console/log_1M_4_threads", [&]()
+		{
+			LogConsole::clear();
+			std::atomic<int> running(4);
+			std::vector<std::thread> threads;
+			for (int t = 0; t < 4; t++)
+				threads.push_back(std::thread([&running, t, threadLines]()
+				{
+					for (int i = 0; i < threadLines; i++)
+						LogConsole::log(i % 100 ? LogConsole::Info : LogConsole::Warning, "worker %d: job %d done in %.3f ms", t, i, i * 0.001f);
+					running--;
+				}));
+			while (running > 0)
+				LogConsole::drain();
+			for (int t = 0; t < 4; t++)
+				threads[t].join();
+			LogConsole::drain();
+		}))
+		{
+			LogConsole::Stats stats = LogConsole::getStats();
+			Benchmark::items(4.0 * threadLines);
+			Benchmark::counter("retained", stats.retained);
+			Benchmark::counter("dropped", (double)stats.dropped);
+		}
+
+		// 10M lines, drained as they come so the queue never fills
+		LogConsole::clear();
+		for (int i = 0; i < 10000000; i++)
+		{
+			LogConsole::log(i % 1000 ? LogConsole::Info : LogConsole::Error, "frame %d: object %d loaded in %.2f ms", i / 100, i % 977, (i % 50) * 0.1f);
+			if ((i & 4095) == 4095)
+				LogConsole::drain();
+		}
+		LogConsole::drain();
+
+		// Following the newest line, then after a filter change until every line is tested, then filtered
+		Benchmark::run("console/frame_10M_lines", [&]() { frame(); });
+		int frames = 0;
+		if (Benchmark::run("console/refilter_10M_lines", [&]()
+		{
+			LogConsole::setFilter("object 7");
+			frames = 0;
+			do
+			{
+				frame();
+				frames++;
+			} while (LogConsole::getStats().filtering);
+		}))
+		{
+			Benchmark::counter("frames", frames);
+			Benchmark::counter("shown", LogConsole::getStats().shown);
+		}
+		LogConsole::setFilter("object 7");
+		while (LogConsole::getStats().filtering)
+			LogConsole::drain();
+		Benchmark::run("console/frame_10M_lines_filtered", [&]() { frame(); });
+
+		LogConsole::setFilter(NULL);
+		LogConsole::clear();
+		LogConsole::echo = true;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	Benchmark::Options options;
+	const char* output = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) options.filter = argv[++i];
+		else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) options.repetitions = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) options.warmup = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) options.minRepetitionMs = atof(argv[++i]);
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) output = argv[++i];
+		else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) Fonts::ttf = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--filter name] [--repetitions n] [--warmup n] [--min-time ms] [--out results.json] [--font cjk.ttf]\n", argv[0]);
+			return 1;
+		}
+	}
+	Benchmark::configure(options);
+
+	if (SDL_Init(SDL_INIT_TIMER) != 0)
+	{
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+	GLStub::install();
+	JobSystem::init();
+	MemorySystem::installImGui();
+	Gui::init();
+
+	Loader::run();
+	Math::run();
+	DrawList::run();
+	Gui::run();
+	Storage::run();
+	Hash::run();
+	Fonts::run();
+	Submit::run();
+	Hover::run();
+	Plot::run();
+	Alloc::run();
+	Ini::run();
+	Console::run();
+
+	JobSystem::shutdown();
+	ImGui::Shutdown();
+	SDL_Quit();
+
+	if (!Benchmark::writeJSON(output))
+	{
+		fprintf(stderr, "Couldn't write %s\n", output);
+		return 1;
+	}
+	return 0;
+}
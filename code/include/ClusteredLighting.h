@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+
+#include "GL_framework.h"
+
+// Clustered forward shading. The view frustum (from the projection matrix) is cut into a grid of
+// froxels: screen tiles times exponential depth slices. Every frame the lights are binned into the
+// froxels they touch on the JobSystem, and the fragment shaders (shaders/clustered.glsl) only loop
+// over the lights of their own froxel. Lists reach the GPU through texture buffers.
+namespace ClusteredLighting
+{
+	const int tilesX = 16, tilesY = 9, slices = 24;
+	const int clusterCount = tilesX * tilesY * slices;
+
+	struct Light
+	{
+		glm::vec3 position;
+		float radius;           // no influence past it
+		glm::vec3 color;
+		glm::vec3 direction;    // spot lights only
+		float cosCutoff;        // < -1 for point lights
+	};
+
+	// World space scene lights, main thread. Light 0 is the key spot light over the object.
+	extern std::vector<Light> lights;
+	extern bool animate;
+	// Keeps light 0 and fills the rest with random point/spot lights around the origin
+	void generate(int count);
+
+	// Main thread (GLprepare): bins the lights into view.lightData / clusterLights / lightIndices
+	void build(SceneView& view, float dt);
+
+	// GL thread
+	void setup();
+	void cleanup();
+	void upload(const SceneView& view);
+	// Binds the texture buffers to units 1-3 and sets the cluster uniforms of 'program'
+	void bind(GLuint program, const SceneView& view);
+
+	// clusteredLighting() of shaders/clustered.glsl on the CPU, for the software renderer
+	struct ShadeParams
+	{
+		float tileWidth, tileHeight;    // pixels
+		float depthScale, logNear;      // slices / log(far / near), log(near)
+	};
+	ShadeParams shadeParams(const SceneView& view);
+	glm::vec3 shade(const SceneView& view, const ShadeParams& params, const glm::vec3& viewPos, const glm::vec3& normal, const glm::vec3& albedo, float fragX, float fragY);
+
+	struct Stats
+	{
+		int lights;
+		float binMs;
+		int maxInCluster;
+		int indexCount;         // light references over all clusters
+	};
+	Stats getStats();
+
+	// Frame time curve from 1 to 10000 lights, stepped by build() over the next frames.
+	// A frame is the wall time between two build() calls; the main loop drops its frame cap meanwhile.
+	void startBenchmark();
+	bool benchmarkRunning();
+	struct BenchPoint
+	{
+		int lights;
+		float frameMs;
+		float binMs;
+	};
+	const std::vector<BenchPoint>& benchmarkResults();
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+struct ImFontAtlas;
+
+// On-disk cache of the baked ImGui font atlas: alpha pixels, glyph tables and custom rectangle
+// positions. The file name and header carry a hash of every build input (TTF data, sizes,
+// oversampling, glyph ranges, custom rectangles), so a changed font or config simply misses and is
+// rebuilt with stb_truetype. Valid files are memory-mapped and copied into the atlas.
+// Atlases with DynamicGlyphs are always built: their baked part is small.
+namespace FontCache
+{
+	// Call once the fonts are added (an empty atlas gets the default font) and before the font
+	// texture is created. Returns true when the atlas came from the cache.
+	bool build(ImFontAtlas* atlas, const char* directory = "cache");
+}
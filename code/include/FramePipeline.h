@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <SDL2\SDL.h>
+#include <imgui\imgui.h>
+
+#include "GL_framework.h"
+
+// Optional two-stage frame pipeline: the main thread builds frame N+1 (input, GUI, scene)
+// while a render thread that owns the GL context submits and presents frame N.
+namespace FramePipeline
+{
+	// Lock-free single-producer / single-consumer ring. Capacity must be a power of two.
+	template <typename T, unsigned Capacity>
+	class SPSCQueue
+	{
+	public:
+		SPSCQueue() : head(0), tail(0) {}
+
+		// Producer thread only
+		bool push(const T& item)
+		{
+			unsigned t = tail.load(std::memory_order_relaxed);
+			if (t - head.load(std::memory_order_acquire) == Capacity)
+				return false;
+			items[t & (Capacity - 1)] = item;
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer thread only
+		bool pop(T& item)
+		{
+			unsigned h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire))
+				return false;
+			item = items[h & (Capacity - 1)];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		static_assert((Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+		alignas(64) std::atomic<unsigned> head;
+		alignas(64) std::atomic<unsigned> tail;
+		T items[Capacity];
+	};
+
+	// Everything the render thread needs to draw and present one frame
+	struct FramePacket
+	{
+		SceneView view;
+
+		// Deep copy of ImGui's draw data, owned by the packet so the main thread can start the next UI frame
+		ImVector<ImDrawList*> drawLists;
+		ImDrawData drawData;
+		ImVec2 displaySize;
+		ImVec2 framebufferScale;
+
+		// Font texture area rasterized since the previous packet (ImFontAtlas::DynamicGlyphs), fontWidth is 0 when there is none
+		ImVector<unsigned char> fontPixels;
+		int fontX, fontY, fontWidth, fontHeight;
+
+		Uint64 inputTimestamp; // SDL performance counter when the input of this frame was sampled
+	};
+
+	struct Stats
+	{
+		float framesPerSecond;  // presented frames per second
+		float skippedPerSecond; // frames the idle mode built the UI for but did not draw
+		float inputLatencyMs;   // input sampled -> SwapWindow returned, averaged
+		float cpuPercent;       // process CPU time over the last second, 100 = one core busy
+		bool threaded;
+		bool idle;              // idle mode is on (initIdle)
+	};
+
+	// Moves the GL context to a new render thread, runs GLinit and the ImGui device setup there. Returns once it is ready.
+	bool start(SDL_Window* window, SDL_GLContext context, int width, int height);
+	// Drains pending frames, runs GLcleanup on the render thread and gives the context back to the calling thread
+	void stop();
+
+	// Main thread: get a free packet to fill (waits while the render thread still holds both)
+	FramePacket* beginFrame();
+	// Main thread: copy the draw data produced by ImGui::Render() into the packet
+	void captureDrawData(FramePacket& packet, const ImDrawData* drawData);
+	// Main thread: hand the packet to the render thread
+	void submitFrame(FramePacket* packet);
+	// Main thread: give an unsubmitted packet back, beginFrame() returns it again
+	void cancelFrame(FramePacket* packet);
+
+	// Idle mode (--idle): the main loop sleeps in SDL_WaitEventTimeout and only draws when something changed.
+	// Main thread, after SDL_Init: registers the event wake() posts
+	void initIdle();
+	// Any thread: ask for a redraw, e.g. a background job finished something the next frame shows. Cheap to call often.
+	void wake();
+	// Main thread: whether wake() was called since the last call
+	bool takeWake();
+	bool isWakeEvent(const SDL_Event& event);
+	// Hash of the vertices, indices and draw commands: equal hashes mean the UI looks the same
+	ImU32 hashDrawData(const ImDrawData* drawData);
+
+	// Called by whichever thread presents, right after SDL_GL_SwapWindow
+	void recordPresent(Uint64 inputTimestamp);
+	// Main thread, for a frame the idle mode did not draw
+	void recordSkip();
+	Stats getStats();
+}
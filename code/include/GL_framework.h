@@ -1,7 +1,31 @@
 #pragma once
 
+#include <vector>
+#include <glm\glm.hpp>
+
 struct MouseEvent {
 	float posx, posy;
 	enum class Button { None = 0, Left = 1, Middle = 2, Right = 4 };
 	Button button;
-};
\ No newline at end of file
+};
+
+// Everything the GL submission stage needs from the scene for one frame.
+// Built on the main thread (GLprepare) and consumed by GLsubmit, possibly on the render thread.
+struct SceneView {
+	glm::mat4 projection;
+	glm::mat4 modelView;
+	glm::mat4 MVP;
+	float time;
+	int width, height;
+
+	// World matrices of the two Cube exercise cubes, from its scene graph
+	glm::mat4 cubeWorld[2];
+
+	// Draw packets: world matrices of the visible CubeField instances
+	std::vector<glm::mat4> cubeInstances;
+
+	// Clustered lighting, built by ClusteredLighting::build
+	std::vector<glm::vec4> lightData;           // 3 texels per light, view space
+	std::vector<unsigned int> clusterLights;    // offset, count per cluster
+	std::vector<unsigned int> lightIndices;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+
+// Work-stealing job scheduler. Every thread taking part (the main thread is worker 0)
+// owns a deque: it pushes and pops work at the bottom, idle threads steal from the top of the others.
+// A Counter tracks the jobs of a batch still in flight; waiting on it is how work depends on other work.
+namespace JobSystem
+{
+	typedef void (*JobFunction)(void* data, int begin, int end);
+
+	struct Counter
+	{
+		std::atomic<int> pending;
+		Counter() : pending(0) {}
+	};
+
+	struct Job
+	{
+		JobFunction function;
+		void* data;
+		int begin, end;
+		int grain;          // > 0: the range is split in halves until it is at most this many items
+		Counter* counter;
+	};
+
+	// workers < 0: one worker per hardware thread besides the calling (main) thread
+	void init(int workers = -1);
+	// Runs whatever is still queued on the calling (main) thread before the deques go away
+	void shutdown();
+	// Threads taking jobs: worker threads plus the main thread, at most maxThreadCount()
+	int threadCount();
+	// Threads the system was started with
+	int maxThreadCount();
+	// Main thread: only workers below count take jobs, the others sleep (count <= 0: all of them).
+	// For measuring scaling on the live system; queued work is never dropped.
+	void setActiveThreads(int count);
+	// Main thread: runs queued jobs until every deque is empty and every worker sleeps
+	void waitIdle();
+
+	// Queue function(data, begin, end) on the calling thread's deque
+	void run(JobFunction function, void* data, int begin, int end, Counter* counter);
+	// Queue [0, count) split recursively into chunks of at most 'grain' items
+	void parallelFor(int count, int grain, JobFunction function, void* data, Counter* counter);
+	// Returns once every job of the counter finished; the calling thread executes queued jobs meanwhile
+	void wait(Counter* counter);
+
+	template <typename Body>
+	void invokeBody(void* data, int begin, int end)
+	{
+		(*(const Body*)data)(begin, end);
+	}
+
+	// Blocking convenience: body(begin, end) over [0, count)
+	template <typename Body>
+	void parallelFor(int count, int grain, const Body& body)
+	{
+		Counter counter;
+		parallelFor(count, grain, &invokeBody<Body>, (void*)&body, &counter);
+		wait(&counter);
+	}
+}
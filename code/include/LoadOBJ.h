@@ -15,6 +15,35 @@
 
 namespace loadObject 
 {
+	// One newmtl block of a .mtl file
+	struct Material
+	{
+		std::string name;
+		glm::vec3 ambient = glm::vec3(1.f, 0.5f, 0.31f);   // Ka
+		glm::vec3 diffuse = glm::vec3(1.f, 0.5f, 0.31f);   // Kd
+		glm::vec3 specular = glm::vec3(0.5f, 0.5f, 0.5f);  // Ks
+		float shininess = 32.f;                            // Ns
+		std::string diffuseMap;                            // map_Kd, relative to the working directory
+	};
+
+	// Vertices [first, first + count) of the output use 'material'
+	struct SubMesh
+	{
+		int material;
+		int first, count;
+	};
+
+	bool loadMTL(const char* path, std::vector < Material >& out_materials);
+
+	// Faces come out grouped by material: one submesh per material, ordered by diffuse map so
+	// materials sharing a texture are adjacent. Faces before any usemtl get a default material.
+	bool loadOBJ(const char* path,
+		std::vector < glm::vec3 >& out_vertices,
+		std::vector < glm::vec2 >& out_uvs,
+		std::vector < glm::vec3 >& out_normals,
+		std::vector < SubMesh >& out_submeshes,
+		std::vector < Material >& out_materials);
+
 	bool loadOBJ(const char* path,
 		std::vector < glm::vec3 >& out_vertices,
 		std::vector < glm::vec2 >& out_uvs,
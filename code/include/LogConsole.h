@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+
+// Log lines from any thread, shown in an ImGui console window. A producer formats into a slot of a
+// lock-free multi-producer queue and never blocks: when the queue stays full for a few yields the
+// line is dropped and counted. The main thread moves the lines into 1 MB text chunks indexed by line, keeps the newest
+// maxLines / maxBytes, filters new lines as they arrive and draws only the visible ones.
+namespace LogConsole
+{
+	enum Level { Info, Warning, Error };
+
+	// Any thread. The text is split at newlines, longer lines than maxLineLength are cut.
+	// With echo the message is printed as well (stdout for Info, stderr otherwise), so command line runs keep their output.
+	void log(Level level, const char* format, ...);
+	void logv(Level level, const char* format, va_list args);
+
+	// Main thread: moves the queued lines into the console, draw() calls it
+	void drain();
+	// Main thread: the console window
+	void draw(bool* open = NULL);
+	void clear();
+	// Main thread: same as typing in the filter box ("incl,-excl"), NULL or "" shows every line
+	void setFilter(const char* text);
+
+	const int maxLineLength = 250;
+	extern bool echo;        // default true
+	extern bool queue;       // default true; false for runs without a console, where nothing drains: lines are only echoed
+	extern int maxLines;     // retained lines, default 10M
+	extern size_t maxBytes;  // retained text, default 1 GB
+	extern float filterMs;   // time per frame spent filtering older lines after the filter changed
+
+	struct Stats
+	{
+		long long received;  // lines drained since start
+		long long dropped;   // lines lost to a full queue
+		int retained;
+		int shown;           // retained lines that pass the filter (so far, while filtering)
+		bool filtering;      // the filter changed and older lines are still being tested
+		size_t textBytes;
+	};
+	Stats getStats();
+}
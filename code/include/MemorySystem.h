@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Allocators for the main thread's frame loop.
+// - A size-class pool for long-lived small objects: blocks of 16 B to 8 KB carved out of 64 KB pages,
+//   freed blocks go back on a free list of their class. ImGui allocates through it (installImGui), counted by MemoryTracker.
+// - A linear arena for memory that only lives until the end of the frame: frameAlloc() bumps a pointer,
+//   beginFrame() takes everything back at once.
+// Allocations too large for either go to malloc and are counted as heap allocations, so a steady
+// state reaching zero of those per frame no longer touches the general heap.
+// Everything here belongs to the main thread, like ImGui itself.
+namespace MemorySystem
+{
+	const size_t maxPoolSize = 8192;
+
+	void* poolAlloc(size_t size);
+	// Also takes pointers from malloc (allocations larger than maxPoolSize, or made before installImGui)
+	void poolFree(void* ptr);
+
+	// Valid until the next beginFrame(), never freed one by one
+	void* frameAlloc(size_t size, size_t align = 16);
+	template <typename T>
+	T* frameAlloc(size_t count) { return (T*)frameAlloc(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16); }
+
+	// std allocator on the frame arena, for per-frame containers
+	template <typename T>
+	struct FrameAllocator
+	{
+		typedef T value_type;
+		FrameAllocator() {}
+		template <typename U> FrameAllocator(const FrameAllocator<U>&) {}
+		T* allocate(size_t count) { return frameAlloc<T>(count); }
+		void deallocate(T*, size_t) {}
+		template <typename U> bool operator==(const FrameAllocator<U>&) const { return true; }
+		template <typename U> bool operator!=(const FrameAllocator<U>&) const { return false; }
+	};
+	template <typename T>
+	using FrameVector = std::vector<T, FrameAllocator<T> >;
+
+	// Before ImGui::NewFrame(): resets the arena and closes the counters of the previous frame.
+	// An arena that overflowed during the frame is replaced by one chunk large enough for all of it.
+	void beginFrame();
+
+	// Points ImGui's IO.MemAllocFn / MemFreeFn at the pool. Safe at any time: blocks ImGui allocated
+	// with malloc before are recognized and freed with free().
+	void installImGui();
+
+	struct Stats
+	{
+		// Previous frame
+		int poolAllocs, frameAllocs, heapAllocs;
+		size_t poolBytes, frameBytes, heapBytes;   // requested sizes
+		// Now
+		int poolLive;                              // pool blocks in use
+		size_t poolReserved;                       // pool pages
+		size_t arenaCapacity;
+	};
+	Stats getStats();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+
+// Where memory goes, by subsystem and call site. Always on:
+// - operator new / delete are replaced: every block carries a 16 byte header with its size and the call site
+//   that was current on the allocating thread (Scope), so the free is charged to the same site from any thread.
+// - ImGui's allocations are counted by MemorySystem's hooks, at the size of the pool block they use.
+// - GL buffers and textures are counted where glBufferData / glTexImage2D are called (gpuBuffer, gpuTexture).
+// Counters are per thread and only written by their thread (plain loads and stores, no locked instructions),
+// the report sums them once per frame. malloc and aligned new are not seen.
+namespace MemoryTracker
+{
+	enum Tag { Other, Mesh, Textures, Shaders, Fonts, Scene, Lighting, Culling, Log, Gui, TagCount }; // Gui: ImGui and the app's windows
+	const char* tagName(Tag tag);
+
+	const int maxSites = 128;
+
+	// Id of a call site, registered on first use. The same name pointer (a string literal) or the same text
+	// gives the same id. Past maxSites new names go to site 0, "(untagged)".
+	int site(Tag tag, const char* name);
+
+	// Allocations and GL objects of this thread are charged to the site until the scope ends. Scopes nest.
+	// Meant for subsystem entry points and job bodies, not inner loops: a scope looks its site up by name.
+	class Scope
+	{
+	public:
+		Scope(Tag tag, const char* name);
+		~Scope();
+	private:
+		int previous;
+		int current;
+	};
+
+	// For allocators that bypass operator new
+	void countAlloc(int site, size_t bytes);
+	void countFree(int site, size_t bytes);
+
+	// GL thread, right after glBufferData / glTexImage2D: the object holds bytes now (all mip levels for a texture),
+	// replacing what it held before. Charged to the current scope.
+	void gpuBuffer(unsigned handle, size_t bytes);
+	void gpuTexture(unsigned handle, size_t bytes);
+	// GL thread, next to glDeleteBuffers / glDeleteTextures
+	void gpuBuffersDeleted(int count, const unsigned* handles);
+	void gpuTexturesDeleted(int count, const unsigned* handles);
+
+	// Main thread, once per frame: sums the thread counters into the report.
+	// CPU peaks are sampled here and when a scope ends, so a site's short-lived spikes in between are missed.
+	void beginFrame();
+
+	struct Usage
+	{
+		long long live, peak;        // CPU bytes
+		long long allocs;            // since start
+		int allocsPerFrame, freesPerFrame;
+		long long gpuBuffers, gpuTextures, gpuPeak;
+	};
+	struct SiteUsage
+	{
+		const char* name;
+		Tag tag;
+		Usage usage;
+	};
+	// As of the last beginFrame()
+	Usage total();
+	Usage tagUsage(Tag tag);
+	// Sites with anything live or allocated last frame, by live CPU + GPU bytes, at most max
+	int topSites(SiteUsage* out, int max);
+
+	// Main thread: the report window
+	void draw(bool* open = NULL);
+	// Main thread: totals, tags and every site as text
+	bool dump(const char* filename);
+}
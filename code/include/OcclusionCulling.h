@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+
+// Software occlusion culling. The occluder meshes picked at load time are rasterized every frame
+// into a small depth buffer (AVX2 when the CPU has it, one job per screen tile), reduced into a
+// Hi-Z pyramid of farthest depths, and object bounds are tested against it before the draw
+// packets are built.
+namespace OcclusionCulling
+{
+	const int width = 256, height = 128;
+	const int tileWidth = 64, tileHeight = 32;
+
+	extern bool enabled;
+
+	// Load time. Keeps the mesh (an indexed triangle list, counter-clockwise) only when its world
+	// bounds are large enough to hide something; returns the occluder id or -1 if it was rejected.
+	int addOccluder(const glm::vec3* vertices, int vertexCount, const unsigned int* indices, int indexCount, const glm::mat4& world);
+	void removeOccluder(int id);
+	int occluderCount();
+
+	// Main thread, once per frame before testing: rasterizes the occluders and builds the Hi-Z
+	void render(const glm::mat4& viewProj);
+	// Thread safe after render(). False only when the world box is hidden behind the occluders.
+	bool testBox(const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+	struct Stats
+	{
+		bool avx2;
+		int triangles;      // after back-face culling and near clipping
+		float setupMs, rasterMs, hizMs;
+	};
+	Stats getStats();
+
+	// Checks the last view: the AVX2 depth buffer against the scalar one, and the Hi-Z test of every
+	// box against a scalar reference rasterized at 4x the resolution and tested per pixel
+	struct CheckResult
+	{
+		int tested, culled;
+		int falseNegatives;     // culled, but the reference sees part of the box
+		int missedCulls;        // the reference hides the box, the Hi-Z does not
+		int mismatchedPixels;   // AVX2 against scalar rasterization
+		float simdMs, scalarMs; // rasterization on every thread
+	};
+	CheckResult check(const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "SoftwareRenderer.h"
+
+// Golden-image and frame-time regression runs (--regress). Every scene is drawn through the software
+// renderer from each of its scripted cameras, compared with the reference image stored in the
+// directory, and its frame times are appended to history.jsonl there (one JSON object per line).
+namespace Regression
+{
+	struct Options
+	{
+		std::string directory;
+		float pixelThreshold;   // YIQ color distance in [0, 1] under which pixels count as equal
+		float maxDiffRatio;     // share of differing pixels that still passes
+		float timeThreshold;    // allowed median slowdown against the history, 0.25 = 25%
+		int warmupFrames, frames;
+		bool update;            // write the references instead of comparing
+
+		Options() : directory("regress"), pixelThreshold(0.1f), maxDiffRatio(0.001f), timeThreshold(0.25f), warmupFrames(3), frames(20), update(false) {}
+	};
+
+	// setup() switches the scene on; render() draws it into 'target' from one of its cameras
+	struct Scene
+	{
+		const char* name;
+		int cameras;
+		void (*setup)();
+		void (*render)(int camera, SoftwareRenderer::Image& target);
+	};
+
+	struct ImageDiff
+	{
+		int differing, total;
+		float maxDelta;
+	};
+	// Perceptual difference (YIQ weighted like pixelmatch), 'diff' gets the differing pixels in red if not NULL
+	ImageDiff compare(const SoftwareRenderer::Image& a, const SoftwareRenderer::Image& b, float threshold, SoftwareRenderer::Image* diff);
+
+	// Returns the number of failed scene/camera pairs
+	int run(const std::vector<Scene>& scenes, const Options& options);
+}
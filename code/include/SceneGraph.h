@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+
+// Transform hierarchy stored in flat arrays in depth-first (pre)order: a parent always comes
+// before its children and every subtree is the contiguous range [node, subtreeEnd[node]).
+// Only subtrees whose local transform changed are recomputed, static nodes cost nothing per frame.
+namespace SceneGraph
+{
+	struct Range
+	{
+		int begin, end;
+	};
+
+	struct Graph
+	{
+		std::vector<int> parent;            // -1 for roots
+		std::vector<int> subtreeEnd;        // one past the last descendant
+		std::vector<glm::mat4> local;
+		std::vector<glm::mat4> world;
+		std::vector<unsigned char> dirty;   // local changed since the last update
+		std::vector<int> changed;           // nodes with the dirty bit set, in no particular order
+
+		// Filled by update(): node ranges whose world matrix was recomputed, sorted and disjoint
+		std::vector<Range> changedRanges;
+
+		int size() const { return (int)parent.size(); }
+	};
+
+	// Adds a node as the last child of 'parentNode' (-1 for a new root) and returns its index.
+	// Keeps the preorder layout by inserting after the parent's current subtree, so node
+	// indices after the insertion point shift by one; build hierarchies before storing indices
+	// or add children in depth-first order (then nothing moves).
+	int addNode(Graph& g, int parentNode, const glm::mat4& local);
+	void setLocal(Graph& g, int node, const glm::mat4& local);
+
+	// Recomputes the world matrices of the changed subtrees (disjoint subtrees run as parallel jobs)
+	void update(Graph& g);
+	// Recomputes everything, the reference for update()
+	void updateAll(Graph& g);
+
+	struct BenchResult
+	{
+		int nodes;
+		float animatedFraction;
+		float incrementalMs;    // average update() after animating the nodes
+		float fullMs;           // average updateAll()
+		float nodesRecomputed;  // average per frame with update()
+	};
+	BenchResult benchmark(int nodes, float animatedFraction, int frames);
+}
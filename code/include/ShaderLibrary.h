@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <GL\glew.h>
+
+// Shader programs loaded from files in the shaders/ directory. The directory is watched and changed
+// programs are rebuilt in the background with GL_KHR/ARB_parallel_shader_compile. Without it the build
+// is issued in one frame and its link status read in the next, which blocks that frame until the driver
+// is done. The program in use is only replaced once the new one linked, so a broken edit keeps the
+// last good program running.
+namespace ShaderLibrary
+{
+	// Files are relative to shaders/ and may pull in shared code with '#include "file"' lines.
+	// attributes is a NULL-terminated list bound to locations 0, 1, 2... before linking
+	// (NULL when the shader uses layout qualifiers). Builds synchronously the first time.
+	int create(const char* name, const char* vertexFile, const char* fragmentFile, const char* const* attributes = NULL);
+	// Current GL program of a library entry, may change between frames
+	GLuint program(int id);
+
+	// Once per frame on the GL thread: check the watcher and swap in the builds that finished
+	void update();
+	// GL thread
+	void shutdown();
+
+	struct ProgramStats
+	{
+		std::string name;
+		int builds;
+		float lastBuildMs;   // compile + link, from issue until the driver reported completion
+		bool pending;
+		bool lastFailed;
+		std::string log;
+	};
+	// Safe from any thread (the GUI may run apart from the GL thread)
+	void getStats(std::vector<ProgramStats>& out);
+	bool parallelCompileSupported();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+
+#include "TextureSystem.h"
+
+// CPU rasterizer for machines without a GPU (thumbnails, regression images). Draws are recorded
+// between begin() and end(); end() bins the triangles into screen tiles and rasterizes one tile per
+// job: SSE2 edge functions, perspective-correct varyings, LEQUAL depth test and back-face culling
+// like the GL state set up in GLinit. Vertex shading is done by the caller, fragments by a callback.
+namespace SoftwareRenderer
+{
+	const int tileSize = 64;
+	const int maxVaryings = 12;
+
+	struct Image
+	{
+		int width, height;
+		std::vector<unsigned int> color;    // RGBA8, rows bottom-up like GL
+		std::vector<float> depth;
+	};
+
+	struct Vertex
+	{
+		glm::vec4 position;                 // clip space
+		float varyings[maxVaryings];
+	};
+
+	// Returns the color of the fragment at window position (x, y); varyings are interpolated
+	typedef glm::vec4 (*FragmentShader)(const void* uniforms, const float* varyings, float x, float y);
+
+	struct Batch
+	{
+		FragmentShader shader;
+		const void* uniforms;               // must live until end()
+		int varyingCount;
+	};
+
+	void begin(Image& target, int width, int height, const glm::vec4& clearColor);
+	// Triangle list, counter-clockwise front faces
+	void drawTriangles(const Batch& batch, const Vertex* vertices, const unsigned int* indices, int indexCount);
+	// Line list, one pixel wide, never culled
+	void drawLines(const Batch& batch, const Vertex* vertices, const unsigned int* indices, int indexCount);
+	void end();
+
+	// Bilinear, repeating, level 0 only
+	glm::vec4 sample(const TextureSystem::Image& image, const glm::vec2& uv);
+
+	// 32-bit uncompressed TGA, TextureSystem::decodeTGA reads it back
+	bool writeTGA(const Image& image, const char* path);
+
+	struct Stats
+	{
+		int triangles;                      // submitted
+		int rasterized;                     // after clipping and culling
+		float setupMs, rasterMs;
+	};
+	Stats getStats();
+}
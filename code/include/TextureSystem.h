@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <GL\glew.h>
+
+// Textures decoded and mip-mapped on the JobSystem workers, then streamed to the GPU through pixel
+// buffer objects under a per-frame byte budget. The smallest mips go first, so a texture is usable
+// right away and sharpens as the big levels arrive. Reads BMP (through SDL) and TGA files.
+namespace TextureSystem
+{
+	struct Image
+	{
+		struct Level
+		{
+			int width, height;
+			size_t offset;  // into pixels
+		};
+		std::vector<Level> levels;          // level 0 is the full image
+		std::vector<unsigned char> pixels;  // RGBA8, rows bottom-up as GL expects, levels back to back
+	};
+
+	// Fill level 0 only
+	bool decodeTGA(const unsigned char* data, size_t size, Image& out);
+	bool decodeFile(const char* path, Image& out);
+	// Appends the mip chain of level 0 (2x2 box filter, SSE2)
+	void generateMips(Image& image);
+	// Reference for generateMips, gives the same bytes
+	void generateMipsScalar(Image& image);
+
+	// GL thread. Returns at once, the file is decoded in the background
+	int load(const char* path);
+	// Texture to bind: a white placeholder until the first mip arrives (and for id < 0)
+	GLuint texture(int id);
+
+	// Main thread, once per frame: queues the decode jobs (jobs can only be queued from JobSystem threads)
+	void dispatch();
+	// GL thread, once per frame: streams decoded levels within the upload budget
+	void update();
+	// GL thread
+	void shutdown();
+
+	extern int uploadBudget; // bytes per frame
+
+	struct Stats
+	{
+		int loaded, ready, failed;
+		float decodeMBs, mipMBs;   // per worker, over every texture decoded so far
+		int uploadedLastFrame;     // bytes
+	};
+	Stats getStats();
+
+	struct BenchResult
+	{
+		float decodeMBs;           // TGA decode on all threads
+		float mipScalarMBs, mipSimdMBs;
+	};
+	BenchResult benchmark();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+#include <glm\gtc\quaternion.hpp>
+
+// Transforms stored as structure-of-arrays (one array per component) so world matrices
+// can be composed four at a time with the SSE kernels in glm/simd/matrix.h.
+namespace TransformSystem
+{
+	struct Transforms
+	{
+		std::vector<float> posX, posY, posZ;
+		std::vector<float> rotX, rotY, rotZ, rotW; // unit quaternion
+		std::vector<float> scaleX, scaleY, scaleZ;
+
+		int size() const { return (int)posX.size(); }
+		void resize(int count);
+		void set(int i, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	};
+
+	// world = parent * T * R * S for transforms [begin, end), written as column-major 4x4 float matrices
+	// (16 floats each) to 'out', which can be a mapped instance buffer. parent may be NULL for identity.
+	void compose(const Transforms& t, const glm::mat4* parent, int begin, int end, float* out);
+	// Same for an arbitrary list of transform indices (e.g. the survivors of culling)
+	void compose(const Transforms& t, const glm::mat4* parent, const int* indices, int count, float* out);
+
+	// Reference path: one transform at a time with glm::translate/mat4_cast/scale
+	void composeScalar(const Transforms& t, const glm::mat4* parent, int begin, int end, float* out);
+
+	// Single thread, 'count' transforms: matrices per second of composeScalar and compose
+	void benchmark(int count, double& scalarPerSec, double& simdPerSec);
+}
@@ -30,6 +30,21 @@
 //---- Don't implement ImFormatString(), ImFormatStringV() so you can reimplement them yourself.
 //#define IMGUI_DISABLE_FORMAT_STRING_FUNCTIONS
 
+//---- Tessellate anti-aliased lines and convex fills with scalar code only (the SSE2/AVX2 paths are picked at runtime otherwise)
+//#define IMGUI_DISABLE_SIMD_DRAW
+
+//---- Hash IDs with table code only (the SSE4.2 crc32 instruction is picked at runtime otherwise, both give the same IDs)
+//#define IMGUI_DISABLE_SIMD_HASH
+
+//---- Back ImGuiStorage (window state, WindowsById) with a linear-probing hash table instead of a sorted array: O(1) inserts for storages with many keys
+//#define IMGUI_STORAGE_HASH
+
+//---- Hit-test the mouse against a uniform grid of windows instead of every window in FindHoveredWindow(): for thousands of (child) windows
+//#define IMGUI_WINDOW_HOVER_GRID
+
+//---- Save the .ini file from a background thread (temp file + rename), formatting only the window settings that changed on the UI thread
+//#define IMGUI_ASYNC_INI_SAVE
+
 //---- Pack colors to BGRA instead of RGBA (remove need to post process vertex buffer in back ends)
 //#define IMGUI_USE_BGRA_PACKED_COLOR
 
@@ -596,6 +596,29 @@
 #else
 #include <stdint.h>     // intptr_t
 #endif
+#if !defined(IMGUI_DISABLE_SIMD_HASH) && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)) && (defined(_MSC_VER) || defined(__GNUC__))
+#define IMGUI_HASH_SSE42
+#include <nmmintrin.h>  // _mm_crc32_*, selected at runtime
+#ifdef _MSC_VER
+#include <intrin.h>     // __cpuid
+#endif
+#endif
+#ifdef IMGUI_ASYNC_INI_SAVE
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>    // MoveFileExW
+#endif
+#endif
 
 #ifdef _MSC_VER
 #pragma warning (disable: 4127) // condition expression is constant
@@ -637,7 +660,6 @@ static void             SetWindowScrollY(ImGuiWindow* window, float new_scroll_y
 static void             SetWindowPos(ImGuiWindow* window, const ImVec2& pos, ImGuiCond cond);
 static void             SetWindowSize(ImGuiWindow* window, const ImVec2& size, ImGuiCond cond);
 static void             SetWindowCollapsed(ImGuiWindow* window, bool collapsed, ImGuiCond cond);
-static ImGuiWindow*     FindHoveredWindow(ImVec2 pos);
 static ImGuiWindow*     CreateNewWindow(const char* name, ImVec2 size, ImGuiWindowFlags flags);
 static void             ClearSetNextWindowData();
 static void             CheckStacksSize(ImGuiWindow* window, bool write);
@@ -654,6 +676,11 @@ static void             LoadIniSettingsFromMemory(const char* buf);
 static void             SaveIniSettingsToDisk(const char* ini_filename);
 static void             SaveIniSettingsToMemory(ImVector<char>& out_buf);
 static void             MarkIniSettingsDirty(ImGuiWindow* window);
+#ifdef IMGUI_ASYNC_INI_SAVE
+static void             SyncIniSettings(ImGuiWindow* window);
+static void             QueueIniSettings(const char* ini_filename, bool write);
+static void             StopIniWriter();
+#endif
 
 static ImRect           GetVisibleRect();
 
@@ -1016,48 +1043,122 @@ int ImFormatStringV(char* buf, int buf_size, const char* fmt, va_list args)
 }
 #endif // #ifdef IMGUI_DISABLE_FORMAT_STRING_FUNCTIONS
 
-// Pass data_size==0 for zero-terminated strings
-// FIXME-OPT: Replace with e.g. FNV1a hash? CRC32 pretty much randomly access 1KB. Need to do proper measurements.
-ImU32 ImHash(const void* data, int data_size, ImU32 seed)
+// ImHash() is a CRC32-C (Castagnoli polynomial, the one of the SSE4.2 crc32 instruction), computed 8 bytes at a time
+// either with the instruction or with slicing-by-8 tables.
+static ImU32 GCrc32cTable[8][256];
+
+static ImU32 ImCrc32cTables(ImU32 crc, const unsigned char* data, size_t size)
 {
-    static ImU32 crc32_lut[256] = { 0 };
-    if (!crc32_lut[1])
+    if (!GCrc32cTable[0][1])
     {
-        const ImU32 polynomial = 0xEDB88320;
+        const ImU32 polynomial = 0x82F63B78;
         for (ImU32 i = 0; i < 256; i++)
         {
-            ImU32 crc = i;
+            ImU32 c = i;
             for (ImU32 j = 0; j < 8; j++)
-                crc = (crc >> 1) ^ (ImU32(-int(crc & 1)) & polynomial);
-            crc32_lut[i] = crc;
+                c = (c >> 1) ^ (ImU32(-int(c & 1)) & polynomial);
+            GCrc32cTable[0][i] = c;
         }
+        for (int n = 1; n < 8; n++)
+            for (int i = 0; i < 256; i++)
+                GCrc32cTable[n][i] = (GCrc32cTable[n-1][i] >> 8) ^ GCrc32cTable[0][GCrc32cTable[n-1][i] & 0xFF];
     }
 
-    seed = ~seed;
-    ImU32 crc = seed;
-    const unsigned char* current = (const unsigned char*)data;
+    const ImU32 (*t)[256] = GCrc32cTable;
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        const ImU32 lo = crc ^ ((ImU32)data[0] | ((ImU32)data[1] << 8) | ((ImU32)data[2] << 16) | ((ImU32)data[3] << 24));
+        const ImU32 hi = (ImU32)data[4] | ((ImU32)data[5] << 8) | ((ImU32)data[6] << 16) | ((ImU32)data[7] << 24);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    while (size--)
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    return crc;
+}
 
-    if (data_size > 0)
+#ifdef IMGUI_HASH_SSE42
+#if defined(__GNUC__) && !defined(__SSE4_2__)
+#define IMGUI_SSE42_FUNCTION __attribute__((target("sse4.2")))
+#else
+#define IMGUI_SSE42_FUNCTION
+#endif
+
+IMGUI_SSE42_FUNCTION static ImU32 ImCrc32cHardware(ImU32 crc, const unsigned char* data, size_t size)
+{
+#if defined(_M_X64) || defined(__x86_64__)
+    ImU64 crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8)
     {
-        // Known size
-        while (data_size--)
-            crc = (crc >> 8) ^ crc32_lut[(crc & 0xFF) ^ *current++];
+        ImU64 v;
+        memcpy(&v, data, 8);
+        crc64 = _mm_crc32_u64(crc64, v);
     }
-    else
+    crc = (ImU32)crc64;
+#endif
+    for (; size >= 4; data += 4, size -= 4)
     {
-        // Zero-terminated string
-        while (unsigned char c = *current++)
-        {
-            // We support a syntax of "label###id" where only "###id" is included in the hash, and only "label" gets displayed.
-            // Because this syntax is rarely used we are optimizing for the common case.
-            // - If we reach ### in the string we discard the hash so far and reset to the seed.
-            // - We don't do 'current += 2; continue;' after handling ### to keep the code smaller.
-            if (c == '#' && current[0] == '#' && current[1] == '#')
-                crc = seed;
-            crc = (crc >> 8) ^ crc32_lut[(crc & 0xFF) ^ c];
-        }
+        unsigned int v;
+        memcpy(&v, data, 4);
+        crc = _mm_crc32_u32(crc, v);
     }
-    return ~crc;
+    while (size--)
+        crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+#endif
+
+static int GHashHardware = -1;
+
+static bool HashHardwareAvailable()
+{
+#if defined(IMGUI_HASH_SSE42) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#elif defined(IMGUI_HASH_SSE42)
+    return __builtin_cpu_supports("sse4.2") != 0;
+#else
+    return false;
+#endif
+}
+
+bool ImGui::GetHashHardware()
+{
+    if (GHashHardware < 0)
+        GHashHardware = HashHardwareAvailable() ? 1 : 0;
+    return GHashHardware != 0;
+}
+
+void ImGui::SetHashHardware(bool enabled)
+{
+    GHashHardware = (enabled && HashHardwareAvailable()) ? 1 : 0;
+}
+
+// Pass data_size==0 for zero-terminated strings
+ImU32 ImHash(const void* data, int data_size, ImU32 seed)
+{
+    const unsigned char* current = (const unsigned char*)data;
+    size_t size = (size_t)data_size;
+    if (data_size <= 0)
+    {
+        // Zero-terminated string
+        // We support a syntax of "label###id" where only "###id" is included in the hash, and only "label" gets displayed.
+        // The hash restarts from the seed at every ###, so we hash from the last one. Labels rarely contain '#'.
+        size = strlen((const char*)data);
+        const unsigned char* end = current + size;
+        for (const unsigned char* p = (const unsigned char*)memchr(current, '#', size); p != NULL; p = (const unsigned char*)memchr(p + 1, '#', end - p - 1))
+            if (p[1] == '#' && p[2] == '#')
+                current = p;
+        size = end - current;
+    }
+
+    ImU32 crc = ~seed;
+#ifdef IMGUI_HASH_SSE42
+    if (ImGui::GetHashHardware())
+        return ~ImCrc32cHardware(crc, current, size);
+#endif
+    return ~ImCrc32cTables(crc, current, size);
 }
 
 //-----------------------------------------------------------------------------
@@ -1402,6 +1503,90 @@ void* ImFileLoadToMemory(const char* filename, const char* file_open_mode, int*
 // Helper: Key->value storage
 //-----------------------------------------------------------------------------
 
+#ifdef IMGUI_STORAGE_HASH
+
+static inline ImU32 StorageHash(ImGuiID key)
+{
+    // IDs are mostly hashes already, but pointer and integer IDs have poor low bits
+    ImU32 h = key * 0x9E3779B1u;
+    return h ^ (h >> 15);
+}
+
+// Size the index for a load factor of at most 1/2 and reinsert every pair. The first pair wins if a key was pushed twice.
+static void StorageRebuildIndex(ImGuiStorage* storage)
+{
+    int size = 16;
+    while (size < storage->Data.Size * 2)
+        size <<= 1;
+    storage->Index.resize(size);
+    memset(storage->Index.Data, 0xFF, (size_t)size * sizeof(int));
+    const ImU32 mask = (ImU32)size - 1;
+    for (int n = 0; n < storage->Data.Size; n++)
+    {
+        const ImGuiID key = storage->Data[n].key;
+        ImU32 slot = StorageHash(key) & mask;
+        while (storage->Index[slot] >= 0 && storage->Data[storage->Index[slot]].key != key)
+            slot = (slot + 1) & mask;
+        if (storage->Index[slot] < 0)
+            storage->Index[slot] = n;
+    }
+    storage->IndexedCount = storage->Data.Size;
+    storage->IndexedFirstKey = storage->Data.Size ? storage->Data[0].key : 0;
+    storage->IndexedLastKey = storage->Data.Size ? storage->Data.back().key : 0;
+}
+
+// Catches pairs added, removed or replaced behind the index's back, short of rewriting keys in the middle only
+static inline bool StorageIndexValid(const ImGuiStorage* storage)
+{
+    const int size = storage->Data.Size;
+    return storage->Index.Size != 0 && storage->IndexedCount == size
+        && (size == 0 || (storage->Data.Data[0].key == storage->IndexedFirstKey && storage->Data.Data[size - 1].key == storage->IndexedLastKey));
+}
+
+// Returns the pair of 'key', or NULL with *out_slot set to the empty index slot where it would go
+static ImGuiStorage::Pair* StorageFind(ImGuiStorage* storage, ImGuiID key, ImU32* out_slot = NULL)
+{
+    if (!StorageIndexValid(storage))
+        StorageRebuildIndex(storage);
+    const ImU32 mask = (ImU32)storage->Index.Size - 1;
+    ImU32 slot = StorageHash(key) & mask;
+    for (;;)
+    {
+        const int n = storage->Index[slot];
+        if (n < 0)
+            break;
+        if (storage->Data[n].key == key)
+            return &storage->Data[n];
+        slot = (slot + 1) & mask;
+    }
+    if (out_slot)
+        *out_slot = slot;
+    return NULL;
+}
+
+static ImGuiStorage::Pair* StorageFindOrInsert(ImGuiStorage* storage, const ImGuiStorage::Pair& pair)
+{
+    ImU32 slot;
+    if (ImGuiStorage::Pair* found = StorageFind(storage, pair.key, &slot))
+        return found;
+    storage->Data.push_back(pair);
+    if (storage->Data.Size * 2 > storage->Index.Size)
+    {
+        StorageRebuildIndex(storage);
+    }
+    else
+    {
+        storage->Index[slot] = storage->Data.Size - 1;
+        storage->IndexedCount++;
+        storage->IndexedLastKey = pair.key;
+        if (storage->Data.Size == 1)
+            storage->IndexedFirstKey = pair.key;
+    }
+    return &storage->Data.back();
+}
+
+#else
+
 // std::lower_bound but without the bullshit
 static ImVector<ImGuiStorage::Pair>::iterator LowerBound(ImVector<ImGuiStorage::Pair>& data, ImGuiID key)
 {
@@ -1425,6 +1610,24 @@ static ImVector<ImGuiStorage::Pair>::iterator LowerBound(ImVector<ImGuiStorage::
     return first;
 }
 
+static ImGuiStorage::Pair* StorageFind(ImGuiStorage* storage, ImGuiID key)
+{
+    ImVector<ImGuiStorage::Pair>::iterator it = LowerBound(storage->Data, key);
+    if (it == storage->Data.end() || it->key != key)
+        return NULL;
+    return it;
+}
+
+static ImGuiStorage::Pair* StorageFindOrInsert(ImGuiStorage* storage, const ImGuiStorage::Pair& pair)
+{
+    ImVector<ImGuiStorage::Pair>::iterator it = LowerBound(storage->Data, pair.key);
+    if (it == storage->Data.end() || it->key != pair.key)
+        it = storage->Data.insert(it, pair);
+    return it;
+}
+
+#endif // IMGUI_STORAGE_HASH
+
 // For quicker full rebuild of a storage (instead of an incremental one), you may add all your contents and then sort once.
 void ImGuiStorage::BuildSortByKey()
 {
@@ -1440,14 +1643,15 @@ void ImGuiStorage::BuildSortByKey()
     };
     if (Data.Size > 1)
         qsort(Data.Data, (size_t)Data.Size, sizeof(Pair), StaticFunc::PairCompareByID);
+#ifdef IMGUI_STORAGE_HASH
+    IndexedCount = -1; // Pairs moved
+#endif
 }
 
 int ImGuiStorage::GetInt(ImGuiID key, int default_val) const
 {
-    ImVector<Pair>::iterator it = LowerBound(const_cast<ImVector<ImGuiStorage::Pair>&>(Data), key);
-    if (it == Data.end() || it->key != key)
-        return default_val;
-    return it->val_i;
+    const Pair* it = StorageFind(const_cast<ImGuiStorage*>(this), key);
+    return it ? it->val_i : default_val;
 }
 
 bool ImGuiStorage::GetBool(ImGuiID key, bool default_val) const
@@ -1457,27 +1661,20 @@ bool ImGuiStorage::GetBool(ImGuiID key, bool default_val) const
 
 float ImGuiStorage::GetFloat(ImGuiID key, float default_val) const
 {
-    ImVector<Pair>::iterator it = LowerBound(const_cast<ImVector<ImGuiStorage::Pair>&>(Data), key);
-    if (it == Data.end() || it->key != key)
-        return default_val;
-    return it->val_f;
+    const Pair* it = StorageFind(const_cast<ImGuiStorage*>(this), key);
+    return it ? it->val_f : default_val;
 }
 
 void* ImGuiStorage::GetVoidPtr(ImGuiID key) const
 {
-    ImVector<Pair>::iterator it = LowerBound(const_cast<ImVector<ImGuiStorage::Pair>&>(Data), key);
-    if (it == Data.end() || it->key != key)
-        return NULL;
-    return it->val_p;
+    const Pair* it = StorageFind(const_cast<ImGuiStorage*>(this), key);
+    return it ? it->val_p : NULL;
 }
 
 // References are only valid until a new value is added to the storage. Calling a Set***() function or a Get***Ref() function invalidates the pointer.
 int* ImGuiStorage::GetIntRef(ImGuiID key, int default_val)
 {
-    ImVector<Pair>::iterator it = LowerBound(Data, key);
-    if (it == Data.end() || it->key != key)
-        it = Data.insert(it, Pair(key, default_val));
-    return &it->val_i;
+    return &StorageFindOrInsert(this, Pair(key, default_val))->val_i;
 }
 
 bool* ImGuiStorage::GetBoolRef(ImGuiID key, bool default_val)
@@ -1487,30 +1684,18 @@ bool* ImGuiStorage::GetBoolRef(ImGuiID key, bool default_val)
 
 float* ImGuiStorage::GetFloatRef(ImGuiID key, float default_val)
 {
-    ImVector<Pair>::iterator it = LowerBound(Data, key);
-    if (it == Data.end() || it->key != key)
-        it = Data.insert(it, Pair(key, default_val));
-    return &it->val_f;
+    return &StorageFindOrInsert(this, Pair(key, default_val))->val_f;
 }
 
 void** ImGuiStorage::GetVoidPtrRef(ImGuiID key, void* default_val)
 {
-    ImVector<Pair>::iterator it = LowerBound(Data, key);
-    if (it == Data.end() || it->key != key)
-        it = Data.insert(it, Pair(key, default_val));
-    return &it->val_p;
+    return &StorageFindOrInsert(this, Pair(key, default_val))->val_p;
 }
 
 // FIXME-OPT: Need a way to reuse the result of lower_bound when doing GetInt()/SetInt() - not too bad because it only happens on explicit interaction (maximum one a frame)
 void ImGuiStorage::SetInt(ImGuiID key, int val)
 {
-    ImVector<Pair>::iterator it = LowerBound(Data, key);
-    if (it == Data.end() || it->key != key)
-    {
-        Data.insert(it, Pair(key, val));
-        return;
-    }
-    it->val_i = val;
+    StorageFindOrInsert(this, Pair(key, val))->val_i = val;
 }
 
 void ImGuiStorage::SetBool(ImGuiID key, bool val)
@@ -1520,24 +1705,12 @@ void ImGuiStorage::SetBool(ImGuiID key, bool val)
 
 void ImGuiStorage::SetFloat(ImGuiID key, float val)
 {
-    ImVector<Pair>::iterator it = LowerBound(Data, key);
-    if (it == Data.end() || it->key != key)
-    {
-        Data.insert(it, Pair(key, val));
-        return;
-    }
-    it->val_f = val;
+    StorageFindOrInsert(this, Pair(key, val))->val_f = val;
 }
 
 void ImGuiStorage::SetVoidPtr(ImGuiID key, void* val)
 {
-    ImVector<Pair>::iterator it = LowerBound(Data, key);
-    if (it == Data.end() || it->key != key)
-    {
-        Data.insert(it, Pair(key, val));
-        return;
-    }
-    it->val_p = val;
+    StorageFindOrInsert(this, Pair(key, val))->val_p = val;
 }
 
 void ImGuiStorage::SetAllInt(int v)
@@ -1868,6 +2041,14 @@ ImGuiWindow::ImGuiWindow(const char* name)
     FocusIdxAllCounter = FocusIdxTabCounter = -1;
     FocusIdxAllRequestCurrent = FocusIdxTabRequestCurrent = INT_MAX;
     FocusIdxAllRequestNext = FocusIdxTabRequestNext = INT_MAX;
+#ifdef IMGUI_WINDOW_HOVER_GRID
+    HoverOrder = 0;
+    HoverCellMinX = HoverCellMinY = 0;
+    HoverCellMaxX = HoverCellMaxY = -1;
+#endif
+#ifdef IMGUI_ASYNC_INI_SAVE
+    SettingsIdx = -1;
+#endif
 }
 
 ImGuiWindow::~ImGuiWindow()
@@ -2580,6 +2761,16 @@ void ImGui::Initialize()
     // Load .ini file
     IM_ASSERT(g.SettingsWindows.empty());
     LoadIniSettingsFromDisk(g.IO.IniFilename);
+#ifdef IMGUI_ASYNC_INI_SAVE
+    // Hand the loaded entries to the writer now, so the saves during the session only format what changes
+    for (int i = 0; i < g.SettingsWindows.Size; i++)
+    {
+        g.SettingsWindows[i].Dirty = true;
+        g.SettingsDirty.push_back(i);
+    }
+    if (g.IO.IniFilename)
+        QueueIniSettings(g.IO.IniFilename, false);
+#endif
     g.Initialized = true;
 }
 
@@ -2596,7 +2787,16 @@ void ImGui::Shutdown()
     if (!g.Initialized)
         return;
 
+#ifdef IMGUI_ASYNC_INI_SAVE
+    // Windows not begun since they last changed (e.g. SetWindowPos() by name) are only picked up here
+    for (int i = 0; i < g.Windows.Size; i++)
+        SyncIniSettings(g.Windows[i]);
+    SaveIniSettingsToDisk(g.IO.IniFilename);
+    StopIniWriter();
+    g.SettingsDirty.clear();
+#else
     SaveIniSettingsToDisk(g.IO.IniFilename);
+#endif
 
     for (int i = 0; i < g.Windows.Size; i++)
     {
@@ -2605,6 +2805,13 @@ void ImGui::Shutdown()
     }
     g.Windows.clear();
     g.WindowsSortBuffer.clear();
+#ifdef IMGUI_WINDOW_HOVER_GRID
+    g.WindowsHoverGrid.Cells.clear();
+    g.WindowsHoverGrid.Nodes.clear();
+    g.WindowsHoverGrid.CellsX = g.WindowsHoverGrid.CellsY = 0;
+    g.WindowsHoverGrid.FreeNode = -1;
+    g.WindowsHoverGrid.OrderDirty = true;
+#endif
     g.CurrentWindow = NULL;
     g.CurrentWindowStack.clear();
     g.WindowsById.Clear();
@@ -2746,6 +2953,9 @@ static void SaveIniSettingsToDisk(const char* ini_filename)
     if (!ini_filename)
         return;
 
+#ifdef IMGUI_ASYNC_INI_SAVE
+    QueueIniSettings(ini_filename, true);
+#else
     ImVector<char> buf;
     SaveIniSettingsToMemory(buf);
 
@@ -2754,6 +2964,7 @@ static void SaveIniSettingsToDisk(const char* ini_filename)
         return;
     fwrite(buf.Data, sizeof(char), (size_t)buf.Size, f);
     fclose(f);
+#endif
 }
 
 static void SaveIniSettingsToMemory(ImVector<char>& out_buf)
@@ -2784,6 +2995,228 @@ static void MarkIniSettingsDirty(ImGuiWindow* window)
             g.SettingsDirtyTimer = g.IO.IniSavingRate;
 }
 
+#ifdef IMGUI_ASYNC_INI_SAVE
+// Asynchronous .ini saving
+// - Begin() copies a window's position/size/collapsed state into its settings entry when it changes and lists the entry in g.SettingsDirty.
+// - A save formats only the listed entries (same text as SettingsHandlerWindow_WriteAll) and hands them to a background thread, so its cost
+//   on the UI thread is O(changed entries). Other settings handlers are small and written whole.
+// - The writer keeps the text of every entry, indexed like g.SettingsWindows (entries are never removed), and rewrites the file as
+//   "<ini>.tmp" renamed over the .ini: a crash or a full disk never leaves a truncated file. Saves queued while it writes are merged.
+// - The writer allocates with the C++ heap only: ImGui::MemAlloc() and GImGui belong to the UI thread.
+struct ImGuiIniWriter
+{
+    std::thread                 Thread;
+    std::mutex                  Mutex;
+    std::condition_variable     Wake, Idle;
+
+    // Under Mutex
+    std::vector<std::pair<int, std::string> > Pending; // Changed entries, oldest first
+    std::string                 PendingOthers;          // Text of the other settings handlers at the last save
+    std::string                 Filename;
+    bool                        WriteRequested;
+    bool                        Writing;
+    bool                        Quit;
+
+    // Writer thread only
+    std::vector<std::string>    Entries;
+    std::string                 Others;
+    std::string                 Text;
+
+    ImGuiIniWriter() { WriteRequested = Writing = Quit = false; }
+};
+
+static void FormatIniSettings(const ImGuiWindowSettings* settings, std::string& out)
+{
+    out.clear();
+    if (settings->Pos.x == FLT_MAX)
+        return;
+    const char* name = settings->Name;
+    if (const char* p = strstr(name, "###"))  // Skip to the "###" marker if any. We don't skip past to match the behavior of GetID()
+        name = p;
+    char buf[96];
+    ImFormatString(buf, IM_ARRAYSIZE(buf), "Pos=%d,%d\nSize=%d,%d\nCollapsed=%d\n\n", (int)settings->Pos.x, (int)settings->Pos.y, (int)settings->Size.x, (int)settings->Size.y, settings->Collapsed);
+    out.reserve(strlen(name) + strlen(buf) + 12);
+    out += "[Window][";
+    out += name;
+    out += "]\n";
+    out += buf;
+}
+
+// ImFileOpen() without the ImVector, so the writer thread never calls ImGui::MemAlloc()
+static FILE* IniWriterOpen(const std::string& filename)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    std::vector<ImWchar> wfilename((size_t)ImTextCountCharsFromUtf8(filename.c_str(), NULL) + 1);
+    ImTextStrFromUtf8(&wfilename[0], (int)wfilename.size(), filename.c_str(), NULL);
+    return _wfopen((wchar_t*)&wfilename[0], L"wt");
+#else
+    return fopen(filename.c_str(), "wt");
+#endif
+}
+
+static bool IniWriterReplace(const std::string& from, const std::string& to)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    std::vector<ImWchar> wfrom((size_t)ImTextCountCharsFromUtf8(from.c_str(), NULL) + 1), wto((size_t)ImTextCountCharsFromUtf8(to.c_str(), NULL) + 1);
+    ImTextStrFromUtf8(&wfrom[0], (int)wfrom.size(), from.c_str(), NULL);
+    ImTextStrFromUtf8(&wto[0], (int)wto.size(), to.c_str(), NULL);
+    return MoveFileExW((wchar_t*)&wfrom[0], (wchar_t*)&wto[0], MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+static void IniWriterThread(ImGuiIniWriter* w)
+{
+    std::unique_lock<std::mutex> lock(w->Mutex);
+    while (true)
+    {
+        w->Wake.wait(lock, [w]() { return w->WriteRequested || w->Quit; });
+        if (!w->WriteRequested)
+            break;
+        std::vector<std::pair<int, std::string> > changed;
+        changed.swap(w->Pending);
+        w->Others.swap(w->PendingOthers);
+        const std::string filename = w->Filename;
+        w->WriteRequested = false;
+        w->Writing = true;
+        lock.unlock();
+
+        for (size_t i = 0; i < changed.size(); i++)
+        {
+            if (changed[i].first >= (int)w->Entries.size())
+                w->Entries.resize((size_t)changed[i].first + 1);
+            w->Entries[(size_t)changed[i].first].swap(changed[i].second);
+        }
+        w->Text.clear();
+        for (size_t i = 0; i < w->Entries.size(); i++)
+            w->Text += w->Entries[i];
+        w->Text += w->Others;
+
+        const std::string temp = filename + ".tmp";
+        if (FILE* f = IniWriterOpen(temp))
+        {
+            bool ok = fwrite(w->Text.data(), sizeof(char), w->Text.size(), f) == w->Text.size();
+            ok &= fclose(f) == 0;
+            if (!ok || !IniWriterReplace(temp, filename))
+                remove(temp.c_str());
+        }
+
+        lock.lock();
+        w->Writing = false;
+        w->Idle.notify_all();
+    }
+}
+
+// Begin(): the window's entry follows its position, size and collapsed state
+static void SyncIniSettings(ImGuiWindow* window)
+{
+    ImGuiContext& g = *GImGui;
+    if (window->Flags & ImGuiWindowFlags_NoSavedSettings)
+        return;
+    if (window->SettingsIdx < 0)
+    {
+        ImGuiWindowSettings* settings = ImGui::FindWindowSettings(window->ID);
+        if (!settings)
+            settings = AddWindowSettings(window->Name);
+        window->SettingsIdx = (int)(settings - g.SettingsWindows.Data);
+    }
+    ImGuiWindowSettings* settings = &g.SettingsWindows[window->SettingsIdx];
+    if (settings->Pos.x == window->Pos.x && settings->Pos.y == window->Pos.y && settings->Size.x == window->SizeFull.x && settings->Size.y == window->SizeFull.y && settings->Collapsed == window->Collapsed)
+        return;
+    settings->Pos = window->Pos;
+    settings->Size = window->SizeFull;
+    settings->Collapsed = window->Collapsed;
+    if (!settings->Dirty)
+    {
+        settings->Dirty = true;
+        g.SettingsDirty.push_back(window->SettingsIdx);
+    }
+}
+
+// Formats the dirty entries and passes them to the writer, which writes the file if 'write'
+static void QueueIniSettings(const char* ini_filename, bool write)
+{
+    ImGuiContext& g = *GImGui;
+    std::vector<std::pair<int, std::string> > changed(g.SettingsDirty.Size);
+    for (int i = 0; i < g.SettingsDirty.Size; i++)
+    {
+        ImGuiWindowSettings* settings = &g.SettingsWindows[g.SettingsDirty[i]];
+        settings->Dirty = false;
+        changed[i].first = g.SettingsDirty[i];
+        FormatIniSettings(settings, changed[i].second);
+    }
+    g.SettingsDirty.resize(0);
+
+    std::string others;
+    if (write)
+    {
+        const ImGuiID window_type_hash = ImHash("Window", 0, 0);
+        ImGuiTextBuffer buf;
+        for (int handler_n = 0; handler_n < g.SettingsHandlers.Size; handler_n++)
+            if (g.SettingsHandlers[handler_n].TypeHash != window_type_hash)
+                g.SettingsHandlers[handler_n].WriteAllFn(g, &buf);
+        others.assign(buf.begin(), (size_t)buf.size());
+    }
+
+    if (!g.SettingsWriter)
+    {
+        g.SettingsWriter = (ImGuiIniWriter*)ImGui::MemAlloc(sizeof(ImGuiIniWriter));
+        IM_PLACEMENT_NEW(g.SettingsWriter) ImGuiIniWriter();
+        g.SettingsWriter->Thread = std::thread(IniWriterThread, g.SettingsWriter);
+    }
+    ImGuiIniWriter* w = g.SettingsWriter;
+    {
+        std::lock_guard<std::mutex> lock(w->Mutex);
+        const size_t first = w->Pending.size();
+        w->Pending.resize(first + changed.size());
+        for (size_t i = 0; i < changed.size(); i++)
+        {
+            w->Pending[first + i].first = changed[i].first;
+            w->Pending[first + i].second.swap(changed[i].second);
+        }
+        if (write)
+        {
+            w->PendingOthers.swap(others);
+            w->Filename = ini_filename;
+            w->WriteRequested = true;
+        }
+    }
+    if (write)
+        w->Wake.notify_one();
+}
+
+// Shutdown(): writes what is queued and ends the thread
+static void StopIniWriter()
+{
+    ImGuiContext& g = *GImGui;
+    ImGuiIniWriter* w = g.SettingsWriter;
+    if (!w)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(w->Mutex);
+        w->Quit = true;
+    }
+    w->Wake.notify_one();
+    w->Thread.join();
+    w->~ImGuiIniWriter();
+    ImGui::MemFree(w);
+    g.SettingsWriter = NULL;
+}
+#endif
+
+void ImGui::WaitIniSettingsSaved()
+{
+#ifdef IMGUI_ASYNC_INI_SAVE
+    ImGuiContext& g = *GImGui;
+    if (ImGuiIniWriter* w = g.SettingsWriter)
+    {
+        std::unique_lock<std::mutex> lock(w->Mutex);
+        w->Idle.wait(lock, [w]() { return !w->WriteRequested && !w->Writing; });
+    }
+#endif
+}
+
 // FIXME: Add a more explicit sort order in the window structure.
 static int ChildWindowComparer(const void* lhs, const void* rhs)
 {
@@ -2798,6 +3231,9 @@ static int ChildWindowComparer(const void* lhs, const void* rhs)
 
 static void AddWindowToSortedBuffer(ImVector<ImGuiWindow*>& out_sorted_windows, ImGuiWindow* window)
 {
+#ifdef IMGUI_WINDOW_HOVER_GRID
+    window->HoverOrder = out_sorted_windows.Size;
+#endif
     out_sorted_windows.push_back(window);
     if (window->Active)
     {
@@ -2970,6 +3406,9 @@ void ImGui::EndFrame()
 
     IM_ASSERT(g.Windows.Size == g.WindowsSortBuffer.Size);  // we done something wrong
     g.Windows.swap(g.WindowsSortBuffer);
+#ifdef IMGUI_WINDOW_HOVER_GRID
+    g.WindowsHoverGrid.OrderDirty = false;
+#endif
 
     // Clear Input data for next frame
     g.IO.MouseWheel = 0.0f;
@@ -3362,11 +3801,123 @@ void ImGui::CalcListClipping(int items_count, float items_height, int* out_items
     *out_items_display_end = end;
 }
 
+#ifdef IMGUI_WINDOW_HOVER_GRID
+static void HoverGridCell(const ImGuiWindowHoverGrid& grid, ImVec2 pos, int* out_x, int* out_y)
+{
+    // Clamp before converting: pos may be -FLT_MAX (no mouse). NaN goes to cell 0.
+    const float x = pos.x / grid.CellSize, y = pos.y / grid.CellSize;
+    *out_x = x > 0.0f ? (int)ImMin(x, (float)(grid.CellsX - 1)) : 0;
+    *out_y = y > 0.0f ? (int)ImMin(y, (float)(grid.CellsY - 1)) : 0;
+}
+
+static void HoverGridUnlink(ImGuiWindowHoverGrid& grid, ImGuiWindow* window)
+{
+    for (int y = window->HoverCellMinY; y <= window->HoverCellMaxY; y++)
+        for (int x = window->HoverCellMinX; x <= window->HoverCellMaxX; x++)
+            for (int* link = &grid.Cells[y * grid.CellsX + x]; *link != -1; link = &grid.Nodes[*link].Next)
+                if (grid.Nodes[*link].Window == window)
+                {
+                    const int n = *link;
+                    *link = grid.Nodes[n].Next;
+                    grid.Nodes[n].Next = grid.FreeNode;
+                    grid.FreeNode = n;
+                    break;
+                }
+}
+
+// Called by Begin() once WindowRectClipped is set. Windows which didn't change cells are left alone.
+static void HoverGridUpdateWindow(ImGuiWindow* window)
+{
+    ImGuiWindowHoverGrid& grid = GImGui->WindowsHoverGrid;
+    if (grid.CellsX == 0)
+        return; // Not built yet, the first FindHoveredWindow() lists every window
+    int x0, y0, x1, y1;
+    HoverGridCell(grid, window->WindowRectClipped.Min - grid.Padding, &x0, &y0);
+    HoverGridCell(grid, window->WindowRectClipped.Max + grid.Padding, &x1, &y1);
+    if (x0 == window->HoverCellMinX && y0 == window->HoverCellMinY && x1 == window->HoverCellMaxX && y1 == window->HoverCellMaxY)
+        return;
+
+    HoverGridUnlink(grid, window);
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+        {
+            int n = grid.FreeNode;
+            if (n != -1)
+                grid.FreeNode = grid.Nodes[n].Next;
+            else
+            {
+                n = grid.Nodes.Size;
+                grid.Nodes.resize(n + 1);
+            }
+            int& head = grid.Cells[y * grid.CellsX + x];
+            grid.Nodes[n].Window = window;
+            grid.Nodes[n].Next = head;
+            head = n;
+        }
+    window->HoverCellMinX = x0; window->HoverCellMinY = y0;
+    window->HoverCellMaxX = x1; window->HoverCellMaxY = y1;
+}
+
+// Relist every window when the display size or TouchExtraPadding changed, renumber HoverOrder when g.Windows was reordered since EndFrame()
+static void HoverGridValidate()
+{
+    ImGuiContext& g = *GImGui;
+    ImGuiWindowHoverGrid& grid = g.WindowsHoverGrid;
+    const int cells_x = (int)ImClamp(g.IO.DisplaySize.x / grid.CellSize + 1.0f, 1.0f, 256.0f);
+    const int cells_y = (int)ImClamp(g.IO.DisplaySize.y / grid.CellSize + 1.0f, 1.0f, 256.0f);
+    if (cells_x != grid.CellsX || cells_y != grid.CellsY || grid.Padding.x != g.Style.TouchExtraPadding.x || grid.Padding.y != g.Style.TouchExtraPadding.y)
+    {
+        grid.CellsX = cells_x;
+        grid.CellsY = cells_y;
+        grid.Padding = g.Style.TouchExtraPadding;
+        grid.Cells.resize(cells_x * cells_y);
+        memset(grid.Cells.Data, 0xFF, (size_t)grid.Cells.Size * sizeof(int));
+        grid.Nodes.resize(0);
+        grid.FreeNode = -1;
+        for (int i = 0; i != g.Windows.Size; i++)
+        {
+            ImGuiWindow* window = g.Windows[i];
+            window->HoverCellMinX = window->HoverCellMinY = 0;
+            window->HoverCellMaxX = window->HoverCellMaxY = -1;
+            HoverGridUpdateWindow(window);
+        }
+    }
+    if (grid.OrderDirty)
+    {
+        for (int i = 0; i != g.Windows.Size; i++)
+            g.Windows[i]->HoverOrder = i;
+        grid.OrderDirty = false;
+    }
+}
+#endif
+
 // Find window given position, search front-to-back
+// With IMGUI_WINDOW_HOVER_GRID only the windows listed in the cell of pos are tested, and the front-most hit (highest HoverOrder) is the same window the scan finds.
 // FIXME: Note that we have a lag here because WindowRectClipped is updated in Begin() so windows moved by user via SetWindowPos() and not SetNextWindowPos() will have that rectangle lagging by a frame at the time FindHoveredWindow() is called, aka before the next Begin(). Moving window thankfully isn't affected.
-static ImGuiWindow* FindHoveredWindow(ImVec2 pos)
+ImGuiWindow* ImGui::FindHoveredWindow(ImVec2 pos)
 {
     ImGuiContext& g = *GImGui;
+#ifdef IMGUI_WINDOW_HOVER_GRID
+    HoverGridValidate();
+    const ImGuiWindowHoverGrid& grid = g.WindowsHoverGrid;
+    int cell_x, cell_y;
+    HoverGridCell(grid, pos, &cell_x, &cell_y);
+    ImGuiWindow* hovered = NULL;
+    for (int n = grid.Cells[cell_y * grid.CellsX + cell_x]; n != -1; n = grid.Nodes[n].Next)
+    {
+        ImGuiWindow* window = grid.Nodes[n].Window;
+        if (hovered && window->HoverOrder < hovered->HoverOrder)
+            continue;
+        if (!window->Active)
+            continue;
+        if (window->Flags & ImGuiWindowFlags_NoInputs)
+            continue;
+        ImRect bb(window->WindowRectClipped.Min - g.Style.TouchExtraPadding, window->WindowRectClipped.Max + g.Style.TouchExtraPadding);
+        if (bb.Contains(pos))
+            hovered = window;
+    }
+    return hovered;
+#else
     for (int i = g.Windows.Size - 1; i >= 0; i--)
     {
         ImGuiWindow* window = g.Windows[i];
@@ -3381,6 +3932,7 @@ static ImGuiWindow* FindHoveredWindow(ImVec2 pos)
             return window;
     }
     return NULL;
+#endif
 }
 
 // Test if mouse cursor is hovering given rectangle
@@ -4157,6 +4709,9 @@ static ImGuiWindow* CreateNewWindow(const char* name, ImVec2 size, ImGuiWindowFl
 
         if (ImGuiWindowSettings* settings = ImGui::FindWindowSettings(window->ID))
         {
+#ifdef IMGUI_ASYNC_INI_SAVE
+            window->SettingsIdx = (int)(settings - g.SettingsWindows.Data);
+#endif
             SetWindowConditionAllowFlags(window, ImGuiCond_FirstUseEver, false);
             window->PosFloat = settings->Pos;
             window->Pos = ImVec2((float)(int)window->PosFloat.x, (float)(int)window->PosFloat.y);
@@ -4185,6 +4740,9 @@ static ImGuiWindow* CreateNewWindow(const char* name, ImVec2 size, ImGuiWindowFl
         g.Windows.insert(g.Windows.begin(), window); // Quite slow but rare and only once
     else
         g.Windows.push_back(window);
+#ifdef IMGUI_WINDOW_HOVER_GRID
+    g.WindowsHoverGrid.OrderDirty = true;
+#endif
     return window;
 }
 
@@ -4897,6 +5455,12 @@ bool ImGui::Begin(const char* name, bool* p_open, ImGuiWindowFlags flags)
         // Save clipped aabb so we can access it in constant-time in FindHoveredWindow()
         window->WindowRectClipped = window->Rect();
         window->WindowRectClipped.ClipWith(window->ClipRect);
+#ifdef IMGUI_WINDOW_HOVER_GRID
+        HoverGridUpdateWindow(window);
+#endif
+#ifdef IMGUI_ASYNC_INI_SAVE
+        SyncIniSettings(window);
+#endif
 
         // Pressing CTRL+C while holding on a window copy its content to the clipboard
         // This works but 1. doesn't handle multiple Begin/End pairs, 2. recursing into another Begin/End pair - so we need to work that out and add better logging scope.
@@ -5130,6 +5694,9 @@ void ImGui::BringWindowToFront(ImGuiWindow* window)
         {
             g.Windows.erase(g.Windows.begin() + i);
             g.Windows.push_back(window);
+#ifdef IMGUI_WINDOW_HOVER_GRID
+            g.WindowsHoverGrid.OrderDirty = true;
+#endif
             break;
         }
 }
@@ -5144,6 +5711,9 @@ void ImGui::BringWindowToBack(ImGuiWindow* window)
         {
             memmove(&g.Windows[1], &g.Windows[0], (size_t)i * sizeof(ImGuiWindow*));
             g.Windows[0] = window;
+#ifdef IMGUI_WINDOW_HOVER_GRID
+            g.WindowsHoverGrid.OrderDirty = true;
+#endif
             break;
         }
 }
@@ -7968,6 +8538,208 @@ void ImGui::PlotHistogram(const char* label, float (*values_getter)(void* data,
     PlotEx(ImGuiPlotType_Histogram, label, values_getter, data, values_count, values_offset, overlay_text, scale_min, scale_max, graph_size);
 }
 
+void ImGuiPlotSeries::Reserve(int capacity)
+{
+    Values.reserve(capacity);
+    for (int level = 0; level < IM_PLOT_SERIES_LEVELS; level++)
+        Levels[level].reserve(((capacity - 1) >> (level + IM_PLOT_SERIES_BLOCK_SHIFT)) + 1);
+}
+
+void ImGuiPlotSeries::Clear()
+{
+    Values.clear();
+    for (int level = 0; level < IM_PLOT_SERIES_LEVELS; level++)
+        Levels[level].clear();
+}
+
+void ImGuiPlotSeries::Append(float v)
+{
+    const int idx = Values.Size;
+    Values.push_back(v);
+    for (int level = 0; level < IM_PLOT_SERIES_LEVELS; level++)
+    {
+        ImVector<ImVec2>& blocks = Levels[level];
+        const int block = idx >> (level + IM_PLOT_SERIES_BLOCK_SHIFT);
+        if (block == blocks.Size)
+        {
+            blocks.push_back(ImVec2(v, v));
+            continue;
+        }
+        ImVec2& min_max = blocks[block];
+        if (v >= min_max.x && v <= min_max.y)
+            break;  // The blocks above contain this one, they already cover v
+        min_max.x = ImMin(min_max.x, v);
+        min_max.y = ImMax(min_max.y, v);
+    }
+}
+
+ImVec2 ImGuiPlotSeries::GetMinMax(int first, int last) const
+{
+    IM_ASSERT(first >= 0 && last <= Values.Size);
+    ImVec2 r(FLT_MAX, -FLT_MAX);
+    int i = first;
+    while (i < last)
+    {
+        // Largest block starting at i that ends before 'last'
+        int level = -1;
+        while (level + 1 < IM_PLOT_SERIES_LEVELS)
+        {
+            const int block_size = 1 << (level + 1 + IM_PLOT_SERIES_BLOCK_SHIFT);
+            if ((i & (block_size - 1)) != 0 || last - i < block_size)
+                break;
+            level++;
+        }
+        if (level < 0)
+        {
+            r.x = ImMin(r.x, Values[i]);
+            r.y = ImMax(r.y, Values[i]);
+            i++;
+        }
+        else
+        {
+            const int shift = level + IM_PLOT_SERIES_BLOCK_SHIFT;
+            const ImVec2& min_max = Levels[level][i >> shift];
+            r.x = ImMin(r.x, min_max.x);
+            r.y = ImMax(r.y, min_max.y);
+            i += 1 << shift;
+        }
+    }
+    return r;
+}
+
+// Each pixel column shows the min and max of its values, taken from the pyramid level whose blocks are no larger than a column.
+// Inner column boundaries are rounded down to that block size, so a column reads 1 to 3 blocks whatever the number of values.
+void ImGui::PlotSeriesEx(ImGuiPlotType plot_type, const char* label, const ImGuiPlotSeries& series, int values_first, int values_count, const char* overlay_text, float scale_min, float scale_max, ImVec2 graph_size)
+{
+    ImGuiWindow* window = GetCurrentWindow();
+    if (window->SkipItems)
+        return;
+
+    ImGuiContext& g = *GImGui;
+    const ImGuiStyle& style = g.Style;
+
+    if (values_count < 0)
+        values_count = series.Size() - values_first;
+    IM_ASSERT(values_first >= 0 && values_count >= 0 && values_first + values_count <= series.Size());
+
+    if (graph_size.x == 0.0f)
+        graph_size.x = CalcItemWidth();
+    const int res_w = (int)(graph_size.x - style.FramePadding.x * 2);
+    if (values_count <= res_w || res_w <= 0)
+    {
+        // No more values than pixels: nothing to decimate
+        ImGuiPlotArrayGetterData data(series.Values.Data + values_first, sizeof(float));
+        PlotEx(plot_type, label, &Plot_ArrayGetter, (void*)&data, values_count, 0, overlay_text, scale_min, scale_max, graph_size);
+        return;
+    }
+
+    const ImVec2 label_size = CalcTextSize(label, NULL, true);
+    if (graph_size.y == 0.0f)
+        graph_size.y = label_size.y + (style.FramePadding.y * 2);
+
+    const ImRect frame_bb(window->DC.CursorPos, window->DC.CursorPos + ImVec2(graph_size.x, graph_size.y));
+    const ImRect inner_bb(frame_bb.Min + style.FramePadding, frame_bb.Max - style.FramePadding);
+    const ImRect total_bb(frame_bb.Min, frame_bb.Max + ImVec2(label_size.x > 0.0f ? style.ItemInnerSpacing.x + label_size.x : 0.0f, 0));
+    ItemSize(total_bb, style.FramePadding.y);
+    if (!ItemAdd(total_bb, 0))
+        return;
+    const bool hovered = ItemHoverable(inner_bb, 0);
+
+    const int values_last = values_first + values_count;
+    if (scale_min == FLT_MAX || scale_max == FLT_MAX)
+    {
+        const ImVec2 min_max = series.GetMinMax(values_first, values_last);
+        if (scale_min == FLT_MAX)
+            scale_min = min_max.x;
+        if (scale_max == FLT_MAX)
+            scale_max = min_max.y;
+    }
+    const float scale_inv = (scale_max != scale_min) ? 1.0f / (scale_max - scale_min) : 0.0f;
+
+    RenderFrame(frame_bb.Min, frame_bb.Max, GetColorU32(ImGuiCol_FrameBg), true, style.FrameRounding);
+
+    // Largest block size not above the values per column
+    int shift = 0;
+    while ((2 << shift) <= values_count / res_w)
+        shift++;
+    const int level = shift - IM_PLOT_SERIES_BLOCK_SHIFT;
+
+    int n_hovered = -1;
+    if (hovered)
+        n_hovered = ImClamp((int)((g.IO.MousePos.x - inner_bb.Min.x) * res_w / inner_bb.GetWidth()), 0, res_w - 1);
+
+    const ImU32 col_base = GetColorU32((plot_type == ImGuiPlotType_Lines) ? ImGuiCol_PlotLines : ImGuiCol_PlotHistogram);
+    const ImU32 col_hovered = GetColorU32((plot_type == ImGuiPlotType_Lines) ? ImGuiCol_PlotLinesHovered : ImGuiCol_PlotHistogramHovered);
+    const float histogram_zero_line_t = (scale_min * scale_max < 0.0f) ? (-scale_min / (scale_max - scale_min)) : (scale_min < 0.0f ? 0.0f : 1.0f);
+    const float zero_y = ImLerp(inner_bb.Min.y, inner_bb.Max.y, histogram_zero_line_t);
+
+    int idx0 = values_first;
+    float prev_y_min = 0.0f, prev_y_max = 0.0f;
+    for (int n = 0; n < res_w; n++)
+    {
+        const int idx1 = (n + 1 == res_w) ? values_last : (values_first + (int)((ImU64)(n + 1) * values_count / res_w)) >> shift << shift;
+
+        ImVec2 min_max;
+        if (n == 0 || n + 1 == res_w)
+        {
+            min_max = series.GetMinMax(idx0, idx1);     // Unaligned ends
+        }
+        else if (level < 0)
+        {
+            min_max = ImVec2(FLT_MAX, -FLT_MAX);
+            for (int i = idx0; i < idx1; i++)
+                min_max = ImVec2(ImMin(min_max.x, series.Values[i]), ImMax(min_max.y, series.Values[i]));
+        }
+        else
+        {
+            const ImVec2* blocks = series.Levels[level].Data;
+            min_max = blocks[idx0 >> shift];
+            for (int b = (idx0 >> shift) + 1; b < (idx1 >> shift); b++)
+                min_max = ImVec2(ImMin(min_max.x, blocks[b].x), ImMax(min_max.y, blocks[b].y));
+        }
+
+        if (n == n_hovered)
+            SetTooltip("%d..%d: %8.4g .. %8.4g", idx0 - values_first, idx1 - 1 - values_first, min_max.x, min_max.y);
+
+        const float x0 = ImLerp(inner_bb.Min.x, inner_bb.Max.x, (float)n / res_w);
+        const float x1 = ImLerp(inner_bb.Min.x, inner_bb.Max.x, (float)(n + 1) / res_w);
+        const float y_min = ImLerp(inner_bb.Min.y, inner_bb.Max.y, 1.0f - ImSaturate((min_max.x - scale_min) * scale_inv));
+        const float y_max = ImLerp(inner_bb.Min.y, inner_bb.Max.y, 1.0f - ImSaturate((min_max.y - scale_min) * scale_inv));
+        const ImU32 col = (n == n_hovered) ? col_hovered : col_base;
+        if (plot_type == ImGuiPlotType_Lines)
+        {
+            // A vertical span per column, stretched to touch the previous one so the trace stays connected
+            const float y0 = (n > 0) ? ImMin(y_max, prev_y_min) : y_max;
+            const float y1 = (n > 0) ? ImMax(y_min, prev_y_max) : y_min;
+            window->DrawList->AddRectFilled(ImVec2(x0, y0), ImVec2(ImMax(x1, x0 + 1.0f), ImMax(y1, y0 + 1.0f)), col);
+            prev_y_min = y_min;
+            prev_y_max = y_max;
+        }
+        else if (plot_type == ImGuiPlotType_Histogram)
+        {
+            window->DrawList->AddRectFilled(ImVec2(x0, ImMin(y_max, zero_y)), ImVec2(ImMax(x1, x0 + 1.0f), ImMax(y_min, zero_y)), col);
+        }
+        idx0 = idx1;
+    }
+
+    // Text overlay
+    if (overlay_text)
+        RenderTextClipped(ImVec2(frame_bb.Min.x, frame_bb.Min.y + style.FramePadding.y), frame_bb.Max, overlay_text, NULL, NULL, ImVec2(0.5f,0.0f));
+
+    if (label_size.x > 0.0f)
+        RenderText(ImVec2(frame_bb.Max.x + style.ItemInnerSpacing.x, inner_bb.Min.y), label);
+}
+
+void ImGui::PlotLines(const char* label, const ImGuiPlotSeries& series, int values_first, int values_count, const char* overlay_text, float scale_min, float scale_max, ImVec2 graph_size)
+{
+    PlotSeriesEx(ImGuiPlotType_Lines, label, series, values_first, values_count, overlay_text, scale_min, scale_max, graph_size);
+}
+
+void ImGui::PlotHistogram(const char* label, const ImGuiPlotSeries& series, int values_first, int values_count, const char* overlay_text, float scale_min, float scale_max, ImVec2 graph_size)
+{
+    PlotSeriesEx(ImGuiPlotType_Histogram, label, series, values_first, values_count, overlay_text, scale_min, scale_max, graph_size);
+}
+
 // size_arg (for each axis) < 0.0f: align to end, 0.0f: auto, > 0.0f: specified size
 void ImGui::ProgressBar(float fraction, const ImVec2& size_arg, const char* overlay)
 {
@@ -53,6 +53,9 @@ struct ImDrawList;                  // A single draw command list (generally one
 struct ImDrawVert;                  // A single vertex (20 bytes by default, override layout with IMGUI_OVERRIDE_DRAWVERT_STRUCT_LAYOUT)
 struct ImFont;                      // Runtime data for a single font within a parent ImFontAtlas
 struct ImFontAtlas;                 // Runtime data for multiple fonts, bake multiple fonts into a single texture, TTF/OTF font loader
+struct ImFontAtlasGlyphCache;       // Glyphs rasterized on first use (ImFontAtlas::DynamicGlyphs), opaque
+struct ImFontGlyphCache;            // Per-font part of ImFontAtlasGlyphCache, opaque
+struct ImFontTextCache;             // Layout of strings recently measured or drawn with a font (ImFontAtlas::TextLayoutCache), opaque
 struct ImFontConfig;                // Configuration data when adding a font or merging fonts
 struct ImColor;                     // Helper functions to create a color that can be converted to either u32 or float4
 struct ImGuiIO;                     // Main configuration and I/O between your application and ImGui
@@ -64,6 +67,7 @@ struct ImGuiTextBuffer;             // Text buffer for logging/accumulating text
 struct ImGuiTextEditCallbackData;   // Shared state of ImGui::InputText() when using custom ImGuiTextEditCallback (rare/advanced use)
 struct ImGuiSizeConstraintCallbackData;// Structure used to constraint window size in custom ways when using custom ImGuiSizeConstraintCallback (rare/advanced use)
 struct ImGuiListClipper;            // Helper to manually clip large list of items
+struct ImGuiPlotSeries;             // Append-only series of floats with a min/max pyramid, for plotting millions of samples
 struct ImGuiPayload;                // User data payload for drag and drop operations
 struct ImGuiContext;                // ImGui context (opaque)
 
@@ -294,6 +298,8 @@ namespace ImGui
     IMGUI_API void          PlotLines(const char* label, float (*values_getter)(void* data, int idx), void* data, int values_count, int values_offset = 0, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0,0));
     IMGUI_API void          PlotHistogram(const char* label, const float* values, int values_count, int values_offset = 0, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0,0), int stride = sizeof(float));
     IMGUI_API void          PlotHistogram(const char* label, float (*values_getter)(void* data, int idx), void* data, int values_count, int values_offset = 0, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0,0));
+    IMGUI_API void          PlotLines(const char* label, const ImGuiPlotSeries& series, int values_first = 0, int values_count = -1, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0,0));     // plot values [values_first, values_first+values_count) of the series, -1 count: up to the last one. Keeps every peak, cost independent of the count
+    IMGUI_API void          PlotHistogram(const char* label, const ImGuiPlotSeries& series, int values_first = 0, int values_count = -1, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0,0));
     IMGUI_API void          ProgressBar(float fraction, const ImVec2& size_arg = ImVec2(-1,0), const char* overlay = NULL);
 
     // Widgets: Combo Box
@@ -1125,6 +1131,23 @@ struct ImGuiTextBuffer
     IMGUI_API void      appendfv(const char* fmt, va_list args) IM_FMTLIST(2);
 };
 
+// Helper: Append-only series of floats for PlotLines()/PlotHistogram(), e.g. a frame time history of millions of samples.
+// Keeps the min and max of every aligned block of 8, 16, 32... values, updated as values are appended (half a float of extra memory per value),
+// so a plot reads a few blocks per pixel column instead of one value per column: no spike is lost and the cost doesn't depend on the count.
+#define IM_PLOT_SERIES_LEVELS           28      // block sizes 8 << 0 .. 8 << 27, enough for INT_MAX values
+#define IM_PLOT_SERIES_BLOCK_SHIFT      3       // smallest block: 8 values, shorter ranges read Values directly
+struct ImGuiPlotSeries
+{
+    ImVector<float>     Values;
+    ImVector<ImVec2>    Levels[IM_PLOT_SERIES_LEVELS];  // x = min, y = max of the values [i << shift, (i+1) << shift) with shift = level + IM_PLOT_SERIES_BLOCK_SHIFT, the last block of each level is partial
+
+    int                 Size() const { return Values.Size; }
+    IMGUI_API void      Reserve(int capacity);
+    IMGUI_API void      Clear();
+    IMGUI_API void      Append(float v);
+    IMGUI_API ImVec2    GetMinMax(int first, int last) const;     // x = min, y = max of the values [first, last)
+};
+
 // Helper: Simple Key->value storage
 // Typically you don't have to worry about this since a storage is held within each Window.
 // We use it to e.g. store collapse state for a tree (Int 0/1), store color edit options. 
@@ -1144,11 +1167,22 @@ struct ImGuiStorage
         Pair(ImGuiID _key, void* _val_p) { key = _key; val_p = _val_p; }
     };
     ImVector<Pair>      Data;
+#ifdef IMGUI_STORAGE_HASH
+    ImVector<int>       Index;          // Open addressing table of indices into Data (-1: empty), linear probing. Rebuilt on lookup when the size or the first or last key of Data differ from when it was built (e.g. pairs pushed directly, Data cleared and refilled).
+    int                 IndexedCount;   // Set to -1 after direct writes to Data that keep all three (keys rewritten in the middle)
+    ImGuiID             IndexedFirstKey, IndexedLastKey;
+
+    ImGuiStorage()      { IndexedCount = 0; IndexedFirstKey = IndexedLastKey = 0; }
+#endif
 
-    // - Get***() functions find pair, never add/allocate. Pairs are sorted so a query is O(log N)
+    // - Get***() functions find pair, never add/allocate. Pairs are sorted so a query is O(log N). With IMGUI_STORAGE_HASH pairs are in insertion order and a query is O(1).
     // - Set***() functions find pair, insertion on demand if missing.
-    // - Sorted insertion is costly, paid once. A typical frame shouldn't need to insert any new pair.
+    // - Sorted insertion is costly, paid once. A typical frame shouldn't need to insert any new pair. With IMGUI_STORAGE_HASH insertion is amortized O(1).
+#ifdef IMGUI_STORAGE_HASH
+    void                Clear() { Data.clear(); Index.clear(); IndexedCount = -1; }
+#else
     void                Clear() { Data.clear(); }
+#endif
     IMGUI_API int       GetInt(ImGuiID key, int default_val = 0) const;
     IMGUI_API void      SetInt(ImGuiID key, int val);
     IMGUI_API bool      GetBool(ImGuiID key, bool default_val = false) const;
@@ -1540,6 +1574,14 @@ struct ImFontAtlas
     IMGUI_API void              GetTexDataAsRGBA32(unsigned char** out_pixels, int* out_width, int* out_height, int* out_bytes_per_pixel = NULL);  // 4 bytes-per-pixel
     void                        SetTexID(ImTextureID id)    { TexID = id; }
 
+    // Dynamic glyphs: with DynamicGlyphs set, Build() only rasterizes the part of the glyph ranges within GetGlyphRangesDefault() and the
+    // rest is rasterized into the texture the first time FindGlyph() asks for it. Advances are computed up front so text layout is exact.
+    // When the texture is full, the glyph least recently drawn (and not in the current frame) gives its place. The texture has a fixed
+    // size (TexDesiredWidth or 1024, DynamicTexHeight) and is only updated in Alpha8 form: keep TexPixelsAlpha8 and the TTF data alive,
+    // and after each frame upload the area TakeTexDirtyRect() returns.
+    IMGUI_API bool              TakeTexDirtyRect(int* out_x, int* out_y, int* out_w, int* out_h);  // Area of TexPixelsAlpha8 rasterized since the last call, false if none
+    IMGUI_API void              GetGlyphCacheStats(int* out_resident, int* out_rasterized, int* out_evicted);  // Glyphs in the texture now, rasterized and evicted since Build()
+
     //-------------------------------------------
     // Glyph Ranges
     //-------------------------------------------
@@ -1596,6 +1638,10 @@ struct ImFontAtlas
     ImTextureID                 TexID;              // User data to refer to the texture once it has been uploaded to user's graphic systems. It is passed back to you during rendering via the ImDrawCmd structure.
     int                         TexDesiredWidth;    // Texture width desired by user before Build(). Must be a power-of-two. If have many glyphs your graphics API have texture size restrictions you may want to increase texture width to decrease height.
     int                         TexGlyphPadding;    // Padding between glyphs within texture in pixels. Defaults to 1.
+    bool                        DynamicGlyphs;      // Rasterize glyphs on first use instead of in Build(), see TakeTexDirtyRect(). Set before Build(). Defaults to false.
+    int                         DynamicTexHeight;   // Texture height with DynamicGlyphs, 0 for 1024. Must be a power-of-two.
+    bool                        TextLayoutCache;    // Keep the size and glyph quads of strings per (font, size, wrap width, text) so unchanged text is not laid out again. Not used for fonts with DynamicGlyphs. Defaults to false.
+    int                         TextLayoutCacheMaxAge; // Frames a cached string is kept without being measured or drawn. Defaults to 60.
 
     // [Internal]
     // NB: Access texture data via GetTexData*() calls! Which will setup a default font for you.
@@ -1608,6 +1654,7 @@ struct ImFontAtlas
     ImVector<CustomRect>        CustomRects;        // Rectangles for packing custom texture data into the atlas.
     ImVector<ImFontConfig>      ConfigData;         // Internal data
     int                         CustomRectIds[1];   // Identifiers of custom texture rectangle used by ImFontAtlas/ImDrawList
+    ImFontAtlasGlyphCache*      GlyphCache;         // Dynamic glyphs state, NULL unless built with DynamicGlyphs
 };
 
 // Font runtime data and rendering
@@ -1631,6 +1678,8 @@ struct ImFont
     ImFontAtlas*                ContainerAtlas;     //              // What we has been loaded into
     float                       Ascent, Descent;    //              // Ascent: distance from top to bottom of e.g. 'A' [0..FontSize]
     int                         MetricsTotalSurface;//              // Total surface in pixels to get an idea of the font rasterization/texture cost (not exact, we approximate the cost of padding between glyphs)
+    ImFontGlyphCache*           GlyphCache;         //              // Codepoints rasterized on first use, NULL unless ContainerAtlas->DynamicGlyphs
+    ImFontTextCache*            TextCache;          //              // Strings laid out recently, NULL until used with ContainerAtlas->TextLayoutCache
 
     // Methods
     IMGUI_API ImFont();
@@ -1638,6 +1687,7 @@ struct ImFont
     IMGUI_API void              ClearOutputData();
     IMGUI_API void              BuildLookupTable();
     IMGUI_API const ImFontGlyph*FindGlyph(ImWchar c) const;
+    IMGUI_API bool              HasGlyph(ImWchar c) const;  // True when FindGlyph(c) would not fall back. Does not rasterize dynamic glyphs.
     IMGUI_API void              SetFallbackChar(ImWchar c);
     float                       GetCharAdvance(ImWchar c) const     { return ((int)c < IndexAdvanceX.Size) ? IndexAdvanceX[(int)c] : FallbackAdvanceX; }
     bool                        IsLoaded() const                    { return ContainerAtlas != NULL; }
@@ -2119,7 +2119,7 @@ void ImGui::ShowStyleEditor(ImGuiStyle* ref)
                     {
                         int count = 0;
                         for (int n = 0; n < 256; n++)
-                            count += font->FindGlyph((ImWchar)(base + n)) ? 1 : 0;
+                            count += font->HasGlyph((ImWchar)(base + n)) ? 1 : 0;
                         if (count > 0 && ImGui::TreeNode((void*)(intptr_t)base, "U+%04X..U+%04X (%d %s)", base, base+255, count, count > 1 ? "glyphs" : "glyph"))
                         {
                             float cell_spacing = style.ItemSpacing.y;
@@ -2148,7 +2148,7 @@ void ImGui::ShowStyleEditor(ImGuiStyle* ref)
                             ImGui::TreePop();
                         }
                     }
-                    font->FallbackGlyph = glyph_fallback;
+                    font->FallbackGlyph = glyph_fallback != NULL ? font->FindGlyph(font->FallbackChar) : NULL; // Glyphs[] may have grown if dynamic glyphs got rasterized
                     ImGui::TreePop();
                 }
                 ImGui::TreePop();
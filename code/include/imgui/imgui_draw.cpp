@@ -19,6 +19,17 @@
 #include "imgui_internal.h"
 
 #include <stdio.h>      // vsnprintf, sscanf, printf
+#if !defined(IMGUI_DISABLE_SIMD_DRAW) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86))
+#define IMGUI_DRAW_SSE2
+#include <emmintrin.h>  // SSE2 tessellation
+#if defined(_MSC_VER) || defined(__GNUC__)
+#define IMGUI_DRAW_AVX2
+#include <immintrin.h>  // AVX2 tessellation, selected at runtime
+#ifdef _MSC_VER
+#include <intrin.h>     // __cpuid, _xgetbv
+#endif
+#endif
+#endif
 #if !defined(alloca)
 #ifdef _WIN32
 #include <malloc.h>     // alloca
@@ -276,6 +287,218 @@ void ImGui::StyleColorsLight(ImGuiStyle* dst)
     colors[ImGuiCol_DragDropTarget]         = ImVec4(0.26f, 0.59f, 0.98f, 0.95f);
 }
 
+//-----------------------------------------------------------------------------
+// ImDrawList tessellation helpers
+//-----------------------------------------------------------------------------
+// Segment normals and averaged (miter) normals of the anti-aliased AddPolyline()/AddConvexPolyFilled(), 4 (SSE2) or
+// 8 (AVX2) at a time. The vector paths do the same operations in the same order as the scalar ones (true division and
+// sqrt, no rsqrt, no FMA), so all of them produce bit-identical vertices.
+
+static int GDrawSimdLevel = -1;
+
+static int DrawSimdMaxLevel()
+{
+#ifdef IMGUI_DRAW_AVX2
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7)
+    {
+        __cpuid(info, 1);
+        const int avx_osxsave = (1 << 27) | (1 << 28);
+        if ((info[2] & avx_osxsave) == avx_osxsave && (_xgetbv(0) & 6) == 6)
+        {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5))
+                return ImDrawSimd_AVX2;
+        }
+    }
+#else
+    if (__builtin_cpu_supports("avx2"))
+        return ImDrawSimd_AVX2;
+#endif
+#endif
+#ifdef IMGUI_DRAW_SSE2
+    return ImDrawSimd_SSE2;
+#else
+    return ImDrawSimd_Scalar;
+#endif
+}
+
+int ImGui::GetDrawSimdLevel()
+{
+    if (GDrawSimdLevel < 0)
+        GDrawSimdLevel = DrawSimdMaxLevel();
+    return GDrawSimdLevel;
+}
+
+void ImGui::SetDrawSimdLevel(int level)
+{
+    GDrawSimdLevel = ImClamp(level, (int)ImDrawSimd_Scalar, DrawSimdMaxLevel());
+}
+
+// Left normal of the segment p1 -> p2, (0,0) for a degenerate one
+static inline void PolyNormal(const ImVec2& p1, const ImVec2& p2, ImVec2& out)
+{
+    ImVec2 diff = p2 - p1;
+    diff *= ImInvLength(diff, 1.0f);
+    out.x = diff.y;
+    out.y = -diff.x;
+}
+
+// Miter direction at a point from the normals of its two segments
+static inline ImVec2 PolyAverageNormal(const ImVec2& n0, const ImVec2& n1)
+{
+    ImVec2 dm = (n0 + n1) * 0.5f;
+    float dmr2 = dm.x*dm.x + dm.y*dm.y;
+    if (dmr2 > 0.000001f)
+    {
+        float scale = 1.0f / dmr2;
+        if (scale > 100.0f) scale = 100.0f;
+        dm *= scale;
+    }
+    return dm;
+}
+
+#ifdef IMGUI_DRAW_SSE2
+// Two points per register, lanes (x0,y0,x1,y1)
+static inline __m128 PolyNormalSSE2(__m128 p1, __m128 p2)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 negate_y = _mm_castsi128_ps(_mm_set_epi32((int)0x80000000, 0, (int)0x80000000, 0));
+    __m128 diff = _mm_sub_ps(p2, p1);
+    __m128 sq = _mm_mul_ps(diff, diff);
+    __m128 d = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2,3,0,1)));
+    __m128 valid = _mm_cmpgt_ps(d, _mm_setzero_ps());
+    __m128 inv_length = _mm_div_ps(one, _mm_sqrt_ps(d));
+    diff = _mm_mul_ps(diff, _mm_or_ps(_mm_and_ps(valid, inv_length), _mm_andnot_ps(valid, one)));
+    return _mm_xor_ps(_mm_shuffle_ps(diff, diff, _MM_SHUFFLE(2,3,0,1)), negate_y);
+}
+
+static inline __m128 PolyAverageNormalSSE2(__m128 n0, __m128 n1)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 dm = _mm_mul_ps(_mm_add_ps(n0, n1), _mm_set1_ps(0.5f));
+    __m128 sq = _mm_mul_ps(dm, dm);
+    __m128 dmr2 = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2,3,0,1)));
+    __m128 valid = _mm_cmpgt_ps(dmr2, _mm_set1_ps(0.000001f));
+    __m128 scale = _mm_min_ps(_mm_div_ps(one, dmr2), _mm_set1_ps(100.0f));
+    return _mm_mul_ps(dm, _mm_or_ps(_mm_and_ps(valid, scale), _mm_andnot_ps(valid, one)));
+}
+
+// Normals of segments [0, count), segment i going from points[i] to points[i+1]. Returns the number done.
+static int PolyNormalsSSE2(const ImVec2* points, int count, ImVec2* normals)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(&normals[i].x, PolyNormalSSE2(_mm_loadu_ps(&points[i].x), _mm_loadu_ps(&points[i+1].x)));
+        _mm_storeu_ps(&normals[i+2].x, PolyNormalSSE2(_mm_loadu_ps(&points[i+2].x), _mm_loadu_ps(&points[i+3].x)));
+    }
+    return i;
+}
+
+// Miters of points [first, last), see PolyMiters()
+static int PolyMitersSSE2(const ImVec2* normals, int first, int last, ImVec2* miters)
+{
+    int i = first;
+    for (; i + 2 <= last; i += 2)
+        _mm_storeu_ps(&miters[i].x, PolyAverageNormalSSE2(_mm_loadu_ps(&normals[i-1].x), _mm_loadu_ps(&normals[i].x)));
+    return i;
+}
+#endif
+
+#ifdef IMGUI_DRAW_AVX2
+#if defined(__GNUC__) && !defined(__AVX2__)
+#define IMGUI_AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define IMGUI_AVX2_FUNCTION
+#endif
+
+// Four points per register, shuffles stay within 128-bit lanes so the math matches the SSE2 path lane for lane
+IMGUI_AVX2_FUNCTION static inline __m256 PolyNormalAVX2(__m256 p1, __m256 p2)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 negate_y = _mm256_castsi256_ps(_mm256_set_epi32((int)0x80000000, 0, (int)0x80000000, 0, (int)0x80000000, 0, (int)0x80000000, 0));
+    __m256 diff = _mm256_sub_ps(p2, p1);
+    __m256 sq = _mm256_mul_ps(diff, diff);
+    __m256 d = _mm256_add_ps(sq, _mm256_shuffle_ps(sq, sq, _MM_SHUFFLE(2,3,0,1)));
+    __m256 valid = _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GT_OQ);
+    __m256 inv_length = _mm256_div_ps(one, _mm256_sqrt_ps(d));
+    diff = _mm256_mul_ps(diff, _mm256_blendv_ps(one, inv_length, valid));
+    return _mm256_xor_ps(_mm256_shuffle_ps(diff, diff, _MM_SHUFFLE(2,3,0,1)), negate_y);
+}
+
+IMGUI_AVX2_FUNCTION static inline __m256 PolyAverageNormalAVX2(__m256 n0, __m256 n1)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 dm = _mm256_mul_ps(_mm256_add_ps(n0, n1), _mm256_set1_ps(0.5f));
+    __m256 sq = _mm256_mul_ps(dm, dm);
+    __m256 dmr2 = _mm256_add_ps(sq, _mm256_shuffle_ps(sq, sq, _MM_SHUFFLE(2,3,0,1)));
+    __m256 valid = _mm256_cmp_ps(dmr2, _mm256_set1_ps(0.000001f), _CMP_GT_OQ);
+    __m256 scale = _mm256_min_ps(_mm256_div_ps(one, dmr2), _mm256_set1_ps(100.0f));
+    return _mm256_mul_ps(dm, _mm256_blendv_ps(one, scale, valid));
+}
+
+IMGUI_AVX2_FUNCTION static int PolyNormalsAVX2(const ImVec2* points, int count, ImVec2* normals)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(&normals[i].x, PolyNormalAVX2(_mm256_loadu_ps(&points[i].x), _mm256_loadu_ps(&points[i+1].x)));
+        _mm256_storeu_ps(&normals[i+4].x, PolyNormalAVX2(_mm256_loadu_ps(&points[i+4].x), _mm256_loadu_ps(&points[i+5].x)));
+    }
+    return i;
+}
+
+IMGUI_AVX2_FUNCTION static int PolyMitersAVX2(const ImVec2* normals, int first, int last, ImVec2* miters)
+{
+    int i = first;
+    for (; i + 4 <= last; i += 4)
+        _mm256_storeu_ps(&miters[i].x, PolyAverageNormalAVX2(_mm256_loadu_ps(&normals[i-1].x), _mm256_loadu_ps(&normals[i].x)));
+    return i;
+}
+#endif
+
+// normals[i] for the segment points[i] -> points[i+1]; closed adds points[count-1] -> points[0]
+static void PolyNormals(const ImVec2* points, int points_count, bool closed, ImVec2* normals, int level)
+{
+    int i = 0;
+#ifdef IMGUI_DRAW_AVX2
+    if (level >= ImDrawSimd_AVX2)
+        i = PolyNormalsAVX2(points, points_count - 1, normals);
+#endif
+#ifdef IMGUI_DRAW_SSE2
+    if (level >= ImDrawSimd_SSE2)
+        i += PolyNormalsSSE2(points + i, points_count - 1 - i, normals + i);
+#endif
+    (void)level;
+    for (; i < points_count - 1; i++)
+        PolyNormal(points[i], points[i+1], normals[i]);
+    if (closed)
+        PolyNormal(points[points_count-1], points[0], normals[points_count-1]);
+}
+
+// miters[i] from the normals of the segments ending and starting at points[i], for every point after the first
+// (and the first if closed)
+static void PolyMiters(const ImVec2* normals, int points_count, bool closed, ImVec2* miters, int level)
+{
+    int i = 1;
+#ifdef IMGUI_DRAW_AVX2
+    if (level >= ImDrawSimd_AVX2)
+        i = PolyMitersAVX2(normals, i, points_count, miters);
+#endif
+#ifdef IMGUI_DRAW_SSE2
+    if (level >= ImDrawSimd_SSE2)
+        i = PolyMitersSSE2(normals, i, points_count, miters);
+#endif
+    (void)level;
+    for (; i < points_count; i++)
+        miters[i] = PolyAverageNormal(normals[i-1], normals[i]);
+    if (closed)
+        miters[0] = PolyAverageNormal(normals[points_count-1], normals[0]);
+}
+
 //-----------------------------------------------------------------------------
 // ImDrawList
 //-----------------------------------------------------------------------------
@@ -601,19 +824,15 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
         PrimReserve(idx_count, vtx_count);
 
         // Temporary buffer
-        ImVec2* temp_normals = (ImVec2*)alloca(points_count * (thick_line ? 5 : 3) * sizeof(ImVec2));
-        ImVec2* temp_points = temp_normals + points_count;
+        ImVec2* temp_normals = (ImVec2*)alloca(points_count * (thick_line ? 6 : 4) * sizeof(ImVec2));
+        ImVec2* temp_miters = temp_normals + points_count;
+        ImVec2* temp_points = temp_miters + points_count;
 
-        for (int i1 = 0; i1 < count; i1++)
-        {
-            const int i2 = (i1+1) == points_count ? 0 : i1+1;
-            ImVec2 diff = points[i2] - points[i1];
-            diff *= ImInvLength(diff, 1.0f);
-            temp_normals[i1].x = diff.y;
-            temp_normals[i1].y = -diff.x;
-        }
+        const int simd_level = ImGui::GetDrawSimdLevel();
+        PolyNormals(points, points_count, closed, temp_normals, simd_level);
         if (!closed)
             temp_normals[points_count-1] = temp_normals[points_count-2];
+        PolyMiters(temp_normals, points_count, closed, temp_miters, simd_level);
 
         if (!thick_line)
         {
@@ -633,14 +852,7 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
                 unsigned int idx2 = (i1+1) == points_count ? _VtxCurrentIdx : idx1+3;
 
                 // Average normals
-                ImVec2 dm = (temp_normals[i1] + temp_normals[i2]) * 0.5f;
-                float dmr2 = dm.x*dm.x + dm.y*dm.y;
-                if (dmr2 > 0.000001f)
-                {
-                    float scale = 1.0f / dmr2;
-                    if (scale > 100.0f) scale = 100.0f;
-                    dm *= scale;
-                }
+                ImVec2 dm = temp_miters[i2];
                 dm *= AA_SIZE;
                 temp_points[i2*2+0] = points[i2] + dm;
                 temp_points[i2*2+1] = points[i2] - dm;
@@ -687,14 +899,7 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
                 unsigned int idx2 = (i1+1) == points_count ? _VtxCurrentIdx : idx1+4;
 
                 // Average normals
-                ImVec2 dm = (temp_normals[i1] + temp_normals[i2]) * 0.5f;
-                float dmr2 = dm.x*dm.x + dm.y*dm.y;
-                if (dmr2 > 0.000001f)
-                {
-                    float scale = 1.0f / dmr2;
-                    if (scale > 100.0f) scale = 100.0f;
-                    dm *= scale;
-                }
+                ImVec2 dm = temp_miters[i2];
                 ImVec2 dm_out = dm * (half_inner_thickness + AA_SIZE);
                 ImVec2 dm_in = dm * half_inner_thickness;
                 temp_points[i2*4+0] = points[i2] + dm_out;
@@ -781,32 +986,16 @@ void ImDrawList::AddConvexPolyFilled(const ImVec2* points, const int points_coun
             _IdxWritePtr += 3;
         }
 
-        // Compute normals
-        ImVec2* temp_normals = (ImVec2*)alloca(points_count * sizeof(ImVec2));
-        for (int i0 = points_count-1, i1 = 0; i1 < points_count; i0 = i1++)
-        {
-            const ImVec2& p0 = points[i0];
-            const ImVec2& p1 = points[i1];
-            ImVec2 diff = p1 - p0;
-            diff *= ImInvLength(diff, 1.0f);
-            temp_normals[i0].x = diff.y;
-            temp_normals[i0].y = -diff.x;
-        }
+        // Compute normals and their averages at each point
+        ImVec2* temp_normals = (ImVec2*)alloca(points_count * 2 * sizeof(ImVec2));
+        ImVec2* temp_miters = temp_normals + points_count;
+        const int simd_level = ImGui::GetDrawSimdLevel();
+        PolyNormals(points, points_count, true, temp_normals, simd_level);
+        PolyMiters(temp_normals, points_count, true, temp_miters, simd_level);
 
         for (int i0 = points_count-1, i1 = 0; i1 < points_count; i0 = i1++)
         {
-            // Average normals
-            const ImVec2& n0 = temp_normals[i0];
-            const ImVec2& n1 = temp_normals[i1];
-            ImVec2 dm = (n0 + n1) * 0.5f;
-            float dmr2 = dm.x*dm.x + dm.y*dm.y;
-            if (dmr2 > 0.000001f)
-            {
-                float scale = 1.0f / dmr2;
-                if (scale > 100.0f) scale = 100.0f;
-                dm *= scale;
-            }
-            dm *= AA_SIZE * 0.5f;
+            ImVec2 dm = temp_miters[i1] * (AA_SIZE * 0.5f);
 
             // Add vertices
             _VtxWritePtr[0].pos = (points[i1] - dm); _VtxWritePtr[0].uv = uv; _VtxWritePtr[0].col = col;        // Inner
@@ -1351,6 +1540,284 @@ static const ImVec2 FONT_ATLAS_DEFAULT_TEX_CURSOR_DATA[ImGuiMouseCursor_Count_][
 };
 
 
+// Dynamic glyphs (ImFontAtlas::DynamicGlyphs).
+// Each input font gets fixed cells sized to its bounding box, handed out along shelves below the glyphs baked by Build().
+// All cells of an input are interchangeable, so once the texture is full the least recently drawn glyph of the input gives its cell.
+struct ImFontAtlasGlyphCache
+{
+    struct Input
+    {
+        stbtt_fontinfo      FontInfo;
+        float               Scale;
+        int                 CellW, CellH;
+        int                 ShelfX, ShelfY;     // Next cell of the input's current shelf, ShelfY < 0 before the first one
+        int                 LruHead, LruTail;   // Slots of the input, most recently drawn first
+    };
+    struct Slot
+    {
+        int                 X, Y;
+        int                 Input;              // Index in ImFontAtlas::ConfigData
+        int                 Glyph;              // Index in Glyphs[] of the input's DstFont
+        int                 LastUsedFrame;
+        int                 Prev, Next;
+    };
+    ImVector<Input>         Inputs;             // Parallel to ImFontAtlas::ConfigData
+    ImVector<Slot>          Slots;
+    int                     FreeY;              // Rows from here down are not used by any shelf yet
+    int                     DirtyX0, DirtyY0, DirtyX1, DirtyY1;
+    int                     Rasterized, Evicted;
+};
+
+struct ImFontGlyphCache
+{
+    ImVector<short>         Source;             // Per codepoint, ImFontAtlas::ConfigData index to rasterize it from (-1: baked or not in any range)
+    ImVector<int>           Slots;              // Per glyph, ImFontAtlasGlyphCache::Slots index (-1 or past the end: baked)
+};
+
+static bool ImFontAtlasRangesContain(const ImWchar* ranges, int c)
+{
+    for (; ranges[0] && ranges[1]; ranges += 2)
+        if (c >= ranges[0] && c <= ranges[1])
+            return true;
+    return false;
+}
+
+static void ImFontAtlasClearGlyphCache(ImFontAtlas* atlas)
+{
+    for (int i = 0; i < atlas->Fonts.Size; i++)
+        if (ImFontGlyphCache* font_cache = atlas->Fonts[i]->GlyphCache)
+        {
+            font_cache->~ImFontGlyphCache();
+            ImGui::MemFree(font_cache);
+            atlas->Fonts[i]->GlyphCache = NULL;
+        }
+    if (atlas->GlyphCache)
+    {
+        atlas->GlyphCache->~ImFontAtlasGlyphCache();
+        ImGui::MemFree(atlas->GlyphCache);
+        atlas->GlyphCache = NULL;
+    }
+}
+
+// Called by the build once the fonts are set up: codepoints outside GetGlyphRangesDefault() were not baked, rows from 'free_y' down are free.
+static void ImFontAtlasBuildGlyphCache(ImFontAtlas* atlas, int free_y)
+{
+    ImFontAtlasGlyphCache* cache = (ImFontAtlasGlyphCache*)ImGui::MemAlloc(sizeof(ImFontAtlasGlyphCache));
+    IM_PLACEMENT_NEW(cache) ImFontAtlasGlyphCache();
+    cache->FreeY = free_y;
+    cache->DirtyX0 = atlas->TexWidth;
+    cache->DirtyY0 = atlas->TexHeight;
+    cache->DirtyX1 = cache->DirtyY1 = 0;
+    cache->Rasterized = cache->Evicted = 0;
+    atlas->GlyphCache = cache;
+
+    const ImWchar* baked_ranges = atlas->GetGlyphRangesDefault();
+    cache->Inputs.resize(atlas->ConfigData.Size);
+    for (int input_i = 0; input_i < atlas->ConfigData.Size; input_i++)
+    {
+        ImFontConfig& cfg = atlas->ConfigData[input_i];
+        ImFontAtlasGlyphCache::Input& in = cache->Inputs[input_i];
+        stbtt_InitFont(&in.FontInfo, (unsigned char*)cfg.FontData, stbtt_GetFontOffsetForIndex((unsigned char*)cfg.FontData, cfg.FontNo));
+        in.Scale = stbtt_ScaleForPixelHeight(&in.FontInfo, cfg.SizePixels);
+        int x0, y0, x1, y1;
+        stbtt_GetFontBoundingBox(&in.FontInfo, &x0, &y0, &x1, &y1);
+        in.CellW = (int)((x1 - x0) * in.Scale * cfg.OversampleH) + 2 + atlas->TexGlyphPadding + cfg.OversampleH - 1;
+        in.CellH = (int)((y1 - y0) * in.Scale * cfg.OversampleV) + 2 + atlas->TexGlyphPadding + cfg.OversampleV - 1;
+        in.ShelfX = 0;
+        in.ShelfY = -1;
+        in.LruHead = in.LruTail = -1;
+
+        // Later inputs of a merged font take over codepoints, as they do when baked
+        ImFont* font = cfg.DstFont;
+        if (!font->GlyphCache)
+        {
+            font->GlyphCache = (ImFontGlyphCache*)ImGui::MemAlloc(sizeof(ImFontGlyphCache));
+            IM_PLACEMENT_NEW(font->GlyphCache) ImFontGlyphCache();
+        }
+        ImVector<short>& source = font->GlyphCache->Source;
+        for (const ImWchar* in_range = cfg.GlyphRanges; in_range[0] && in_range[1]; in_range += 2)
+        {
+            if (in_range[1] >= source.Size)
+                source.resize(in_range[1] + 1, (short)-1);
+            for (int c = in_range[0]; c <= in_range[1]; c++)
+                if (!ImFontAtlasRangesContain(baked_ranges, c))
+                    source[c] = (short)input_i;
+        }
+    }
+}
+
+static void ImFontAtlasGlyphCacheUnlink(ImFontAtlasGlyphCache* cache, int slot_i)
+{
+    ImFontAtlasGlyphCache::Slot& slot = cache->Slots[slot_i];
+    ImFontAtlasGlyphCache::Input& in = cache->Inputs[slot.Input];
+    if (slot.Prev >= 0) cache->Slots[slot.Prev].Next = slot.Next; else in.LruHead = slot.Next;
+    if (slot.Next >= 0) cache->Slots[slot.Next].Prev = slot.Prev; else in.LruTail = slot.Prev;
+    slot.Prev = slot.Next = -1;
+}
+
+static void ImFontAtlasGlyphCachePushFront(ImFontAtlasGlyphCache* cache, int slot_i)
+{
+    ImFontAtlasGlyphCache::Slot& slot = cache->Slots[slot_i];
+    ImFontAtlasGlyphCache::Input& in = cache->Inputs[slot.Input];
+    slot.Prev = -1;
+    slot.Next = in.LruHead;
+    if (in.LruHead >= 0) cache->Slots[in.LruHead].Prev = slot_i; else in.LruTail = slot_i;
+    in.LruHead = slot_i;
+}
+
+// Glyph found in the index: move it to the front of its input's LRU list once per frame
+static void ImFontGlyphCacheTouch(const ImFont* font, int glyph_i)
+{
+    const ImVector<int>& glyph_slots = font->GlyphCache->Slots;
+    if (glyph_i >= glyph_slots.Size || glyph_slots[glyph_i] < 0)
+        return;
+    ImFontAtlasGlyphCache* cache = font->ContainerAtlas->GlyphCache;
+    const int slot_i = glyph_slots[glyph_i];
+    ImFontAtlasGlyphCache::Slot& slot = cache->Slots[slot_i];
+    if (slot.LastUsedFrame == GImGui->FrameCount)
+        return;
+    slot.LastUsedFrame = GImGui->FrameCount;
+    ImFontAtlasGlyphCacheUnlink(cache, slot_i);
+    ImFontAtlasGlyphCachePushFront(cache, slot_i);
+}
+
+// Glyph missing from the index: rasterize it if one of the font inputs has it, returns NULL to fall back
+static const ImFontGlyph* ImFontGlyphCacheLoad(ImFont* font, ImWchar c)
+{
+    ImFontAtlas* atlas = font->ContainerAtlas;
+    ImFontAtlasGlyphCache* cache = atlas ? atlas->GlyphCache : NULL;
+    if (!cache || !atlas->TexPixelsAlpha8 || c >= font->GlyphCache->Source.Size || font->GlyphCache->Source[c] < 0)
+        return NULL;
+    const int input_i = font->GlyphCache->Source[c];
+    const ImFontConfig& cfg = atlas->ConfigData[input_i];
+    ImFontAtlasGlyphCache::Input& in = cache->Inputs[input_i];
+    const int frame_count = GImGui->FrameCount;
+
+    // Measure first, a glyph larger than the font bounding box would spill over its neighbours
+    int codepoint = (int)c;
+    stbtt_packedchar pc = {};
+    stbtt_pack_range range = {};
+    range.font_size = cfg.SizePixels;
+    range.array_of_unicode_codepoints = &codepoint;
+    range.num_chars = 1;
+    range.chardata_for_range = &pc;
+    stbtt_pack_context spc = {};
+    spc.width = atlas->TexWidth;
+    spc.height = atlas->TexHeight;
+    spc.stride_in_bytes = atlas->TexWidth;
+    spc.padding = atlas->TexGlyphPadding;
+    spc.pixels = atlas->TexPixelsAlpha8;
+    stbtt_PackSetOversampling(&spc, cfg.OversampleH, cfg.OversampleV);
+    stbrp_rect rect = {};
+    stbtt_PackFontRangesGatherRects(&spc, &in.FontInfo, &range, 1, &rect);
+    if (rect.w > in.CellW || rect.h > in.CellH)
+        return NULL;
+
+    // Take the next cell of the input's shelf (opening a new shelf if needed), else the least recently drawn glyph not drawn this frame
+    if ((in.ShelfY < 0 || in.ShelfX + in.CellW > atlas->TexWidth) && in.CellW <= atlas->TexWidth && cache->FreeY + in.CellH <= atlas->TexHeight)
+    {
+        in.ShelfX = 0;
+        in.ShelfY = cache->FreeY;
+        cache->FreeY += in.CellH;
+    }
+    int slot_i;
+    if (in.ShelfY >= 0 && in.ShelfX + in.CellW <= atlas->TexWidth)
+    {
+        slot_i = cache->Slots.Size;
+        cache->Slots.resize(cache->Slots.Size + 1);
+        ImFontAtlasGlyphCache::Slot& slot = cache->Slots.back();
+        slot.X = in.ShelfX;
+        slot.Y = in.ShelfY;
+        slot.Input = input_i;
+        slot.Glyph = -1;
+        slot.Prev = slot.Next = -1;
+        in.ShelfX += in.CellW;
+    }
+    else
+    {
+        slot_i = in.LruTail;
+        if (slot_i >= 0 && &font->Glyphs[cache->Slots[slot_i].Glyph] == font->FallbackGlyph)
+            slot_i = cache->Slots[slot_i].Prev;
+        if (slot_i < 0 || cache->Slots[slot_i].LastUsedFrame == frame_count)
+            return NULL;
+        font->IndexLookup[font->Glyphs[cache->Slots[slot_i].Glyph].Codepoint] = (unsigned short)-1;
+        ImFontAtlasGlyphCacheUnlink(cache, slot_i);
+        cache->Evicted++;
+    }
+    ImFontAtlasGlyphCache::Slot& slot = cache->Slots[slot_i];
+
+    // Rasterize into the cleared cell
+    unsigned char* pixels = atlas->TexPixelsAlpha8;
+    for (int y = 0; y < in.CellH; y++)
+        memset(pixels + slot.X + (slot.Y + y) * atlas->TexWidth, 0, (size_t)in.CellW);
+    rect.x = (stbrp_coord)slot.X;
+    rect.y = (stbrp_coord)slot.Y;
+    rect.was_packed = 1;
+    stbtt_PackFontRangesRenderIntoRects(&spc, &in.FontInfo, &range, 1, &rect);
+    if (cfg.RasterizerMultiply != 1.0f)
+    {
+        unsigned char multiply_table[256];
+        ImFontAtlasBuildMultiplyCalcLookupTable(multiply_table, cfg.RasterizerMultiply);
+        ImFontAtlasBuildMultiplyRectAlpha8(multiply_table, pixels, rect.x, rect.y, rect.w, rect.h, atlas->TexWidth);
+    }
+
+    // Setup the glyph as the build does, reusing the entry of the glyph evicted from the cell
+    stbtt_aligned_quad q;
+    float dummy_x = 0.0f, dummy_y = 0.0f;
+    stbtt_GetPackedQuad(&pc, atlas->TexWidth, atlas->TexHeight, 0, &dummy_x, &dummy_y, &q, 0);
+    const float off_x = cfg.GlyphOffset.x;
+    const float off_y = cfg.GlyphOffset.y + (float)(int)(font->Ascent + 0.5f);
+    const int fallback_i = font->FallbackGlyph ? (int)(font->FallbackGlyph - font->Glyphs.Data) : -1;
+    font->AddGlyph(c, q.x0 + off_x, q.y0 + off_y, q.x1 + off_x, q.y1 + off_y, q.s0, q.t0, q.s1, q.t1, pc.xadvance);
+    if (slot.Glyph >= 0)
+    {
+        font->Glyphs[slot.Glyph] = font->Glyphs.back();
+        font->Glyphs.pop_back();
+    }
+    else
+    {
+        slot.Glyph = font->Glyphs.Size - 1;
+    }
+    IM_ASSERT(font->Glyphs.Size < 0xFFFF && c < font->IndexLookup.Size);
+    font->FallbackGlyph = (fallback_i >= 0) ? &font->Glyphs[fallback_i] : NULL;
+    font->IndexLookup[c] = (unsigned short)slot.Glyph;
+    ImVector<int>& glyph_slots = font->GlyphCache->Slots;
+    if (glyph_slots.Size < font->Glyphs.Size)
+        glyph_slots.resize(font->Glyphs.Size, -1);
+    glyph_slots[slot.Glyph] = slot_i;
+    slot.LastUsedFrame = frame_count;
+    ImFontAtlasGlyphCachePushFront(cache, slot_i);
+
+    cache->DirtyX0 = ImMin(cache->DirtyX0, slot.X);
+    cache->DirtyY0 = ImMin(cache->DirtyY0, slot.Y);
+    cache->DirtyX1 = ImMax(cache->DirtyX1, slot.X + in.CellW);
+    cache->DirtyY1 = ImMax(cache->DirtyY1, slot.Y + in.CellH);
+    cache->Rasterized++;
+    return &font->Glyphs[slot.Glyph];
+}
+
+bool    ImFontAtlas::TakeTexDirtyRect(int* out_x, int* out_y, int* out_w, int* out_h)
+{
+    ImFontAtlasGlyphCache* cache = GlyphCache;
+    if (!cache || cache->DirtyX1 <= cache->DirtyX0 || cache->DirtyY1 <= cache->DirtyY0)
+        return false;
+    *out_x = cache->DirtyX0;
+    *out_y = cache->DirtyY0;
+    *out_w = cache->DirtyX1 - cache->DirtyX0;
+    *out_h = cache->DirtyY1 - cache->DirtyY0;
+    cache->DirtyX0 = TexWidth;
+    cache->DirtyY0 = TexHeight;
+    cache->DirtyX1 = cache->DirtyY1 = 0;
+    return true;
+}
+
+void    ImFontAtlas::GetGlyphCacheStats(int* out_resident, int* out_rasterized, int* out_evicted)
+{
+    *out_resident = GlyphCache ? GlyphCache->Slots.Size : 0;
+    *out_rasterized = GlyphCache ? GlyphCache->Rasterized : 0;
+    *out_evicted = GlyphCache ? GlyphCache->Evicted : 0;
+}
+
 ImFontAtlas::ImFontAtlas()
 {
     TexID = NULL;
@@ -1360,6 +1827,11 @@ ImFontAtlas::ImFontAtlas()
     TexPixelsRGBA32 = NULL;
     TexWidth = TexHeight = 0;
     TexUvWhitePixel = ImVec2(0, 0);
+    DynamicGlyphs = false;
+    DynamicTexHeight = 0;
+    TextLayoutCache = false;
+    TextLayoutCacheMaxAge = 60;
+    GlyphCache = NULL;
     for (int n = 0; n < IM_ARRAYSIZE(CustomRectIds); n++)
         CustomRectIds[n] = -1;
 }
@@ -1389,6 +1861,7 @@ void    ImFontAtlas::ClearInputData()
     CustomRects.clear();
     for (int n = 0; n < IM_ARRAYSIZE(CustomRectIds); n++)
         CustomRectIds[n] = -1;
+    ImFontAtlasClearGlyphCache(this); // Dynamic glyphs need the TTF data
 }
 
 void    ImFontAtlas::ClearTexData()
@@ -1399,10 +1872,12 @@ void    ImFontAtlas::ClearTexData()
         ImGui::MemFree(TexPixelsRGBA32);
     TexPixelsAlpha8 = NULL;
     TexPixelsRGBA32 = NULL;
+    ImFontAtlasClearGlyphCache(this);
 }
 
 void    ImFontAtlas::ClearFonts()
 {
+    ImFontAtlasClearGlyphCache(this);
     for (int i = 0; i < Fonts.Size; i++)
     {
         Fonts[i]->~ImFont();
@@ -1646,21 +2121,44 @@ bool    ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
     atlas->TexUvWhitePixel = ImVec2(0, 0);
     atlas->ClearTexData();
 
+    // With DynamicGlyphs we only bake the part of the ranges within GetGlyphRangesDefault(), the rest is rasterized on first use
+    ImVector<ImWchar> baked_ranges;
+    ImVector<int> baked_ranges_start;
+    if (atlas->DynamicGlyphs)
+        for (int input_i = 0; input_i < atlas->ConfigData.Size; input_i++)
+        {
+            ImFontConfig& cfg = atlas->ConfigData[input_i];
+            if (!cfg.GlyphRanges)
+                cfg.GlyphRanges = atlas->GetGlyphRangesDefault();
+            baked_ranges_start.push_back(baked_ranges.Size);
+            for (const ImWchar* in_range = cfg.GlyphRanges; in_range[0] && in_range[1]; in_range += 2)
+                for (const ImWchar* clip_range = atlas->GetGlyphRangesDefault(); clip_range[0] && clip_range[1]; clip_range += 2)
+                    if (ImMax(in_range[0], clip_range[0]) <= ImMin(in_range[1], clip_range[1]))
+                    {
+                        baked_ranges.push_back((ImWchar)ImMax(in_range[0], clip_range[0]));
+                        baked_ranges.push_back((ImWchar)ImMin(in_range[1], clip_range[1]));
+                    }
+            baked_ranges.push_back(0);
+        }
+
     // Count glyphs/ranges
     int total_glyphs_count = 0;
     int total_ranges_count = 0;
+    ImVector<const ImWchar*> glyph_ranges;
+    glyph_ranges.resize(atlas->ConfigData.Size);
     for (int input_i = 0; input_i < atlas->ConfigData.Size; input_i++)
     {
         ImFontConfig& cfg = atlas->ConfigData[input_i];
         if (!cfg.GlyphRanges)
             cfg.GlyphRanges = atlas->GetGlyphRangesDefault();
-        for (const ImWchar* in_range = cfg.GlyphRanges; in_range[0] && in_range[1]; in_range += 2, total_ranges_count++)
+        glyph_ranges[input_i] = atlas->DynamicGlyphs ? &baked_ranges[baked_ranges_start[input_i]] : cfg.GlyphRanges;
+        for (const ImWchar* in_range = glyph_ranges[input_i]; in_range[0] && in_range[1]; in_range += 2, total_ranges_count++)
             total_glyphs_count += (in_range[1] - in_range[0]) + 1;
     }
 
     // We need a width for the skyline algorithm. Using a dumb heuristic here to decide of width. User can override TexDesiredWidth and TexGlyphPadding if they wish.
     // Width doesn't really matter much, but some API/GPU have texture size limitations and increasing width can decrease height.
-    atlas->TexWidth = (atlas->TexDesiredWidth > 0) ? atlas->TexDesiredWidth : (total_glyphs_count > 4000) ? 4096 : (total_glyphs_count > 2000) ? 2048 : (total_glyphs_count > 1000) ? 1024 : 512;
+    atlas->TexWidth = (atlas->TexDesiredWidth > 0) ? atlas->TexDesiredWidth : atlas->DynamicGlyphs ? 1024 : (total_glyphs_count > 4000) ? 4096 : (total_glyphs_count > 2000) ? 2048 : (total_glyphs_count > 1000) ? 1024 : 512;
     atlas->TexHeight = 0;
 
     // Start packing
@@ -1715,14 +2213,14 @@ bool    ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
         // Setup ranges
         int font_glyphs_count = 0;
         int font_ranges_count = 0;
-        for (const ImWchar* in_range = cfg.GlyphRanges; in_range[0] && in_range[1]; in_range += 2, font_ranges_count++)
+        for (const ImWchar* in_range = glyph_ranges[input_i]; in_range[0] && in_range[1]; in_range += 2, font_ranges_count++)
             font_glyphs_count += (in_range[1] - in_range[0]) + 1;
         tmp.Ranges = buf_ranges + buf_ranges_n;
         tmp.RangesCount = font_ranges_count;
         buf_ranges_n += font_ranges_count;
         for (int i = 0; i < font_ranges_count; i++)
         {
-            const ImWchar* in_range = &cfg.GlyphRanges[i * 2];
+            const ImWchar* in_range = &glyph_ranges[input_i][i * 2];
             stbtt_pack_range& range = tmp.Ranges[i];
             range.font_size = cfg.SizePixels;
             range.first_unicode_codepoint_in_range = in_range[0];
@@ -1750,7 +2248,11 @@ bool    ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
     IM_ASSERT(buf_ranges_n == total_ranges_count);
 
     // Create texture
+    // With DynamicGlyphs the texture keeps room below the packed glyphs for the glyphs rasterized later
+    const int packed_height = atlas->TexHeight;
     atlas->TexHeight = ImUpperPowerOfTwo(atlas->TexHeight);
+    if (atlas->DynamicGlyphs)
+        atlas->TexHeight = ImMax(atlas->TexHeight, (atlas->DynamicTexHeight > 0) ? atlas->DynamicTexHeight : 1024);
     atlas->TexPixelsAlpha8 = (unsigned char*)ImGui::MemAlloc(atlas->TexWidth * atlas->TexHeight);
     memset(atlas->TexPixelsAlpha8, 0, atlas->TexWidth * atlas->TexHeight);
     spc.pixels = atlas->TexPixelsAlpha8;
@@ -1822,6 +2324,8 @@ bool    ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
     ImGui::MemFree(buf_ranges);
     ImGui::MemFree(tmp_array);
 
+    if (atlas->DynamicGlyphs)
+        ImFontAtlasBuildGlyphCache(atlas, packed_height);
     ImFontAtlasBuildFinish(atlas);
 
     return true;
@@ -2104,11 +2608,249 @@ void ImFontAtlas::GlyphRangesBuilder::BuildRanges(ImVector<ImWchar>* out_ranges)
 // ImFont
 //-----------------------------------------------------------------------------
 
+// Text layout cache (ImFontAtlas::TextLayoutCache).
+// Entries are keyed by (size, wrap width, text) within a font and hold what CalcTextSizeA() returns for max_width == FLT_MAX and the glyph
+// quads RenderText() emits, relative to the pixel-aligned position. RenderText() uses the quads when they all fall inside the clip rectangle
+// (nothing to cull or clip), else lays the text out as usual. Entries not used for TextLayoutCacheMaxAge frames are dropped.
+struct ImFontTextCache
+{
+    struct Quad
+    {
+        float               X0, Y0, X1, Y1;
+        float               U0, V0, U1, V1;
+    };
+    struct Entry
+    {
+        ImU32               Hash;
+        float               Size, WrapWidth;
+        int                 TextOffset, TextLength; // In Text[]
+        int                 QuadOffset, QuadCount;  // In Quads[], QuadCount < 0 until first drawn
+        ImVec2              TextSize;               // x < 0 until first measured
+        ImVec4              Bounds;                 // Quads and line tops: min x, min y, max x, max y
+        int                 LastUsedFrame;
+        int                 Next;                   // Next entry of the bucket
+    };
+    ImVector<Entry>         Entries;
+    ImVector<int>           Buckets;                // First entry per hash bucket, power-of-two size
+    ImVector<char>          Text;
+    ImVector<Quad>          Quads;
+    int                     LastSweepFrame;
+};
+
+static const int TEXT_CACHE_MAX_LENGTH = 1024;      // Longer text (e.g. multi-line InputText() contents) is laid out every time
+
+static void ImFontTextCacheClear(ImFont* font)
+{
+    if (font->TextCache)
+    {
+        font->TextCache->~ImFontTextCache();
+        ImGui::MemFree(font->TextCache);
+        font->TextCache = NULL;
+    }
+}
+
+static void ImFontTextCacheRebuildBuckets(ImFontTextCache* cache)
+{
+    int bucket_count = 64;
+    while (bucket_count < cache->Entries.Size)
+        bucket_count <<= 1;
+    cache->Buckets.resize(bucket_count);
+    memset(cache->Buckets.Data, 0xFF, (size_t)bucket_count * sizeof(int));
+    for (int i = 0; i < cache->Entries.Size; i++)
+    {
+        int& head = cache->Buckets[cache->Entries[i].Hash & (bucket_count - 1)];
+        cache->Entries[i].Next = head;
+        head = i;
+    }
+}
+
+// Drop entries unused for max_age frames and compact the text and quads of the others
+static void ImFontTextCacheSweep(ImFontTextCache* cache, int frame_count, int max_age)
+{
+    ImVector<char> text;
+    ImVector<ImFontTextCache::Quad> quads;
+    int kept = 0;
+    for (int i = 0; i < cache->Entries.Size; i++)
+    {
+        ImFontTextCache::Entry entry = cache->Entries[i];
+        if (frame_count - entry.LastUsedFrame > max_age)
+            continue;
+        text.resize(text.Size + entry.TextLength);
+        memcpy(text.Data + text.Size - entry.TextLength, cache->Text.Data + entry.TextOffset, (size_t)entry.TextLength);
+        entry.TextOffset = text.Size - entry.TextLength;
+        if (entry.QuadCount > 0)
+        {
+            quads.resize(quads.Size + entry.QuadCount);
+            memcpy(quads.Data + quads.Size - entry.QuadCount, cache->Quads.Data + entry.QuadOffset, (size_t)entry.QuadCount * sizeof(ImFontTextCache::Quad));
+            entry.QuadOffset = quads.Size - entry.QuadCount;
+        }
+        cache->Entries[kept++] = entry;
+    }
+    cache->Entries.resize(kept);
+    cache->Text.swap(text);
+    cache->Quads.swap(quads);
+    ImFontTextCacheRebuildBuckets(cache);
+    cache->LastSweepFrame = frame_count;
+}
+
+// Entry for the text, added (unmeasured, not laid out) if missing. NULL when the cache is off for this font or text.
+static ImFontTextCache::Entry* ImFontTextCacheFind(const ImFont* font, float size, float wrap_width, const char* text_begin, const char* text_end)
+{
+    ImFontAtlas* atlas = font->ContainerAtlas;
+    const int text_length = (int)(text_end - text_begin);
+    if (!atlas || !atlas->TextLayoutCache || font->GlyphCache || text_length <= 0 || text_length > TEXT_CACHE_MAX_LENGTH)
+        return NULL;
+    const int frame_count = GImGui->FrameCount;
+    ImFontTextCache* cache = font->TextCache;
+    if (!cache)
+    {
+        cache = (ImFontTextCache*)ImGui::MemAlloc(sizeof(ImFontTextCache));
+        IM_PLACEMENT_NEW(cache) ImFontTextCache();
+        cache->LastSweepFrame = frame_count;
+        ImFontTextCacheRebuildBuckets(cache);
+        const_cast<ImFont*>(font)->TextCache = cache;
+    }
+    else if (frame_count - cache->LastSweepFrame > atlas->TextLayoutCacheMaxAge)
+    {
+        ImFontTextCacheSweep(cache, frame_count, atlas->TextLayoutCacheMaxAge);
+    }
+
+    const float key[2] = { size, wrap_width };
+    const ImU32 hash = ImHash(text_begin, text_length, ImHash(key, sizeof(key), 0));
+    for (int i = cache->Buckets[hash & (cache->Buckets.Size - 1)]; i >= 0; i = cache->Entries[i].Next)
+    {
+        ImFontTextCache::Entry& entry = cache->Entries[i];
+        if (entry.Hash == hash && entry.Size == size && entry.WrapWidth == wrap_width && entry.TextLength == text_length && memcmp(cache->Text.Data + entry.TextOffset, text_begin, (size_t)text_length) == 0)
+        {
+            entry.LastUsedFrame = frame_count;
+            return &entry;
+        }
+    }
+
+    ImFontTextCache::Entry entry;
+    entry.Hash = hash;
+    entry.Size = size;
+    entry.WrapWidth = wrap_width;
+    entry.TextOffset = cache->Text.Size;
+    entry.TextLength = text_length;
+    entry.QuadOffset = 0;
+    entry.QuadCount = -1;
+    entry.TextSize = ImVec2(-1.0f, 0.0f);
+    entry.Bounds = ImVec4(0.0f, 0.0f, 0.0f, 0.0f);
+    entry.LastUsedFrame = frame_count;
+    cache->Text.resize(cache->Text.Size + text_length);
+    memcpy(cache->Text.Data + entry.TextOffset, text_begin, (size_t)text_length);
+    cache->Entries.push_back(entry);
+    if (cache->Entries.Size > cache->Buckets.Size)
+    {
+        ImFontTextCacheRebuildBuckets(cache);
+    }
+    else
+    {
+        int& head = cache->Buckets[hash & (cache->Buckets.Size - 1)];
+        cache->Entries.back().Next = head;
+        head = cache->Entries.Size - 1;
+    }
+    return &cache->Entries.back();
+}
+
+// Same walk as RenderText() from (0,0) without any clipping
+static void ImFontTextCacheLayout(const ImFont* font, ImFontTextCache::Entry* entry, const char* text_begin, const char* text_end)
+{
+    ImFontTextCache* cache = font->TextCache;
+    const float scale = entry->Size / font->FontSize;
+    const float line_height = font->FontSize * scale;
+    const float wrap_width = entry->WrapWidth;
+    const bool word_wrap_enabled = (wrap_width > 0.0f);
+    const char* word_wrap_eol = NULL;
+    float x = 0.0f;
+    float y = 0.0f;
+    ImVec4 bounds(FLT_MAX, 0.0f, -FLT_MAX, 0.0f);
+    entry->QuadOffset = cache->Quads.Size;
+
+    const char* s = text_begin;
+    while (s < text_end)
+    {
+        if (word_wrap_enabled)
+        {
+            if (!word_wrap_eol)
+            {
+                word_wrap_eol = font->CalcWordWrapPositionA(scale, s, text_end, wrap_width - x);
+                if (word_wrap_eol == s)
+                    word_wrap_eol++;
+            }
+
+            if (s >= word_wrap_eol)
+            {
+                x = 0.0f;
+                y += line_height;
+                word_wrap_eol = NULL;
+                while (s < text_end)
+                {
+                    const char c = *s;
+                    if (ImCharIsSpace(c)) { s++; } else if (c == '\n') { s++; break; } else { break; }
+                }
+                continue;
+            }
+        }
+
+        unsigned int c = (unsigned int)*s;
+        if (c < 0x80)
+        {
+            s += 1;
+        }
+        else
+        {
+            s += ImTextCharFromUtf8(&c, s, text_end);
+            if (c == 0)
+                break;
+        }
+
+        if (c < 32)
+        {
+            if (c == '\n')
+            {
+                x = 0.0f;
+                y += line_height;
+                continue;
+            }
+            if (c == '\r')
+                continue;
+        }
+
+        float char_width = 0.0f;
+        if (const ImFontGlyph* glyph = font->FindGlyph((unsigned short)c))
+        {
+            char_width = glyph->AdvanceX * scale;
+            if (c != ' ' && c != '\t')
+            {
+                ImFontTextCache::Quad q;
+                q.X0 = x + glyph->X0 * scale;
+                q.X1 = x + glyph->X1 * scale;
+                q.Y0 = y + glyph->Y0 * scale;
+                q.Y1 = y + glyph->Y1 * scale;
+                q.U0 = glyph->U0; q.V0 = glyph->V0;
+                q.U1 = glyph->U1; q.V1 = glyph->V1;
+                cache->Quads.push_back(q);
+                bounds.x = ImMin(bounds.x, q.X0);
+                bounds.y = ImMin(bounds.y, q.Y0);
+                bounds.z = ImMax(bounds.z, q.X1);
+                bounds.w = ImMax(bounds.w, q.Y1);
+            }
+        }
+        x += char_width;
+    }
+    entry->QuadCount = cache->Quads.Size - entry->QuadOffset;
+    entry->Bounds = ImVec4(bounds.x, bounds.y, bounds.z, ImMax(bounds.w, y));
+}
+
 ImFont::ImFont()
 {
     Scale = 1.0f;
     FallbackChar = (ImWchar)'?';
     DisplayOffset = ImVec2(0.0f, 1.0f);
+    GlyphCache = NULL;
+    TextCache = NULL;
     ClearOutputData();
 }
 
@@ -2138,10 +2880,18 @@ void    ImFont::ClearOutputData()
     ContainerAtlas = NULL;
     Ascent = Descent = 0.0f;
     MetricsTotalSurface = 0;
+    if (GlyphCache)
+    {
+        GlyphCache->~ImFontGlyphCache();
+        ImGui::MemFree(GlyphCache);
+        GlyphCache = NULL;
+    }
+    ImFontTextCacheClear(this);
 }
 
 void ImFont::BuildLookupTable()
 {
+    ImFontTextCacheClear(this);
     int max_codepoint = 0;
     for (int i = 0; i != Glyphs.Size; i++)
         max_codepoint = ImMax(max_codepoint, (int)Glyphs[i].Codepoint);
@@ -2157,6 +2907,24 @@ void ImFont::BuildLookupTable()
         IndexLookup[codepoint] = (unsigned short)i;
     }
 
+    // Dynamic glyphs not rasterized yet: the advance comes from the font metrics
+    if (GlyphCache && ContainerAtlas->GlyphCache)
+    {
+        const ImVector<short>& source = GlyphCache->Source;
+        GrowIndex(source.Size);
+        for (int codepoint = 0; codepoint < source.Size; codepoint++)
+            if (source[codepoint] >= 0 && IndexLookup[codepoint] == (unsigned short)-1)
+            {
+                const ImFontAtlasGlyphCache::Input& in = ContainerAtlas->GlyphCache->Inputs[source[codepoint]];
+                int advance, lsb;
+                stbtt_GetGlyphHMetrics(&in.FontInfo, stbtt_FindGlyphIndex(&in.FontInfo, codepoint), &advance, &lsb);
+                float advance_x = in.Scale * advance + ConfigData->GlyphExtraSpacing.x;
+                if (ConfigData->PixelSnapH)
+                    advance_x = (float)(int)(advance_x + 0.5f);
+                IndexAdvanceX[codepoint] = advance_x;
+            }
+    }
+
     // Create a glyph to handle TAB
     // FIXME: Needs proper TAB handling but it needs to be contextualized (or we could arbitrary say that each string starts at "column 0" ?)
     if (FindGlyph((unsigned short)' '))
@@ -2174,7 +2942,7 @@ void ImFont::BuildLookupTable()
     FallbackGlyph = NULL;
     FallbackGlyph = FindGlyph(FallbackChar);
     FallbackAdvanceX = FallbackGlyph ? FallbackGlyph->AdvanceX : 0.0f;
-    for (int i = 0; i < max_codepoint + 1; i++)
+    for (int i = 0; i < IndexAdvanceX.Size; i++)
         if (IndexAdvanceX[i] < 0.0f)
             IndexAdvanceX[i] = FallbackAdvanceX;
 }
@@ -2226,6 +2994,7 @@ void ImFont::AddRemapChar(ImWchar dst, ImWchar src, bool overwrite_dst)
     if (src >= index_size && dst >= index_size) // both 'dst' and 'src' don't exist -> no-op
         return;
 
+    ImFontTextCacheClear(this);
     GrowIndex(dst + 1);
     IndexLookup[dst] = (src < index_size) ? IndexLookup.Data[src] : (unsigned short)-1;
     IndexAdvanceX[dst] = (src < index_size) ? IndexAdvanceX.Data[src] : 1.0f;
@@ -2237,11 +3006,25 @@ const ImFontGlyph* ImFont::FindGlyph(ImWchar c) const
     {
         const unsigned short i = IndexLookup[c];
         if (i != (unsigned short)-1)
+        {
+            if (GlyphCache)
+                ImFontGlyphCacheTouch(this, i);
             return &Glyphs.Data[i];
+        }
     }
+    if (GlyphCache)
+        if (const ImFontGlyph* glyph = ImFontGlyphCacheLoad(const_cast<ImFont*>(this), c))
+            return glyph;
     return FallbackGlyph;
 }
 
+bool ImFont::HasGlyph(ImWchar c) const
+{
+    if (c < IndexLookup.Size && IndexLookup[c] != (unsigned short)-1)
+        return true;
+    return GlyphCache && c < GlyphCache->Source.Size && GlyphCache->Source[c] >= 0;
+}
+
 const char* ImFont::CalcWordWrapPositionA(float scale, const char* text, const char* text_end, float wrap_width) const
 {
     // Simple word-wrapping for English, not full-featured. Please submit failing cases!
@@ -2346,6 +3129,17 @@ ImVec2 ImFont::CalcTextSizeA(float size, float max_width, float wrap_width, cons
     if (!text_end)
         text_end = text_begin + strlen(text_begin); // FIXME-OPT: Need to avoid this.
 
+    if (!remaining && max_width == FLT_MAX)
+        if (ImFontTextCache::Entry* entry = ImFontTextCacheFind(this, size, wrap_width, text_begin, text_end))
+        {
+            if (entry->TextSize.x < 0.0f)
+            {
+                const char* end;    // Passing 'remaining' bypasses the cache
+                entry->TextSize = CalcTextSizeA(size, max_width, wrap_width, text_begin, text_end, &end);
+            }
+            return entry->TextSize;
+        }
+
     const float line_height = size;
     const float scale = size / FontSize;
 
@@ -2462,6 +3256,42 @@ void ImFont::RenderText(ImDrawList* draw_list, float size, ImVec2 pos, ImU32 col
     if (y > clip_rect.w)
         return;
 
+    // Cached layout entirely inside the clip rectangle: translate its quads
+    if (!cpu_fine_clip)
+        if (ImFontTextCache::Entry* entry = ImFontTextCacheFind(this, size, wrap_width, text_begin, text_end))
+        {
+            if (entry->QuadCount < 0)
+                ImFontTextCacheLayout(this, entry, text_begin, text_end);
+            if (entry->QuadCount == 0)
+                return;
+            if (x + entry->Bounds.x >= clip_rect.x && y + entry->Bounds.y >= clip_rect.y && x + entry->Bounds.z <= clip_rect.z && y + entry->Bounds.w <= clip_rect.w)
+            {
+                const ImFontTextCache::Quad* quad = TextCache->Quads.Data + entry->QuadOffset;
+                const int quad_count = entry->QuadCount;
+                draw_list->PrimReserve(quad_count * 6, quad_count * 4);
+                ImDrawVert* vtx_write = draw_list->_VtxWritePtr;
+                ImDrawIdx* idx_write = draw_list->_IdxWritePtr;
+                unsigned int vtx_current_idx = draw_list->_VtxCurrentIdx;
+                for (int n = 0; n < quad_count; n++, quad++)
+                {
+                    const float x1 = x + quad->X0, y1 = y + quad->Y0, x2 = x + quad->X1, y2 = y + quad->Y1;
+                    idx_write[0] = (ImDrawIdx)(vtx_current_idx); idx_write[1] = (ImDrawIdx)(vtx_current_idx+1); idx_write[2] = (ImDrawIdx)(vtx_current_idx+2);
+                    idx_write[3] = (ImDrawIdx)(vtx_current_idx); idx_write[4] = (ImDrawIdx)(vtx_current_idx+2); idx_write[5] = (ImDrawIdx)(vtx_current_idx+3);
+                    vtx_write[0].pos.x = x1; vtx_write[0].pos.y = y1; vtx_write[0].col = col; vtx_write[0].uv.x = quad->U0; vtx_write[0].uv.y = quad->V0;
+                    vtx_write[1].pos.x = x2; vtx_write[1].pos.y = y1; vtx_write[1].col = col; vtx_write[1].uv.x = quad->U1; vtx_write[1].uv.y = quad->V0;
+                    vtx_write[2].pos.x = x2; vtx_write[2].pos.y = y2; vtx_write[2].col = col; vtx_write[2].uv.x = quad->U1; vtx_write[2].uv.y = quad->V1;
+                    vtx_write[3].pos.x = x1; vtx_write[3].pos.y = y2; vtx_write[3].col = col; vtx_write[3].uv.x = quad->U0; vtx_write[3].uv.y = quad->V1;
+                    vtx_write += 4;
+                    vtx_current_idx += 4;
+                    idx_write += 6;
+                }
+                draw_list->_VtxWritePtr = vtx_write;
+                draw_list->_IdxWritePtr = idx_write;
+                draw_list->_VtxCurrentIdx = vtx_current_idx;
+                return;
+            }
+        }
+
     const float scale = size / FontSize;
     const float line_height = FontSize * scale;
     const bool word_wrap_enabled = (wrap_width > 0.0f);
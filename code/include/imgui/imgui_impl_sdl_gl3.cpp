@@ -16,6 +16,9 @@
 #include <SDL_syswm.h>
 #include <GL/glew.h>    // This example is using gl3w to access OpenGL functions (because it is small). You may use glew/glad/glLoadGen/etc. whatever already works for you.
 
+// GL buffer and texture sizes for the application's memory report
+#include "MemoryTracker.h"
+
 // Data
 static double       g_Time = 0.0f;
 static bool         g_MousePressed[3] = { false, false, false };
@@ -31,13 +34,23 @@ static unsigned int g_VboHandle = 0, g_VaoHandle = 0, g_ElementsHandle = 0;
 // If text or lines are blurry when integrating ImGui in your engine: in your Render function, try translating your projection matrix by (0.5f,0.5f) or (0.375f,0.375f)
 void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data)
 {
-    // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
     ImGuiIO& io = ImGui::GetIO();
-    int fb_width = (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x);
-    int fb_height = (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y);
+    int x, y, w, h;
+    if (io.Fonts->TakeTexDirtyRect(&x, &y, &w, &h))    // Glyphs rasterized on first use this frame (ImFontAtlas::DynamicGlyphs)
+        ImGui_ImplSdlGL3_UpdateFontsTexture(io.Fonts->TexPixelsAlpha8 + x + y * io.Fonts->TexWidth, x, y, w, h, io.Fonts->TexWidth);
+    ImGui_ImplSdlGL3_RenderDrawData(draw_data, io.DisplaySize, io.DisplayFramebufferScale);
+}
+
+// Same as above but without touching the ImGui context, so it can run on a render thread from a copy of the draw data
+void ImGui_ImplSdlGL3_RenderDrawData(ImDrawData* draw_data, const ImVec2& display_size, const ImVec2& framebuffer_scale)
+{
+    // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
+    int fb_width = (int)(display_size.x * framebuffer_scale.x);
+    int fb_height = (int)(display_size.y * framebuffer_scale.y);
     if (fb_width == 0 || fb_height == 0)
         return;
-    draw_data->ScaleClipRects(io.DisplayFramebufferScale);
+    draw_data->ScaleClipRects(framebuffer_scale);
+    MemoryTracker::Scope memory_scope(MemoryTracker::Gui, "ImGui_ImplSdlGL3_RenderDrawData");
 
     // Backup GL state
     GLenum last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
@@ -75,8 +88,8 @@ void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data)
     glViewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
     const float ortho_projection[4][4] =
     {
-        { 2.0f/io.DisplaySize.x, 0.0f,                   0.0f, 0.0f },
-        { 0.0f,                  2.0f/-io.DisplaySize.y, 0.0f, 0.0f },
+        { 2.0f/display_size.x,   0.0f,                   0.0f, 0.0f },
+        { 0.0f,                  2.0f/-display_size.y,   0.0f, 0.0f },
         { 0.0f,                  0.0f,                  -1.0f, 0.0f },
         {-1.0f,                  1.0f,                   0.0f, 1.0f },
     };
@@ -93,9 +106,11 @@ void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data)
 
         glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
         glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert), (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW);
+        MemoryTracker::gpuBuffer(g_VboHandle, (size_t)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx), (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW);
+        MemoryTracker::gpuBuffer(g_ElementsHandle, (size_t)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
 
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
@@ -189,26 +204,50 @@ bool ImGui_ImplSdlGL3_ProcessEvent(SDL_Event* event)
 
 void ImGui_ImplSdlGL3_CreateFontsTexture()
 {
+    MemoryTracker::Scope memory_scope(MemoryTracker::Gui, "ImGui_ImplSdlGL3_CreateFontsTexture");
+
     // Build texture atlas
     ImGuiIO& io = ImGui::GetIO();
     unsigned char* pixels;
     int width, height;
-    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);   // Load as RGBA 32-bits for OpenGL3 demo because it is more likely to be compatible with user's existing shader.
+    io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);   // Font pixels are coverage only: upload one channel and swizzle it to (1,1,1,a) for the shader.
 
     // Upload texture to graphics system
-    GLint last_texture;
+    GLint last_texture, last_unpack_alignment;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &last_unpack_alignment);
     glGenTextures(1, &g_FontTexture);
     glBindTexture(GL_TEXTURE_2D, g_FontTexture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    const GLint swizzle[4] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    MemoryTracker::gpuTexture(g_FontTexture, (size_t)width * height);
 
     // Store our identifier
     io.Fonts->TexID = (void *)(intptr_t)g_FontTexture;
 
     // Restore state
+    glPixelStorei(GL_UNPACK_ALIGNMENT, last_unpack_alignment);
+    glBindTexture(GL_TEXTURE_2D, last_texture);
+}
+
+void ImGui_ImplSdlGL3_UpdateFontsTexture(const unsigned char* pixels, int x, int y, int w, int h, int stride)
+{
+    if (!g_FontTexture)
+        return;
+    GLint last_texture, last_unpack_alignment;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &last_unpack_alignment);
+    glBindTexture(GL_TEXTURE_2D, g_FontTexture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, last_unpack_alignment);
     glBindTexture(GL_TEXTURE_2D, last_texture);
 }
 
@@ -294,6 +333,8 @@ void    ImGui_ImplSdlGL3_InvalidateDeviceObjects()
     if (g_VaoHandle) glDeleteVertexArrays(1, &g_VaoHandle);
     if (g_VboHandle) glDeleteBuffers(1, &g_VboHandle);
     if (g_ElementsHandle) glDeleteBuffers(1, &g_ElementsHandle);
+    MemoryTracker::gpuBuffersDeleted(1, &g_VboHandle);
+    MemoryTracker::gpuBuffersDeleted(1, &g_ElementsHandle);
     g_VaoHandle = g_VboHandle = g_ElementsHandle = 0;
 
     if (g_ShaderHandle && g_VertHandle) glDetachShader(g_ShaderHandle, g_VertHandle);
@@ -310,6 +351,7 @@ void    ImGui_ImplSdlGL3_InvalidateDeviceObjects()
     if (g_FontTexture)
     {
         glDeleteTextures(1, &g_FontTexture);
+        MemoryTracker::gpuTexturesDeleted(1, &g_FontTexture);
         ImGui::GetIO().Fonts->TexID = 0;
         g_FontTexture = 0;
     }
@@ -16,6 +16,13 @@ IMGUI_API void        ImGui_ImplSdlGL3_Shutdown();
 IMGUI_API void        ImGui_ImplSdlGL3_NewFrame(SDL_Window* window);
 IMGUI_API bool        ImGui_ImplSdlGL3_ProcessEvent(SDL_Event* event);
 
+// Draw a (copied) ImDrawData without reading the ImGui context. Used when rendering happens on a separate thread.
+IMGUI_API void        ImGui_ImplSdlGL3_RenderDrawData(ImDrawData* draw_data, const ImVec2& display_size, const ImVec2& framebuffer_scale);
+
+// Upload a w*h area of Alpha8 font pixels (rows 'stride' bytes apart) to (x,y) of the font texture, e.g. what ImFontAtlas::TakeTexDirtyRect() returns.
+// ImGui_ImplSdlGL3_RenderDrawLists() does it by itself, call it before RenderDrawData() when rendering a copy.
+IMGUI_API void        ImGui_ImplSdlGL3_UpdateFontsTexture(const unsigned char* pixels, int x, int y, int w, int h, int stride);
+
 // Use if you want to reset your rendering device without losing ImGui state.
 IMGUI_API void        ImGui_ImplSdlGL3_InvalidateDeviceObjects();
 IMGUI_API bool        ImGui_ImplSdlGL3_CreateDeviceObjects();
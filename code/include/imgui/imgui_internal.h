@@ -42,6 +42,7 @@ struct ImGuiMouseCursorData;
 struct ImGuiPopupRef;
 struct ImGuiWindow;
 struct ImGuiWindowSettings;
+struct ImGuiIniWriter;
 
 typedef int ImGuiLayoutType;        // enum: horizontal or vertical             // enum ImGuiLayoutType_
 typedef int ImGuiButtonFlags;       // flags: for ButtonEx(), ButtonBehavior()  // enum ImGuiButtonFlags_
@@ -256,6 +257,14 @@ enum ImGuiDir
     ImGuiDir_Count_
 };
 
+// Tessellation paths of the anti-aliased AddPolyline()/AddConvexPolyFilled(), see SetDrawSimdLevel()
+enum ImDrawSimdLevel_
+{
+    ImDrawSimd_Scalar,
+    ImDrawSimd_SSE2,
+    ImDrawSimd_AVX2             // Runtime-detected
+};
+
 // 2D axis aligned bounding-box
 // NB: we can't rely on ImVec2 math operators being available here
 struct IMGUI_API ImRect
@@ -377,8 +386,15 @@ struct ImGuiWindowSettings
     ImVec2      Pos;
     ImVec2      Size;
     bool        Collapsed;
+#ifdef IMGUI_ASYNC_INI_SAVE
+    bool        Dirty;      // Listed in g.SettingsDirty: re-formatted at the next save
+#endif
 
+#ifdef IMGUI_ASYNC_INI_SAVE
+    ImGuiWindowSettings() { Name = NULL; Id = 0; Pos = Size = ImVec2(0,0); Collapsed = false; Dirty = false; }
+#else
     ImGuiWindowSettings() { Name = NULL; Id = 0; Pos = Size = ImVec2(0,0); Collapsed = false; }
+#endif
 };
 
 struct ImGuiSettingsHandler
@@ -453,6 +469,24 @@ struct ImGuiColumnsSet
     }
 };
 
+#ifdef IMGUI_WINDOW_HOVER_GRID
+// Uniform grid of CellSize cells over the display, listing each window in the cells its WindowRectClipped (+ TouchExtraPadding) overlaps.
+// Border cells also hold everything beyond the display. Begin() relinks a window only when its cell range changes.
+struct ImGuiWindowHoverGrid
+{
+    struct Node { ImGuiWindow* Window; int Next; };
+    float               CellSize;
+    int                 CellsX, CellsY;
+    ImVec2              Padding;                // TouchExtraPadding the cell ranges were computed with
+    ImVector<int>       Cells;                  // Head node per cell, -1 when empty
+    ImVector<Node>      Nodes;
+    int                 FreeNode;
+    bool                OrderDirty;             // g.Windows was reordered outside of EndFrame(): ImGuiWindow::HoverOrder needs renumbering
+
+    ImGuiWindowHoverGrid() { CellSize = 64.0f; CellsX = CellsY = 0; Padding = ImVec2(0.0f, 0.0f); FreeNode = -1; OrderDirty = true; }
+};
+#endif
+
 // Main state for ImGui
 struct ImGuiContext
 {
@@ -470,6 +504,9 @@ struct ImGuiContext
     int                     FrameCountRendered;
     ImVector<ImGuiWindow*>  Windows;
     ImVector<ImGuiWindow*>  WindowsSortBuffer;
+#ifdef IMGUI_WINDOW_HOVER_GRID
+    ImGuiWindowHoverGrid    WindowsHoverGrid;                   // Candidates for FindHoveredWindow()
+#endif
     ImVector<ImGuiWindow*>  CurrentWindowStack;
     ImGuiStorage            WindowsById;
     int                     WindowsActiveCount;
@@ -557,6 +594,10 @@ struct ImGuiContext
     float                          SettingsDirtyTimer;          // Save .ini Settings on disk when time reaches zero
     ImVector<ImGuiWindowSettings>  SettingsWindows;             // .ini settings for ImGuiWindow
     ImVector<ImGuiSettingsHandler> SettingsHandlers;            // List of .ini settings handlers
+#ifdef IMGUI_ASYNC_INI_SAVE
+    ImVector<int>                  SettingsDirty;               // Indices in SettingsWindows changed since the last save
+    ImGuiIniWriter*                SettingsWriter;              // Background thread writing the .ini file, started by the first save
+#endif
 
     // Logging
     bool                    LogEnabled;
@@ -644,6 +685,9 @@ struct ImGuiContext
         memset(MouseCursorData, 0, sizeof(MouseCursorData));
 
         SettingsDirtyTimer = 0.0f;
+#ifdef IMGUI_ASYNC_INI_SAVE
+        SettingsWriter = NULL;
+#endif
 
         LogEnabled = false;
         LogFile = NULL;
@@ -784,6 +828,13 @@ struct IMGUI_API ImGuiWindow
     ImVector<ImGuiID>       IDStack;                            // ID stack. ID are hashes seeded with the value at the top of the stack
     ImRect                  ClipRect;                           // = DrawList->clip_rect_stack.back(). Scissoring / clipping rectangle. x1, y1, x2, y2.
     ImRect                  WindowRectClipped;                  // = WindowRect just after setup in Begin(). == window->Rect() for root window.
+#ifdef IMGUI_WINDOW_HOVER_GRID
+    int                     HoverOrder;                         // Index in g.Windows (z-order), renumbered by EndFrame() or when reordered
+    int                     HoverCellMinX, HoverCellMinY, HoverCellMaxX, HoverCellMaxY; // Cells of g.WindowsHoverGrid listing this window, none when Min > Max
+#endif
+#ifdef IMGUI_ASYNC_INI_SAVE
+    int                     SettingsIdx;                        // Index in g.SettingsWindows, -1 until the window has an entry
+#endif
     ImRect                  InnerRect;
     int                     LastFrameActive;
     float                   ItemWidthDefault;
@@ -848,6 +899,7 @@ namespace ImGui
     inline    ImGuiWindow*  GetCurrentWindowRead()      { ImGuiContext& g = *GImGui; return g.CurrentWindow; }
     inline    ImGuiWindow*  GetCurrentWindow()          { ImGuiContext& g = *GImGui; g.CurrentWindow->WriteAccessed = true; return g.CurrentWindow; }
     IMGUI_API ImGuiWindow*  FindWindowByName(const char* name);
+    IMGUI_API ImGuiWindow*  FindHoveredWindow(ImVec2 pos);
     IMGUI_API void          FocusWindow(ImGuiWindow* window);
     IMGUI_API void          BringWindowToFront(ImGuiWindow* window);
     IMGUI_API void          BringWindowToBack(ImGuiWindow* window);
@@ -858,6 +910,7 @@ namespace ImGui
     IMGUI_API void                  MarkIniSettingsDirty();
     IMGUI_API ImGuiSettingsHandler* FindSettingsHandler(ImGuiID type_id);
     IMGUI_API ImGuiWindowSettings*  FindWindowSettings(ImGuiID id);
+    IMGUI_API void                  WaitIniSettingsSaved();     // Blocks until the .ini file is written: with IMGUI_ASYNC_INI_SAVE the background writer is idle
 
     IMGUI_API void          SetActiveID(ImGuiID id, ImGuiWindow* window);
     IMGUI_API void          ClearActiveID();
@@ -939,10 +992,21 @@ namespace ImGui
     IMGUI_API void          TreePushRawID(ImGuiID id);
 
     IMGUI_API void          PlotEx(ImGuiPlotType plot_type, const char* label, float (*values_getter)(void* data, int idx), void* data, int values_count, int values_offset, const char* overlay_text, float scale_min, float scale_max, ImVec2 graph_size);
+    IMGUI_API void          PlotSeriesEx(ImGuiPlotType plot_type, const char* label, const ImGuiPlotSeries& series, int values_first, int values_count, const char* overlay_text, float scale_min, float scale_max, ImVec2 graph_size);
 
     IMGUI_API int           ParseFormatPrecision(const char* fmt, int default_value);
     IMGUI_API float         RoundScalar(float value, int decimal_precision);
 
+    // Tessellation path of the anti-aliased AddPolyline()/AddConvexPolyFilled(), an ImDrawSimd_ value. Defaults to the
+    // best one the CPU supports and is clamped to it; every path produces the same vertices.
+    IMGUI_API int           GetDrawSimdLevel();
+    IMGUI_API void          SetDrawSimdLevel(int level);
+
+    // ImHash() path: true for the SSE4.2 crc32 instruction, false for the slicing-by-8 tables. Defaults to the instruction
+    // when the CPU has it and can't be turned on otherwise; both paths produce the same IDs.
+    IMGUI_API bool          GetHashHardware();
+    IMGUI_API void          SetHashHardware(bool enabled);
+
     // Shade functions
     IMGUI_API void          ShadeVertsLinearColorGradientKeepAlpha(ImDrawVert* vert_start, ImDrawVert* vert_end, ImVec2 gradient_p0, ImVec2 gradient_p1, ImU32 col0, ImU32 col1);
     IMGUI_API void          ShadeVertsLinearAlphaGradientForLeftToRightText(ImDrawVert* vert_start, ImDrawVert* vert_end, float gradient_p0_x, float gradient_p1_x);
@@ -0,0 +1,6 @@
+#version 330
+in vec4 vert_color;
+out vec4 out_Color;
+void main() {
+	out_Color = vert_color;
+}
@@ -0,0 +1,32 @@
+// Clustered forward lighting: lights binned per froxel by ClusteredLighting on the CPU
+uniform samplerBuffer lightData;       // 3 texels per light: position.xyz radius / color / direction.xyz cosCutoff
+uniform usamplerBuffer clusterLights;  // offset, count per cluster
+uniform usamplerBuffer lightIndices;
+uniform ivec3 clusterDims;
+uniform vec2 clusterTileSize;          // pixels
+uniform vec2 clusterDepth;             // slices / log(far / near), log(near)
+
+vec3 clusteredLighting(vec3 viewPos, vec3 normal, vec3 albedo)
+{
+	int slice = clamp(int((log(max(-viewPos.z, 1e-4)) - clusterDepth.y) * clusterDepth.x), 0, clusterDims.z - 1);
+	ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterTileSize), ivec2(0), clusterDims.xy - 1);
+	uvec2 range = texelFetch(clusterLights, (slice * clusterDims.y + tile.y) * clusterDims.x + tile.x).xy;
+
+	vec3 result = vec3(0.0);
+	for (uint i = 0u; i < range.y; i++)
+	{
+		int light = int(texelFetch(lightIndices, int(range.x + i)).x) * 3;
+		vec4 positionRadius = texelFetch(lightData, light);
+		vec3 color = texelFetch(lightData, light + 1).rgb;
+		vec4 spot = texelFetch(lightData, light + 2);
+
+		vec3 toLight = positionRadius.xyz - viewPos;
+		float distance2 = dot(toLight, toLight);
+		vec3 L = toLight * inversesqrt(max(distance2, 1e-8));
+		// Smooth window reaching 0 at the radius, the light's froxel bound
+		float window = clamp(1.0 - distance2 / (positionRadius.w * positionRadius.w), 0.0, 1.0);
+		float cone = spot.w < -1.0 ? 1.0 : smoothstep(spot.w, spot.w + 0.05, dot(-L, spot.xyz));
+		result += albedo * color * max(dot(normal, L), 0.0) * window * window * cone;
+	}
+	return result;
+}
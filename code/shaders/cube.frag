@@ -0,0 +1,13 @@
+#version 330
+in vec4 vert_Normal;
+in vec3 vert_ViewPos;
+out vec4 out_Color;
+uniform mat4 mv_Mat;
+uniform vec4 color;
+
+#include "clustered.glsl"
+
+void main() {
+	vec3 lights = clusteredLighting(vert_ViewPos, normalize(vert_Normal.xyz), color.xyz);
+	out_Color = vec4(color.xyz * dot(vert_Normal, mv_Mat*vec4(0.0, 1.0, 0.0, 0.0)) + color.xyz * 0.3 + lights, 1.0 );
+}
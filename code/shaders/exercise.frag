@@ -0,0 +1,7 @@
+#version 330
+
+out vec4 color;
+uniform vec4 triangleColor;
+void main(){
+	color = triangleColor;
+}
@@ -0,0 +1,6 @@
+#version 330
+layout (location = 0) in vec3 aPos;
+
+void main(){
+	gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
+}
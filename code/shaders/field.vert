@@ -0,0 +1,13 @@
+#version 330
+in vec3 in_Position;
+in vec3 in_Normal;
+in mat4 in_ObjMat;
+out vec4 vert_Normal;
+out vec3 vert_ViewPos;
+uniform mat4 mv_Mat;
+uniform mat4 mvpMat;
+void main() {
+	gl_Position = mvpMat * in_ObjMat * vec4(in_Position, 1.0);
+	vert_Normal = mv_Mat * in_ObjMat * vec4(in_Normal, 0.0);
+	vert_ViewPos = vec3(mv_Mat * in_ObjMat * vec4(in_Position, 1.0));
+}
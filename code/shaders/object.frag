@@ -0,0 +1,32 @@
+#version 330
+in vec4 vert_Normal;
+in vec3 FragPos;
+in vec2 vert_UV;
+flat in int vert_Material;
+in vec3 vert_ViewPos;
+out vec4 out_Color;
+uniform vec3 lightPos;
+uniform mat4 mv_Mat;
+uniform vec4 color;
+uniform sampler2D diffuseMap;
+
+#include "clustered.glsl"
+
+// Packed material table, one entry per .mtl material (Object::PackedMaterial)
+struct Material {
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular; // w = shininess
+};
+layout (std140) uniform Materials {
+	Material materials[256];
+};
+
+void main() {
+	Material material = materials[vert_Material];
+	vec3 texel = texture(diffuseMap, vert_UV).rgb;
+	vec3 albedo = color.xyz * texel;
+	float lambert = dot(vert_Normal, mv_Mat * vec4(0.0, 1.0, 0.0, 0.0));
+	vec3 lights = clusteredLighting(vert_ViewPos, normalize(vert_Normal.xyz), material.diffuse.rgb * texel);
+	out_Color = vec4(albedo * (material.diffuse.rgb * lambert + material.ambient.rgb * 0.3) + lights, 1.0 );
+}
@@ -0,0 +1,22 @@
+#version 330
+layout (location = 0) in vec3 in_Vertices;
+layout (location = 1) in vec3 in_Normals;
+layout (location = 2) in vec2 in_UVs;
+layout (location = 3) in int in_Material;
+out vec4 vert_Normal;
+out vec3 FragPos;
+out vec2 vert_UV;
+flat out int vert_Material;
+out vec3 vert_ViewPos;
+uniform mat4 objMat;
+uniform mat4 mv_Mat;
+uniform mat4 mvpMat;
+uniform vec3 viewPos;
+void main() {
+	gl_Position = mvpMat * objMat * vec4(in_Vertices, 1.0);
+	vert_Normal = mv_Mat * objMat * vec4(in_Normals, 0.0);
+	FragPos = vec3(objMat * vec4(in_Vertices, 1.0));
+	vert_UV = in_UVs;
+	vert_Material = in_Material;
+	vert_ViewPos = vec3(mv_Mat * objMat * vec4(in_Vertices, 1.0));
+}
@@ -0,0 +1,415 @@
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <glm\gtc\matrix_transform.hpp>
+
+#include "ClusteredLighting.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+
+namespace ClusteredLighting
+{
+	std::vector<Light> lights;
+	bool animate = true;
+
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		// Froxel bounds in view space, rebuilt when the projection changes
+		glm::mat4 clusterProjection(0.f);
+		float nearZ, farZ;
+		std::vector<glm::vec3> clusterMin, clusterMax;
+
+		// Froxel range touched by each light (empty when z0 > z1)
+		struct Bounds
+		{
+			int x0, x1, y0, y1, z0, z1;
+		};
+		std::vector<Bounds> bounds;
+		// Per-cluster lists, cleared every frame but keeping their capacity
+		std::vector< std::vector<unsigned int> > clusterLists(clusterCount);
+
+		float angle = 0.f;
+		Stats stats = {};
+
+		GLuint buffers[3], textures[3];
+
+		// Benchmark
+		const int benchSteps[] = { 1, 10, 100, 500, 1000, 2500, 5000, 10000 };
+		const int benchWarmup = 10, benchFrames = 50;
+		int benchStep = -1, benchFrame, benchRestore;
+		double benchFrameSum, benchBinSum;
+		Clock::time_point benchLast;  // previous build(): frames are timed from one call to the next
+		std::vector<BenchPoint> benchResults;
+
+		void planes(const glm::mat4& projection, float& n, float& f)
+		{
+			n = projection[3][2] / (projection[2][2] - 1.f);
+			f = projection[3][2] / (projection[2][2] + 1.f);
+		}
+
+		int sliceOf(float depth)
+		{
+			int z = (int)(std::log(depth / nearZ) * slices / std::log(farZ / nearZ));
+			return std::min(std::max(z, 0), slices - 1);
+		}
+
+		void buildClusters(const glm::mat4& projection)
+		{
+			clusterProjection = projection;
+			planes(projection, nearZ, farZ);
+			clusterMin.resize(clusterCount);
+			clusterMax.resize(clusterCount);
+
+			const glm::mat4 inverse = glm::inverse(projection);
+			for (int ty = 0; ty < tilesY; ty++)
+			{
+				for (int tx = 0; tx < tilesX; tx++)
+				{
+					// Tile corners on the near plane, then pushed to each slice's depths
+					glm::vec3 corners[4];
+					for (int k = 0; k < 4; k++)
+					{
+						float nx = (tx + (k & 1)) * 2.f / tilesX - 1.f;
+						float ny = (ty + (k >> 1)) * 2.f / tilesY - 1.f;
+						glm::vec4 p = inverse * glm::vec4(nx, ny, -1.f, 1.f);
+						corners[k] = glm::vec3(p) / p.w;
+					}
+					for (int z = 0; z < slices; z++)
+					{
+						float depths[2] = {
+							nearZ * std::pow(farZ / nearZ, (float)z / slices),
+							nearZ * std::pow(farZ / nearZ, (float)(z + 1) / slices) };
+						glm::vec3 lo(1e30f), hi(-1e30f);
+						for (int d = 0; d < 2; d++)
+						{
+							for (int k = 0; k < 4; k++)
+							{
+								glm::vec3 p = corners[k] * (depths[d] / -corners[k].z);
+								lo = glm::min(lo, p);
+								hi = glm::max(hi, p);
+							}
+						}
+						int c = (z * tilesY + ty) * tilesX + tx;
+						clusterMin[c] = lo;
+						clusterMax[c] = hi;
+					}
+				}
+			}
+		}
+
+		Bounds lightBounds(const glm::mat4& projection, const glm::vec3& center, float radius)
+		{
+			Bounds b = { 0, tilesX - 1, 0, tilesY - 1, 1, 0 };
+			float dmin = -center.z - radius, dmax = -center.z + radius;
+			if (dmax < nearZ || dmin > farZ)
+				return b;
+			b.z0 = sliceOf(std::max(dmin, nearZ));
+			b.z1 = sliceOf(std::min(dmax, farZ));
+
+			// Entirely in front of the camera: the projected box of the sphere bounds the tiles
+			if (dmin > nearZ)
+			{
+				glm::vec2 lo(1e30f), hi(-1e30f);
+				for (int k = 0; k < 8; k++)
+				{
+					glm::vec3 corner = center + radius * glm::vec3(k & 1 ? 1.f : -1.f, k & 2 ? 1.f : -1.f, k & 4 ? 1.f : -1.f);
+					glm::vec4 clip = projection * glm::vec4(corner, 1.f);
+					glm::vec2 ndc = glm::vec2(clip) / clip.w;
+					lo = glm::min(lo, ndc);
+					hi = glm::max(hi, ndc);
+				}
+				b.x0 = std::max(0, (int)std::floor((lo.x * 0.5f + 0.5f) * tilesX));
+				b.x1 = std::min(tilesX - 1, (int)std::floor((hi.x * 0.5f + 0.5f) * tilesX));
+				b.y0 = std::max(0, (int)std::floor((lo.y * 0.5f + 0.5f) * tilesY));
+				b.y1 = std::min(tilesY - 1, (int)std::floor((hi.y * 0.5f + 0.5f) * tilesY));
+				if (b.x0 > b.x1 || b.y0 > b.y1)
+					b.z0 = 1, b.z1 = 0;
+			}
+			return b;
+		}
+
+		bool sphereTouchesBox(const glm::vec3& center, float radius, const glm::vec3& lo, const glm::vec3& hi)
+		{
+			glm::vec3 d = center - glm::clamp(center, lo, hi);
+			return glm::dot(d, d) <= radius * radius;
+		}
+
+		// Every cluster of slice z only gets written by this job
+		void binSlice(const SceneView& view, int z)
+		{
+			const int first = z * tilesX * tilesY;
+			for (int c = first; c < first + tilesX * tilesY; c++)
+				clusterLists[c].clear();
+
+			for (int i = 0; i < (int)bounds.size(); i++)
+			{
+				const Bounds& b = bounds[i];
+				if (z < b.z0 || z > b.z1)
+					continue;
+				const glm::vec3 center(view.lightData[i * 3]);
+				const float radius = view.lightData[i * 3].w;
+				for (int ty = b.y0; ty <= b.y1; ty++)
+				{
+					for (int tx = b.x0; tx <= b.x1; tx++)
+					{
+						int c = first + ty * tilesX + tx;
+						if (sphereTouchesBox(center, radius, clusterMin[c], clusterMax[c]))
+							clusterLists[c].push_back((unsigned int)i);
+					}
+				}
+			}
+		}
+
+		void benchmarkFrame()
+		{
+			if (benchStep < 0)
+				return;
+			Clock::time_point now = Clock::now();
+			if (benchFrame >= benchWarmup)
+			{
+				benchFrameSum += std::chrono::duration<double>(now - benchLast).count();
+				benchBinSum += stats.binMs;
+			}
+			benchLast = now;
+			if (++benchFrame < benchWarmup + benchFrames)
+				return;
+
+			BenchPoint point = { benchSteps[benchStep], (float)(1e3 * benchFrameSum / benchFrames), (float)(benchBinSum / benchFrames) };
+			benchResults.push_back(point);
+			benchFrame = 0;
+			benchFrameSum = benchBinSum = 0.0;
+			if (++benchStep == (int)(sizeof(benchSteps) / sizeof(benchSteps[0])))
+			{
+				benchStep = -1;
+				generate(benchRestore);
+			}
+			else
+				generate(benchSteps[benchStep]);
+		}
+	}
+
+	void generate(int count)
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Lighting, "ClusteredLighting::generate");
+		// Light 0: the spot light that used to be Object::Light
+		lights.resize(1);
+		lights[0].position = glm::vec3(0.f, 6.f, 0.f);
+		lights[0].radius = 15.f;
+		lights[0].color = glm::vec3(0.9f, 0.1f, 0.1f);
+		lights[0].direction = glm::vec3(0.f, -1.f, 0.f);
+		lights[0].cosCutoff = glm::cos(glm::radians(12.5f));
+
+		unsigned seed = 2024u;
+		struct Random
+		{
+			static float next(unsigned& s) { s = s * 1664525u + 1013904223u; return (s >> 8) / 16777216.f; }
+		};
+		for (int i = 1; i < count; i++)
+		{
+			Light l;
+			l.position = glm::vec3(Random::next(seed) * 40.f - 20.f, 0.5f + Random::next(seed) * 3.5f, Random::next(seed) * 40.f - 20.f);
+			l.radius = 1.f + Random::next(seed) * 2.f;
+			l.color = glm::vec3(Random::next(seed), Random::next(seed), Random::next(seed));
+			bool spot = Random::next(seed) < 0.3f;
+			l.direction = glm::normalize(glm::vec3(Random::next(seed) - 0.5f, -1.f, Random::next(seed) - 0.5f));
+			l.cosCutoff = spot ? glm::cos(glm::radians(30.f)) : -2.f;
+			lights.push_back(l);
+		}
+	}
+
+	void build(SceneView& view, float dt)
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Lighting, "ClusteredLighting::build");
+		benchmarkFrame();
+		if (view.width <= 0 || view.height <= 0)
+			return;
+
+		Clock::time_point start = Clock::now();
+		if (lights.empty())
+			generate(1);
+		if (view.projection != clusterProjection)
+			buildClusters(view.projection);
+		if (animate)
+			angle += dt * 0.3f;
+
+		// View space light data and froxel ranges
+		const int n = (int)lights.size();
+		const glm::mat4 orbit = glm::rotate(glm::mat4(), angle, glm::vec3(0.f, 1.f, 0.f));
+		view.lightData.resize((size_t)n * 3);
+		bounds.resize(n);
+		JobSystem::parallelFor(n, 256, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				const Light& l = lights[i];
+				// Everything but the key light circles around the scene
+				glm::mat4 toView = i == 0 ? view.modelView : view.modelView * orbit;
+				glm::vec3 position = glm::vec3(toView * glm::vec4(l.position, 1.f));
+				glm::vec3 direction = glm::normalize(glm::mat3(toView) * l.direction);
+				view.lightData[i * 3 + 0] = glm::vec4(position, l.radius);
+				view.lightData[i * 3 + 1] = glm::vec4(l.color, 0.f);
+				view.lightData[i * 3 + 2] = glm::vec4(direction, l.cosCutoff);
+				bounds[i] = lightBounds(view.projection, position, l.radius);
+			}
+		});
+
+		JobSystem::parallelFor(slices, 1, [&](int begin, int end)
+		{
+			for (int z = begin; z < end; z++)
+				binSlice(view, z);
+		});
+
+		// Compact the per-cluster lists
+		view.clusterLights.resize(clusterCount * 2);
+		unsigned int total = 0;
+		int maxInCluster = 0;
+		for (int c = 0; c < clusterCount; c++)
+		{
+			const int count = (int)clusterLists[c].size();
+			view.clusterLights[c * 2] = total;
+			view.clusterLights[c * 2 + 1] = count;
+			total += count;
+			maxInCluster = std::max(maxInCluster, count);
+		}
+		view.lightIndices.resize(total);
+		for (int c = 0; c < clusterCount; c++)
+		{
+			if (!clusterLists[c].empty())
+				memcpy(&view.lightIndices[view.clusterLights[c * 2]], &clusterLists[c][0], clusterLists[c].size() * sizeof(unsigned int));
+		}
+
+		stats.lights = n;
+		stats.binMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		stats.maxInCluster = maxInCluster;
+		stats.indexCount = (int)total;
+	}
+
+	void setup()
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Lighting, "ClusteredLighting::setup");
+		const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+		glGenBuffers(3, buffers);
+		glGenTextures(3, textures);
+		for (int i = 0; i < 3; i++)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+			glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+			MemoryTracker::gpuBuffer(buffers[i], 16);
+			glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+			glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+		}
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	void cleanup()
+	{
+		glDeleteTextures(3, textures);
+		glDeleteBuffers(3, buffers);
+		MemoryTracker::gpuBuffersDeleted(3, buffers);
+	}
+
+	void upload(const SceneView& view)
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Lighting, "ClusteredLighting::upload");
+		const void* data[3] = {
+			view.lightData.empty() ? NULL : &view.lightData[0],
+			view.clusterLights.empty() ? NULL : &view.clusterLights[0],
+			view.lightIndices.empty() ? NULL : &view.lightIndices[0] };
+		const size_t sizes[3] = {
+			view.lightData.size() * sizeof(glm::vec4),
+			view.clusterLights.size() * sizeof(unsigned int),
+			view.lightIndices.size() * sizeof(unsigned int) };
+
+		for (int i = 0; i < 3; i++)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+			if (sizes[i])
+			{
+				glBufferData(GL_TEXTURE_BUFFER, sizes[i], data[i], GL_STREAM_DRAW);
+				MemoryTracker::gpuBuffer(buffers[i], sizes[i]);
+			}
+		}
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	void bind(GLuint program, const SceneView& view)
+	{
+		const char* samplers[3] = { "lightData", "clusterLights", "lightIndices" };
+		for (int i = 0; i < 3; i++)
+		{
+			glActiveTexture(GL_TEXTURE1 + i);
+			glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+			glUniform1i(glGetUniformLocation(program, samplers[i]), 1 + i);
+		}
+		glActiveTexture(GL_TEXTURE0);
+
+		ShadeParams params = shadeParams(view);
+		glUniform3i(glGetUniformLocation(program, "clusterDims"), tilesX, tilesY, slices);
+		glUniform2f(glGetUniformLocation(program, "clusterTileSize"), params.tileWidth, params.tileHeight);
+		glUniform2f(glGetUniformLocation(program, "clusterDepth"), params.depthScale, params.logNear);
+	}
+
+	ShadeParams shadeParams(const SceneView& view)
+	{
+		float n, f;
+		planes(view.projection, n, f);
+		ShadeParams params = { (float)view.width / tilesX, (float)view.height / tilesY, slices / std::log(f / n), std::log(n) };
+		return params;
+	}
+
+	glm::vec3 shade(const SceneView& view, const ShadeParams& params, const glm::vec3& viewPos, const glm::vec3& normal, const glm::vec3& albedo, float fragX, float fragY)
+	{
+		int slice = std::min(std::max((int)((std::log(std::max(-viewPos.z, 1e-4f)) - params.logNear) * params.depthScale), 0), slices - 1);
+		int tileX = std::min(std::max((int)(fragX / params.tileWidth), 0), tilesX - 1);
+		int tileY = std::min(std::max((int)(fragY / params.tileHeight), 0), tilesY - 1);
+		size_t cluster = ((size_t)slice * tilesY + tileY) * tilesX + tileX;
+		if (cluster * 2 + 1 >= view.clusterLights.size())
+			return glm::vec3(0.f);
+		const unsigned int offset = view.clusterLights[cluster * 2], count = view.clusterLights[cluster * 2 + 1];
+
+		glm::vec3 result(0.f);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const glm::vec4* light = &view.lightData[view.lightIndices[offset + i] * 3];
+			glm::vec3 toLight = glm::vec3(light[0]) - viewPos;
+			float distance2 = glm::dot(toLight, toLight);
+			glm::vec3 L = toLight / std::sqrt(std::max(distance2, 1e-8f));
+			float window = glm::clamp(1.f - distance2 / (light[0].w * light[0].w), 0.f, 1.f);
+			float cone = light[2].w < -1.f ? 1.f : glm::smoothstep(light[2].w, light[2].w + 0.05f, glm::dot(-L, glm::vec3(light[2])));
+			result += albedo * glm::vec3(light[1]) * std::max(glm::dot(normal, L), 0.f) * window * window * cone;
+		}
+		return result;
+	}
+
+	Stats getStats()
+	{
+		return stats;
+	}
+
+	void startBenchmark()
+	{
+		if (benchStep >= 0)
+			return;
+		benchRestore = (int)lights.size();
+		benchResults.clear();
+		benchStep = 0;
+		benchFrame = 0;
+		benchFrameSum = benchBinSum = 0.0;
+		benchLast = Clock::now();
+		generate(benchSteps[0]);
+	}
+
+	bool benchmarkRunning()
+	{
+		return benchStep >= 0;
+	}
+
+	const std::vector<BenchPoint>& benchmarkResults()
+	{
+		return benchResults;
+	}
+}
@@ -0,0 +1,366 @@
+#include <imgui\imgui.h>
+#include <imgui\imgui_internal.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "FontCache.h"
+#include "LogConsole.h"
+#include "MemoryTracker.h"
+
+namespace FontCache
+{
+	namespace
+	{
+		const unsigned int version = 1;
+
+		// File layout: Header, FontEntry[fontCount], RectEntry[rectCount], ImFontGlyph[glyphCount],
+		// then texWidth * texHeight alpha bytes. Every block is a multiple of 4 bytes.
+		struct Header
+		{
+			char magic[4];
+			unsigned int version;
+			unsigned long long key;
+			unsigned long long size;    // whole file, catches truncated writes
+			int texWidth, texHeight;
+			int configCount, fontCount, rectCount, glyphCount;
+		};
+
+		struct FontEntry
+		{
+			float ascent, descent;
+			int glyphCount;             // from the TTF pass, ImFontAtlasBuildFinish adds the rest
+			int metricsTotalSurface;
+		};
+
+		struct RectEntry
+		{
+			unsigned short x, y;
+		};
+
+		// FNV-1a over 64-bit words, byte tail
+		struct Hasher
+		{
+			unsigned long long value;
+
+			Hasher() : value(14695981039346656037ull) {}
+
+			void add(const void* data, size_t size)
+			{
+				const unsigned char* bytes = (const unsigned char*)data;
+				for (; size >= 8; size -= 8, bytes += 8)
+				{
+					unsigned long long word;
+					memcpy(&word, bytes, 8);
+					value = (value ^ word) * 1099511628211ull;
+				}
+				for (; size > 0; size--, bytes++)
+					value = (value ^ *bytes) * 1099511628211ull;
+			}
+
+			template <typename T>
+			void add(const T& v)
+			{
+				add(&v, sizeof(T));
+			}
+		};
+
+		struct MappedFile
+		{
+			const unsigned char* data;
+			size_t size;
+#ifdef _WIN32
+			HANDLE file, mapping;
+#endif
+		};
+
+		bool mapFile(const char* path, MappedFile& out)
+		{
+			out.data = NULL;
+			out.size = 0;
+#ifdef _WIN32
+			out.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (out.file == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER size;
+			out.mapping = GetFileSizeEx(out.file, &size) && size.QuadPart > 0 ? CreateFileMappingA(out.file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+			if (out.mapping == NULL)
+			{
+				CloseHandle(out.file);
+				return false;
+			}
+			out.data = (const unsigned char*)MapViewOfFile(out.mapping, FILE_MAP_READ, 0, 0, 0);
+			out.size = (size_t)size.QuadPart;
+			if (out.data == NULL)
+			{
+				CloseHandle(out.mapping);
+				CloseHandle(out.file);
+				return false;
+			}
+#else
+			int fd = open(path, O_RDONLY);
+			if (fd < 0)
+				return false;
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size <= 0)
+			{
+				close(fd);
+				return false;
+			}
+			void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (data == MAP_FAILED)
+				return false;
+			out.data = (const unsigned char*)data;
+			out.size = (size_t)st.st_size;
+#endif
+			return true;
+		}
+
+		void unmapFile(MappedFile& file)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(file.data);
+			CloseHandle(file.mapping);
+			CloseHandle(file.file);
+#else
+			munmap((void*)file.data, file.size);
+#endif
+			file.data = NULL;
+		}
+
+		void makeDirectory(const char* path)
+		{
+#ifdef _WIN32
+			_mkdir(path);
+#else
+			mkdir(path, 0755);
+#endif
+		}
+
+		int fontIndex(const ImFontAtlas* atlas, const ImFont* font)
+		{
+			for (int i = 0; i < atlas->Fonts.Size; i++)
+				if (atlas->Fonts[i] == font)
+					return i;
+			return -1;
+		}
+
+		// Glyphs ImFontAtlasBuildFinish appends to 'font': the custom rectangle ones, then TAB
+		int finishGlyphCount(const ImFontAtlas* atlas, const ImFont* font)
+		{
+			int count = 0;
+			for (int i = 0; i < atlas->CustomRects.Size; i++)
+				if (atlas->CustomRects[i].Font == font && atlas->CustomRects[i].ID <= 0x10000)
+					count++;
+			if (!font->Glyphs.empty() && font->Glyphs.back().Codepoint == '\t')
+				count++;
+			return count;
+		}
+
+		// Everything ImFontAtlasBuildWithStbTruetype reads
+		unsigned long long computeKey(const ImFontAtlas* atlas)
+		{
+			Hasher h;
+			h.add(version);
+			h.add(sizeof(ImFontGlyph));
+			h.add(atlas->TexDesiredWidth);
+			h.add(atlas->TexGlyphPadding);
+			h.add(atlas->Fonts.Size);
+			for (int i = 0; i < atlas->ConfigData.Size; i++)
+			{
+				const ImFontConfig& cfg = atlas->ConfigData[i];
+				h.add(cfg.FontDataSize);
+				h.add(cfg.FontData, (size_t)cfg.FontDataSize);
+				h.add(cfg.FontNo);
+				h.add(cfg.SizePixels);
+				h.add(cfg.OversampleH);
+				h.add(cfg.OversampleV);
+				h.add(cfg.PixelSnapH);
+				h.add(cfg.GlyphExtraSpacing);
+				h.add(cfg.GlyphOffset);
+				h.add(cfg.MergeMode);
+				h.add(cfg.RasterizerMultiply);
+				h.add(fontIndex(atlas, cfg.DstFont));
+				const ImWchar* range = cfg.GlyphRanges;
+				for (; range[0] && range[1]; range += 2)
+					h.add(range, 2 * sizeof(ImWchar));
+			}
+			for (int i = 0; i < atlas->CustomRects.Size; i++)
+			{
+				const ImFontAtlas::CustomRect& r = atlas->CustomRects[i];
+				h.add(r.ID);
+				h.add(r.Width);
+				h.add(r.Height);
+				h.add(r.GlyphAdvanceX);
+				h.add(r.GlyphOffset);
+				h.add(fontIndex(atlas, r.Font));
+			}
+			return h.value;
+		}
+
+		bool load(ImFontAtlas* atlas, const char* path, unsigned long long key)
+		{
+			MappedFile file;
+			if (!mapFile(path, file))
+				return false;
+
+			Header header;
+			bool valid = file.size >= sizeof(Header);
+			if (valid)
+			{
+				memcpy(&header, file.data, sizeof(Header));
+				valid = memcmp(header.magic, "IMFA", 4) == 0 && header.version == version && header.key == key && header.size == file.size &&
+					header.configCount == atlas->ConfigData.Size && header.fontCount == atlas->Fonts.Size && header.rectCount == atlas->CustomRects.Size &&
+					header.size == sizeof(Header) + header.fontCount * sizeof(FontEntry) + header.rectCount * sizeof(RectEntry) +
+						header.glyphCount * sizeof(ImFontGlyph) + (size_t)header.texWidth * header.texHeight;
+			}
+			if (!valid)
+			{
+				unmapFile(file);
+				return false;
+			}
+
+			const FontEntry* entries = (const FontEntry*)(file.data + sizeof(Header));
+			const RectEntry* rects = (const RectEntry*)(entries + header.fontCount);
+			const ImFontGlyph* glyphs = (const ImFontGlyph*)(rects + header.rectCount);
+			const unsigned char* pixels = (const unsigned char*)(glyphs + header.glyphCount);
+			std::vector<FontEntry> fonts(entries, entries + header.fontCount);
+			int glyphCount = 0;
+			for (int i = 0; i < header.fontCount; i++)
+				glyphCount += fonts[i].glyphCount >= 0 ? fonts[i].glyphCount : header.glyphCount + 1;
+			if (glyphCount != header.glyphCount)
+			{
+				unmapFile(file);
+				return false;
+			}
+
+			// Same state ImFontAtlasBuildWithStbTruetype leaves before ImFontAtlasBuildFinish
+			atlas->TexID = NULL;
+			atlas->ClearTexData();
+			atlas->TexWidth = header.texWidth;
+			atlas->TexHeight = header.texHeight;
+			atlas->TexUvWhitePixel = ImVec2(0, 0);
+			atlas->TexPixelsAlpha8 = (unsigned char*)ImGui::MemAlloc((size_t)header.texWidth * header.texHeight);
+			memcpy(atlas->TexPixelsAlpha8, pixels, (size_t)header.texWidth * header.texHeight);
+			for (int i = 0; i < header.rectCount; i++)
+			{
+				atlas->CustomRects[i].X = rects[i].x;
+				atlas->CustomRects[i].Y = rects[i].y;
+			}
+			for (int i = 0; i < atlas->ConfigData.Size; i++)
+			{
+				ImFontConfig& cfg = atlas->ConfigData[i];
+				const FontEntry& font = fonts[fontIndex(atlas, cfg.DstFont)];
+				ImFontAtlasBuildSetupFont(atlas, cfg.DstFont, &cfg, font.ascent, font.descent);
+			}
+			for (int i = 0; i < header.fontCount; i++)
+			{
+				ImVector<ImFontGlyph>& dst = atlas->Fonts[i]->Glyphs;
+				dst.resize(fonts[i].glyphCount);
+				if (fonts[i].glyphCount > 0)
+					memcpy(dst.Data, glyphs, fonts[i].glyphCount * sizeof(ImFontGlyph));
+				glyphs += fonts[i].glyphCount;
+			}
+			unmapFile(file);
+
+			ImFontAtlasBuildFinish(atlas);
+			for (int i = 0; i < header.fontCount; i++)
+				atlas->Fonts[i]->MetricsTotalSurface = fonts[i].metricsTotalSurface;
+			return true;
+		}
+
+		bool save(const ImFontAtlas* atlas, const char* path, unsigned long long key)
+		{
+			Header header;
+			memcpy(header.magic, "IMFA", 4);
+			header.version = version;
+			header.key = key;
+			header.texWidth = atlas->TexWidth;
+			header.texHeight = atlas->TexHeight;
+			header.configCount = atlas->ConfigData.Size;
+			header.fontCount = atlas->Fonts.Size;
+			header.rectCount = atlas->CustomRects.Size;
+			header.glyphCount = 0;
+
+			std::vector<FontEntry> fonts(atlas->Fonts.Size);
+			for (int i = 0; i < atlas->Fonts.Size; i++)
+			{
+				const ImFont* font = atlas->Fonts[i];
+				fonts[i].ascent = font->Ascent;
+				fonts[i].descent = font->Descent;
+				fonts[i].glyphCount = font->Glyphs.Size - finishGlyphCount(atlas, font);
+				fonts[i].metricsTotalSurface = font->MetricsTotalSurface;
+				header.glyphCount += fonts[i].glyphCount;
+			}
+			std::vector<RectEntry> rects(atlas->CustomRects.Size);
+			for (int i = 0; i < atlas->CustomRects.Size; i++)
+			{
+				rects[i].x = atlas->CustomRects[i].X;
+				rects[i].y = atlas->CustomRects[i].Y;
+			}
+			header.size = sizeof(Header) + fonts.size() * sizeof(FontEntry) + rects.size() * sizeof(RectEntry) +
+				header.glyphCount * sizeof(ImFontGlyph) + (size_t)header.texWidth * header.texHeight;
+
+			FILE* file = fopen(path, "wb");
+			if (file == NULL)
+				return false;
+			bool ok = fwrite(&header, sizeof(Header), 1, file) == 1;
+			if (!fonts.empty())
+				ok = ok && fwrite(&fonts[0], sizeof(FontEntry), fonts.size(), file) == fonts.size();
+			if (!rects.empty())
+				ok = ok && fwrite(&rects[0], sizeof(RectEntry), rects.size(), file) == rects.size();
+			for (int i = 0; i < atlas->Fonts.Size; i++)
+				if (fonts[i].glyphCount > 0)
+					ok = ok && fwrite(atlas->Fonts[i]->Glyphs.Data, sizeof(ImFontGlyph), fonts[i].glyphCount, file) == (size_t)fonts[i].glyphCount;
+			ok = ok && fwrite(atlas->TexPixelsAlpha8, 1, (size_t)header.texWidth * header.texHeight, file) == (size_t)header.texWidth * header.texHeight;
+			ok = fclose(file) == 0 && ok;
+			if (!ok)
+				remove(path);
+			return ok;
+		}
+	}
+
+	bool build(ImFontAtlas* atlas, const char* directory)
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Fonts, "FontCache::build");
+		if (atlas->ConfigData.empty())
+			atlas->AddFontDefault();
+
+		// Dynamic glyphs keep rasterizing from the TTF data, a cached bake would save little
+		if (atlas->DynamicGlyphs)
+		{
+			atlas->Build();
+			return false;
+		}
+
+		// The defaults Build() would fill in, so they are part of the key
+		ImFontAtlasBuildRegisterDefaultCustomRects(atlas);
+		for (int i = 0; i < atlas->ConfigData.Size; i++)
+			if (!atlas->ConfigData[i].GlyphRanges)
+				atlas->ConfigData[i].GlyphRanges = atlas->GetGlyphRangesDefault();
+
+		const unsigned long long key = computeKey(atlas);
+		char path[512];
+		snprintf(path, sizeof(path), "%s/imgui_atlas_%016llx.bin", directory, key);
+		if (load(atlas, path, key))
+			return true;
+
+		if (!atlas->Build())
+			return false;
+		makeDirectory(directory);
+		if (!save(atlas, path, key))
+			LogConsole::log(LogConsole::Warning, "FontCache: could not write %s\n", path);
+		return false;
+	}
+}
@@ -0,0 +1,327 @@
+#include <GL\glew.h>
+#include <thread>
+#include <imgui\imgui.h>
+#include <imgui\imgui_internal.h>
+#include <imgui\imgui_impl_sdl_gl3.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "FramePipeline.h"
+
+extern void GLinit(int width, int height);
+extern void GLcleanup();
+extern void GLsubmit(const SceneView& view);
+
+namespace FramePipeline
+{
+	namespace
+	{
+		const int packetCount = 2; // double-buffered: main builds one packet while the render thread draws the other
+
+		FramePacket packets[packetCount];
+		SPSCQueue<FramePacket*, 4> readyPackets; // main -> render
+		SPSCQueue<FramePacket*, 4> freePackets;  // render -> main
+		FramePacket* cancelledPacket = NULL;     // main thread only
+
+		std::thread renderThread;
+		SDL_sem* readySignal = NULL; // idle mode: the render thread sleeps on it instead of spinning
+		std::atomic<bool> ready(false);
+		std::atomic<bool> quit(false);
+		std::atomic<bool> threaded(false);
+
+		SDL_Window* window = NULL;
+		SDL_GLContext context = NULL;
+		int initWidth, initHeight;
+
+		// Present statistics, written by the presenting thread and read by the GUI
+		std::atomic<float> framesPerSecond(0.f);
+		std::atomic<float> inputLatencyMs(0.f);
+		std::atomic<float> skippedPerSecond(0.f);
+		std::atomic<float> cpuPercent(0.f);
+		std::atomic<int> windowSkips(0);
+		Uint64 windowStart = 0;
+		int windowFrames = 0;
+		double windowCpu = 0.0;
+
+		// Idle mode
+		std::atomic<Uint32> wakeEvent((Uint32)-1);
+		std::atomic<bool> woken(false);
+
+		// User + kernel time of every thread of the process, in seconds
+		double processCpuSeconds()
+		{
+#ifdef _WIN32
+			FILETIME creation, exit, kernel, user;
+			if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+				return 0.0;
+			ULARGE_INTEGER k, u;
+			k.LowPart = kernel.dwLowDateTime;
+			k.HighPart = kernel.dwHighDateTime;
+			u.LowPart = user.dwLowDateTime;
+			u.HighPart = user.dwHighDateTime;
+			return (double)(k.QuadPart + u.QuadPart) * 1e-7; // 100 ns units
+#else
+			rusage usage;
+			getrusage(RUSAGE_SELF, &usage);
+			return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+		}
+
+		template <typename T>
+		void copyVector(ImVector<T>& dst, const ImVector<T>& src)
+		{
+			dst.resize(src.Size);
+			if (src.Size > 0)
+				memcpy(dst.Data, src.Data, (size_t)src.Size * sizeof(T));
+		}
+
+		void drawPacket(FramePacket* packet)
+		{
+			GLsubmit(packet->view);
+			if (packet->fontWidth > 0)
+				ImGui_ImplSdlGL3_UpdateFontsTexture(packet->fontPixels.Data, packet->fontX, packet->fontY, packet->fontWidth, packet->fontHeight, packet->fontWidth);
+			if (packet->drawData.CmdListsCount > 0)
+				ImGui_ImplSdlGL3_RenderDrawData(&packet->drawData, packet->displaySize, packet->framebufferScale);
+			SDL_GL_SwapWindow(window);
+			recordPresent(packet->inputTimestamp);
+		}
+
+		void renderLoop()
+		{
+			SDL_GL_MakeCurrent(window, context);
+			GLinit(initWidth, initHeight);
+			ImGui_ImplSdlGL3_CreateDeviceObjects();
+			ready = true;
+
+			FramePacket* packet;
+			while (true)
+			{
+				if (readyPackets.pop(packet))
+				{
+					drawPacket(packet);
+					freePackets.push(packet);
+				}
+				else if (quit)
+				{
+					break;
+				}
+				else if (wakeEvent.load(std::memory_order_relaxed) != (Uint32)-1)
+				{
+					SDL_SemWait(readySignal);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			GLcleanup();
+			ImGui_ImplSdlGL3_InvalidateDeviceObjects();
+			SDL_GL_MakeCurrent(window, NULL);
+		}
+	}
+
+	bool start(SDL_Window* win, SDL_GLContext ctx, int width, int height)
+	{
+		window = win;
+		context = ctx;
+		initWidth = width;
+		initHeight = height;
+		for (int i = 0; i < packetCount; i++)
+			freePackets.push(&packets[i]);
+
+		// The context can only be current on one thread at a time
+		SDL_GL_MakeCurrent(window, NULL);
+		readySignal = SDL_CreateSemaphore(0);
+		quit = false;
+		renderThread = std::thread(renderLoop);
+		while (!ready)
+			std::this_thread::yield();
+
+		threaded = true;
+		return true;
+	}
+
+	void stop()
+	{
+		if (!threaded)
+			return;
+
+		quit = true;
+		SDL_SemPost(readySignal);
+		renderThread.join();
+		SDL_DestroySemaphore(readySignal);
+		readySignal = NULL;
+		threaded = false;
+		ready = false;
+		cancelledPacket = NULL;
+
+		SDL_GL_MakeCurrent(window, context);
+		for (int i = 0; i < packetCount; i++)
+		{
+			for (int n = 0; n < packets[i].drawLists.Size; n++)
+				delete packets[i].drawLists[n];
+			packets[i].drawLists.clear();
+		}
+	}
+
+	FramePacket* beginFrame()
+	{
+		FramePacket* packet = cancelledPacket;
+		cancelledPacket = NULL;
+		while (!packet && !freePackets.pop(packet))
+			std::this_thread::yield();
+		return packet;
+	}
+
+	void captureDrawData(FramePacket& packet, const ImDrawData* drawData)
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		packet.displaySize = io.DisplaySize;
+		packet.framebufferScale = io.DisplayFramebufferScale;
+
+		// The atlas pixels keep changing on this thread, so the packet carries its own copy of the new glyphs
+		ImFontAtlas* atlas = io.Fonts;
+		packet.fontWidth = 0;
+		if (atlas->TakeTexDirtyRect(&packet.fontX, &packet.fontY, &packet.fontWidth, &packet.fontHeight))
+		{
+			packet.fontPixels.resize(packet.fontWidth * packet.fontHeight);
+			for (int y = 0; y < packet.fontHeight; y++)
+				memcpy(packet.fontPixels.Data + y * packet.fontWidth, atlas->TexPixelsAlpha8 + packet.fontX + (packet.fontY + y) * atlas->TexWidth, (size_t)packet.fontWidth);
+		}
+
+		int count = (drawData && drawData->Valid) ? drawData->CmdListsCount : 0;
+		while (packet.drawLists.Size < count)
+			packet.drawLists.push_back(new ImDrawList());
+
+		for (int n = 0; n < count; n++)
+		{
+			const ImDrawList* src = drawData->CmdLists[n];
+			ImDrawList* dst = packet.drawLists[n];
+			copyVector(dst->CmdBuffer, src->CmdBuffer);
+			copyVector(dst->IdxBuffer, src->IdxBuffer);
+			copyVector(dst->VtxBuffer, src->VtxBuffer);
+		}
+
+		packet.drawData.Valid = count > 0;
+		packet.drawData.CmdLists = count > 0 ? packet.drawLists.Data : NULL;
+		packet.drawData.CmdListsCount = count;
+		packet.drawData.TotalVtxCount = count > 0 ? drawData->TotalVtxCount : 0;
+		packet.drawData.TotalIdxCount = count > 0 ? drawData->TotalIdxCount : 0;
+	}
+
+	void submitFrame(FramePacket* packet)
+	{
+		while (!readyPackets.push(packet))
+			std::this_thread::yield();
+		if (wakeEvent.load(std::memory_order_relaxed) != (Uint32)-1)
+			SDL_SemPost(readySignal);
+	}
+
+	void cancelFrame(FramePacket* packet)
+	{
+		cancelledPacket = packet;
+	}
+
+	void initIdle()
+	{
+		wakeEvent = SDL_RegisterEvents(1);
+	}
+
+	void wake()
+	{
+		// One queued event is enough to end the wait, the flag carries the rest
+		Uint32 type = wakeEvent.load(std::memory_order_relaxed);
+		if (woken.exchange(true) || type == (Uint32)-1)
+			return;
+		SDL_Event event;
+		SDL_zero(event);
+		event.type = type;
+		SDL_PushEvent(&event);
+	}
+
+	bool takeWake()
+	{
+		return woken.exchange(false);
+	}
+
+	bool isWakeEvent(const SDL_Event& event)
+	{
+		return event.type == wakeEvent.load(std::memory_order_relaxed);
+	}
+
+	ImU32 hashDrawData(const ImDrawData* drawData)
+	{
+		ImU32 hash = 0;
+		if (!drawData || !drawData->Valid)
+			return hash;
+		for (int n = 0; n < drawData->CmdListsCount; n++)
+		{
+			const ImDrawList* list = drawData->CmdLists[n];
+			if (list->VtxBuffer.Size > 0)
+				hash = ImHash(list->VtxBuffer.Data, list->VtxBuffer.Size * (int)sizeof(ImDrawVert), hash);
+			if (list->IdxBuffer.Size > 0)
+				hash = ImHash(list->IdxBuffer.Data, list->IdxBuffer.Size * (int)sizeof(ImDrawIdx), hash);
+			// Field by field: ImDrawCmd has padding
+			for (int c = 0; c < list->CmdBuffer.Size; c++)
+			{
+				const ImDrawCmd& cmd = list->CmdBuffer[c];
+				hash = ImHash(&cmd.ElemCount, sizeof(cmd.ElemCount), hash);
+				hash = ImHash(&cmd.ClipRect, sizeof(cmd.ClipRect), hash);
+				hash = ImHash(&cmd.TextureId, sizeof(cmd.TextureId), hash);
+				hash = ImHash(&cmd.UserCallback, sizeof(cmd.UserCallback), hash);
+			}
+		}
+		return hash;
+	}
+
+	void recordPresent(Uint64 inputTimestamp)
+	{
+		const Uint64 now = SDL_GetPerformanceCounter();
+		const double freq = (double)SDL_GetPerformanceFrequency();
+
+		// Exponential average so the GUI shows a stable number
+		float latency = (float)(1e3 * (double)(now - inputTimestamp) / freq);
+		float prev = inputLatencyMs.load(std::memory_order_relaxed);
+		inputLatencyMs.store(prev == 0.f ? latency : prev + (latency - prev) * 0.1f, std::memory_order_relaxed);
+
+		if (windowStart == 0)
+		{
+			windowStart = now;
+			windowCpu = processCpuSeconds();
+		}
+		windowFrames++;
+		double elapsed = (double)(now - windowStart) / freq;
+		if (elapsed >= 1.0)
+		{
+			double cpu = processCpuSeconds();
+			framesPerSecond.store((float)(windowFrames / elapsed), std::memory_order_relaxed);
+			skippedPerSecond.store((float)(windowSkips.exchange(0) / elapsed), std::memory_order_relaxed);
+			cpuPercent.store((float)(100.0 * (cpu - windowCpu) / elapsed), std::memory_order_relaxed);
+			windowStart = now;
+			windowFrames = 0;
+			windowCpu = cpu;
+		}
+	}
+
+	void recordSkip()
+	{
+		windowSkips++;
+	}
+
+	Stats getStats()
+	{
+		Stats stats;
+		stats.framesPerSecond = framesPerSecond.load(std::memory_order_relaxed);
+		stats.skippedPerSecond = skippedPerSecond.load(std::memory_order_relaxed);
+		stats.inputLatencyMs = inputLatencyMs.load(std::memory_order_relaxed);
+		stats.cpuPercent = cpuPercent.load(std::memory_order_relaxed);
+		stats.threaded = threaded;
+		stats.idle = wakeEvent.load(std::memory_order_relaxed) != (Uint32)-1;
+		return stats;
+	}
+}
@@ -0,0 +1,306 @@
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "JobSystem.h"
+
+namespace JobSystem
+{
+	namespace
+	{
+		// Chase-Lev deque with a fixed ring. The owner pushes/pops at the bottom, thieves take from the top.
+		class WorkDeque
+		{
+		public:
+			static const int64_t capacity = 4096;
+
+			WorkDeque() : top(0), bottom(0) {}
+
+			bool push(const Job& job)
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed);
+				int64_t t = top.load(std::memory_order_acquire);
+				if (b - t >= capacity - 1)
+					return false;
+				jobs[b & (capacity - 1)] = job;
+				std::atomic_thread_fence(std::memory_order_release);
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return true;
+			}
+
+			bool pop(Job& job)
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+				bottom.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t t = top.load(std::memory_order_relaxed);
+				if (t > b)
+				{
+					// Empty
+					bottom.store(b + 1, std::memory_order_relaxed);
+					return false;
+				}
+				job = jobs[b & (capacity - 1)];
+				if (t == b)
+				{
+					// Last item: race against thieves for it
+					bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+					bottom.store(b + 1, std::memory_order_relaxed);
+					return won;
+				}
+				return true;
+			}
+
+			bool steal(Job& job)
+			{
+				int64_t t = top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t b = bottom.load(std::memory_order_acquire);
+				if (t >= b)
+					return false;
+				job = jobs[t & (capacity - 1)];
+				return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			}
+
+			bool empty() const
+			{
+				return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_acquire);
+			}
+
+		private:
+			// Padding keeps the owner's and the thieves' ends on separate cache lines
+			std::atomic<int64_t> top;
+			char padTop[64 - sizeof(std::atomic<int64_t>)];
+			std::atomic<int64_t> bottom;
+			char padBottom[64 - sizeof(std::atomic<int64_t>)];
+			Job jobs[capacity];
+		};
+
+		std::vector<WorkDeque*> deques; // [0] belongs to the main thread
+		std::vector<std::thread> workers;
+		std::atomic<bool> quit(false);
+		std::atomic<int> activeThreads(0); // workers at or above this index take no jobs
+
+		// Sleeping support so idle workers don't spin between frames
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+		std::atomic<int> sleepers(0);
+
+		thread_local int threadIndex = -1;
+		thread_local unsigned stealSeed = 0;
+
+		bool getJob(Job& job)
+		{
+			int count = (int)deques.size();
+			if (threadIndex >= 0 && deques[threadIndex]->pop(job))
+				return true;
+
+			// Start at a different victim each time so thieves spread out
+			stealSeed = stealSeed * 1664525u + 1013904223u;
+			int start = (int)(stealSeed >> 16) % count;
+			for (int i = 0; i < count; i++)
+			{
+				int victim = (start + i) % count;
+				if (victim != threadIndex && deques[victim]->steal(job))
+					return true;
+			}
+			return false;
+		}
+
+		void wake()
+		{
+			if (sleepers.load(std::memory_order_relaxed) > 0)
+				sleepCondition.notify_all();
+		}
+
+		void finish(Counter* counter)
+		{
+			if (counter)
+				counter->pending.fetch_sub(1, std::memory_order_release);
+		}
+
+		void execute(Job job)
+		{
+			// Split off the upper half until the range is small enough, leaving those halves to thieves
+			while (job.grain > 0 && job.end - job.begin > job.grain)
+			{
+				int mid = job.begin + (job.end - job.begin) / 2;
+				Job upper = job;
+				upper.begin = mid;
+				if (job.counter)
+					job.counter->pending.fetch_add(1, std::memory_order_relaxed);
+				if (!deques[threadIndex]->push(upper))
+				{
+					finish(job.counter);
+					break; // deque full: run the whole remaining range here
+				}
+				wake();
+				job.end = mid;
+			}
+			job.function(job.data, job.begin, job.end);
+			finish(job.counter);
+		}
+
+		void workerLoop(int index)
+		{
+			threadIndex = index;
+			stealSeed = (unsigned)index * 2654435761u;
+
+			int idleSpins = 0;
+			Job job;
+			while (!quit.load(std::memory_order_relaxed))
+			{
+				if (index < activeThreads.load(std::memory_order_relaxed) && getJob(job))
+				{
+					execute(job);
+					idleSpins = 0;
+				}
+				else if (++idleSpins < 64)
+				{
+					std::this_thread::yield();
+				}
+				else
+				{
+					// Timed wait: a missed notify only costs a millisecond
+					std::unique_lock<std::mutex> lock(sleepMutex);
+					sleepers++;
+					sleepCondition.wait_for(lock, std::chrono::milliseconds(1));
+					sleepers--;
+				}
+			}
+		}
+	}
+
+	void init(int workerCount)
+	{
+		if (workerCount < 0)
+		{
+			int hw = (int)std::thread::hardware_concurrency();
+			workerCount = hw > 1 ? hw - 1 : 0;
+		}
+
+		quit = false;
+		threadIndex = 0;
+		for (int i = 0; i <= workerCount; i++)
+			deques.push_back(new WorkDeque());
+		activeThreads = workerCount + 1;
+		for (int i = 1; i <= workerCount; i++)
+			workers.push_back(std::thread(workerLoop, i));
+	}
+
+	void shutdown()
+	{
+		quit = true;
+		sleepCondition.notify_all();
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i].join();
+		workers.clear();
+
+		// Jobs nobody waited on yet (texture decodes) still have to run and release their counters,
+		// including work a worker split off just before it stopped
+		Job job;
+		while (getJob(job))
+			execute(job);
+
+		for (size_t i = 0; i < deques.size(); i++)
+			delete deques[i];
+		deques.clear();
+		activeThreads = 0;
+		threadIndex = -1;
+	}
+
+	int threadCount()
+	{
+		return activeThreads.load(std::memory_order_relaxed);
+	}
+
+	int maxThreadCount()
+	{
+		return (int)deques.size();
+	}
+
+	void setActiveThreads(int count)
+	{
+		int all = (int)deques.size();
+		activeThreads = count <= 0 || count > all ? all : count;
+	}
+
+	void waitIdle()
+	{
+		Job job;
+		for (;;)
+		{
+			if (getJob(job))
+			{
+				execute(job);
+				continue;
+			}
+			{
+				// A sleeping worker runs nothing and only the main thread can push now, so this state is final
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				bool empty = sleepers.load(std::memory_order_relaxed) == (int)workers.size();
+				for (size_t i = 0; empty && i < deques.size(); i++)
+					empty = deques[i]->empty();
+				if (empty)
+					return;
+			}
+			std::this_thread::yield();
+		}
+	}
+
+	void run(JobFunction function, void* data, int begin, int end, Counter* counter)
+	{
+		Job job = { function, data, begin, end, 0, counter };
+		if (counter)
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+		// Threads outside the system (or a full deque) just run the job inline
+		if (threadIndex < 0 || !deques[threadIndex]->push(job))
+		{
+			function(data, begin, end);
+			finish(counter);
+			return;
+		}
+		wake();
+	}
+
+	void parallelFor(int count, int grain, JobFunction function, void* data, Counter* counter)
+	{
+		if (count <= 0)
+			return;
+		if (grain < 1)
+			grain = 1;
+
+		Job job = { function, data, 0, count, grain, counter };
+		if (counter)
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+		if (threadIndex < 0)
+		{
+			function(data, 0, count);
+			finish(counter);
+		}
+		else if (count <= grain || !deques[threadIndex]->push(job))
+		{
+			execute(job);
+		}
+		else
+		{
+			wake();
+		}
+	}
+
+	void wait(Counter* counter)
+	{
+		Job job;
+		while (counter->pending.load(std::memory_order_acquire) > 0)
+		{
+			if (threadIndex >= 0 && getJob(job))
+				execute(job);
+			else
+				std::this_thread::yield();
+		}
+	}
+}
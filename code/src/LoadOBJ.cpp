@@ -1,15 +1,82 @@
 #include "LoadOBJ.h"
+#include "LogConsole.h"
+
+#include <algorithm>
 
 namespace loadObject
 {
+	// Paths inside .obj / .mtl files are relative to the file referencing them
+	static std::string siblingPath(const char* path, const char* name)
+	{
+		std::string dir(path);
+		size_t slash = dir.find_last_of("/\\");
+		return slash == std::string::npos ? std::string(name) : dir.substr(0, slash + 1) + name;
+	}
+
+	static void skipLine(FILE* file)
+	{
+		int c;
+		while ((c = fgetc(file)) != EOF && c != '\n') {}
+	}
+
+	// Read path, append every newmtl block to out_materials, return false if the file can't be opened
+	bool loadMTL(const char* path, std::vector < Material >& out_materials)
+	{
+		FILE* file = fopen(path, "r");
+		if (file == NULL)
+		{
+			LogConsole::log(LogConsole::Error, "Impossible to open the material file %s!\n", path);
+			return false;
+		}
+
+		Material* current = NULL;
+		while (1)
+		{
+			char lineHeader[128];
+			if (fscanf(file, "%127s", lineHeader) == EOF)
+				break;
+
+			if (strcmp(lineHeader, "newmtl") == 0)
+			{
+				char name[256];
+				fscanf(file, "%255s", name);
+				out_materials.push_back(Material());
+				current = &out_materials.back();
+				current->name = name;
+			}
+			else if (current && strcmp(lineHeader, "Ka") == 0)
+				fscanf(file, "%f %f %f", &current->ambient.x, &current->ambient.y, &current->ambient.z);
+			else if (current && strcmp(lineHeader, "Kd") == 0)
+				fscanf(file, "%f %f %f", &current->diffuse.x, &current->diffuse.y, &current->diffuse.z);
+			else if (current && strcmp(lineHeader, "Ks") == 0)
+				fscanf(file, "%f %f %f", &current->specular.x, &current->specular.y, &current->specular.z);
+			else if (current && strcmp(lineHeader, "Ns") == 0)
+				fscanf(file, "%f", &current->shininess);
+			else if (current && strcmp(lineHeader, "map_Kd") == 0)
+			{
+				char name[256];
+				fscanf(file, "%255s", name);
+				current->diffuseMap = siblingPath(path, name);
+			}
+			else
+				skipLine(file); // comments, illum, d, other maps...
+		}
+		fclose(file);
+		return true;
+	}
+
 	// Read path, write in out_vertices / out_uvs / out_normals, return false if something went wrong
 	bool loadOBJ(const char* path,
 		std::vector < glm::vec3 >& out_vertices,
 		std::vector < glm::vec2 >& out_uvs,
-		std::vector < glm::vec3 >& out_normals)
+		std::vector < glm::vec3 >& out_normals,
+		std::vector < SubMesh >& out_submeshes,
+		std::vector < Material >& out_materials)
 	{
 		// Generate variable to store .obj contents
 		std::vector< unsigned int > vertexIndices, uvIndices, normalIndices;
+		std::vector< int > faceMaterials;
+		int currentMaterial = 0;
 		std::vector< glm::vec3 > temp_vertices;
 		std::vector< glm::vec2 > temp_uvs;
 		std::vector< glm::vec3 > temp_normals;
@@ -19,16 +86,21 @@ namespace loadObject
 		if (file == NULL)
 		{
 			// Something went wrong
-			printf("Impossible to open the file!\n");
+			LogConsole::log(LogConsole::Error, "Impossible to open the file!\n");
 			return false;
 		}
 
+		// Default for faces without usemtl
+		const size_t firstMaterial = out_materials.size();
+		out_materials.push_back(Material());
+		out_materials.back().name = "default";
+
 		// Read the file untill EOF
 		while (1)
 		{
 			char lineHeader[128];
 			// Read the first word of the line
-			int res = fscanf(file, "%s", lineHeader);
+			int res = fscanf(file, "%127s", lineHeader);
 
 			if (res == EOF)
 				break; // EOF = End Of File. Quit the loop.
@@ -66,7 +138,8 @@ namespace loadObject
 
 				if (matches != 9)
 				{
-					printf("File can't be read by our simple parser : ( Try exporting with other options\n");
+					LogConsole::log(LogConsole::Error, "File can't be read by our simple parser : ( Try exporting with other options\n");
+					fclose(file);
 					return false;
 				}
 
@@ -79,35 +152,104 @@ namespace loadObject
 				normalIndices.push_back(normalIndex[0]);
 				normalIndices.push_back(normalIndex[1]);
 				normalIndices.push_back(normalIndex[2]);
+				faceMaterials.push_back(currentMaterial);
+			} // Material library (mtllib cube.mtl)
+			else if (strcmp(lineHeader, "mtllib") == 0)
+			{
+				char name[256];
+				fscanf(file, "%255s", name);
+				loadMTL(siblingPath(path, name).c_str(), out_materials);
+			} // Following faces use this material (usemtl name)
+			else if (strcmp(lineHeader, "usemtl") == 0)
+			{
+				char name[256];
+				fscanf(file, "%255s", name);
+				currentMaterial = 0;
+				for (size_t m = firstMaterial + 1; m < out_materials.size(); m++)
+				{
+					if (out_materials[m].name == name)
+						currentMaterial = (int)(m - firstMaterial);
+				}
+				if (currentMaterial == 0)
+					LogConsole::log(LogConsole::Warning, "Material %s not found, using the default\n", name);
+			}
+			else
+			{
+				// Comments, objects, smoothing groups...
+				skipLine(file);
 			}
 		}
+		fclose(file);
+
+		// MATERIAL ORDER
+		// Faces are emitted grouped by material, materials sharing a diffuse map next to each other
+		const int materialCount = (int)(out_materials.size() - firstMaterial);
+		std::vector< int > order(materialCount);
+		for (int m = 0; m < materialCount; m++)
+			order[m] = m;
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+		{
+			return out_materials[firstMaterial + a].diffuseMap < out_materials[firstMaterial + b].diffuseMap;
+		});
+
+		// Counting sort of the faces by material rank
+		std::vector< int > rank(materialCount), faceStart(materialCount + 1, 0);
+		for (int r = 0; r < materialCount; r++)
+			rank[order[r]] = r;
+		for (size_t f = 0; f < faceMaterials.size(); f++)
+			faceStart[rank[faceMaterials[f]] + 1]++;
+		for (int r = 0; r < materialCount; r++)
+			faceStart[r + 1] += faceStart[r];
+
+		std::vector< unsigned int > faceOrder(faceMaterials.size());
+		std::vector< int > next(faceStart.begin(), faceStart.end() - 1);
+		for (size_t f = 0; f < faceMaterials.size(); f++)
+			faceOrder[next[rank[faceMaterials[f]]]++] = (unsigned int)f;
+
+		for (int r = 0; r < materialCount; r++)
+		{
+			if (faceStart[r + 1] == faceStart[r])
+				continue;
+			SubMesh submesh;
+			submesh.material = (int)firstMaterial + order[r];
+			submesh.first = (int)out_vertices.size() + faceStart[r] * 3;
+			submesh.count = (faceStart[r + 1] - faceStart[r]) * 3;
+			out_submeshes.push_back(submesh);
+		}
 
 		// INDEX DATA
-		// For each vertex of each triangle
-		for (unsigned int i = 0; i < vertexIndices.size(); i++)
+		// For each vertex of each triangle, in material order
+		for (unsigned int k = 0; k < faceOrder.size() * 3; k++)
 		{
+			unsigned int i = faceOrder[k / 3] * 3 + k % 3;
+
 			// Index to the vertex position
 			unsigned int vertexIndex = vertexIndices[i];
 			// Position
 			glm::vec3 vertex = temp_vertices[vertexIndex - 1];
 			// Position of new vertex
 			out_vertices.push_back(vertex);
-		}
 
-		for (unsigned int i = 0; i < uvIndices.size(); i++)
-		{
 			// UVs
 			unsigned int uvIndex = uvIndices[i];
 			glm::vec2 uv = temp_uvs[uvIndex - 1];
 			out_uvs.push_back(uv);
-		}
 
-		for (unsigned int i = 0; i < normalIndices.size(); i++)
-		{
 			// Normals
 			unsigned int normalIndex = normalIndices[i];
 			glm::vec3 normal = temp_normals[normalIndex - 1];
 			out_normals.push_back(normal);
 		}
+		return true;
+	}
+
+	bool loadOBJ(const char* path,
+		std::vector < glm::vec3 >& out_vertices,
+		std::vector < glm::vec2 >& out_uvs,
+		std::vector < glm::vec3 >& out_normals)
+	{
+		std::vector < SubMesh > submeshes;
+		std::vector < Material > materials;
+		return loadOBJ(path, out_vertices, out_uvs, out_normals, submeshes, materials);
 	}
-}
\ No newline at end of file
+}
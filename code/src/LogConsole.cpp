@@ -0,0 +1,366 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <imgui\imgui.h>
+
+#include "LogConsole.h"
+#include "MemoryTracker.h"
+
+namespace LogConsole
+{
+	bool echo = true;
+	bool queue = true;
+	int maxLines = 10000000;
+	size_t maxBytes = (size_t)1 << 30;
+	float filterMs = 2.f;
+
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		////////////////////////////////////////////////// Queue
+		// Bounded multi-producer / single-consumer ring with a sequence number per slot (D. Vyukov): a producer claims
+		// a slot with one CAS on the tail and publishes it through the sequence, the consumer hands it back the same way
+		struct Slot
+		{
+			std::atomic<unsigned> sequence;
+			unsigned char level;
+			unsigned char length;
+			char text[maxLineLength];
+		};
+
+		const unsigned queueSize = 8192; // power of two
+		Slot slots[queueSize];
+		alignas(64) std::atomic<unsigned> tail(0); // producers
+		alignas(64) unsigned head = 0;             // consumer
+		std::atomic<long long> dropped(0);
+
+		struct SlotInit
+		{
+			SlotInit()
+			{
+				for (unsigned i = 0; i < queueSize; i++)
+					slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		} slotInit;
+
+		// Any thread. False when the queue is still full after giving the consumer a few time slices
+		bool push(Level level, const char* text, int length)
+		{
+			unsigned pos = tail.load(std::memory_order_relaxed);
+			Slot* slot;
+			int retries = 0;
+			while (true)
+			{
+				slot = &slots[pos & (queueSize - 1)];
+				int diff = (int)(slot->sequence.load(std::memory_order_acquire) - pos);
+				if (diff == 0)
+				{
+					if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+				{
+					if (++retries > 16)
+						return false;
+					std::this_thread::yield();
+					pos = tail.load(std::memory_order_relaxed);
+				}
+				else
+				{
+					pos = tail.load(std::memory_order_relaxed);
+				}
+			}
+			slot->level = (unsigned char)level;
+			slot->length = (unsigned char)length;
+			memcpy(slot->text, text, (size_t)length);
+			slot->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		////////////////////////////////////////////////// Lines
+		// Every line is [level][length][text] in a chunk, lines never straddle two chunks.
+		// Offsets are global (chunk number << chunkShift | offset in chunk), so dropping old chunks moves nothing.
+		const int chunkShift = 20;
+		const long long chunkSize = 1LL << chunkShift;
+
+		std::deque<char*> chunks;      // chunks[0] is chunk number firstChunk
+		long long firstChunk = 0;
+		char* spareChunk = NULL;       // the last dropped chunk, reused by the next one
+		long long writeOffset = 0;     // where the next line goes
+		std::deque<long long> lines;   // offset of every retained line, oldest first
+		long long firstLine = 0;       // id of lines[0], ids keep counting up
+		long long received = 0;
+
+		ImGuiTextFilter filter;
+		bool showLevel[3] = { true, true, true };
+		bool filterAll = true;         // no filter: line n of the view is lines[n], shownLines stays empty
+		std::deque<long long> shownLines; // ids of the lines that pass, oldest first
+		long long filterNext = 0;      // id of the next line to test
+
+		const char* lineText(long long id, Level& level, int& length)
+		{
+			const long long offset = lines[(size_t)(id - firstLine)];
+			const char* p = chunks[(size_t)((offset >> chunkShift) - firstChunk)] + (offset & (chunkSize - 1));
+			level = (Level)p[0];
+			length = (unsigned char)p[1];
+			return p + 2;
+		}
+
+		void dropFirstChunk()
+		{
+			delete[] spareChunk;
+			spareChunk = chunks.front();
+			chunks.pop_front();
+			firstChunk++;
+		}
+
+		void append(const Slot& slot)
+		{
+			const long long size = 2 + slot.length;
+			if ((writeOffset & (chunkSize - 1)) + size > chunkSize)
+				writeOffset = ((writeOffset >> chunkShift) + 1) << chunkShift;
+			if ((writeOffset >> chunkShift) == firstChunk + (long long)chunks.size())
+			{
+				chunks.push_back(spareChunk ? spareChunk : new char[(size_t)chunkSize]);
+				spareChunk = NULL;
+			}
+			char* p = chunks.back() + (writeOffset & (chunkSize - 1));
+			p[0] = (char)slot.level;
+			p[1] = (char)slot.length;
+			memcpy(p + 2, slot.text, slot.length);
+			lines.push_back(writeOffset);
+			writeOffset += size;
+			received++;
+
+			// Oldest lines past the limits, then the chunks nothing points into anymore
+			while ((int)lines.size() > maxLines)
+			{
+				lines.pop_front();
+				firstLine++;
+			}
+			while (chunks.size() > 1 && (long long)chunks.size() * chunkSize > (long long)maxBytes)
+			{
+				const long long chunkEnd = (firstChunk + 1) << chunkShift;
+				while (lines.front() < chunkEnd)
+				{
+					lines.pop_front();
+					firstLine++;
+				}
+				dropFirstChunk();
+			}
+			while (chunks.size() > 1 && lines.front() >= (firstChunk + 1) << chunkShift)
+				dropFirstChunk();
+		}
+
+		void restartFilter()
+		{
+			filterAll = !filter.IsActive() && showLevel[Info] && showLevel[Warning] && showLevel[Error];
+			shownLines.clear();
+			filterNext = firstLine;
+		}
+
+		// Tests the lines not seen yet, new ones and older ones after a filter change, for at most filterMs
+		void filterStep()
+		{
+			const long long end = firstLine + (long long)lines.size();
+			if (filterAll)
+			{
+				filterNext = end;
+				return;
+			}
+			Clock::time_point start = Clock::now();
+			for (int n = 1; filterNext < end; n++)
+			{
+				if ((n & 1023) == 0 && std::chrono::duration<float, std::milli>(Clock::now() - start).count() > filterMs)
+					break;
+				Level level;
+				int length;
+				const char* text = lineText(filterNext, level, length);
+				if (showLevel[level] && filter.PassFilter(text, text + length))
+					shownLines.push_back(filterNext);
+				filterNext++;
+			}
+		}
+
+		void drawLine(long long id)
+		{
+			Level level;
+			int length;
+			const char* text = lineText(id, level, length);
+			if (level != Info)
+				ImGui::PushStyleColor(ImGuiCol_Text, level == Error ? ImVec4(1.f, 0.4f, 0.4f, 1.f) : ImVec4(1.f, 0.8f, 0.3f, 1.f));
+			ImGui::TextUnformatted(text, text + length);
+			if (level != Info)
+				ImGui::PopStyleColor();
+		}
+	}
+
+	void logv(Level level, const char* format, va_list args)
+	{
+		char buffer[1024];
+		std::vector<char> large;
+		va_list copy;
+		va_copy(copy, args);
+		int length = vsnprintf(buffer, sizeof(buffer), format, args);
+		const char* text = buffer;
+		if (length >= (int)sizeof(buffer))
+		{
+			large.resize((size_t)length + 1);
+			vsnprintf(&large[0], large.size(), format, copy);
+			text = &large[0];
+		}
+		va_end(copy);
+		if (length <= 0)
+			return;
+
+		if (echo)
+		{
+			FILE* out = level == Info ? stdout : stderr;
+			fputs(text, out);
+			if (text[length - 1] != '\n')
+				fputc('\n', out);
+		}
+
+		if (!queue)
+			return;
+
+		// One slot per line
+		const char* end = text + length;
+		while (text < end)
+		{
+			const char* eol = (const char*)memchr(text, '\n', (size_t)(end - text));
+			if (!eol)
+				eol = end;
+			int n = (int)(eol - text);
+			if (n > 0 && text[n - 1] == '\r')
+				n--;
+			if (!push(level, text, std::min(n, maxLineLength)))
+				dropped++;
+			text = eol + 1;
+		}
+	}
+
+	void log(Level level, const char* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		logv(level, format, args);
+		va_end(args);
+	}
+
+	void drain()
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Log, "LogConsole::drain");
+		while (true)
+		{
+			Slot& slot = slots[head & (queueSize - 1)];
+			if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+				break;
+			append(slot);
+			slot.sequence.store(head + queueSize, std::memory_order_release);
+			head++;
+		}
+
+		while (!shownLines.empty() && shownLines.front() < firstLine)
+			shownLines.pop_front();
+		filterNext = std::max(filterNext, firstLine);
+		filterStep();
+	}
+
+	void clear()
+	{
+		firstLine += (long long)lines.size();
+		lines.clear();
+		while (!chunks.empty())
+			dropFirstChunk();
+		writeOffset = firstChunk << chunkShift;
+		restartFilter();
+	}
+
+	void setFilter(const char* text)
+	{
+		snprintf(filter.InputBuf, sizeof(filter.InputBuf), "%s", text ? text : "");
+		filter.Build();
+		restartFilter();
+	}
+
+	void draw(bool* open)
+	{
+		drain();
+
+		ImGui::SetNextWindowSize(ImVec2(720.f, 360.f), ImGuiCond_FirstUseEver);
+		if (!ImGui::Begin("Console", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (ImGui::Button("Clear"))
+			clear();
+		bool changed = false;
+		const char* levelNames[3] = { "Info", "Warnings", "Errors" };
+		for (int l = 0; l < 3; l++)
+		{
+			ImGui::SameLine();
+			changed |= ImGui::Checkbox(levelNames[l], &showLevel[l]);
+		}
+		ImGui::SameLine();
+		changed |= filter.Draw("Filter", 200.f);
+		if (changed)
+			restartFilter();
+
+		Stats stats = getStats();
+		ImGui::Text("%d lines, %d shown%s, %lld dropped, %.1f MB", stats.retained, stats.shown, stats.filtering ? " (filtering)" : "", stats.dropped, stats.textBytes / (1024.f * 1024.f));
+		ImGui::Separator();
+
+		ImGui::BeginChild("Lines", ImVec2(0.f, 0.f), false, ImGuiWindowFlags_HorizontalScrollbar);
+		const bool follow = ImGui::GetScrollY() >= ImGui::GetScrollMaxY(); // at the bottom: keep showing the newest line
+		const int shown = stats.shown;
+		const float lineHeight = ImGui::GetTextLineHeightWithSpacing();
+		const int maxRows = (int)(8388608.f / lineHeight); // 2^23 pixels: float positions are still exact
+		if (shown <= maxRows)
+		{
+			ImGuiListClipper clipper(shown, lineHeight);
+			while (clipper.Step())
+				for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+					drawLine(filterAll ? firstLine + i : shownLines[i]);
+		}
+		else
+		{
+			// Past that the scroll range covers maxRows rows and maps onto the lines proportionally
+			const float scroll = ImGui::GetScrollY();
+			const float range = ImGui::GetScrollMaxY();
+			const int visible = (int)(ImGui::GetWindowHeight() / lineHeight) + 1;
+			long long first = range > 0.f ? (long long)((double)scroll / range * (shown - visible)) : 0;
+			first = std::max(0LL, std::min(first, (long long)(shown - visible)));
+			ImGui::SetCursorPosY(scroll);
+			for (int i = 0; i < visible; i++)
+				drawLine(filterAll ? firstLine + first + i : shownLines[(size_t)(first + i)]);
+			ImGui::SetCursorPosY(maxRows * lineHeight);
+		}
+		if (follow)
+			ImGui::SetScrollHere(1.f);
+		ImGui::EndChild();
+
+		ImGui::End();
+	}
+
+	Stats getStats()
+	{
+		Stats stats;
+		stats.received = received;
+		stats.dropped = dropped.load(std::memory_order_relaxed);
+		stats.retained = (int)lines.size();
+		stats.shown = filterAll ? stats.retained : (int)shownLines.size();
+		stats.filtering = filterNext < firstLine + (long long)lines.size();
+		stats.textBytes = chunks.size() * (size_t)chunkSize;
+		return stats;
+	}
+}
@@ -0,0 +1,244 @@
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include <imgui\imgui.h>
+
+#include "MemorySystem.h"
+#include "MemoryTracker.h"
+
+namespace MemorySystem
+{
+	namespace
+	{
+		////////////////////////////////////////////////// Pool
+		// A page serves one size class. Pages are aligned on their size, so a pointer's page is ptr & ~(pageSize - 1)
+		// and the sorted page list tells both whether the pool owns a pointer and its class. Pages are kept for reuse.
+		const size_t pageSize = 64 * 1024;
+		const int classCount = 18;
+		const size_t classSizes[classCount] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192 };
+
+		struct FreeBlock
+		{
+			FreeBlock* next;
+		};
+
+		struct Page
+		{
+			uintptr_t base;
+			int sizeClass;
+			bool operator<(const Page& other) const { return base < other.base; }
+		};
+
+		unsigned char classOfSize[maxPoolSize / 16 + 1]; // (size + 15) / 16 -> smallest class that fits
+		FreeBlock* freeLists[classCount];
+		std::vector<Page> pages;                          // sorted by base
+
+		struct ClassInit
+		{
+			ClassInit()
+			{
+				int c = 0;
+				for (size_t units = 0; units <= maxPoolSize / 16; units++)
+				{
+					while (classSizes[c] < units * 16)
+						c++;
+					classOfSize[units] = (unsigned char)c;
+				}
+			}
+		} classInit;
+
+		void* alignedPage()
+		{
+#ifdef _WIN32
+			return _aligned_malloc(pageSize, pageSize);
+#else
+			void* page = NULL;
+			return posix_memalign(&page, pageSize, pageSize) == 0 ? page : NULL;
+#endif
+		}
+
+		// The page holding ptr, NULL for memory the pool does not own
+		const Page* findPage(const void* ptr)
+		{
+			Page key = { (uintptr_t)ptr & ~(uintptr_t)(pageSize - 1), 0 };
+			std::vector<Page>::const_iterator it = std::lower_bound(pages.begin(), pages.end(), key);
+			return it != pages.end() && it->base == key.base ? &*it : NULL;
+		}
+
+		bool refill(int sizeClass)
+		{
+			char* base = (char*)alignedPage();
+			if (!base)
+				return false;
+			Page page = { (uintptr_t)base, sizeClass };
+			pages.insert(std::upper_bound(pages.begin(), pages.end(), page), page);
+
+			// Blocks linked in address order
+			const size_t size = classSizes[sizeClass];
+			const size_t count = pageSize / size;
+			for (size_t i = 0; i + 1 < count; i++)
+				((FreeBlock*)(base + i * size))->next = (FreeBlock*)(base + (i + 1) * size);
+			((FreeBlock*)(base + (count - 1) * size))->next = freeLists[sizeClass];
+			freeLists[sizeClass] = (FreeBlock*)base;
+			return true;
+		}
+
+		////////////////////////////////////////////////// Frame arena
+		const size_t initialArena = 256 * 1024;
+		char* arena = NULL;
+		size_t arenaCapacity = 0;
+		size_t arenaUsed = 0;
+		std::vector<char*> retired;  // chunks filled up this frame, still referenced until beginFrame()
+		size_t retiredBytes = 0;
+
+		////////////////////////////////////////////////// Counters
+		Stats current = {};
+		Stats last = {};
+		int poolLive = 0;
+		size_t poolReserved = 0;
+
+		void* heapAlloc(size_t size)
+		{
+			current.heapAllocs++;
+			current.heapBytes += size;
+			return malloc(size);
+		}
+
+		// The memory ImGui holds, as the tracker sees it: the whole block for the pool, the requested size past it.
+		// Blocks ImGui got from malloc before installImGui() are in neither and not counted when freed.
+		int imguiSite = 0;
+		std::unordered_map<void*, size_t> imguiLarge;
+
+		void* imguiAlloc(size_t size)
+		{
+			void* ptr = poolAlloc(size);
+			if (!ptr)
+				return NULL;
+			if (size > maxPoolSize)
+				imguiLarge[ptr] = size;
+			MemoryTracker::countAlloc(imguiSite, size > maxPoolSize ? size : classSizes[classOfSize[(size + 15) / 16]]);
+			return ptr;
+		}
+
+		void imguiFree(void* ptr)
+		{
+			if (!ptr)
+				return;
+			if (const Page* page = findPage(ptr))
+				MemoryTracker::countFree(imguiSite, classSizes[page->sizeClass]);
+			else
+			{
+				std::unordered_map<void*, size_t>::iterator it = imguiLarge.find(ptr);
+				if (it != imguiLarge.end())
+				{
+					MemoryTracker::countFree(imguiSite, it->second);
+					imguiLarge.erase(it);
+				}
+			}
+			poolFree(ptr);
+		}
+	}
+
+	void* poolAlloc(size_t size)
+	{
+		if (size > maxPoolSize)
+			return heapAlloc(size);
+		const int sizeClass = classOfSize[(size + 15) / 16];
+		if (!freeLists[sizeClass])
+		{
+			current.heapAllocs++; // a new page comes from the heap
+			current.heapBytes += pageSize;
+			if (!refill(sizeClass))
+				return NULL;
+			poolReserved += pageSize;
+		}
+		FreeBlock* block = freeLists[sizeClass];
+		freeLists[sizeClass] = block->next;
+		current.poolAllocs++;
+		current.poolBytes += size;
+		poolLive++;
+		return block;
+	}
+
+	void poolFree(void* ptr)
+	{
+		if (!ptr)
+			return;
+		const Page* page = findPage(ptr);
+		if (!page)
+		{
+			free(ptr);
+			return;
+		}
+		FreeBlock* block = (FreeBlock*)ptr;
+		block->next = freeLists[page->sizeClass];
+		freeLists[page->sizeClass] = block;
+		poolLive--;
+	}
+
+	void* frameAlloc(size_t size, size_t align)
+	{
+		size_t offset = (arenaUsed + align - 1) & ~(align - 1);
+		if (!arena || offset + size > arenaCapacity)
+		{
+			// The full chunk stays valid until the end of the frame, the next one is at least twice as large
+			if (arena)
+			{
+				retired.push_back(arena);
+				retiredBytes += arenaCapacity;
+			}
+			arenaCapacity = std::max(std::max(initialArena, arenaCapacity * 2), size + align);
+			arena = (char*)heapAlloc(arenaCapacity);
+			MemoryTracker::countAlloc(MemoryTracker::site(MemoryTracker::Other, "Frame arena"), arenaCapacity);
+			offset = (((uintptr_t)arena + align - 1) & ~(uintptr_t)(align - 1)) - (uintptr_t)arena;
+		}
+		arenaUsed = offset + size;
+		current.frameAllocs++;
+		current.frameBytes += size;
+		return arena + offset;
+	}
+
+	void beginFrame()
+	{
+		last = current;
+		current = Stats();
+
+		// One chunk for what the last frame needed in total
+		if (!retired.empty())
+		{
+			const int site = MemoryTracker::site(MemoryTracker::Other, "Frame arena");
+			const size_t total = retiredBytes + arenaCapacity;
+			for (size_t i = 0; i < retired.size(); i++)
+				free(retired[i]);
+			retired.clear();
+			retiredBytes = 0;
+			free(arena);
+			MemoryTracker::countFree(site, total);
+			arenaCapacity = total;
+			arena = (char*)heapAlloc(arenaCapacity);
+			MemoryTracker::countAlloc(site, arenaCapacity);
+		}
+		arenaUsed = 0;
+	}
+
+	void installImGui()
+	{
+		imguiSite = MemoryTracker::site(MemoryTracker::Gui, "ImGui");
+		ImGuiIO& io = ImGui::GetIO();
+		io.MemAllocFn = imguiAlloc;
+		io.MemFreeFn = imguiFree;
+	}
+
+	Stats getStats()
+	{
+		Stats stats = last;
+		stats.poolLive = poolLive;
+		stats.poolReserved = poolReserved;
+		stats.arenaCapacity = arenaCapacity;
+		return stats;
+	}
+}
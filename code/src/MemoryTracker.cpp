@@ -0,0 +1,482 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <algorithm>
+#include <imgui\imgui.h>
+
+#include "MemoryTracker.h"
+#include "LogConsole.h"
+
+namespace MemoryTracker
+{
+	namespace
+	{
+		////////////////////////////////////////////////// Sites
+		// Append only: a name is written before the count that publishes it, lookups scan without the lock
+		const char* siteNames[maxSites] = { "(untagged)" };
+		Tag siteTags[maxSites] = { Other };
+		std::atomic<int> siteCount(1);
+		std::atomic_flag siteLock = ATOMIC_FLAG_INIT;
+
+		////////////////////////////////////////////////// Counters
+		// Only the owning thread writes its counters, with a plain load and store. The report reads every thread's.
+		struct Counter
+		{
+			std::atomic<long long> allocs, frees, bytes, freedBytes;
+		};
+		struct ThreadCounters
+		{
+			Counter sites[maxSites];
+		};
+
+		// Blocks are never given back, threads past maxThreads share the last one with locked adds
+		const int maxThreads = 64;
+		ThreadCounters threads[maxThreads + 1];
+		std::atomic<int> threadCount(0);
+		thread_local ThreadCounters* counters = NULL;
+		thread_local int currentSite = 0;
+
+		std::atomic<long long> sitePeak[maxSites];
+
+		ThreadCounters* threadCounters()
+		{
+			ThreadCounters* c = counters;
+			if (!c)
+				c = counters = &threads[std::min(threadCount.fetch_add(1), maxThreads)];
+			return c;
+		}
+
+		inline void add(ThreadCounters* owner, std::atomic<long long>& value, long long delta)
+		{
+			if (owner == &threads[maxThreads])
+				value.fetch_add(delta, std::memory_order_acq_rel);
+			else
+				value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_release);
+		}
+
+		inline void raise(std::atomic<long long>& peak, long long value)
+		{
+			long long current = peak.load(std::memory_order_relaxed);
+			while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+				;
+		}
+
+		// Registered threads and the shared block
+		long long sum(int site, std::atomic<long long> Counter::* field)
+		{
+			const int count = std::min(threadCount.load(std::memory_order_acquire), maxThreads);
+			long long value = (threads[maxThreads].sites[site].*field).load(std::memory_order_acquire);
+			for (int t = 0; t < count; t++)
+				value += (threads[t].sites[site].*field).load(std::memory_order_acquire);
+			return value;
+		}
+
+		// Frees are read before allocations: a free seen here happened after its allocation, so live never goes negative
+		long long siteLive(int site)
+		{
+			const long long freed = sum(site, &Counter::freedBytes);
+			return sum(site, &Counter::bytes) - freed;
+		}
+
+		////////////////////////////////////////////////// operator new
+		// 16 bytes keep the default new alignment of 64-bit targets
+		const size_t headerSize = 16;
+		struct Header
+		{
+			size_t size;
+			int site;
+		};
+
+		void* allocate(size_t size)
+		{
+			if (size > (size_t)-1 - headerSize)
+				return NULL;
+			Header* header = (Header*)malloc(size + headerSize);
+			if (!header)
+				return NULL;
+			header->size = size;
+			header->site = currentSite;
+			countAlloc(header->site, size);
+			return (char*)header + headerSize;
+		}
+
+		void release(void* ptr)
+		{
+			if (!ptr)
+				return;
+			Header* header = (Header*)((char*)ptr - headerSize);
+			countFree(header->site, header->size);
+			free(header);
+		}
+
+		////////////////////////////////////////////////// GL objects
+		// GL thread only, except the byte counts the report reads
+		enum GpuKind { Buffer, Texture };
+		struct GpuObject
+		{
+			int site;
+			size_t bytes;
+		};
+		std::unordered_map<unsigned, GpuObject> gpuObjects[2];
+		std::atomic<long long> gpuBytes[2][maxSites];
+		std::atomic<long long> gpuSitePeak[maxSites];
+		std::atomic<long long> gpuTotal(0), gpuTotalPeak(0);
+
+		inline void gpuAdd(std::atomic<long long>& value, long long delta)
+		{
+			value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+		}
+
+		void gpuSet(GpuKind kind, unsigned handle, size_t bytes)
+		{
+			if (!handle)
+				return;
+			GpuObject& object = gpuObjects[kind][handle];
+			gpuAdd(gpuBytes[kind][object.site], -(long long)object.bytes);
+			gpuAdd(gpuTotal, (long long)bytes - (long long)object.bytes);
+			object.site = currentSite;
+			object.bytes = bytes;
+			gpuAdd(gpuBytes[kind][object.site], (long long)bytes);
+
+			const long long site = gpuBytes[Buffer][object.site].load(std::memory_order_relaxed) + gpuBytes[Texture][object.site].load(std::memory_order_relaxed);
+			raise(gpuSitePeak[object.site], site);
+			raise(gpuTotalPeak, gpuTotal.load(std::memory_order_relaxed));
+		}
+
+		void gpuDelete(GpuKind kind, int count, const unsigned* handles)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				std::unordered_map<unsigned, GpuObject>::iterator it = gpuObjects[kind].find(handles[i]);
+				if (it == gpuObjects[kind].end())
+					continue;
+				gpuAdd(gpuBytes[kind][it->second.site], -(long long)it->second.bytes);
+				gpuAdd(gpuTotal, -(long long)it->second.bytes);
+				gpuObjects[kind].erase(it);
+			}
+		}
+
+		////////////////////////////////////////////////// Report
+		// Main thread, refreshed by beginFrame()
+		struct Totals
+		{
+			long long allocs, frees;
+		};
+		Totals lastTotals[maxSites];
+		Usage siteReport[maxSites];
+		Usage tagReport[TagCount];
+		Usage totalReport;
+		int reportSites = 0;
+		long long frame = 0;
+
+		const char* const tagNames[TagCount] = { "Other", "Mesh", "Textures", "Shaders", "Fonts", "Scene", "Lighting", "Culling", "Log", "ImGui" };
+
+		void accumulate(Usage& into, const Usage& usage)
+		{
+			into.live += usage.live;
+			into.allocs += usage.allocs;
+			into.allocsPerFrame += usage.allocsPerFrame;
+			into.freesPerFrame += usage.freesPerFrame;
+			into.gpuBuffers += usage.gpuBuffers;
+			into.gpuTextures += usage.gpuTextures;
+		}
+
+		bool byFootprint(const SiteUsage& a, const SiteUsage& b)
+		{
+			return a.usage.live + a.usage.gpuBuffers + a.usage.gpuTextures > b.usage.live + b.usage.gpuBuffers + b.usage.gpuTextures;
+		}
+
+		// "12.3 MB"
+		const char* formatBytes(char* buffer, size_t size, long long bytes)
+		{
+			if (bytes >= 1024 * 1024 || bytes <= -1024 * 1024)
+				snprintf(buffer, size, "%.1f MB", bytes / (1024.0 * 1024.0));
+			else if (bytes >= 1024 || bytes <= -1024)
+				snprintf(buffer, size, "%.1f KB", bytes / 1024.0);
+			else
+				snprintf(buffer, size, "%lld B", bytes);
+			return buffer;
+		}
+
+		struct Bytes
+		{
+			char text[32];
+			explicit Bytes(long long bytes) { formatBytes(text, sizeof(text), bytes); }
+		};
+	}
+
+	const char* tagName(Tag tag)
+	{
+		return tag >= 0 && tag < TagCount ? tagNames[tag] : "?";
+	}
+
+	int site(Tag tag, const char* name)
+	{
+		const int count = siteCount.load(std::memory_order_acquire);
+		for (int i = 1; i < count; i++)
+			if (siteNames[i] == name && siteTags[i] == tag)
+				return i;
+
+		while (siteLock.test_and_set(std::memory_order_acquire))
+			std::this_thread::yield();
+		int id = siteCount.load(std::memory_order_relaxed);
+		for (int i = 1; i < id; i++)
+			if (siteTags[i] == tag && strcmp(siteNames[i], name) == 0)
+			{
+				id = i;
+				break;
+			}
+		if (id == siteCount.load(std::memory_order_relaxed))
+		{
+			if (id < maxSites)
+			{
+				siteNames[id] = name;
+				siteTags[id] = tag;
+				siteCount.store(id + 1, std::memory_order_release);
+			}
+			else
+				id = 0;
+		}
+		siteLock.clear(std::memory_order_release);
+		return id;
+	}
+
+	Scope::Scope(Tag tag, const char* name) : previous(currentSite), current(site(tag, name))
+	{
+		currentSite = current;
+	}
+
+	Scope::~Scope()
+	{
+		currentSite = previous;
+		raise(sitePeak[current], siteLive(current));
+	}
+
+	void countAlloc(int site, size_t bytes)
+	{
+		ThreadCounters* owner = threadCounters();
+		Counter& c = owner->sites[site];
+		add(owner, c.allocs, 1);
+		add(owner, c.bytes, (long long)bytes);
+	}
+
+	void countFree(int site, size_t bytes)
+	{
+		ThreadCounters* owner = threadCounters();
+		Counter& c = owner->sites[site];
+		add(owner, c.frees, 1);
+		add(owner, c.freedBytes, (long long)bytes);
+	}
+
+	void gpuBuffer(unsigned handle, size_t bytes) { gpuSet(Buffer, handle, bytes); }
+	void gpuTexture(unsigned handle, size_t bytes) { gpuSet(Texture, handle, bytes); }
+	void gpuBuffersDeleted(int count, const unsigned* handles) { gpuDelete(Buffer, count, handles); }
+	void gpuTexturesDeleted(int count, const unsigned* handles) { gpuDelete(Texture, count, handles); }
+
+	void beginFrame()
+	{
+		frame++;
+		reportSites = siteCount.load(std::memory_order_acquire);
+		totalReport = Usage();
+		for (int t = 0; t < TagCount; t++)
+			tagReport[t] = Usage();
+
+		for (int s = 0; s < reportSites; s++)
+		{
+			Totals now;
+			now.frees = sum(s, &Counter::frees);
+			const long long freed = sum(s, &Counter::freedBytes);
+			now.allocs = sum(s, &Counter::allocs);
+			const long long bytes = sum(s, &Counter::bytes);
+
+			Usage& usage = siteReport[s];
+			usage.live = bytes - freed;
+			raise(sitePeak[s], usage.live);
+			usage.peak = sitePeak[s].load(std::memory_order_relaxed);
+			usage.allocs = now.allocs;
+			usage.allocsPerFrame = (int)(now.allocs - lastTotals[s].allocs);
+			usage.freesPerFrame = (int)(now.frees - lastTotals[s].frees);
+			usage.gpuBuffers = gpuBytes[Buffer][s].load(std::memory_order_relaxed);
+			usage.gpuTextures = gpuBytes[Texture][s].load(std::memory_order_relaxed);
+			usage.gpuPeak = gpuSitePeak[s].load(std::memory_order_relaxed);
+			lastTotals[s] = now;
+
+			// A tag's peak is the sum of its sites' peaks: an upper bound, the sites need not peak together
+			Usage& tag = tagReport[siteTags[s]];
+			accumulate(tag, usage);
+			tag.peak += usage.peak;
+			tag.gpuPeak += usage.gpuPeak;
+			accumulate(totalReport, usage);
+		}
+
+		static long long totalPeak = 0;
+		totalPeak = std::max(totalPeak, totalReport.live);
+		totalReport.peak = totalPeak;
+		totalReport.gpuPeak = gpuTotalPeak.load(std::memory_order_relaxed);
+	}
+
+	Usage total()
+	{
+		return totalReport;
+	}
+
+	Usage tagUsage(Tag tag)
+	{
+		return tagReport[tag];
+	}
+
+	int topSites(SiteUsage* out, int max)
+	{
+		SiteUsage all[maxSites];
+		int n = 0;
+		for (int s = 0; s < reportSites; s++)
+		{
+			const Usage& usage = siteReport[s];
+			if (usage.live == 0 && usage.gpuBuffers == 0 && usage.gpuTextures == 0 && usage.allocsPerFrame == 0)
+				continue;
+			all[n].name = siteNames[s];
+			all[n].tag = siteTags[s];
+			all[n].usage = usage;
+			n++;
+		}
+		const int shown = std::min(n, max);
+		std::partial_sort(all, all + shown, all + n, byFootprint);
+		std::copy(all, all + shown, out);
+		return shown;
+	}
+
+	void draw(bool* open)
+	{
+		ImGui::SetNextWindowSize(ImVec2(720.f, 480.f), ImGuiCond_FirstUseEver);
+		if (!ImGui::Begin("Memory", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		const Usage all = total();
+		ImGui::Text("CPU %s live, %s peak, %d allocations / %d frees per frame", Bytes(all.live).text, Bytes(all.peak).text, all.allocsPerFrame, all.freesPerFrame);
+		ImGui::Text("GPU %s in buffers, %s in textures, %s peak", Bytes(all.gpuBuffers).text, Bytes(all.gpuTextures).text, Bytes(all.gpuPeak).text);
+		static const char* dumpFile = "memory_report.txt";
+		static int dumped = 0; // 1 written, -1 failed
+		if (ImGui::Button("Dump to memory_report.txt"))
+			dumped = dump(dumpFile) ? 1 : -1;
+		if (dumped)
+		{
+			ImGui::SameLine();
+			ImGui::TextUnformatted(dumped > 0 ? "written" : "could not write");
+		}
+
+		ImGui::Separator();
+		ImGui::Columns(6, "tags");
+		const char* tagHeaders[6] = { "Subsystem", "Live", "Peak", "Allocs/frame", "GPU buffers", "GPU textures" };
+		for (int c = 0; c < 6; c++)
+		{
+			ImGui::TextUnformatted(tagHeaders[c]);
+			ImGui::NextColumn();
+		}
+		ImGui::Separator();
+		for (int t = 0; t < TagCount; t++)
+		{
+			const Usage& usage = tagReport[t];
+			ImGui::TextUnformatted(tagNames[t]); ImGui::NextColumn();
+			ImGui::TextUnformatted(Bytes(usage.live).text); ImGui::NextColumn();
+			ImGui::TextUnformatted(Bytes(usage.peak).text); ImGui::NextColumn();
+			ImGui::Text("%d", usage.allocsPerFrame); ImGui::NextColumn();
+			ImGui::TextUnformatted(Bytes(usage.gpuBuffers).text); ImGui::NextColumn();
+			ImGui::TextUnformatted(Bytes(usage.gpuTextures).text); ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+		ImGui::Separator();
+
+		ImGui::Text("Top call sites");
+		SiteUsage sites[20];
+		const int n = topSites(sites, 20);
+		ImGui::Columns(6, "sites");
+		const char* siteHeaders[6] = { "Site", "Subsystem", "Live", "Peak", "Allocs/frame", "GPU" };
+		for (int c = 0; c < 6; c++)
+		{
+			ImGui::TextUnformatted(siteHeaders[c]);
+			ImGui::NextColumn();
+		}
+		ImGui::Separator();
+		for (int i = 0; i < n; i++)
+		{
+			const Usage& usage = sites[i].usage;
+			ImGui::TextUnformatted(sites[i].name); ImGui::NextColumn();
+			ImGui::TextUnformatted(tagNames[sites[i].tag]); ImGui::NextColumn();
+			ImGui::TextUnformatted(Bytes(usage.live).text); ImGui::NextColumn();
+			ImGui::TextUnformatted(Bytes(usage.peak).text); ImGui::NextColumn();
+			ImGui::Text("%d", usage.allocsPerFrame); ImGui::NextColumn();
+			ImGui::TextUnformatted(Bytes(usage.gpuBuffers + usage.gpuTextures).text); ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+
+		ImGui::End();
+	}
+
+	bool dump(const char* filename)
+	{
+		FILE* f = fopen(filename, "w");
+		if (!f)
+		{
+			LogConsole::log(LogConsole::Error, "Error MemoryTracker: could not write %s\n", filename);
+			return false;
+		}
+
+		const Usage all = total();
+		fprintf(f, "Memory report, frame %lld\n\n", frame);
+		fprintf(f, "CPU live %s, peak %s, %lld allocations, %d allocations / %d frees last frame\n", Bytes(all.live).text, Bytes(all.peak).text, all.allocs, all.allocsPerFrame, all.freesPerFrame);
+		fprintf(f, "GPU buffers %s, textures %s, peak %s\n\n", Bytes(all.gpuBuffers).text, Bytes(all.gpuTextures).text, Bytes(all.gpuPeak).text);
+
+		const char* row = "%-32s %-10s %12s %12s %12s %12s %12s\n";
+		fprintf(f, row, "Subsystem", "", "Live", "Peak", "Allocs/frame", "GPU buffers", "GPU textures");
+		for (int t = 0; t < TagCount; t++)
+		{
+			const Usage& usage = tagReport[t];
+			char allocs[16];
+			snprintf(allocs, sizeof(allocs), "%d", usage.allocsPerFrame);
+			fprintf(f, row, tagNames[t], "", Bytes(usage.live).text, Bytes(usage.peak).text, allocs, Bytes(usage.gpuBuffers).text, Bytes(usage.gpuTextures).text);
+		}
+
+		fprintf(f, "\n");
+		fprintf(f, row, "Site", "Subsystem", "Live", "Peak", "Allocs/frame", "GPU buffers", "GPU textures");
+		SiteUsage sites[maxSites];
+		const int n = topSites(sites, maxSites);
+		for (int i = 0; i < n; i++)
+		{
+			const Usage& usage = sites[i].usage;
+			char allocs[16];
+			snprintf(allocs, sizeof(allocs), "%d", usage.allocsPerFrame);
+			fprintf(f, row, sites[i].name, tagNames[sites[i].tag], Bytes(usage.live).text, Bytes(usage.peak).text, allocs, Bytes(usage.gpuBuffers).text, Bytes(usage.gpuTextures).text);
+		}
+
+		const bool ok = ferror(f) == 0;
+		fclose(f);
+		if (ok)
+			LogConsole::log(LogConsole::Info, "Memory report written to %s\n", filename);
+		return ok;
+	}
+}
+
+// Every new / delete of the program goes through the tracker. Arrays, sized and nothrow forms forward to the same two.
+void* operator new(size_t size)
+{
+	void* ptr = MemoryTracker::allocate(size);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return MemoryTracker::allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return MemoryTracker::allocate(size); }
+void operator delete(void* ptr) noexcept { MemoryTracker::release(ptr); }
+void operator delete[](void* ptr) noexcept { MemoryTracker::release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { MemoryTracker::release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { MemoryTracker::release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { MemoryTracker::release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { MemoryTracker::release(ptr); }
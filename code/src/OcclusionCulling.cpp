@@ -0,0 +1,513 @@
+#include <cmath>
+#include <cfloat>
+#include <chrono>
+#include <mutex>
+#include <algorithm>
+#include <SDL2\SDL_cpuinfo.h>
+
+#include "OcclusionCulling.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#include <immintrin.h>
+// MSVC accepts AVX2 intrinsics anywhere, GCC and clang only in functions built for it
+#if defined(__GNUC__)
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+#endif
+
+namespace OcclusionCulling
+{
+	bool enabled = true;
+
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		// Occluder selection: big enough to hide something, cheap enough to rasterize every frame
+		const float minOccluderSize = 1.5f;     // second largest extent of the world bounds
+		const int maxOccluderTriangles = 4096;
+
+		struct Occluder
+		{
+			std::vector<glm::vec3> vertices;
+			std::vector<unsigned int> indices;
+			glm::mat4 world;
+			bool alive;
+			int firstVertex, firstTriangle;     // into clipVertices / triangles
+		};
+		// Added on the GL thread at load time, rasterized on the main thread
+		std::vector<Occluder> occluders;
+		std::mutex occluderMutex;
+		bool layoutDirty = true;
+
+		// Edge functions a*x + b*y + c, all >= 0 inside, and the depth plane, in pixels of the target
+		struct Triangle
+		{
+			float a[3], b[3], c[3];
+			float zx, zy, zc;
+			int minX, minY, maxX, maxY;     // pixel centers covered, empty when minX > maxX
+		};
+		std::vector<glm::vec4> clipVertices;
+		std::vector<Triangle> triangles;    // two per source triangle: near clipping can make a quad
+		std::vector< std::vector<int> > bins;
+
+		struct Target
+		{
+			int width, height;
+			std::vector<float> depth;       // window depth in [0, 1], 1 where nothing was drawn, rows bottom-up
+		};
+		Target buffer;
+		std::vector< std::vector<float> > hiz;  // hiz[l] is level l + 1, farthest depth of 2x2 texels; level 0 is buffer
+		glm::mat4 lastViewProj;
+		bool ready = false;
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+		const bool hasAvx2 = SDL_HasAVX2() == SDL_TRUE;
+#else
+		const bool hasAvx2 = false;
+#endif
+		Stats stats = {};
+
+		void emit(glm::vec4 v0, glm::vec4 v1, glm::vec4 v2, int w, int h, Triangle& t)
+		{
+			t.minX = 1;
+			t.maxX = 0;
+			glm::vec3 p[3];
+			const glm::vec4* v[3] = { &v0, &v1, &v2 };
+			for (int i = 0; i < 3; i++)
+			{
+				float invW = 1.f / v[i]->w;
+				p[i] = glm::vec3((v[i]->x * invW * 0.5f + 0.5f) * w, (v[i]->y * invW * 0.5f + 0.5f) * h, v[i]->z * invW * 0.5f + 0.5f);
+			}
+			// Counter-clockwise on screen (y up) faces the camera
+			float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+			if (area <= 0.f)
+				return;
+
+			float minX = std::min(p[0].x, std::min(p[1].x, p[2].x)), maxX = std::max(p[0].x, std::max(p[1].x, p[2].x));
+			float minY = std::min(p[0].y, std::min(p[1].y, p[2].y)), maxY = std::max(p[0].y, std::max(p[1].y, p[2].y));
+			t.minX = std::max(0, (int)std::ceil(minX - 0.5f));
+			t.maxX = std::min(w - 1, (int)std::floor(maxX - 0.5f));
+			t.minY = std::max(0, (int)std::ceil(minY - 0.5f));
+			t.maxY = std::min(h - 1, (int)std::floor(maxY - 0.5f));
+			if (t.minY > t.maxY)
+				t.maxX = t.minX - 1;
+
+			for (int i = 0; i < 3; i++)
+			{
+				const glm::vec3& a = p[i];
+				const glm::vec3& b = p[(i + 1) % 3];
+				t.a[i] = a.y - b.y;
+				t.b[i] = b.x - a.x;
+				t.c[i] = -(t.a[i] * a.x + t.b[i] * a.y);
+			}
+			t.zx = ((p[1].z - p[0].z) * (p[2].y - p[0].y) - (p[2].z - p[0].z) * (p[1].y - p[0].y)) / area;
+			t.zy = ((p[2].z - p[0].z) * (p[1].x - p[0].x) - (p[1].z - p[0].z) * (p[2].x - p[0].x)) / area;
+			t.zc = p[0].z - t.zx * p[0].x - t.zy * p[0].y;
+		}
+
+		// Clip space vertices and triangle setup of one occluder, clipped against the near plane (z >= -w)
+		void setupOccluder(const Occluder& o, const glm::mat4& viewProj, int w, int h)
+		{
+			const glm::mat4 m = viewProj * o.world;
+			glm::vec4* clip = &clipVertices[o.firstVertex];
+			for (size_t v = 0; v < o.vertices.size(); v++)
+				clip[v] = m * glm::vec4(o.vertices[v], 1.f);
+
+			Triangle* out = &triangles[o.firstTriangle * 2];
+			for (size_t i = 0; i + 2 < o.indices.size(); i += 3, out += 2)
+			{
+				out[0].minX = out[1].minX = 1;
+				out[0].maxX = out[1].maxX = 0;
+				const glm::vec4 v[3] = { clip[o.indices[i]], clip[o.indices[i + 1]], clip[o.indices[i + 2]] };
+				int inside = 0;
+				for (int k = 0; k < 3; k++)
+					inside += v[k].z >= -v[k].w;
+				if (inside == 3)
+					emit(v[0], v[1], v[2], w, h, out[0]);
+				else if (inside > 0)
+				{
+					glm::vec4 poly[4];
+					int n = 0;
+					for (int k = 0; k < 3; k++)
+					{
+						const glm::vec4& a = v[k];
+						const glm::vec4& b = v[(k + 1) % 3];
+						float da = a.z + a.w, db = b.z + b.w;
+						if (da >= 0.f)
+							poly[n++] = a;
+						if ((da >= 0.f) != (db >= 0.f))
+							poly[n++] = a + (b - a) * (da / (da - db));
+					}
+					emit(poly[0], poly[1], poly[2], w, h, out[0]);
+					if (n == 4)
+						emit(poly[0], poly[2], poly[3], w, h, out[1]);
+				}
+			}
+		}
+
+		void rasterTileScalar(Target& target, const std::vector<int>& bin, int x0, int y0, int x1, int y1)
+		{
+			for (size_t i = 0; i < bin.size(); i++)
+			{
+				const Triangle& t = triangles[bin[i]];
+				const int startX = std::max(t.minX, x0), endX = std::min(t.maxX, x1 - 1);
+				const int startY = std::max(t.minY, y0), endY = std::min(t.maxY, y1 - 1);
+				for (int y = startY; y <= endY; y++)
+				{
+					const float py = (float)y + 0.5f;
+					const float row0 = t.b[0] * py + t.c[0], row1 = t.b[1] * py + t.c[1], row2 = t.b[2] * py + t.c[2];
+					const float rowZ = t.zy * py + t.zc;
+					float* depth = &target.depth[y * target.width];
+					for (int x = startX; x <= endX; x++)
+					{
+						const float px = (float)x + 0.5f;
+						if (t.a[0] * px + row0 >= 0.f && t.a[1] * px + row1 >= 0.f && t.a[2] * px + row2 >= 0.f)
+						{
+							float z = t.zx * px + rowZ;
+							if (z < depth[x])
+								depth[x] = z;
+						}
+					}
+				}
+			}
+		}
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+		// Eight pixels per step, same arithmetic as rasterTileScalar so the buffers match bit for bit
+		AVX2_FUNCTION void rasterTileAvx2(Target& target, const std::vector<int>& bin, int x0, int y0, int x1, int y1)
+		{
+			const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+			const __m256 zero = _mm256_setzero_ps();
+			for (size_t i = 0; i < bin.size(); i++)
+			{
+				const Triangle& t = triangles[bin[i]];
+				const int startX = std::max(t.minX, x0), endX = std::min(t.maxX, x1 - 1);
+				const int startY = std::max(t.minY, y0), endY = std::min(t.maxY, y1 - 1);
+				if (startX > endX)
+					continue;
+				const __m256 a0 = _mm256_set1_ps(t.a[0]), a1 = _mm256_set1_ps(t.a[1]), a2 = _mm256_set1_ps(t.a[2]);
+				const __m256 zx = _mm256_set1_ps(t.zx);
+				// Spans are 8-aligned, tiles are multiples of 8 wide: lanes past the triangle bounds are masked
+				const __m256 first = _mm256_set1_ps((float)startX + 0.5f), last = _mm256_set1_ps((float)endX + 0.5f);
+				const int spanBegin = startX & ~7;
+				for (int y = startY; y <= endY; y++)
+				{
+					const float py = (float)y + 0.5f;
+					const __m256 row0 = _mm256_set1_ps(t.b[0] * py + t.c[0]);
+					const __m256 row1 = _mm256_set1_ps(t.b[1] * py + t.c[1]);
+					const __m256 row2 = _mm256_set1_ps(t.b[2] * py + t.c[2]);
+					const __m256 rowZ = _mm256_set1_ps(t.zy * py + t.zc);
+					float* depth = &target.depth[y * target.width];
+					for (int x = spanBegin; x <= endX; x += 8)
+					{
+						const __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), laneOffsets);
+						__m256 mask = _mm256_and_ps(_mm256_cmp_ps(px, first, _CMP_GE_OQ), _mm256_cmp_ps(px, last, _CMP_LE_OQ));
+						mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a0, px), row0), zero, _CMP_GE_OQ));
+						mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a1, px), row1), zero, _CMP_GE_OQ));
+						mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a2, px), row2), zero, _CMP_GE_OQ));
+						if (_mm256_testz_ps(mask, mask))
+							continue;
+						const __m256 z = _mm256_add_ps(_mm256_mul_ps(zx, px), rowZ);
+						const __m256 old = _mm256_loadu_ps(depth + x);
+						_mm256_storeu_ps(depth + x, _mm256_blendv_ps(old, _mm256_min_ps(old, z), mask));
+					}
+				}
+			}
+		}
+#endif
+
+		// Sets up every live occluder for a w x h target, bins the triangles and rasterizes one tile per job
+		void rasterize(const glm::mat4& viewProj, Target& target, bool simd, float& setupMs, float& rasterMs)
+		{
+			Clock::time_point t0 = Clock::now();
+			if (layoutDirty)
+			{
+				int vertexCount = 0, triangleCount = 0;
+				for (size_t i = 0; i < occluders.size(); i++)
+				{
+					occluders[i].firstVertex = vertexCount;
+					occluders[i].firstTriangle = triangleCount;
+					vertexCount += (int)occluders[i].vertices.size();
+					triangleCount += (int)occluders[i].indices.size() / 3;
+				}
+				clipVertices.resize(vertexCount);
+				triangles.resize(triangleCount * 2);
+				layoutDirty = false;
+			}
+			JobSystem::parallelFor((int)occluders.size(), 4, [&](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+				{
+					if (occluders[i].alive)
+						setupOccluder(occluders[i], viewProj, target.width, target.height);
+				}
+			});
+
+			const int tilesX = target.width / tileWidth, tilesY = target.height / tileHeight;
+			bins.resize(tilesX * tilesY);
+			for (size_t b = 0; b < bins.size(); b++)
+				bins[b].clear();
+			int visible = 0;
+			for (size_t i = 0; i < triangles.size(); i++)
+			{
+				const Triangle& t = triangles[i];
+				if (t.minX > t.maxX)
+					continue;
+				visible++;
+				for (int ty = t.minY / tileHeight; ty <= t.maxY / tileHeight; ty++)
+				{
+					for (int tx = t.minX / tileWidth; tx <= t.maxX / tileWidth; tx++)
+						bins[ty * tilesX + tx].push_back((int)i);
+				}
+			}
+			stats.triangles = visible;
+			Clock::time_point t1 = Clock::now();
+
+			target.depth.resize(target.width * target.height);
+			JobSystem::parallelFor(tilesX * tilesY, 1, [&](int begin, int end)
+			{
+				for (int tile = begin; tile < end; tile++)
+				{
+					const int x0 = (tile % tilesX) * tileWidth, y0 = (tile / tilesX) * tileHeight;
+					for (int y = y0; y < y0 + tileHeight; y++)
+						std::fill_n(&target.depth[y * target.width + x0], tileWidth, 1.f);
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+					if (simd)
+					{
+						rasterTileAvx2(target, bins[tile], x0, y0, x0 + tileWidth, y0 + tileHeight);
+						continue;
+					}
+#endif
+					rasterTileScalar(target, bins[tile], x0, y0, x0 + tileWidth, y0 + tileHeight);
+				}
+			});
+			Clock::time_point t2 = Clock::now();
+			setupMs = std::chrono::duration<float, std::milli>(t1 - t0).count();
+			rasterMs = std::chrono::duration<float, std::milli>(t2 - t1).count();
+		}
+
+		void buildHiZ()
+		{
+			int w = width, h = height;
+			const float* src = &buffer.depth[0];
+			// The levels keep their storage from frame to frame
+			size_t levels = 0;
+			while (w > 1 || h > 1)
+			{
+				const int dw = std::max(1, w / 2), dh = std::max(1, h / 2);
+				if (hiz.size() == levels)
+					hiz.push_back(std::vector<float>());
+				hiz[levels].resize(dw * dh);
+				float* dst = &hiz[levels++][0];
+				for (int y = 0; y < dh; y++)
+				{
+					const float* r0 = src + std::min(2 * y, h - 1) * w;
+					const float* r1 = src + std::min(2 * y + 1, h - 1) * w;
+					int x = 0;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+					for (; w % 8 == 0 && x < w; x += 8)
+					{
+						__m128 a = _mm_max_ps(_mm_loadu_ps(r0 + x), _mm_loadu_ps(r1 + x));
+						__m128 b = _mm_max_ps(_mm_loadu_ps(r0 + x + 4), _mm_loadu_ps(r1 + x + 4));
+						_mm_storeu_ps(dst + y * dw + x / 2, _mm_max_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+					}
+#endif
+					for (x /= 2; x < dw; x++)
+					{
+						const int x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+						dst[y * dw + x] = std::max(std::max(r0[x0], r0[x1]), std::max(r1[x0], r1[x1]));
+					}
+				}
+				src = dst;
+				w = dw;
+				h = dh;
+			}
+			hiz.resize(levels);
+		}
+
+		// Pixel rectangle (inclusive) of a world box on a w x h target and its nearest depth.
+		// False when that can't be told: the box crosses the near plane or is off screen.
+		bool projectBox(const glm::mat4& viewProj, const glm::vec3& boxMin, const glm::vec3& boxMax, int w, int h, int rect[4], float& nearest)
+		{
+			glm::vec2 lo(FLT_MAX), hi(-FLT_MAX);
+			nearest = FLT_MAX;
+			for (int i = 0; i < 8; i++)
+			{
+				glm::vec4 p = viewProj * glm::vec4(i & 1 ? boxMax.x : boxMin.x, i & 2 ? boxMax.y : boxMin.y, i & 4 ? boxMax.z : boxMin.z, 1.f);
+				if (p.z < -p.w || p.w <= 0.f)
+					return false;
+				glm::vec3 ndc = glm::vec3(p) / p.w;
+				lo = glm::min(lo, glm::vec2(ndc));
+				hi = glm::max(hi, glm::vec2(ndc));
+				nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+			}
+			rect[0] = std::max(0, (int)std::floor((lo.x * 0.5f + 0.5f) * w));
+			rect[1] = std::max(0, (int)std::floor((lo.y * 0.5f + 0.5f) * h));
+			rect[2] = std::min(w - 1, (int)std::floor((hi.x * 0.5f + 0.5f) * w));
+			rect[3] = std::min(h - 1, (int)std::floor((hi.y * 0.5f + 0.5f) * h));
+			return rect[0] <= rect[2] && rect[1] <= rect[3];
+		}
+
+		// Hidden when the nearest point of the box is behind the farthest occluder depth under it,
+		// read from the level where the rectangle spans at most 3x3 texels
+		bool visibleHiZ(const glm::vec3& boxMin, const glm::vec3& boxMax)
+		{
+			int rect[4];
+			float nearest;
+			if (!projectBox(lastViewProj, boxMin, boxMax, width, height, rect, nearest))
+				return true;
+			const int size = std::max(rect[2] - rect[0], rect[3] - rect[1]) + 1;
+			int level = 0;
+			while (level < (int)hiz.size() && (size >> level) > 2)
+				level++;
+			const float* depth = level ? &hiz[level - 1][0] : &buffer.depth[0];
+			const int levelWidth = std::max(1, width >> level);
+			for (int y = rect[1] >> level; y <= rect[3] >> level; y++)
+			{
+				for (int x = rect[0] >> level; x <= rect[2] >> level; x++)
+				{
+					if (nearest <= depth[y * levelWidth + x])
+						return true;
+				}
+			}
+			return false;
+		}
+
+		bool visibleReference(const Target& reference, const glm::vec3& boxMin, const glm::vec3& boxMax)
+		{
+			int rect[4];
+			float nearest;
+			if (!projectBox(lastViewProj, boxMin, boxMax, reference.width, reference.height, rect, nearest))
+				return true;
+			for (int y = rect[1]; y <= rect[3]; y++)
+			{
+				for (int x = rect[0]; x <= rect[2]; x++)
+				{
+					if (nearest <= reference.depth[y * reference.width + x])
+						return true;
+				}
+			}
+			return false;
+		}
+	}
+
+	int addOccluder(const glm::vec3* vertices, int vertexCount, const unsigned int* indices, int indexCount, const glm::mat4& world)
+	{
+		if (vertexCount == 0 || indexCount / 3 > maxOccluderTriangles)
+			return -1;
+		MemoryTracker::Scope memory(MemoryTracker::Culling, "OcclusionCulling::addOccluder");
+		glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+		for (int i = 0; i < vertexCount; i++)
+		{
+			glm::vec3 p = glm::vec3(world * glm::vec4(vertices[i], 1.f));
+			lo = glm::min(lo, p);
+			hi = glm::max(hi, p);
+		}
+		glm::vec3 extent = hi - lo;
+		float sorted[3] = { extent.x, extent.y, extent.z };
+		std::sort(sorted, sorted + 3);
+		if (sorted[1] < minOccluderSize)
+			return -1;
+
+		std::lock_guard<std::mutex> lock(occluderMutex);
+		size_t id = 0;
+		while (id < occluders.size() && occluders[id].alive)
+			id++;
+		if (id == occluders.size())
+			occluders.push_back(Occluder());
+		Occluder& o = occluders[id];
+		o.vertices.assign(vertices, vertices + vertexCount);
+		o.indices.assign(indices, indices + indexCount);
+		o.world = world;
+		o.alive = true;
+		layoutDirty = true;
+		return (int)id;
+	}
+
+	void removeOccluder(int id)
+	{
+		std::lock_guard<std::mutex> lock(occluderMutex);
+		if (id < 0 || id >= (int)occluders.size())
+			return;
+		occluders[id].alive = false;
+		occluders[id].vertices.clear();
+		occluders[id].indices.clear();
+		layoutDirty = true;
+	}
+
+	int occluderCount()
+	{
+		std::lock_guard<std::mutex> lock(occluderMutex);
+		int count = 0;
+		for (size_t i = 0; i < occluders.size(); i++)
+			count += occluders[i].alive;
+		return count;
+	}
+
+	void render(const glm::mat4& viewProj)
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Culling, "OcclusionCulling::render");
+		std::lock_guard<std::mutex> lock(occluderMutex);
+		ready = false;
+		if (!enabled || occluders.empty())
+			return;
+
+		lastViewProj = viewProj;
+		buffer.width = width;
+		buffer.height = height;
+		stats.avx2 = hasAvx2;
+		rasterize(viewProj, buffer, hasAvx2, stats.setupMs, stats.rasterMs);
+		Clock::time_point t0 = Clock::now();
+		buildHiZ();
+		stats.hizMs = std::chrono::duration<float, std::milli>(Clock::now() - t0).count();
+		ready = true;
+	}
+
+	bool testBox(const glm::vec3& boxMin, const glm::vec3& boxMax)
+	{
+		return !ready || visibleHiZ(boxMin, boxMax);
+	}
+
+	Stats getStats()
+	{
+		return stats;
+	}
+
+	CheckResult check(const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax)
+	{
+		CheckResult result = {};
+		std::lock_guard<std::mutex> lock(occluderMutex);
+		if (!ready)
+			return result;
+
+		Stats saved = stats;
+		float setupMs, rasterMs;
+		Target simd = { width, height, {} }, scalar = { width, height, {} };
+		rasterize(lastViewProj, simd, hasAvx2, setupMs, rasterMs);
+		result.simdMs = setupMs + rasterMs;
+		rasterize(lastViewProj, scalar, false, setupMs, rasterMs);
+		result.scalarMs = setupMs + rasterMs;
+		for (size_t i = 0; i < scalar.depth.size(); i++)
+			result.mismatchedPixels += simd.depth[i] != scalar.depth[i];
+
+		Target reference = { width * 4, height * 4, {} };
+		rasterize(lastViewProj, reference, false, setupMs, rasterMs);
+		stats = saved;
+
+		for (size_t i = 0; i < boxMin.size(); i++)
+		{
+			bool visible = visibleHiZ(boxMin[i], boxMax[i]);
+			bool visibleRef = visibleReference(reference, boxMin[i], boxMax[i]);
+			result.tested++;
+			result.culled += !visible;
+			result.falseNegatives += !visible && visibleRef;
+			result.missedCulls += visible && !visibleRef;
+		}
+		return result;
+	}
+}
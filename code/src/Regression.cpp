@@ -0,0 +1,210 @@
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "Regression.h"
+#include "JobSystem.h"
+
+namespace Regression
+{
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		const int baselineRuns = 5;     // history entries the timing baseline is the median of
+
+		void makeDirectory(const std::string& path)
+		{
+#ifdef _WIN32
+			_mkdir(path.c_str());
+#else
+			mkdir(path.c_str(), 0755);
+#endif
+		}
+
+		bool readImage(const std::string& path, SoftwareRenderer::Image& out)
+		{
+			TextureSystem::Image image;
+			if (!TextureSystem::decodeFile(path.c_str(), image))
+				return false;
+			out.width = image.levels[0].width;
+			out.height = image.levels[0].height;
+			out.color.resize((size_t)out.width * out.height);
+			memcpy(&out.color[0], &image.pixels[0], out.color.size() * 4);
+			return true;
+		}
+
+		float median(std::vector<float> values)
+		{
+			if (values.empty())
+				return 0.f;
+			std::sort(values.begin(), values.end());
+			return values[values.size() / 2];
+		}
+
+		// Median frame time of the last passing runs of the same case in history.jsonl, 0 if none
+		float baseline(const std::string& path, const char* scene, int camera, int width, int height, int threads)
+		{
+			FILE* file = fopen(path.c_str(), "r");
+			if (file == NULL)
+				return 0.f;
+			char key[256];
+			snprintf(key, sizeof(key), "\"scene\": \"%s\", \"camera\": %d, \"width\": %d, \"height\": %d, \"threads\": %d,", scene, camera, width, height, threads);
+			std::vector<float> history;
+			char line[1024];
+			while (fgets(line, sizeof(line), file))
+			{
+				const char* ms = strstr(line, "\"medianMs\": ");
+				if (strstr(line, key) == NULL || strstr(line, "\"passed\": true") == NULL || ms == NULL)
+					continue;
+				float value;
+				if (sscanf(ms + strlen("\"medianMs\": "), "%f", &value) == 1)
+					history.push_back(value);
+			}
+			fclose(file);
+			if ((int)history.size() > baselineRuns)
+				history.erase(history.begin(), history.end() - baselineRuns);
+			return median(history);
+		}
+	}
+
+	ImageDiff compare(const SoftwareRenderer::Image& a, const SoftwareRenderer::Image& b, float threshold, SoftwareRenderer::Image* diff)
+	{
+		ImageDiff result = { 0, a.width * a.height, 0.f };
+		if (a.width != b.width || a.height != b.height)
+		{
+			result.differing = result.total;
+			result.maxDelta = 1.f;
+			return result;
+		}
+		if (diff)
+		{
+			diff->width = a.width;
+			diff->height = a.height;
+			diff->color.resize(a.color.size());
+		}
+
+		// Largest possible YIQ delta of 8-bit colors, as in pixelmatch
+		const float maxDelta = 35215.f;
+		const float limit = maxDelta * threshold * threshold;
+		for (size_t i = 0; i < a.color.size(); i++)
+		{
+			const unsigned int ca = a.color[i], cb = b.color[i];
+			float r = (float)(ca & 0xff) - (float)(cb & 0xff);
+			float g = (float)((ca >> 8) & 0xff) - (float)((cb >> 8) & 0xff);
+			float bl = (float)((ca >> 16) & 0xff) - (float)((cb >> 16) & 0xff);
+			float y = r * 0.29889531f + g * 0.58662247f + bl * 0.11448223f;
+			float iq = r * 0.59597799f - g * 0.27417610f - bl * 0.32180189f;
+			float q = r * 0.21147017f - g * 0.52261711f + bl * 0.31114694f;
+			float delta = 0.5053f * y * y + 0.299f * iq * iq + 0.1957f * q * q;
+			result.maxDelta = std::max(result.maxDelta, std::sqrt(delta / maxDelta));
+			const bool differs = delta > limit;
+			result.differing += differs;
+			if (diff)
+			{
+				// Differences in red over the dimmed reference
+				unsigned int gray = (((ca & 0xff) + ((ca >> 8) & 0xff) + ((ca >> 16) & 0xff)) / 3) / 4 + 160;
+				diff->color[i] = differs ? 0xff0000ffu : (0xff000000u | (gray << 16) | (gray << 8) | gray);
+			}
+		}
+		return result;
+	}
+
+	int run(const std::vector<Scene>& scenes, const Options& options)
+	{
+		makeDirectory(options.directory);
+		const std::string historyPath = options.directory + "/history.jsonl";
+		FILE* history = options.update ? NULL : fopen(historyPath.c_str(), "a");
+
+		char timestamp[32];
+		time_t now = time(NULL);
+		strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+		int failures = 0;
+		SoftwareRenderer::Image image, reference, diff;
+		for (size_t s = 0; s < scenes.size(); s++)
+		{
+			const Scene& scene = scenes[s];
+			scene.setup();
+			for (int camera = 0; camera < scene.cameras; camera++)
+			{
+				std::vector<float> frameMs;
+				for (int frame = 0; frame < options.warmupFrames + options.frames; frame++)
+				{
+					Clock::time_point t0 = Clock::now();
+					scene.render(camera, image);
+					if (frame >= options.warmupFrames)
+						frameMs.push_back(std::chrono::duration<float, std::milli>(Clock::now() - t0).count());
+				}
+				std::vector<float> sorted = frameMs;
+				std::sort(sorted.begin(), sorted.end());
+				const float medianMs = median(frameMs);
+				const float p95Ms = sorted.empty() ? 0.f : sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+
+				// References are per resolution
+				char name[256];
+				snprintf(name, sizeof(name), "%s/%s_%d_%dx%d", options.directory.c_str(), scene.name, camera, image.width, image.height);
+
+				if (options.update)
+				{
+					bool written = SoftwareRenderer::writeTGA(image, (std::string(name) + ".tga").c_str());
+					printf("regress %s_%d: reference %s (%.2f ms)\n", scene.name, camera, written ? "written" : "NOT WRITTEN", medianMs);
+					failures += !written;
+					continue;
+				}
+
+				bool passed = true;
+				const char* reason = "";
+				ImageDiff imageDiff = { 0, image.width * image.height, 0.f };
+				if (!readImage(std::string(name) + ".tga", reference))
+				{
+					// First run of this case: its output becomes the reference
+					SoftwareRenderer::writeTGA(image, (std::string(name) + ".tga").c_str());
+					reason = " (new reference)";
+				}
+				else
+				{
+					imageDiff = compare(image, reference, options.pixelThreshold, &diff);
+					if (imageDiff.differing > imageDiff.total * options.maxDiffRatio)
+					{
+						passed = false;
+						reason = " IMAGE DIFFERS";
+						SoftwareRenderer::writeTGA(image, (std::string(name) + ".out.tga").c_str());
+						SoftwareRenderer::writeTGA(diff, (std::string(name) + ".diff.tga").c_str());
+					}
+				}
+
+				const int threads = JobSystem::threadCount();
+				const float baselineMs = baseline(historyPath, scene.name, camera, image.width, image.height, threads);
+				if (passed && baselineMs > 0.f && medianMs > baselineMs * (1.f + options.timeThreshold))
+				{
+					passed = false;
+					reason = " SLOWER";
+				}
+				failures += !passed;
+
+				printf("regress %s_%d: %d of %d pixels differ (max %.3f), median %.2f ms, p95 %.2f ms, baseline %.2f ms%s\n",
+					scene.name, camera, imageDiff.differing, imageDiff.total, imageDiff.maxDelta, medianMs, p95Ms, baselineMs, reason);
+				if (history)
+				{
+					fprintf(history, "{\"time\": \"%s\", \"scene\": \"%s\", \"camera\": %d, \"width\": %d, \"height\": %d, \"threads\": %d, "
+						"\"medianMs\": %.4f, \"p95Ms\": %.4f, \"minMs\": %.4f, \"baselineMs\": %.4f, \"differingPixels\": %d, \"passed\": %s}\n",
+						timestamp, scene.name, camera, image.width, image.height, threads,
+						medianMs, p95Ms, sorted.empty() ? 0.f : sorted[0], baselineMs, imageDiff.differing, passed ? "true" : "false");
+				}
+			}
+		}
+		if (history)
+			fclose(history);
+		printf("regress: %d failure%s\n", failures, failures == 1 ? "" : "s");
+		return failures;
+	}
+}
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <chrono>
+#include <glm\gtc\matrix_transform.hpp>
+
+#include "SceneGraph.h"
+#include "JobSystem.h"
+
+namespace SceneGraph
+{
+	int addNode(Graph& g, int parentNode, const glm::mat4& local)
+	{
+		const int at = parentNode < 0 ? g.size() : g.subtreeEnd[parentNode];
+
+		// Make room: everything from 'at' on moves one slot up
+		if (at < g.size())
+		{
+			for (int i = 0; i < g.size(); i++)
+			{
+				if (g.parent[i] >= at) g.parent[i]++;
+				if (i >= at) g.subtreeEnd[i]++;
+			}
+			for (size_t k = 0; k < g.changed.size(); k++)
+			{
+				if (g.changed[k] >= at) g.changed[k]++;
+			}
+		}
+		// The new node ends up inside the subtree of all its ancestors
+		for (int a = parentNode; a >= 0; a = g.parent[a])
+			g.subtreeEnd[a]++;
+
+		g.parent.insert(g.parent.begin() + at, parentNode);
+		g.subtreeEnd.insert(g.subtreeEnd.begin() + at, at + 1);
+		g.local.insert(g.local.begin() + at, local);
+		g.world.insert(g.world.begin() + at, glm::mat4(1.f));
+		g.dirty.insert(g.dirty.begin() + at, 1);
+		g.changed.push_back(at);
+		return at;
+	}
+
+	void setLocal(Graph& g, int node, const glm::mat4& local)
+	{
+		g.local[node] = local;
+		if (!g.dirty[node])
+		{
+			g.dirty[node] = 1;
+			g.changed.push_back(node);
+		}
+	}
+
+	namespace
+	{
+		// Parents precede children, so one forward pass is enough
+		void recompute(Graph& g, int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				int p = g.parent[i];
+				g.world[i] = p >= 0 ? g.world[p] * g.local[i] : g.local[i];
+			}
+		}
+	}
+
+	void update(Graph& g)
+	{
+		g.changedRanges.clear();
+		if (g.changed.empty())
+			return;
+
+		// In preorder a changed node inside the previous range is already covered by that subtree
+		std::sort(g.changed.begin(), g.changed.end());
+		for (size_t k = 0; k < g.changed.size(); k++)
+		{
+			int node = g.changed[k];
+			g.dirty[node] = 0;
+			if (!g.changedRanges.empty() && node < g.changedRanges.back().end)
+				continue;
+			Range range = { node, g.subtreeEnd[node] };
+			g.changedRanges.push_back(range);
+		}
+		g.changed.clear();
+
+		// Disjoint subtrees don't depend on each other
+		JobSystem::parallelFor((int)g.changedRanges.size(), 1, [&](int begin, int end)
+		{
+			for (int r = begin; r < end; r++)
+				recompute(g, g.changedRanges[r].begin, g.changedRanges[r].end);
+		});
+	}
+
+	void updateAll(Graph& g)
+	{
+		for (size_t k = 0; k < g.changed.size(); k++)
+			g.dirty[g.changed[k]] = 0;
+		g.changed.clear();
+
+		recompute(g, 0, g.size());
+		g.changedRanges.clear();
+		Range range = { 0, g.size() };
+		g.changedRanges.push_back(range);
+	}
+
+	BenchResult benchmark(int nodes, float animatedFraction, int frames)
+	{
+		unsigned seed = 12345u;
+		struct Random
+		{
+			static unsigned next(unsigned& s) { s = s * 1664525u + 1013904223u; return s >> 8; }
+		};
+
+		// Random hierarchy built depth-first: each new node hangs from some node on the current
+		// root-to-leaf path, so it is always appended and the build stays O(n)
+		Graph g;
+		std::vector<int> path;
+		for (int i = 0; i < nodes; i++)
+		{
+			int depth = path.empty() ? 0 : (int)(Random::next(seed) % (path.size() + 1));
+			path.resize(depth);
+			int parentNode = path.empty() ? -1 : path.back();
+			glm::mat4 local = glm::translate(glm::mat4(), glm::vec3(1.f, 0.f, 0.f));
+			path.push_back(addNode(g, parentNode, local));
+			if (path.size() > 32)
+				path.resize(8);
+		}
+		update(g);
+
+		typedef std::chrono::high_resolution_clock Clock;
+		const int animated = std::max(1, (int)(nodes * animatedFraction));
+		double incrementalSeconds = 0.0, fullSeconds = 0.0;
+		double recomputed = 0.0;
+
+		for (int frame = 0; frame < frames; frame++)
+		{
+			for (int k = 0; k < animated; k++)
+			{
+				int node = (int)(Random::next(seed) % (unsigned)nodes);
+				setLocal(g, node, glm::rotate(g.local[node], 0.01f, glm::vec3(0.f, 1.f, 0.f)));
+			}
+
+			Clock::time_point start = Clock::now();
+			update(g);
+			incrementalSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			for (size_t r = 0; r < g.changedRanges.size(); r++)
+				recomputed += g.changedRanges[r].end - g.changedRanges[r].begin;
+
+			start = Clock::now();
+			updateAll(g);
+			fullSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+		}
+
+		BenchResult res;
+		res.nodes = nodes;
+		res.animatedFraction = animatedFraction;
+		res.incrementalMs = (float)(1e3 * incrementalSeconds / frames);
+		res.fullMs = (float)(1e3 * fullSeconds / frames);
+		res.nodesRecomputed = (float)(recomputed / frames);
+		return res;
+	}
+}
@@ -0,0 +1,406 @@
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+#include <sys/stat.h>
+#include <SDL2\SDL.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "ShaderLibrary.h"
+#include "FramePipeline.h"
+#include "LogConsole.h"
+#include "MemoryTracker.h"
+
+namespace ShaderLibrary
+{
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		const char* directory = "shaders";
+
+		struct Entry
+		{
+			std::string vertexPath, fragmentPath;
+			std::vector<std::string> attributes;
+			GLuint program;
+
+			// Build in flight
+			GLuint pendingProgram;
+			GLuint pendingShaders[2];
+			Clock::time_point pendingStart;
+			bool rebuildAgain; // files changed again while building
+
+			time_t vertexTime, fragmentTime;
+			std::vector<std::string> includes;  // files pulled in by #include, watched too
+			std::vector<time_t> includeTimes;
+			ProgramStats stats;
+		};
+
+		std::vector<Entry> entries;
+		std::mutex statsMutex;
+
+		bool initialized = false;
+		bool parallelCompile = false;
+
+		typedef void (GLAPIENTRY * MaxShaderCompilerThreadsProc)(GLuint count);
+
+		////////////////////////////////////////////////// Directory watcher
+#ifdef _WIN32
+		HANDLE changeHandle = INVALID_HANDLE_VALUE;
+
+		void watchStart()
+		{
+			changeHandle = FindFirstChangeNotificationA(directory, FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+		}
+
+		bool watchPoll()
+		{
+			if (changeHandle == INVALID_HANDLE_VALUE)
+				return false;
+			if (WaitForSingleObject(changeHandle, 0) != WAIT_OBJECT_0)
+				return false;
+			FindNextChangeNotification(changeHandle);
+			return true;
+		}
+
+		void watchStop()
+		{
+			if (changeHandle != INVALID_HANDLE_VALUE)
+				FindCloseChangeNotification(changeHandle);
+			changeHandle = INVALID_HANDLE_VALUE;
+		}
+#else
+		int inotifyFd = -1;
+
+		void watchStart()
+		{
+			inotifyFd = inotify_init1(IN_NONBLOCK);
+			if (inotifyFd >= 0)
+				inotify_add_watch(inotifyFd, directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		}
+
+		bool watchPoll()
+		{
+			if (inotifyFd < 0)
+				return false;
+			// Drain every queued event; which files changed is decided by their timestamps
+			char events[4096];
+			bool changed = false;
+			while (read(inotifyFd, events, sizeof(events)) > 0)
+				changed = true;
+			return changed;
+		}
+
+		void watchStop()
+		{
+			if (inotifyFd >= 0)
+				close(inotifyFd);
+			inotifyFd = -1;
+		}
+#endif
+
+		////////////////////////////////////////////////// Builds
+		time_t modifiedTime(const std::string& path)
+		{
+			struct stat info;
+			return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+		}
+
+		bool readFile(const std::string& path, std::string& out)
+		{
+			FILE* file = fopen(path.c_str(), "rb");
+			if (file == NULL)
+				return false;
+			fseek(file, 0, SEEK_END);
+			long size = ftell(file);
+			fseek(file, 0, SEEK_SET);
+			out.resize(size > 0 ? (size_t)size : 0);
+			size_t read = size > 0 ? fread(&out[0], 1, (size_t)size, file) : 0;
+			fclose(file);
+			out.resize(read);
+			return true;
+		}
+
+		// Expands '#include "file"' lines (relative to shaders/, one level deep) and records the files
+		bool readSource(Entry& e, const std::string& path, std::string& out)
+		{
+			std::string source;
+			if (!readFile(path, source))
+				return false;
+
+			out.clear();
+			size_t lineStart = 0;
+			while (lineStart < source.size())
+			{
+				size_t lineEnd = source.find('\n', lineStart);
+				if (lineEnd == std::string::npos)
+					lineEnd = source.size();
+				std::string line = source.substr(lineStart, lineEnd - lineStart);
+				size_t open = line.find('"');
+				size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+				if (line.compare(0, 8, "#include") == 0 && close != std::string::npos)
+				{
+					std::string includePath = std::string(directory) + "/" + line.substr(open + 1, close - open - 1);
+					std::string included;
+					if (!readFile(includePath, included))
+						return false;
+					out += included;
+					out += "\n";
+					e.includes.push_back(includePath);
+					e.includeTimes.push_back(modifiedTime(includePath));
+				}
+				else
+				{
+					out += line;
+					out += "\n";
+				}
+				lineStart = lineEnd + 1;
+			}
+			return true;
+		}
+
+		bool includesChanged(const Entry& e)
+		{
+			for (size_t i = 0; i < e.includes.size(); i++)
+			{
+				if (modifiedTime(e.includes[i]) != e.includeTimes[i])
+					return true;
+			}
+			return false;
+		}
+
+		std::string shaderLog(GLuint shader)
+		{
+			GLint length = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			std::string log(length > 0 ? (size_t)length : 0, '\0');
+			if (length > 0)
+				glGetShaderInfoLog(shader, length, NULL, &log[0]);
+			return log;
+		}
+
+		void setStats(Entry& e, bool pending, bool failed, float ms, const std::string& log, bool finished)
+		{
+			std::lock_guard<std::mutex> lock(statsMutex);
+			e.stats.pending = pending;
+			if (finished)
+			{
+				e.stats.builds++;
+				e.stats.lastFailed = failed;
+				e.stats.lastBuildMs = ms;
+				e.stats.log = log;
+			}
+		}
+
+		// Issues compile + link without querying any status, so the driver can work on it in the background
+		void startBuild(Entry& e)
+		{
+			std::string sources[2];
+			e.includes.clear();
+			e.includeTimes.clear();
+			if (!readSource(e, e.vertexPath, sources[0]) || !readSource(e, e.fragmentPath, sources[1]))
+			{
+				LogConsole::log(LogConsole::Error, "Error Shader %s: can't read %s / %s\n", e.stats.name.c_str(), e.vertexPath.c_str(), e.fragmentPath.c_str());
+				setStats(e, false, true, 0.f, "missing shader file", true);
+				return;
+			}
+
+			const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+			e.pendingStart = Clock::now();
+			e.pendingProgram = glCreateProgram();
+			for (int i = 0; i < 2; i++)
+			{
+				const char* source = sources[i].c_str();
+				e.pendingShaders[i] = glCreateShader(types[i]);
+				glShaderSource(e.pendingShaders[i], 1, &source, NULL);
+				glCompileShader(e.pendingShaders[i]);
+				glAttachShader(e.pendingProgram, e.pendingShaders[i]);
+			}
+			for (size_t i = 0; i < e.attributes.size(); i++)
+				glBindAttribLocation(e.pendingProgram, (GLuint)i, e.attributes[i].c_str());
+			glLinkProgram(e.pendingProgram);
+
+			e.vertexTime = modifiedTime(e.vertexPath);
+			e.fragmentTime = modifiedTime(e.fragmentPath);
+			setStats(e, true, false, 0.f, "", false);
+		}
+
+		// Returns false while the build is still running (only when parallel compile lets us ask).
+		// Without parallel compile reading the link status blocks until the driver finished.
+		bool finishBuild(Entry& e, bool block)
+		{
+			GLuint candidate = e.pendingProgram;
+			if (!block && parallelCompile)
+			{
+				GLint done = GL_FALSE;
+				glGetProgramiv(candidate, GL_COMPLETION_STATUS_ARB, &done);
+				if (done == GL_FALSE)
+					return false;
+			}
+
+			GLint linked = GL_FALSE;
+			glGetProgramiv(candidate, GL_LINK_STATUS, &linked);
+			float ms = std::chrono::duration<float, std::milli>(Clock::now() - e.pendingStart).count();
+
+			std::string log;
+			if (linked == GL_TRUE)
+			{
+				// Swap: draws from now on use the new program
+				if (e.program)
+					glDeleteProgram(e.program);
+				e.program = candidate;
+			}
+			else
+			{
+				log = shaderLog(e.pendingShaders[0]) + shaderLog(e.pendingShaders[1]);
+				GLint length = 0;
+				glGetProgramiv(candidate, GL_INFO_LOG_LENGTH, &length);
+				if (length > 0)
+				{
+					std::string programLog((size_t)length, '\0');
+					glGetProgramInfoLog(candidate, length, NULL, &programLog[0]);
+					log += programLog;
+				}
+				LogConsole::log(LogConsole::Error, "Error Shader %s: %s", e.stats.name.c_str(), log.c_str());
+				glDeleteProgram(candidate);
+			}
+
+			glDeleteShader(e.pendingShaders[0]);
+			glDeleteShader(e.pendingShaders[1]);
+			e.pendingProgram = 0;
+			setStats(e, false, linked != GL_TRUE, ms, log, true);
+			return true;
+		}
+
+		void initialize()
+		{
+			initialized = true;
+			if (GLEW_ARB_parallel_shader_compile)
+			{
+				parallelCompile = true;
+				glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+			}
+			else if (SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile"))
+			{
+				// Same tokens as the ARB version
+				parallelCompile = true;
+				MaxShaderCompilerThreadsProc maxThreads = (MaxShaderCompilerThreadsProc)SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsKHR");
+				if (maxThreads)
+					maxThreads(0xFFFFFFFF);
+			}
+			watchStart();
+		}
+	}
+
+	int create(const char* name, const char* vertexFile, const char* fragmentFile, const char* const* attributes)
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Shaders, "ShaderLibrary::create");
+		if (!initialized)
+			initialize();
+
+		Entry e;
+		e.vertexPath = std::string(directory) + "/" + vertexFile;
+		e.fragmentPath = std::string(directory) + "/" + fragmentFile;
+		for (int i = 0; attributes && attributes[i]; i++)
+			e.attributes.push_back(attributes[i]);
+		e.program = 0;
+		e.pendingProgram = 0;
+		e.rebuildAgain = false;
+		e.vertexTime = e.fragmentTime = 0;
+		e.stats.name = name;
+		e.stats.builds = 0;
+		e.stats.lastBuildMs = 0.f;
+		e.stats.pending = false;
+		e.stats.lastFailed = false;
+
+		{
+			std::lock_guard<std::mutex> lock(statsMutex);
+			entries.push_back(e);
+		}
+		Entry& entry = entries.back();
+		startBuild(entry);
+		if (entry.pendingProgram)
+			finishBuild(entry, true);
+		return (int)entries.size() - 1;
+	}
+
+	GLuint program(int id)
+	{
+		return entries[id].program;
+	}
+
+	void update()
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Shaders, "ShaderLibrary::update");
+		bool changed = watchPoll();
+
+		bool pending = false;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			Entry& e = entries[i];
+			bool started = false;
+			if (changed && (modifiedTime(e.vertexPath) != e.vertexTime || modifiedTime(e.fragmentPath) != e.fragmentTime || includesChanged(e)))
+			{
+				if (e.pendingProgram)
+					e.rebuildAgain = true;
+				else
+				{
+					startBuild(e);
+					started = true;
+				}
+			}
+
+			// Can't ask whether a build is done without parallel compile: give the driver until the next
+			// update before blocking on it, instead of stalling right after glLinkProgram
+			if (e.pendingProgram && !(started && !parallelCompile) && finishBuild(e, false) && e.rebuildAgain)
+			{
+				e.rebuildAgain = false;
+				startBuild(e);
+			}
+			pending |= e.pendingProgram != 0;
+		}
+		// Keep frames coming in idle mode until the driver finishes the builds
+		if (pending)
+			FramePipeline::wake();
+	}
+
+	void shutdown()
+	{
+		watchStop();
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			Entry& e = entries[i];
+			if (e.pendingProgram)
+			{
+				glDeleteProgram(e.pendingProgram);
+				glDeleteShader(e.pendingShaders[0]);
+				glDeleteShader(e.pendingShaders[1]);
+			}
+			if (e.program)
+				glDeleteProgram(e.program);
+		}
+
+		std::lock_guard<std::mutex> lock(statsMutex);
+		entries.clear();
+		initialized = false;
+	}
+
+	void getStats(std::vector<ProgramStats>& out)
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		out.clear();
+		for (size_t i = 0; i < entries.size(); i++)
+			out.push_back(entries[i].stats);
+	}
+
+	bool parallelCompileSupported()
+	{
+		return parallelCompile;
+	}
+}
@@ -0,0 +1,420 @@
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+
+#include "SoftwareRenderer.h"
+#include "JobSystem.h"
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#include <emmintrin.h>
+#endif
+
+namespace SoftwareRenderer
+{
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		// Window space planes a*x + b*y + c: three edge functions (>= 0 inside), depth, 1/w,
+		// then varying/w for each varying of the batch in 'planes'
+		struct Triangle
+		{
+			float a[3], b[3], c[3];
+			float zx, zy, zc;
+			float wx, wy, wc;
+			int minX, minY, maxX, maxY;     // pixel centers covered, empty when minX > maxX
+			int batch;
+			int planeOffset;
+		};
+
+		Image* target = NULL;
+		glm::vec4 clearColor;
+		std::vector<Batch> batches;
+		std::vector<Triangle> triangles;    // two per submitted triangle: near clipping can make a quad
+		std::vector<float> planes;
+
+		// Bins filled per chunk of triangles so binning runs in parallel and draw order survives
+		const int binChunk = 4096;
+		std::vector< std::vector<int> > bins;
+		int tilesX, tilesY;
+
+		Stats stats = {};
+
+		void plane(const glm::vec3 p[3], float area, float f0, float f1, float f2, float& x, float& y, float& c)
+		{
+			x = ((f1 - f0) * (p[2].y - p[0].y) - (f2 - f0) * (p[1].y - p[0].y)) / area;
+			y = ((f2 - f0) * (p[1].x - p[0].x) - (f1 - f0) * (p[2].x - p[0].x)) / area;
+			c = f0 - x * p[0].x - y * p[0].y;
+		}
+
+		void emit(const Vertex* v0, const Vertex* v1, const Vertex* v2, int varyingCount, bool cull, Triangle& t, float* outPlanes)
+		{
+			t.minX = 1;
+			t.maxX = 0;
+			const Vertex* v[3] = { v0, v1, v2 };
+			glm::vec3 p[3];
+			float invW[3];
+			for (int i = 0; i < 3; i++)
+			{
+				invW[i] = 1.f / v[i]->position.w;
+				p[i] = glm::vec3((v[i]->position.x * invW[i] * 0.5f + 0.5f) * target->width,
+					(v[i]->position.y * invW[i] * 0.5f + 0.5f) * target->height,
+					v[i]->position.z * invW[i] * 0.5f + 0.5f);
+			}
+			float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+			if (area == 0.f || (cull && area < 0.f))
+				return;
+			if (area < 0.f)
+			{
+				// Keep the edge functions positive inside
+				std::swap(v[1], v[2]);
+				std::swap(p[1], p[2]);
+				std::swap(invW[1], invW[2]);
+				area = -area;
+			}
+
+			float minX = std::min(p[0].x, std::min(p[1].x, p[2].x)), maxX = std::max(p[0].x, std::max(p[1].x, p[2].x));
+			float minY = std::min(p[0].y, std::min(p[1].y, p[2].y)), maxY = std::max(p[0].y, std::max(p[1].y, p[2].y));
+			t.minX = std::max(0, (int)std::ceil(minX - 0.5f));
+			t.maxX = std::min(target->width - 1, (int)std::floor(maxX - 0.5f));
+			t.minY = std::max(0, (int)std::ceil(minY - 0.5f));
+			t.maxY = std::min(target->height - 1, (int)std::floor(maxY - 0.5f));
+			if (t.minY > t.maxY)
+				t.maxX = t.minX - 1;
+
+			for (int i = 0; i < 3; i++)
+			{
+				const glm::vec3& a = p[i];
+				const glm::vec3& b = p[(i + 1) % 3];
+				t.a[i] = a.y - b.y;
+				t.b[i] = b.x - a.x;
+				t.c[i] = -(t.a[i] * a.x + t.b[i] * a.y);
+			}
+			plane(p, area, p[0].z, p[1].z, p[2].z, t.zx, t.zy, t.zc);
+			plane(p, area, invW[0], invW[1], invW[2], t.wx, t.wy, t.wc);
+			for (int k = 0; k < varyingCount; k++)
+				plane(p, area, v[0]->varyings[k] * invW[0], v[1]->varyings[k] * invW[1], v[2]->varyings[k] * invW[2], outPlanes[k * 3], outPlanes[k * 3 + 1], outPlanes[k * 3 + 2]);
+		}
+
+		Vertex lerp(const Vertex& a, const Vertex& b, float t, int varyingCount)
+		{
+			Vertex r;
+			r.position = a.position + (b.position - a.position) * t;
+			for (int k = 0; k < varyingCount; k++)
+				r.varyings[k] = a.varyings[k] + (b.varyings[k] - a.varyings[k]) * t;
+			return r;
+		}
+
+		// Clip against the near plane (z >= -w) and set up; far and side planes are left to the raster bounds
+		void setup(const Vertex& v0, const Vertex& v1, const Vertex& v2, int varyingCount, bool cull, Triangle* out, float* outPlanes)
+		{
+			out[0].minX = out[1].minX = 1;
+			out[0].maxX = out[1].maxX = 0;
+			const Vertex* v[3] = { &v0, &v1, &v2 };
+			int inside = 0;
+			for (int k = 0; k < 3; k++)
+				inside += v[k]->position.z >= -v[k]->position.w;
+			if (inside == 3)
+			{
+				emit(v[0], v[1], v[2], varyingCount, cull, out[0], outPlanes);
+				return;
+			}
+			if (inside == 0)
+				return;
+
+			Vertex poly[4];
+			int n = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				const Vertex& a = *v[k];
+				const Vertex& b = *v[(k + 1) % 3];
+				float da = a.position.z + a.position.w, db = b.position.z + b.position.w;
+				if (da >= 0.f)
+					poly[n++] = a;
+				if ((da >= 0.f) != (db >= 0.f))
+					poly[n++] = lerp(a, b, da / (da - db), varyingCount);
+			}
+			emit(&poly[0], &poly[1], &poly[2], varyingCount, cull, out[0], outPlanes);
+			if (n == 4)
+				emit(&poly[0], &poly[2], &poly[3], varyingCount, cull, out[1], outPlanes + varyingCount * 3);
+		}
+
+		void submit(const Batch& batch, const Vertex* vertices, const unsigned int* indices, int indexCount, bool cull)
+		{
+			Clock::time_point t0 = Clock::now();
+			const int count = indexCount / 3;
+			const int first = (int)triangles.size();
+			const int firstPlane = (int)planes.size();
+			const int stride = batch.varyingCount * 3;
+			const int batchIndex = (int)batches.size();
+			batches.push_back(batch);
+			triangles.resize(first + count * 2);
+			planes.resize(firstPlane + count * 2 * stride);
+
+			JobSystem::parallelFor(count, 256, [&](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+				{
+					Triangle* out = &triangles[first + i * 2];
+					float* outPlanes = planes.empty() ? NULL : &planes[0] + firstPlane + i * 2 * stride;
+					setup(vertices[indices[i * 3]], vertices[indices[i * 3 + 1]], vertices[indices[i * 3 + 2]], batch.varyingCount, cull, out, outPlanes);
+					out[0].batch = out[1].batch = batchIndex;
+					out[0].planeOffset = firstPlane + i * 2 * stride;
+					out[1].planeOffset = out[0].planeOffset + stride;
+				}
+			});
+			stats.triangles += count;
+			stats.setupMs += std::chrono::duration<float, std::milli>(Clock::now() - t0).count();
+		}
+
+		unsigned int pack(const glm::vec4& color)
+		{
+			glm::vec4 c = glm::clamp(color, 0.f, 1.f) * 255.f + 0.5f;
+			return (unsigned int)c.r | ((unsigned int)c.g << 8) | ((unsigned int)c.b << 16) | ((unsigned int)c.a << 24);
+		}
+
+		void shadePixel(const Triangle& t, const Batch& batch, int x, int y, float px, float py, float z)
+		{
+			float& depth = target->depth[y * target->width + x];
+			if (z > depth || z > 1.f)
+				return;
+			float varyings[maxVaryings];
+			const float w = 1.f / (t.wx * px + t.wy * py + t.wc);
+			for (int k = 0; k < batch.varyingCount; k++)
+			{
+				const float* p = &planes[t.planeOffset + k * 3];
+				varyings[k] = (p[0] * px + p[1] * py + p[2]) * w;
+			}
+			target->color[y * target->width + x] = pack(batch.shader(batch.uniforms, varyings, px, py));
+			depth = z;
+		}
+
+		void rasterTile(int tile)
+		{
+			const int x0 = (tile % tilesX) * tileSize, y0 = (tile / tilesX) * tileSize;
+			const int x1 = std::min(x0 + tileSize, target->width), y1 = std::min(y0 + tileSize, target->height);
+			const unsigned int clear = pack(clearColor);
+			for (int y = y0; y < y1; y++)
+			{
+				std::fill_n(&target->color[y * target->width + x0], x1 - x0, clear);
+				std::fill_n(&target->depth[y * target->width + x0], x1 - x0, 1.f);
+			}
+
+			const int tileCount = tilesX * tilesY;
+			for (size_t chunk = tile; chunk < bins.size(); chunk += tileCount)
+			{
+				const std::vector<int>& bin = bins[chunk];
+				for (size_t i = 0; i < bin.size(); i++)
+				{
+					const Triangle& t = triangles[bin[i]];
+					const Batch& batch = batches[t.batch];
+					const int startX = std::max(t.minX, x0), endX = std::min(t.maxX, x1 - 1);
+					const int startY = std::max(t.minY, y0), endY = std::min(t.maxY, y1 - 1);
+					for (int y = startY; y <= endY; y++)
+					{
+						const float py = (float)y + 0.5f;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+						// Coverage and depth four pixels at a time, shading per covered pixel
+						const __m128 a0 = _mm_set1_ps(t.a[0]), a1 = _mm_set1_ps(t.a[1]), a2 = _mm_set1_ps(t.a[2]);
+						const __m128 row0 = _mm_set1_ps(t.b[0] * py + t.c[0]);
+						const __m128 row1 = _mm_set1_ps(t.b[1] * py + t.c[1]);
+						const __m128 row2 = _mm_set1_ps(t.b[2] * py + t.c[2]);
+						const __m128 zx = _mm_set1_ps(t.zx), rowZ = _mm_set1_ps(t.zy * py + t.zc);
+						const __m128 first = _mm_set1_ps((float)startX), last = _mm_set1_ps((float)endX + 1.f);
+						const __m128 zero = _mm_setzero_ps();
+						for (int x = startX & ~3; x <= endX; x += 4)
+						{
+							const __m128 lane = _mm_add_ps(_mm_set1_ps((float)x), _mm_setr_ps(0.f, 1.f, 2.f, 3.f));
+							const __m128 px = _mm_add_ps(lane, _mm_set1_ps(0.5f));
+							__m128 mask = _mm_and_ps(_mm_cmpge_ps(lane, first), _mm_cmplt_ps(lane, last));
+							mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), row0), zero));
+							mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), row1), zero));
+							mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), row2), zero));
+							int bits = _mm_movemask_ps(mask);
+							if (bits == 0)
+								continue;
+							float z[4];
+							_mm_storeu_ps(z, _mm_add_ps(_mm_mul_ps(zx, px), rowZ));
+							for (int k = 0; k < 4; k++)
+							{
+								if (bits & (1 << k))
+									shadePixel(t, batch, x + k, y, (float)(x + k) + 0.5f, py, z[k]);
+							}
+						}
+#else
+						for (int x = startX; x <= endX; x++)
+						{
+							const float px = (float)x + 0.5f;
+							if (t.a[0] * px + t.b[0] * py + t.c[0] >= 0.f && t.a[1] * px + t.b[1] * py + t.c[1] >= 0.f && t.a[2] * px + t.b[2] * py + t.c[2] >= 0.f)
+								shadePixel(t, batch, x, y, px, py, t.zx * px + t.zy * py + t.zc);
+						}
+#endif
+					}
+				}
+			}
+		}
+	}
+
+	void begin(Image& image, int width, int height, const glm::vec4& color)
+	{
+		target = &image;
+		image.width = width;
+		image.height = height;
+		image.color.resize((size_t)width * height);
+		image.depth.resize((size_t)width * height);
+		clearColor = color;
+		batches.clear();
+		triangles.clear();
+		planes.clear();
+		stats = Stats();
+	}
+
+	void drawTriangles(const Batch& batch, const Vertex* vertices, const unsigned int* indices, int indexCount)
+	{
+		submit(batch, vertices, indices, indexCount, true);
+	}
+
+	void drawLines(const Batch& batch, const Vertex* vertices, const unsigned int* indices, int indexCount)
+	{
+		// Each segment becomes a quad one pixel wide in window space
+		std::vector<Vertex> quads;
+		std::vector<unsigned int> quadIndices;
+		for (int i = 0; i + 1 < indexCount; i += 2)
+		{
+			Vertex a = vertices[indices[i]], b = vertices[indices[i + 1]];
+			float da = a.position.z + a.position.w, db = b.position.z + b.position.w;
+			if (da < 0.f && db < 0.f)
+				continue;
+			if (da < 0.f)
+				a = lerp(a, b, da / (da - db), batch.varyingCount);
+			else if (db < 0.f)
+				b = lerp(b, a, db / (db - da), batch.varyingCount);
+
+			glm::vec2 pa = glm::vec2(a.position) / a.position.w * glm::vec2(target->width, target->height) * 0.5f;
+			glm::vec2 pb = glm::vec2(b.position) / b.position.w * glm::vec2(target->width, target->height) * 0.5f;
+			glm::vec2 d = pb - pa;
+			if (glm::dot(d, d) == 0.f)
+				continue;
+			// Half a pixel to each side, back in NDC units
+			glm::vec2 offset = glm::normalize(glm::vec2(-d.y, d.x)) * 0.5f * 2.f / glm::vec2(target->width, target->height);
+
+			unsigned int base = (unsigned int)quads.size();
+			const Vertex* ends[2] = { &a, &b };
+			for (int e = 0; e < 2; e++)
+			{
+				for (int side = -1; side <= 1; side += 2)
+				{
+					Vertex v = *ends[e];
+					v.position.x += side * offset.x * v.position.w;
+					v.position.y += side * offset.y * v.position.w;
+					quads.push_back(v);
+				}
+			}
+			const unsigned int quad[6] = { base, base + 1, base + 3, base, base + 3, base + 2 };
+			quadIndices.insert(quadIndices.end(), quad, quad + 6);
+		}
+		if (!quadIndices.empty())
+			submit(batch, &quads[0], &quadIndices[0], (int)quadIndices.size(), false);
+	}
+
+	void end()
+	{
+		Clock::time_point t0 = Clock::now();
+		tilesX = (target->width + tileSize - 1) / tileSize;
+		tilesY = (target->height + tileSize - 1) / tileSize;
+		const int tileCount = tilesX * tilesY;
+		const int chunks = ((int)triangles.size() + binChunk - 1) / binChunk;
+		bins.resize((size_t)chunks * tileCount);
+
+		JobSystem::parallelFor(chunks, 1, [&](int begin, int end)
+		{
+			for (int chunk = begin; chunk < end; chunk++)
+			{
+				std::vector<int>* chunkBins = &bins[(size_t)chunk * tileCount];
+				for (int tile = 0; tile < tileCount; tile++)
+					chunkBins[tile].clear();
+				const int last = std::min((int)triangles.size(), (chunk + 1) * binChunk);
+				for (int i = chunk * binChunk; i < last; i++)
+				{
+					const Triangle& t = triangles[i];
+					if (t.minX > t.maxX)
+						continue;
+					for (int ty = t.minY / tileSize; ty <= t.maxY / tileSize; ty++)
+					{
+						for (int tx = t.minX / tileSize; tx <= t.maxX / tileSize; tx++)
+							chunkBins[ty * tilesX + tx].push_back(i);
+					}
+				}
+			}
+		});
+		int rasterized = 0;
+		for (size_t i = 0; i < triangles.size(); i++)
+			rasterized += triangles[i].minX <= triangles[i].maxX;
+		stats.rasterized = rasterized;
+
+		JobSystem::parallelFor(tileCount, 1, [&](int begin, int end)
+		{
+			for (int tile = begin; tile < end; tile++)
+				rasterTile(tile);
+		});
+		stats.rasterMs = std::chrono::duration<float, std::milli>(Clock::now() - t0).count();
+		target = NULL;
+	}
+
+	glm::vec4 sample(const TextureSystem::Image& image, const glm::vec2& uv)
+	{
+		if (image.levels.empty())
+			return glm::vec4(1.f);
+		const int w = image.levels[0].width, h = image.levels[0].height;
+		const float x = uv.x * w - 0.5f, y = uv.y * h - 0.5f;
+		const float fx = std::floor(x), fy = std::floor(y);
+		const int x0 = (((int)fx % w) + w) % w, y0 = (((int)fy % h) + h) % h;
+		const int x1 = (x0 + 1) % w, y1 = (y0 + 1) % h;
+		const unsigned char* p = &image.pixels[image.levels[0].offset];
+		glm::vec4 texel[4];
+		const int xs[4] = { x0, x1, x0, x1 }, ys[4] = { y0, y0, y1, y1 };
+		for (int i = 0; i < 4; i++)
+		{
+			const unsigned char* c = p + ((size_t)ys[i] * w + xs[i]) * 4;
+			texel[i] = glm::vec4(c[0], c[1], c[2], c[3]) * (1.f / 255.f);
+		}
+		const float tx = x - fx, ty = y - fy;
+		return glm::mix(glm::mix(texel[0], texel[1], tx), glm::mix(texel[2], texel[3], tx), ty);
+	}
+
+	bool writeTGA(const Image& image, const char* path)
+	{
+		FILE* file = fopen(path, "wb");
+		if (file == NULL)
+			return false;
+		// Uncompressed true color, 8 alpha bits, origin bottom-left like the image rows
+		unsigned char header[18] = {};
+		header[2] = 2;
+		header[12] = image.width & 0xff;
+		header[13] = (image.width >> 8) & 0xff;
+		header[14] = image.height & 0xff;
+		header[15] = (image.height >> 8) & 0xff;
+		header[16] = 32;
+		header[17] = 8;
+		fwrite(header, 1, sizeof(header), file);
+
+		std::vector<unsigned char> bgra(image.color.size() * 4);
+		for (size_t i = 0; i < image.color.size(); i++)
+		{
+			const unsigned int c = image.color[i];
+			bgra[i * 4 + 0] = (c >> 16) & 0xff;
+			bgra[i * 4 + 1] = (c >> 8) & 0xff;
+			bgra[i * 4 + 2] = c & 0xff;
+			bgra[i * 4 + 3] = c >> 24;
+		}
+		bool ok = bgra.empty() || fwrite(&bgra[0], 1, bgra.size(), file) == bgra.size();
+		fclose(file);
+		return ok;
+	}
+
+	Stats getStats()
+	{
+		return stats;
+	}
+}
@@ -0,0 +1,546 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <glm\glm.hpp>
+#include <SDL2\SDL.h>
+
+#include "TextureSystem.h"
+#include "JobSystem.h"
+#include "FramePipeline.h"
+#include "LogConsole.h"
+#include "MemoryTracker.h"
+
+namespace TextureSystem
+{
+	int uploadBudget = 4 << 20;
+
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		enum State { Queued, Decoded, Ready, Failed };
+
+		struct Slot
+		{
+			std::string path;
+			std::atomic<int> state;
+			Image image;        // owned by the decode job until Decoded, then by the GL thread
+
+			// GL thread
+			GLuint handle;
+			bool allocated;
+			bool hasLevel;      // at least the smallest mip is on the GPU
+			int uploadLevel;    // level being streamed, counts down to 0
+			int uploadRow;
+		};
+
+		const int maxTextures = 256;
+		Slot slots[maxTextures];
+		int slotCount = 0;
+
+		std::mutex requestMutex;
+		std::vector<int> requests;
+		JobSystem::Counter decodeCounter;
+
+		GLuint placeholder = 0;
+		GLuint pbos[2];
+		int pboIndex = 0;
+		std::atomic<int> uploadedLastFrame(0);
+
+		// Accumulated over every decode job, for the throughput report
+		std::atomic<long long> decodeBytes(0), decodeMicros(0), mipBytes(0), mipMicros(0);
+
+		struct Strip
+		{
+			int slot, level, row, rows;
+			size_t offset;  // in the PBO
+		};
+		std::vector<Strip> strips;
+
+		////////////////////////////////////////////////// Decoding
+		bool readFile(const char* path, std::vector<unsigned char>& out)
+		{
+			FILE* file = fopen(path, "rb");
+			if (file == NULL)
+				return false;
+			fseek(file, 0, SEEK_END);
+			long size = ftell(file);
+			fseek(file, 0, SEEK_SET);
+			out.resize(size > 0 ? (size_t)size : 0);
+			size_t read = size > 0 ? fread(&out[0], 1, (size_t)size, file) : 0;
+			fclose(file);
+			return size > 0 && read == (size_t)size;
+		}
+
+		void allocateLevel0(Image& out, int width, int height)
+		{
+			out.levels.resize(1);
+			out.levels[0].width = width;
+			out.levels[0].height = height;
+			out.levels[0].offset = 0;
+			out.pixels.resize((size_t)width * height * 4);
+		}
+
+		bool decodeBMP(const unsigned char* data, size_t size, Image& out)
+		{
+			SDL_Surface* loaded = SDL_LoadBMP_RW(SDL_RWFromConstMem(data, (int)size), 1);
+			if (loaded == NULL)
+				return false;
+			SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+			SDL_FreeSurface(loaded);
+			if (rgba == NULL)
+				return false;
+
+			// Surfaces are top-down
+			allocateLevel0(out, rgba->w, rgba->h);
+			const size_t rowBytes = (size_t)rgba->w * 4;
+			for (int y = 0; y < rgba->h; y++)
+				memcpy(&out.pixels[(size_t)(rgba->h - 1 - y) * rowBytes], (const unsigned char*)rgba->pixels + (size_t)y * rgba->pitch, rowBytes);
+			SDL_FreeSurface(rgba);
+			return true;
+		}
+
+		////////////////////////////////////////////////// Mips
+		// Destination pixel = rounded average of a 2x2 block, edges clamp on odd or 1-pixel sizes
+		void downsample(const unsigned char* src, int sw, int sh, unsigned char* dst, int dw, int dh, bool simd)
+		{
+			for (int y = 0; y < dh; y++)
+			{
+				const unsigned char* row0 = src + (size_t)(2 * y) * sw * 4;
+				const unsigned char* row1 = src + (size_t)std::min(2 * y + 1, sh - 1) * sw * 4;
+				unsigned char* out = dst + (size_t)y * dw * 4;
+
+				int x = 0;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+				if (simd)
+				{
+					const __m128i zero = _mm_setzero_si128();
+					const __m128i round = _mm_set1_epi16(2);
+					// 4 source pixels per row -> 2 destination pixels
+					for (; x + 2 <= dw; x += 2)
+					{
+						__m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+						__m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+						__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+						__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+						__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+						sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+						_mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(sum, sum));
+					}
+				}
+#endif
+				for (; x < dw; x++)
+				{
+					int x0 = 2 * x * 4, x1 = std::min(2 * x + 1, sw - 1) * 4;
+					for (int c = 0; c < 4; c++)
+						out[x * 4 + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+				}
+			}
+		}
+
+		void buildMips(Image& image, bool simd)
+		{
+			image.levels.resize(1);
+			size_t total = (size_t)image.levels[0].width * image.levels[0].height * 4;
+			while (image.levels.back().width > 1 || image.levels.back().height > 1)
+			{
+				Image::Level next;
+				next.width = std::max(1, image.levels.back().width / 2);
+				next.height = std::max(1, image.levels.back().height / 2);
+				next.offset = total;
+				total += (size_t)next.width * next.height * 4;
+				image.levels.push_back(next);
+			}
+			image.pixels.resize(total);
+
+			for (size_t l = 1; l < image.levels.size(); l++)
+			{
+				const Image::Level& src = image.levels[l - 1];
+				const Image::Level& dst = image.levels[l];
+				downsample(&image.pixels[src.offset], src.width, src.height, &image.pixels[dst.offset], dst.width, dst.height, simd);
+			}
+		}
+
+		void decodeJob(void* data, int, int)
+		{
+			Slot& s = *(Slot*)data;
+			MemoryTracker::Scope memory(MemoryTracker::Textures, "TextureSystem decode");
+
+			Clock::time_point start = Clock::now();
+			if (!decodeFile(s.path.c_str(), s.image))
+			{
+				LogConsole::log(LogConsole::Error, "Error Texture: can't decode %s\n", s.path.c_str());
+				s.state.store(Failed, std::memory_order_release);
+				FramePipeline::wake();
+				return;
+			}
+			Clock::time_point decoded = Clock::now();
+			generateMips(s.image);
+			Clock::time_point mipped = Clock::now();
+
+			long long bytes = (long long)s.image.levels[0].width * s.image.levels[0].height * 4;
+			decodeBytes += bytes;
+			decodeMicros += std::chrono::duration_cast<std::chrono::microseconds>(decoded - start).count();
+			mipBytes += bytes;
+			mipMicros += std::chrono::duration_cast<std::chrono::microseconds>(mipped - decoded).count();
+
+			s.uploadLevel = (int)s.image.levels.size() - 1;
+			s.uploadRow = 0;
+			s.state.store(Decoded, std::memory_order_release);
+			FramePipeline::wake(); // the upload happens in the next drawn frame
+		}
+
+		////////////////////////////////////////////////// GL
+		void initialize()
+		{
+			const unsigned char white[4] = { 255, 255, 255, 255 };
+			glGenTextures(1, &placeholder);
+			glBindTexture(GL_TEXTURE_2D, placeholder);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+			MemoryTracker::gpuTexture(placeholder, sizeof(white));
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			glGenBuffers(2, pbos);
+		}
+
+		// Storage for every level up front so the texture is complete from the first uploaded mip on
+		void allocate(Slot& s)
+		{
+			const int levels = (int)s.image.levels.size();
+			glGenTextures(1, &s.handle);
+			glBindTexture(GL_TEXTURE_2D, s.handle);
+			size_t bytes = 0;
+			for (int l = 0; l < levels; l++)
+			{
+				glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, s.image.levels[l].width, s.image.levels[l].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+				bytes += (size_t)s.image.levels[l].width * s.image.levels[l].height * 4;
+			}
+			MemoryTracker::gpuTexture(s.handle, bytes);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levels - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			s.allocated = true;
+		}
+	}
+
+	bool decodeTGA(const unsigned char* data, size_t size, Image& out)
+	{
+		if (size < 18)
+			return false;
+		const int idLength = data[0], colorMapType = data[1], imageType = data[2];
+		const int width = data[12] | (data[13] << 8), height = data[14] | (data[15] << 8);
+		const int bpp = data[16];
+		const bool topDown = (data[17] & 0x20) != 0;
+		const bool rle = imageType == 10 || imageType == 11;
+		const bool gray = imageType == 3 || imageType == 11;
+
+		// Only true color (24/32 bit) and 8-bit grayscale, no color maps
+		if (colorMapType != 0 || width <= 0 || height <= 0)
+			return false;
+		if (gray ? bpp != 8 : ((imageType != 2 && imageType != 10) || (bpp != 24 && bpp != 32)))
+			return false;
+
+		const int pixelBytes = bpp / 8;
+		const unsigned char* p = data + 18 + idLength;
+		const unsigned char* end = data + size;
+		allocateLevel0(out, width, height);
+
+		int x = 0, y = 0;
+		unsigned char* dst = &out.pixels[(size_t)(topDown ? height - 1 : 0) * width * 4];
+		const unsigned char* pixel = NULL;
+		int run = 0, literal = 0;
+		for (size_t n = (size_t)width * height; n > 0; n--)
+		{
+			if (!rle || literal > 0)
+			{
+				if (end - p < pixelBytes) return false;
+				pixel = p;
+				p += pixelBytes;
+				literal--;
+			}
+			else if (run > 0)
+			{
+				run--;
+			}
+			else
+			{
+				// Packet header: high bit set = one pixel repeated, otherwise that many raw pixels
+				if (end - p < 1 + pixelBytes) return false;
+				int count = (*p & 0x7f) + 1;
+				bool repeat = (*p & 0x80) != 0;
+				pixel = p + 1;
+				p += 1 + pixelBytes;
+				run = repeat ? count - 1 : 0;
+				literal = repeat ? 0 : count - 1;
+			}
+
+			// BGR(A) -> RGBA
+			if (gray)
+			{
+				dst[0] = dst[1] = dst[2] = pixel[0];
+				dst[3] = 255;
+			}
+			else
+			{
+				dst[0] = pixel[2];
+				dst[1] = pixel[1];
+				dst[2] = pixel[0];
+				dst[3] = pixelBytes == 4 ? pixel[3] : 255;
+			}
+			dst += 4;
+
+			if (++x == width)
+			{
+				x = 0;
+				y++;
+				dst = &out.pixels[(size_t)(topDown ? height - 1 - std::min(y, height - 1) : std::min(y, height - 1)) * width * 4];
+			}
+		}
+		return true;
+	}
+
+	bool decodeFile(const char* path, Image& out)
+	{
+		std::vector<unsigned char> data;
+		if (!readFile(path, data))
+			return false;
+		if (data.size() >= 2 && data[0] == 'B' && data[1] == 'M')
+			return decodeBMP(&data[0], data.size(), out);
+		return decodeTGA(&data[0], data.size(), out);
+	}
+
+	void generateMips(Image& image)
+	{
+		buildMips(image, true);
+	}
+
+	void generateMipsScalar(Image& image)
+	{
+		buildMips(image, false);
+	}
+
+	int load(const char* path)
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Textures, "TextureSystem::load");
+		if (placeholder == 0)
+			initialize();
+		if (slotCount == maxTextures)
+		{
+			LogConsole::log(LogConsole::Error, "Error Texture: more than %d textures, %s not loaded\n", maxTextures, path);
+			return -1;
+		}
+
+		const int id = slotCount++;
+		Slot& s = slots[id];
+		s.path = path;
+		s.state.store(Queued);
+		s.handle = 0;
+		s.allocated = false;
+		s.hasLevel = false;
+
+		std::lock_guard<std::mutex> lock(requestMutex);
+		requests.push_back(id);
+		FramePipeline::wake();
+		return id;
+	}
+
+	GLuint texture(int id)
+	{
+		if (id < 0 || !slots[id].hasLevel)
+			return placeholder;
+		return slots[id].handle;
+	}
+
+	void dispatch()
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		for (size_t i = 0; i < requests.size(); i++)
+			JobSystem::run(&decodeJob, &slots[requests[i]], 0, 1, &decodeCounter);
+		requests.clear();
+	}
+
+	void update()
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Textures, "TextureSystem::update");
+		// Cut this frame's uploads into row strips, smallest levels first, until the budget is spent
+		strips.clear();
+		size_t bytes = 0;
+		const size_t budget = (size_t)std::max(uploadBudget, 1);
+		for (int i = 0; i < slotCount && bytes < budget; i++)
+		{
+			Slot& s = slots[i];
+			if (s.state.load(std::memory_order_acquire) != Decoded)
+				continue;
+			if (!s.allocated)
+				allocate(s);
+
+			while (s.uploadLevel >= 0 && bytes < budget)
+			{
+				const Image::Level& level = s.image.levels[s.uploadLevel];
+				const size_t rowBytes = (size_t)level.width * 4;
+				const int rows = std::min(level.height - s.uploadRow, (int)std::max<size_t>(1, (budget - bytes) / rowBytes));
+				Strip strip = { i, s.uploadLevel, s.uploadRow, rows, bytes };
+				strips.push_back(strip);
+				bytes += rows * rowBytes;
+
+				s.uploadRow += rows;
+				if (s.uploadRow == level.height)
+				{
+					s.uploadLevel--;
+					s.uploadRow = 0;
+				}
+			}
+		}
+		uploadedLastFrame = (int)bytes;
+		if (strips.empty())
+			return;
+		if (bytes >= budget)
+			FramePipeline::wake(); // more levels wait for the next frame's budget
+
+		// One orphaned PBO per frame, alternating so the copy never waits on last frame's transfer
+		pboIndex ^= 1;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[pboIndex]);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+		MemoryTracker::gpuBuffer(pbos[pboIndex], bytes);
+		unsigned char* mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		for (size_t k = 0; mapped && k < strips.size(); k++)
+		{
+			const Strip& strip = strips[k];
+			const Image& image = slots[strip.slot].image;
+			const Image::Level& level = image.levels[strip.level];
+			const size_t rowBytes = (size_t)level.width * 4;
+			memcpy(mapped + strip.offset, &image.pixels[level.offset + strip.row * rowBytes], strip.rows * rowBytes);
+		}
+		if (mapped == NULL || glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+		{
+			// Nothing valid reached the buffer: rewind to each texture's first strip and retry next frame
+			LogConsole::log(LogConsole::Error, "Error Texture: upload buffer lost, retrying\n");
+			for (size_t k = strips.size(); k-- > 0;)
+			{
+				slots[strips[k].slot].uploadLevel = strips[k].level;
+				slots[strips[k].slot].uploadRow = strips[k].row;
+			}
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			uploadedLastFrame = 0;
+			return;
+		}
+
+		for (size_t k = 0; k < strips.size(); k++)
+		{
+			const Strip& strip = strips[k];
+			Slot& s = slots[strip.slot];
+			const Image::Level& level = s.image.levels[strip.level];
+			glBindTexture(GL_TEXTURE_2D, s.handle);
+			glTexSubImage2D(GL_TEXTURE_2D, strip.level, 0, strip.row, level.width, strip.rows, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)strip.offset);
+
+			if (strip.row + strip.rows < level.height)
+				continue;
+			// Level complete: sample from it from now on
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, strip.level);
+			s.hasLevel = true;
+			if (strip.level == 0)
+			{
+				Image().pixels.swap(s.image.pixels);
+				s.state.store(Ready, std::memory_order_release);
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	void shutdown()
+	{
+		JobSystem::wait(&decodeCounter);
+		for (int i = 0; i < slotCount; i++)
+		{
+			if (slots[i].handle)
+			{
+				glDeleteTextures(1, &slots[i].handle);
+				MemoryTracker::gpuTexturesDeleted(1, &slots[i].handle);
+			}
+			slots[i].handle = 0;
+			slots[i].image = Image();
+		}
+		slotCount = 0;
+		if (placeholder)
+		{
+			glDeleteTextures(1, &placeholder);
+			glDeleteBuffers(2, pbos);
+			MemoryTracker::gpuTexturesDeleted(1, &placeholder);
+			MemoryTracker::gpuBuffersDeleted(2, pbos);
+		}
+		placeholder = 0;
+	}
+
+	Stats getStats()
+	{
+		Stats stats = {};
+		stats.loaded = slotCount;
+		for (int i = 0; i < stats.loaded; i++)
+		{
+			int state = slots[i].state.load(std::memory_order_relaxed);
+			if (state == Ready) stats.ready++;
+			if (state == Failed) stats.failed++;
+		}
+		long long dm = decodeMicros, mm = mipMicros;
+		stats.decodeMBs = dm > 0 ? (float)decodeBytes / (float)dm : 0.f;
+		stats.mipMBs = mm > 0 ? (float)mipBytes / (float)mm : 0.f;
+		stats.uploadedLastFrame = uploadedLastFrame;
+		return stats;
+	}
+
+	BenchResult benchmark()
+	{
+		// 2048x2048 gradient encoded as an uncompressed 32-bit TGA
+		const int side = 2048;
+		std::vector<unsigned char> tga(18 + (size_t)side * side * 4);
+		tga[2] = 2;
+		tga[12] = side & 0xff; tga[13] = side >> 8;
+		tga[14] = side & 0xff; tga[15] = side >> 8;
+		tga[16] = 32;
+		for (size_t i = 0; i < (size_t)side * side; i++)
+		{
+			unsigned char* p = &tga[18 + i * 4];
+			p[0] = (unsigned char)(i % side); p[1] = (unsigned char)(i / side); p[2] = (unsigned char)(i * 7); p[3] = 255;
+		}
+		const double imageMB = (double)side * side * 4 * 1e-6;
+
+		BenchResult res = {};
+		const int copies = 8;
+		std::vector<Image> decoded(copies);
+		Clock::time_point start = Clock::now();
+		JobSystem::parallelFor(copies, 1, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				decodeTGA(&tga[0], tga.size(), decoded[i]);
+		});
+		res.decodeMBs = (float)(copies * imageMB / std::chrono::duration<double>(Clock::now() - start).count());
+
+		Image scalar, simd;
+		scalar.levels = decoded[0].levels;
+		scalar.pixels.swap(decoded[0].pixels);
+		simd.levels = scalar.levels;
+		simd.pixels = scalar.pixels;
+
+		start = Clock::now();
+		generateMipsScalar(scalar);
+		res.mipScalarMBs = (float)(imageMB / std::chrono::duration<double>(Clock::now() - start).count());
+
+		start = Clock::now();
+		generateMips(simd);
+		res.mipSimdMBs = (float)(imageMB / std::chrono::duration<double>(Clock::now() - start).count());
+
+		if (scalar.pixels != simd.pixels)
+			LogConsole::log(LogConsole::Error, "Error Texture: SIMD mips differ from the scalar reference\n");
+		return res;
+	}
+}
@@ -0,0 +1,194 @@
+#include <chrono>
+#include <glm\gtc\matrix_transform.hpp>
+#include <glm\gtc\type_ptr.hpp>
+#include <glm\simd\matrix.h>
+
+#include "TransformSystem.h"
+
+namespace TransformSystem
+{
+	void Transforms::resize(int count)
+	{
+		posX.resize(count); posY.resize(count); posZ.resize(count);
+		rotX.resize(count); rotY.resize(count); rotZ.resize(count); rotW.resize(count, 1.f);
+		scaleX.resize(count, 1.f); scaleY.resize(count, 1.f); scaleZ.resize(count, 1.f);
+	}
+
+	void Transforms::set(int i, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+	{
+		posX[i] = position.x; posY[i] = position.y; posZ[i] = position.z;
+		rotX[i] = rotation.x; rotY[i] = rotation.y; rotZ[i] = rotation.z; rotW[i] = rotation.w;
+		scaleX[i] = scale.x; scaleY[i] = scale.y; scaleZ[i] = scale.z;
+	}
+
+	namespace
+	{
+		// T * R * S of transform i, built straight from the quaternion (same math as the SIMD lanes)
+		void composeOne(const Transforms& t, const glm::mat4* parent, int i, float* out)
+		{
+			float x = t.rotX[i], y = t.rotY[i], z = t.rotZ[i], w = t.rotW[i];
+			float sx = t.scaleX[i], sy = t.scaleY[i], sz = t.scaleZ[i];
+			glm::mat4 local(
+				(1.f - 2.f * (y * y + z * z)) * sx, 2.f * (x * y + w * z) * sx, 2.f * (x * z - w * y) * sx, 0.f,
+				2.f * (x * y - w * z) * sy, (1.f - 2.f * (x * x + z * z)) * sy, 2.f * (y * z + w * x) * sy, 0.f,
+				2.f * (x * z + w * y) * sz, 2.f * (y * z - w * x) * sz, (1.f - 2.f * (x * x + y * y)) * sz, 0.f,
+				t.posX[i], t.posY[i], t.posZ[i], 1.f);
+			glm::mat4 world = parent ? *parent * local : local;
+			memcpy(out, glm::value_ptr(world), sizeof(glm::mat4));
+		}
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+		// How a batch picks its transforms: a contiguous range or an index list
+		struct RangeIndexer
+		{
+			int first;
+			int index(int k) const { return first + k; }
+			__m128 load(const std::vector<float>& v, int k) const { return _mm_loadu_ps(&v[first + k]); }
+		};
+
+		struct ListIndexer
+		{
+			const int* indices;
+			int index(int k) const { return indices[k]; }
+			__m128 load(const std::vector<float>& v, int k) const
+			{
+				return _mm_setr_ps(v[indices[k]], v[indices[k + 1]], v[indices[k + 2]], v[indices[k + 3]]);
+			}
+		};
+
+		template <typename Indexer>
+		void composeBatch(const Transforms& t, const glm::mat4* parent, const Indexer& idx, int count, float* out)
+		{
+			glm_vec4 parentCols[4];
+			if (parent)
+			{
+				for (int c = 0; c < 4; c++)
+					parentCols[c] = _mm_loadu_ps(&(*parent)[c][0]);
+			}
+
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 two = _mm_set1_ps(2.f);
+			const __m128 zero = _mm_setzero_ps();
+
+			int k = 0;
+			for (; k + 4 <= count; k += 4)
+			{
+				// Each register holds the same component of four transforms
+				__m128 x = idx.load(t.rotX, k), y = idx.load(t.rotY, k), z = idx.load(t.rotZ, k), w = idx.load(t.rotW, k);
+				__m128 sx = idx.load(t.scaleX, k), sy = idx.load(t.scaleY, k), sz = idx.load(t.scaleZ, k);
+
+				__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+				__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+				__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+				__m128 col0[4] = {
+					_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+					_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+					_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+					zero };
+				__m128 col1[4] = {
+					_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+					_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+					_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+					zero };
+				__m128 col2[4] = {
+					_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+					_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+					_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+					zero };
+				__m128 col3[4] = { idx.load(t.posX, k), idx.load(t.posY, k), idx.load(t.posZ, k), one };
+
+				// Lanes -> one column per transform
+				_MM_TRANSPOSE4_PS(col0[0], col0[1], col0[2], col0[3]);
+				_MM_TRANSPOSE4_PS(col1[0], col1[1], col1[2], col1[3]);
+				_MM_TRANSPOSE4_PS(col2[0], col2[1], col2[2], col2[3]);
+				_MM_TRANSPOSE4_PS(col3[0], col3[1], col3[2], col3[3]);
+
+				for (int lane = 0; lane < 4; lane++)
+				{
+					glm_vec4 local[4] = { col0[lane], col1[lane], col2[lane], col3[lane] };
+					glm_vec4 world[4];
+					if (parent)
+						glm_mat4_mul(parentCols, local, world);
+					else
+						world[0] = local[0], world[1] = local[1], world[2] = local[2], world[3] = local[3];
+
+					float* dst = out + (k + lane) * 16;
+					_mm_storeu_ps(dst + 0, world[0]);
+					_mm_storeu_ps(dst + 4, world[1]);
+					_mm_storeu_ps(dst + 8, world[2]);
+					_mm_storeu_ps(dst + 12, world[3]);
+				}
+			}
+
+			for (; k < count; k++)
+				composeOne(t, parent, idx.index(k), out + k * 16);
+		}
+#endif
+	}
+
+	void compose(const Transforms& t, const glm::mat4* parent, int begin, int end, float* out)
+	{
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+		RangeIndexer idx = { begin };
+		composeBatch(t, parent, idx, end - begin, out);
+#else
+		for (int i = begin; i < end; i++)
+			composeOne(t, parent, i, out + (i - begin) * 16);
+#endif
+	}
+
+	void compose(const Transforms& t, const glm::mat4* parent, const int* indices, int count, float* out)
+	{
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+		ListIndexer idx = { indices };
+		composeBatch(t, parent, idx, count, out);
+#else
+		for (int k = 0; k < count; k++)
+			composeOne(t, parent, indices[k], out + k * 16);
+#endif
+	}
+
+	void composeScalar(const Transforms& t, const glm::mat4* parent, int begin, int end, float* out)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			glm::quat rotation(t.rotW[i], t.rotX[i], t.rotY[i], t.rotZ[i]);
+			glm::mat4 world = glm::translate(glm::mat4(), glm::vec3(t.posX[i], t.posY[i], t.posZ[i]))
+				* glm::mat4_cast(rotation)
+				* glm::scale(glm::mat4(), glm::vec3(t.scaleX[i], t.scaleY[i], t.scaleZ[i]));
+			if (parent)
+				world = *parent * world;
+			memcpy(out + (i - begin) * 16, glm::value_ptr(world), sizeof(glm::mat4));
+		}
+	}
+
+	void benchmark(int count, double& scalarPerSec, double& simdPerSec)
+	{
+		Transforms t;
+		t.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			glm::quat rotation = glm::angleAxis(i * 0.01f, glm::normalize(glm::vec3(1.f, (float)(i % 3), 0.5f)));
+			t.set(i, glm::vec3((float)i, 1.f, -(float)i), rotation, glm::vec3(1.f + (i % 5) * 0.1f));
+		}
+		glm::mat4 parent = glm::rotate(glm::translate(glm::mat4(), glm::vec3(1.f, 2.f, 3.f)), 0.5f, glm::vec3(0.f, 1.f, 0.f));
+		std::vector<float> out((size_t)count * 16);
+
+		typedef std::chrono::high_resolution_clock Clock;
+		const int iterations = 5;
+
+		Clock::time_point start = Clock::now();
+		for (int it = 0; it < iterations; it++)
+			composeScalar(t, &parent, 0, count, &out[0]);
+		double scalarSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		start = Clock::now();
+		for (int it = 0; it < iterations; it++)
+			compose(t, &parent, 0, count, &out[0]);
+		double simdSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		scalarPerSec = (double)count * iterations / scalarSeconds;
+		simdPerSec = (double)count * iterations / simdSeconds;
+	}
+}
@@ -4,8 +4,19 @@
 #include <imgui\imgui.h>
 #include <imgui\imgui_impl_sdl_gl3.h>
 #include <cstdio>
+#include <cstring>
+#include <cstdlib>
 
 #include "GL_framework.h"
+#include "FramePipeline.h"
+#include "JobSystem.h"
+#include "SoftwareRenderer.h"
+#include "Regression.h"
+#include "FontCache.h"
+#include "ClusteredLighting.h"
+#include "MemorySystem.h"
+#include "MemoryTracker.h"
+#include "LogConsole.h"
 
 
 extern void GUI();
@@ -14,6 +25,12 @@ extern void GLResize(int width, int height);
 extern void GLinit(int width, int height);
 extern void GLcleanup();
 extern void GLrender(float dt);
+extern bool GLanimating();
+extern void GLprepare(SceneView& view, float dt);
+extern void SWinit(int width, int height);
+extern void SWrender(SoftwareRenderer::Image& target, float dt);
+extern void SWbenchmark();
+extern int SWregress(const Regression::Options& options);
 
 //////
 namespace 
@@ -23,6 +40,18 @@ namespace
 	const uint32_t expected_frametime_ms = (uint32_t) (1e3 * expected_frametime);
 	uint32_t prev_frametimestamp = 0;
 	uint32_t curr_frametimestamp = 0;
+	bool frame_cap = true;
+	bool threaded_render = false;
+	const char* software_output = NULL;
+	bool software_bench = false;
+	bool regress = false;
+	Regression::Options regress_options;
+	int software_width = 800, software_height = 600;
+	const char* font_file = NULL;
+	bool eager_glyphs = false;
+	bool idle_mode = false;
+	// Idle mode still draws a frame this often: tooltips, the shader file watcher and the stats catch up
+	const uint32_t idle_heartbeat_ms = 500;
 
 	void waitforFrameEnd() 
 	{
@@ -38,10 +67,85 @@ namespace
 		}
 		prev_frametimestamp = SDL_GetTicks();
 	}
+
+	// Forwards the event to ImGui and the scene. Returns false for the idle mode's wake events, which are no input.
+	bool handleEvent(SDL_Event& eve, bool& quit_app) 
+	{
+		if (FramePipeline::isWakeEvent(eve)) 
+			return false;
+		ImGui_ImplSdlGL3_ProcessEvent(&eve);
+		switch (eve.type) 
+		{
+		case SDL_WINDOWEVENT:
+			if (eve.window.event == SDL_WINDOWEVENT_RESIZED) 
+			{
+				GLResize(eve.window.data1, eve.window.data2);
+			}
+			break;
+		case SDL_QUIT:
+			quit_app = true;
+			break;
+		}
+		return true;
+	}
+
+	// No window and no GL: one frame through the software renderer to a file, its benchmark and/or the regression scenes
+	int runSoftware() 
+	{
+		if (SDL_Init(SDL_INIT_TIMER) != 0) 
+		{
+			SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
+			return -1;
+		}
+		// No console drains the log queue here: once full, every line would wait on it before being dropped
+		LogConsole::queue = false;
+		JobSystem::init();
+		SWinit(software_width, software_height);
+
+		int result = 0;
+		if (software_output) 
+		{
+			SoftwareRenderer::Image image;
+			SWrender(image, (float)expected_frametime);
+			SoftwareRenderer::Stats stats = SoftwareRenderer::getStats();
+			SDL_Log("Software frame %dx%d: %d triangles, setup %.2f ms, raster %.2f ms", image.width, image.height, stats.triangles, stats.setupMs, stats.rasterMs);
+			if (!SoftwareRenderer::writeTGA(image, software_output)) 
+			{
+				SDL_Log("Couldn't write %s", software_output);
+				result = -1;
+			}
+		}
+		if (software_bench) 
+			SWbenchmark();
+		if (regress && SWregress(regress_options) > 0) 
+			result = 1;
+
+		JobSystem::shutdown();
+		SDL_Quit();
+		return result;
+	}
 }
 
 int main(int argc, char** argv) 
 {
+	for (int i = 1; i < argc; i++) 
+	{
+		if (strcmp(argv[i], "--threaded-render") == 0) threaded_render = true;
+		else if (strcmp(argv[i], "--no-frame-cap") == 0) frame_cap = false;
+		else if (strcmp(argv[i], "--software") == 0 && i + 1 < argc) software_output = argv[++i];
+		else if (strcmp(argv[i], "--software-bench") == 0) software_bench = true;
+		else if (strcmp(argv[i], "--regress") == 0) regress = true;
+		else if (strcmp(argv[i], "--regress-update") == 0) regress = regress_options.update = true;
+		else if (strcmp(argv[i], "--regress-dir") == 0 && i + 1 < argc) regress_options.directory = argv[++i];
+		else if (strcmp(argv[i], "--regress-threshold") == 0 && i + 1 < argc) regress_options.timeThreshold = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) sscanf(argv[++i], "%dx%d", &software_width, &software_height);
+		else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) font_file = argv[++i];
+		else if (strcmp(argv[i], "--eager-glyphs") == 0) eager_glyphs = true;
+		else if (strcmp(argv[i], "--idle") == 0) idle_mode = true;
+	}
+	if (software_output || software_bench || regress) 
+		return runSoftware();
+
 	//Init GLFW
 	if (SDL_Init(SDL_INIT_VIDEO) != 0) 
 	{
@@ -81,37 +185,92 @@ int main(int argc, char** argv)
 	}
 	SDL_Log("Status: Using GLEW %s\n", glewGetString(GLEW_VERSION));
 
+	// Worker threads for per-frame jobs, the main thread is worker 0
+	JobSystem::init();
+
+	// ImGui allocates from the size-class pool from here on
+	MemorySystem::installImGui();
+
 	// Disable V-Sync
 	SDL_GL_SetSwapInterval(0);
 
 	int display_w, display_h;
 	SDL_GL_GetDrawableSize(mainwindow, &display_w, &display_h);
 
-	// Init scene
-	GLinit(display_w, display_h);
-	// Setup ImGui binding
-	ImGui_ImplSdlGL3_Init(mainwindow);
+	// Optional TTF merged into the default font for CJK text. Its ~21000 glyphs are rasterized when first drawn unless --eager-glyphs
+	Uint64 font_start = SDL_GetPerformanceCounter();
+	ImFontAtlas* fonts = ImGui::GetIO().Fonts;
+	if (font_file) 
+	{
+		if (FILE* f = fopen(font_file, "rb")) 
+		{
+			fclose(f);
+			fonts->AddFontDefault();
+			ImFontConfig config;
+			config.MergeMode = true;
+			fonts->AddFontFromFileTTF(font_file, 13.f, &config, fonts->GetGlyphRangesChinese() + 2); // + 2: the default font has Basic Latin
+			fonts->DynamicGlyphs = !eager_glyphs;
+		}
+		else 
+		{
+			SDL_Log("Couldn't open font %s", font_file);
+		}
+	}
+
+	// Bake the ImGui font atlas before the binding uploads it, or load last run's from the cache
+	bool font_cached = FontCache::build(fonts);
+	SDL_Log("Font atlas %s in %.2f ms", font_cached ? "loaded from cache" : fonts->DynamicGlyphs ? "built (dynamic glyphs)" : "built", 1e3 * (SDL_GetPerformanceCounter() - font_start) / SDL_GetPerformanceFrequency());
+
+	if (threaded_render) 
+	{
+		// Setup ImGui binding. GL lives on the render thread from now on, so ImGui only produces draw data here
+		ImGui_ImplSdlGL3_Init(mainwindow);
+		ImGui::GetIO().RenderDrawListsFn = NULL;
+		// Init scene (on the render thread)
+		FramePipeline::start(mainwindow, maincontext, display_w, display_h);
+	}
+	else 
+	{
+		// Init scene
+		GLinit(display_w, display_h);
+		// Setup ImGui binding
+		ImGui_ImplSdlGL3_Init(mainwindow);
+	}
+
+	// Idle mode: ImGui only builds draw data, the loop draws it when the frame is not skipped
+	void (*render_ui)(ImDrawData*) = ImGui::GetIO().RenderDrawListsFn;
+	if (idle_mode) 
+	{
+		FramePipeline::initIdle();
+		ImGui::GetIO().RenderDrawListsFn = NULL;
+		ClusteredLighting::animate = false; // a still scene by default, "Animate lights" turns it back on
+	}
+	bool idle = false;             // the last frame changed nothing: wait for an event
+	bool passive_redraw = false;   // the last frame was drawn without input or wake()
+	ImU32 ui_hash = 0;
+	uint32_t last_present = SDL_GetTicks();
 
 	bool quit_app = false;
 	while (!quit_app) 
 	{
+		// Wait for a free frame packet before sampling input, so input is as fresh as possible
+		FramePipeline::FramePacket* packet = threaded_render ? FramePipeline::beginFrame() : NULL;
+
+		bool input = false;
 		SDL_Event eve;
+		if (idle) 
+		{
+			uint32_t since_present = SDL_GetTicks() - last_present;
+			if (since_present < idle_heartbeat_ms && SDL_WaitEventTimeout(&eve, (int)(idle_heartbeat_ms - since_present))) 
+				input |= handleEvent(eve, quit_app);
+		}
 		while (SDL_PollEvent(&eve)) 
 		{
-			ImGui_ImplSdlGL3_ProcessEvent(&eve);
-			switch (eve.type) 
-			{
-			case SDL_WINDOWEVENT:
-				if (eve.window.event == SDL_WINDOWEVENT_RESIZED) 
-				{
-					GLResize(eve.window.data1, eve.window.data2);
-				}
-				break;
-			case SDL_QUIT:
-				quit_app = true;
-				break;
-			}
+			input |= handleEvent(eve, quit_app);
 		}
+		Uint64 input_timestamp = SDL_GetPerformanceCounter();
+		MemorySystem::beginFrame();
+		MemoryTracker::beginFrame();
 		ImGui_ImplSdlGL3_NewFrame(mainwindow);
 
 		ImGuiIO& io = ImGui::GetIO();
@@ -125,14 +284,71 @@ int main(int argc, char** argv)
 				MouseEvent::Button::None)))};
 			GLmousecb(ev);
 		}
-		GLrender((float)expected_frametime);
 
-		SDL_GL_SwapWindow(mainwindow);
-		waitforFrameEnd();
+		// Skip the frame when nothing moved: no input, no wake(), a still scene and the UI drawing as last frame.
+		// A UI that changes again right after a redraw nobody asked for is a live readout (timings), left to the heartbeat.
+		bool redraw = true;
+		if (idle_mode) 
+		{
+			ImGui::Render();
+			ImU32 hash = FramePipeline::hashDrawData(ImGui::GetDrawData());
+			bool ui_changed = hash != ui_hash && !passive_redraw;
+			bool woken = FramePipeline::takeWake();
+			redraw = input || woken || GLanimating() || ui_changed || SDL_GetTicks() - last_present >= idle_heartbeat_ms;
+			passive_redraw = redraw && !input && !woken;
+			ui_hash = hash;
+			idle = !redraw;
+		}
+
+		if (!redraw) 
+		{
+			if (packet) 
+				FramePipeline::cancelFrame(packet);
+			FramePipeline::recordSkip();
+			continue;
+		}
+		if (threaded_render) 
+		{
+			// Build frame N+1 while the render thread submits frame N
+			packet->inputTimestamp = input_timestamp;
+			GLprepare(packet->view, (float)expected_frametime);
+			if (!idle_mode) 
+				ImGui::Render();
+			FramePipeline::captureDrawData(*packet, ImGui::GetDrawData());
+			FramePipeline::submitFrame(packet);
+		}
+		else 
+		{
+			GLrender((float)expected_frametime);
+			if (idle_mode) 
+				render_ui(ImGui::GetDrawData());
+			else 
+				ImGui::Render();
+
+			SDL_GL_SwapWindow(mainwindow);
+			FramePipeline::recordPresent(input_timestamp);
+		}
+		last_present = SDL_GetTicks();
+		// Uncapped while the light benchmark times frames
+		if (frame_cap && !ClusteredLighting::benchmarkRunning()) 
+		{
+			waitforFrameEnd();
+		}
+	}
+
+	if (threaded_render) 
+	{
+		// Runs GLcleanup on the render thread and makes the context current here again
+		FramePipeline::stop();
+		ImGui_ImplSdlGL3_Shutdown();
+	}
+	else 
+	{
+		ImGui_ImplSdlGL3_Shutdown();
+		GLcleanup();
 	}
 
-	ImGui_ImplSdlGL3_Shutdown();
-	GLcleanup();
+	JobSystem::shutdown();
 
 	SDL_GL_DeleteContext(maincontext);
 	SDL_DestroyWindow(mainwindow);
@@ -4,6 +4,8 @@
 #include <cstdio>
 #include <cassert>
 #include <vector>
+#include <atomic>
+#include <map>
 
 #include <imgui\imgui.h>
 #include <imgui\imgui_impl_sdl_gl3.h>
@@ -11,9 +13,19 @@
 #include "GL_framework.h"
 #include "SDL_timer.h"
 #include "LoadOBJ.h"
-
-GLuint compileShader(const char* shaderStr, GLenum shaderType, const char* name = "");
-void linkProgram(GLuint program);
+#include "FramePipeline.h"
+#include "JobSystem.h"
+#include "TransformSystem.h"
+#include "SceneGraph.h"
+#include "ShaderLibrary.h"
+#include "TextureSystem.h"
+#include "ClusteredLighting.h"
+#include "OcclusionCulling.h"
+#include "SoftwareRenderer.h"
+#include "Regression.h"
+#include "LogConsole.h"
+#include "MemorySystem.h"
+#include "MemoryTracker.h"
 
 ///////// fw decl
 namespace ImGui 
@@ -25,7 +37,7 @@ namespace Axis
 {
 	void setupAxis();
 	void cleanupAxis();
-	void drawAxis();
+	void drawAxis(const SceneView& view);
 }
 
 namespace RenderVars
@@ -39,6 +51,7 @@ namespace RenderVars
 	glm::mat4 _MVP;
 	glm::mat4 _inv_modelview;
 	glm::vec4 _cameraPoint;
+	int _width, _height;
 
 	struct prevMouse
 	{
@@ -54,9 +67,11 @@ namespace RV = RenderVars;
 
 
 
+// Only touches CPU-side state: the viewport itself is applied by GLsubmit on the thread owning the context
 void GLResize(int width, int height) 
 {
-	glViewport(0, 0, width, height);
+	RV::_width = width;
+	RV::_height = height;
 	if (height != 0) RV::_projection = glm::perspective(RV::FOV, (float)width / (float)height, RV::zNear, RV::zFar);
 	else RV::_projection = glm::perspective(RV::FOV, 0.f, RV::zNear, RV::zFar);
 }
@@ -92,48 +107,12 @@ void GLmousecb(MouseEvent ev)
 	RV::prevMouse.lasty = ev.posy;
 }
 
-//////////////////////////////////////////////////
-GLuint compileShader(const char* shaderStr, GLenum shaderType, const char* name) 
-{
-	GLuint shader = glCreateShader(shaderType);
-	glShaderSource(shader, 1, &shaderStr, NULL);
-	glCompileShader(shader);
-	GLint res;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &res);
-	if (res == GL_FALSE) 
-	{
-		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &res);
-		char* buff = new char[res];
-		glGetShaderInfoLog(shader, res, &res, buff);
-		fprintf(stderr, "Error Shader %s: %s", name, buff);
-		delete[] buff;
-		glDeleteShader(shader);
-		return 0;
-	}
-	return shader;
-}
-
-void linkProgram(GLuint program) 
-{
-	glLinkProgram(program);
-	GLint res;
-	glGetProgramiv(program, GL_LINK_STATUS, &res);
-	if (res == GL_FALSE) 
-	{
-		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &res);
-		char* buff = new char[res];
-		glGetProgramInfoLog(program, res, &res, buff);
-		fprintf(stderr, "Error Link: %s", buff);
-		delete[] buff;
-	}
-}
-
 ////////////////////////////////////////////////// OBJECT
 namespace Object
 {
-	GLuint program;
+	int shader;
 	GLuint VAO;
-	GLuint VBO[3];
+	GLuint VBO[4];
 
 	glm::mat4 objMat = glm::mat4(1.f);
 
@@ -141,216 +120,290 @@ namespace Object
 	std::vector<glm::vec3> objVertices;
 	std::vector<glm::vec2> objUVs;
 	std::vector<glm::vec3> objNormals;
-
-	// this should be at the fragment shader
-	struct Material {
-		glm::vec3 ambient = glm::vec3(1.f, 0.5f, 0.31f);
-		glm::vec3 diffuse = glm::vec3(1.f, 0.5f, 0.31f);
-		glm::vec3 specular = glm::vec3(0.5f, 0.5f, 0.5f);
-		float shininess = 32.f;
+	std::vector<loadObject::SubMesh> submeshes;   // one per material, sorted by diffuse map
+	std::vector<loadObject::Material> materials;  // from the .mtl, [0] is the default
+
+	// Material table in a uniform buffer (std140 layout of object.frag), indexed per vertex
+	struct PackedMaterial {
+		glm::vec4 ambient;
+		glm::vec4 diffuse;
+		glm::vec4 specular; // w = shininess
 	};
-	Material material;
-
-	struct Light
-	{
-		glm::vec3 position = glm::vec3(0.f, 0.f, 0.f);
-		glm::vec3 direction = glm::vec3(0.f, 0.f, 0.f);
-		glm::vec3 ambient = glm::vec3(0.6f, 0.6f, 0.6f);
-		glm::vec3 diffuse;
-		glm::vec3 specular;
+	const int maxMaterials = 256;
+	GLuint materialUBO;
+	GLuint blockProgram = 0; // program the Materials block was last bound for (changes on hot reload)
+
+	// Submeshes next to each other with the same texture are drawn in one call,
+	// materials only differ in the table so they cost no state change
+	struct Batch {
+		int texture; // TextureSystem id
+		int first, count;
+	};
+	std::vector<Batch> batches;
 
-		float constant = 1.f;
-		float linear = 0.09f;
-		float quadratic = 0.032f;
+	// Last frame, written on the render thread
+	std::atomic<int> drawCount(0), stateChanges(0);
 
-		float cutOff = glm::cos(glm::radians(12.5f));
-	};
-	Light light;
-
-	// A vertex shader that assigns a static position to the vertex
-	static const char* vertex_shader_source[] = {
-		"#version 330\n\
-		layout (location = 0) in vec3 in_Vertices;\n\
-		layout (location = 1) in vec3 in_Normals;\n\
-		layout (location = 2) in vec2 in_UVs;\n\
-		out vec4 vert_Normal;\n\
-		out vec3 FragPos;\n\
-		uniform mat4 objMat;\n\
-		uniform mat4 mv_Mat;\n\
-		uniform mat4 mvpMat;\n\
-		uniform vec3 viewPos;\n\
-		void main() {\n\
-			gl_Position = mvpMat * objMat * vec4(in_Vertices, 1.0);\n\
-			vert_Normal = mv_Mat * objMat * vec4(in_Normals, 0.0);\n\
-			FragPos = vec3(objMat * vec4(in_Vertices, 1.0));\n\
-		}"
-	};
+	// Software renderer: decoded diffuse maps per material (empty when untextured)
+	std::vector<TextureSystem::Image> softwareMaps;
+	bool loaded = false;
 
-	// A fragment shader that assigns a static color
-	static const char* fragment_shader_source[] = {
-		"#version 330\n\
-		in vec4 vert_Normal;\n\
-		in vec3 FragPos;\n\
-		out vec4 out_Color;\n\
-		uniform vec3 lightPos;\n\
-		uniform mat4 mv_Mat;\n\
-		uniform vec4 color;\n\
-		\n\
-		struct Material {\n\
-			vec3 ambient;\n\
-			vec3 diffuse;\n\
-			vec3 specular;\n\
-			float shininess;\n\
-		};\n\
-		uniform Material material;\n\
-		\n\
-		void main() {\n\
-			out_Color = vec4(color.xyz * dot(vert_Normal, mv_Mat * vec4(0.0, 1.0, 0.0, 0.0)) + color.xyz * 0.3, 1.0 );\n\
-		}"
-	};
+	// CPU side of setup, also all the software renderer needs
+	void load()
+	{
+		if (loaded)
+			return;
+		loaded = true;
+		MemoryTracker::Scope memory(MemoryTracker::Mesh, "Object::load");
+		bool res = loadObject::loadOBJ("cube.obj", objVertices, objUVs, objNormals, submeshes, materials);
+		if (materials.empty())
+			materials.push_back(loadObject::Material());
+		if (res)
+		{
+			std::vector<unsigned int> indices(objVertices.size());
+			for (size_t i = 0; i < indices.size(); i++)
+				indices[i] = (unsigned int)i;
+			OcclusionCulling::addOccluder(&objVertices[0], (int)objVertices.size(), &indices[0], (int)indices.size(), objMat);
+		}
+	}
 
 	void setup()
 	{
-		bool res = loadObject::loadOBJ("cube.obj", objVertices, objUVs, objNormals);
-
-		// ==============================================================================================================
-		//Inicialitzar ID del Shader 
-		GLuint vertex_shader;
-		GLuint fragment_shader;
-
-		//Crear ID Shader 
-		vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-		fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-
-		//Cargar datos del Shader en la ID
-		glShaderSource(vertex_shader, 1, vertex_shader_source, NULL);
-		glShaderSource(fragment_shader, 1, fragment_shader_source, NULL);
-
-		//Operar con el Shader -> Pilla la string que te paso y traducelo a binario
-		compileShader(vertex_shader_source[0], GL_VERTEX_SHADER, "vertex");
-		compileShader(fragment_shader_source[0], GL_FRAGMENT_SHADER, "fragment");
-
-		//Crear programa y enlazarlo con los Shaders (Operaciones Bind())
-		program = glCreateProgram();
-		glAttachShader(program, vertex_shader);
-		glAttachShader(program, fragment_shader);
-
-		linkProgram(program);
-
-		// Destroy
-		glDeleteShader(vertex_shader);
-		glDeleteShader(fragment_shader);
+		load();
+		MemoryTracker::Scope memory(MemoryTracker::Mesh, "Object::setup");
+
+		// Attribute locations come from the layout qualifiers
+		shader = ShaderLibrary::create("object", "object.vert", "object.frag");
+
+		// Material table; maps are decoded in the background, untextured until the first mip arrives
+		if ((int)materials.size() > maxMaterials)
+			LogConsole::log(LogConsole::Error, "Error Object: %d materials, only %d fit the table\n", (int)materials.size(), maxMaterials);
+		std::vector<PackedMaterial> packed(maxMaterials);
+		std::vector<int> textures(materials.size(), -1);
+		std::map<std::string, int> loadedMaps;
+		for (size_t m = 0; m < materials.size(); m++)
+		{
+			const loadObject::Material& mat = materials[m];
+			if (m < packed.size())
+			{
+				packed[m].ambient = glm::vec4(mat.ambient, 1.f);
+				packed[m].diffuse = glm::vec4(mat.diffuse, 1.f);
+				packed[m].specular = glm::vec4(mat.specular, mat.shininess);
+			}
+			if (mat.diffuseMap.empty())
+				continue;
+			if (loadedMaps.find(mat.diffuseMap) == loadedMaps.end())
+				loadedMaps[mat.diffuseMap] = TextureSystem::load(mat.diffuseMap.c_str());
+			textures[m] = loadedMaps[mat.diffuseMap];
+		}
+		glGenBuffers(1, &materialUBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, materialUBO);
+		glBufferData(GL_UNIFORM_BUFFER, packed.size() * sizeof(PackedMaterial), &packed[0], GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(materialUBO, packed.size() * sizeof(PackedMaterial));
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		// Per-vertex material index and the draw batches
+		std::vector<GLint> vertexMaterials(objVertices.size(), 0);
+		for (size_t s = 0; s < submeshes.size(); s++)
+		{
+			const loadObject::SubMesh& sub = submeshes[s];
+			std::fill(vertexMaterials.begin() + sub.first, vertexMaterials.begin() + sub.first + sub.count, sub.material < maxMaterials ? sub.material : 0);
+			if (!batches.empty() && batches.back().texture == textures[sub.material] && batches.back().first + batches.back().count == sub.first)
+				batches.back().count += sub.count;
+			else
+			{
+				Batch batch = { textures[sub.material], sub.first, sub.count };
+				batches.push_back(batch);
+			}
+		}
 
 		//Create the vertex array object
 		//This object maintains the state related to the input of the OpenGL
 		glGenVertexArrays(1, &VAO);
 		glBindVertexArray(VAO);
-		glGenBuffers(3, VBO);
+		glGenBuffers(4, VBO);
 
 		// Vertex
 		glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
 		glBufferData(GL_ARRAY_BUFFER, objVertices.size() * sizeof(glm::vec3), &objVertices[0], GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(VBO[0], objVertices.size() * sizeof(glm::vec3));
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 		glEnableVertexAttribArray(0);
 
 		// Normals
 		glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
 		glBufferData(GL_ARRAY_BUFFER, objNormals.size() * sizeof(glm::vec3), &objNormals[0], GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(VBO[1], objNormals.size() * sizeof(glm::vec3));
 		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
 		glEnableVertexAttribArray(1);
 
 		// UVs
 		glBindBuffer(GL_ARRAY_BUFFER, VBO[2]);
 		glBufferData(GL_ARRAY_BUFFER, objUVs.size() * sizeof(glm::vec2), &objUVs[0], GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(VBO[2], objUVs.size() * sizeof(glm::vec2));
 		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
 		glEnableVertexAttribArray(2);
 
+		// Material index
+		glBindBuffer(GL_ARRAY_BUFFER, VBO[3]);
+		glBufferData(GL_ARRAY_BUFFER, vertexMaterials.size() * sizeof(GLint), vertexMaterials.empty() ? NULL : &vertexMaterials[0], GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(VBO[3], vertexMaterials.size() * sizeof(GLint));
+		glVertexAttribIPointer(3, 1, GL_INT, 0, 0);
+		glEnableVertexAttribArray(3);
+
 		// Clean
 		glBindVertexArray(0);
 	}
 
 	void cleanup()
 	{
-		glDeleteProgram(program);
 		glDeleteVertexArrays(1, &VAO);
 
-		glDeleteBuffers(3, VBO);
+		glDeleteBuffers(4, VBO);
+		glDeleteBuffers(1, &materialUBO);
+		MemoryTracker::gpuBuffersDeleted(4, VBO);
+		MemoryTracker::gpuBuffersDeleted(1, &materialUBO);
 	}
 
-	void render()
+	void render(const SceneView& view)
 	{
+		GLuint program = ShaderLibrary::program(shader);
 		glUseProgram(program);
 		glBindVertexArray(VAO);
+		int changes = 2;
+
+		if (program != blockProgram)
+		{
+			GLuint block = glGetUniformBlockIndex(program, "Materials");
+			if (block != GL_INVALID_INDEX)
+				glUniformBlockBinding(program, block, 0);
+			blockProgram = program;
+		}
+		glBindBufferBase(GL_UNIFORM_BUFFER, 0, materialUBO);
+		changes++;
 
-		// THIS NEEDS TO BE AT THE FRAGMENT SHADER
+		// Ambient tint of the old single light. The lights themselves (the old spot light is light 0)
+		// are evaluated per fragment from the clustered light lists
+		const float ambientStrength = 0.6f;
 		glm::vec3 lightColor = { 0.9f, 0.1f, 0.1f };
 		glm::vec3 objectColor = { 0.9f, 0.1f, 0.1f };
-		glm::vec3 result;
-		glm::vec4 fragColor;
-
-		glm::vec3 fragPos;
-		GLint fragPosUniformLocation = glGetUniformLocation(program, "FragPos");
-		glUniform3fv(fragPosUniformLocation, 1, &fragPos[0]);
-
-		// Ambient Lighting
-		float ambientStrength = 0.6f;
-		glm::vec3 ambient = lightColor * material.ambient;
-		light.ambient = ambientStrength * lightColor;
-		//
-
-		// Diffuse Lighting
-		glm::vec3 norm = glm::normalize(objNormals[0]);
-		glm::vec3 lightDir = glm::normalize(-light.direction);
-		float diff = glm::max(glm::dot(norm, lightDir), 0.f);
-		light.diffuse = lightColor * (diff * material.diffuse); //diff * lightColor;
-		//
-
-		// Specular Lighting
-		float specularStrength = 0.5f;
-		glm::vec3 viewPos;
-		glm::vec3 viewDir = glm::normalize(viewPos - fragPos);
-		glm::vec3 reflectDir = glm::reflect(-lightDir, norm);
-		float spec = glm::pow(glm::max(glm::dot(viewDir, reflectDir), 0.f), material.shininess);
-		light.specular = specularStrength * (spec * material.specular);
-		//
-
-		// Point Light
-		float distance = glm::length(light.position - fragPos);
-		float attenuation = 1.f / (light.constant + light.linear * 
-							distance + light.quadratic * (distance * distance));
-		light.ambient *= attenuation;
-		light.diffuse *= attenuation;
-		light.specular *= attenuation;
-		//
-
-		// Spot Light
-		float theta = glm::dot(lightDir, glm::normalize(-light.direction));
-
-		if (theta > light.cutOff)
-			result = (light.ambient + light.diffuse + light.specular) * objectColor;
-		else
-			result = light.ambient * objectColor;
-		//
-		fragColor = glm::vec4(result, 1.0f);
-		// //
+		glm::vec4 fragColor = glm::vec4(ambientStrength * lightColor * objectColor, 1.f);
+		ClusteredLighting::bind(program, view);
 
 		glUniformMatrix4fv(glGetUniformLocation(program, "objMat"), 1, GL_FALSE, glm::value_ptr(objMat));
-		glUniformMatrix4fv(glGetUniformLocation(program, "mv_Mat"), 1, GL_FALSE, glm::value_ptr(RenderVars::_modelView));
-		glUniformMatrix4fv(glGetUniformLocation(program, "mvpMat"), 1, GL_FALSE, glm::value_ptr(RenderVars::_MVP));
+		glUniformMatrix4fv(glGetUniformLocation(program, "mv_Mat"), 1, GL_FALSE, glm::value_ptr(view.modelView));
+		glUniformMatrix4fv(glGetUniformLocation(program, "mvpMat"), 1, GL_FALSE, glm::value_ptr(view.MVP));
 		glUniform4f(glGetUniformLocation(program, "color"), fragColor.x, fragColor.y, fragColor.z, 1.0f);
 
-		// Draw shape
-		glDrawArrays(GL_TRIANGLES, 0, objVertices.size());
+		glActiveTexture(GL_TEXTURE0);
+		glUniform1i(glGetUniformLocation(program, "diffuseMap"), 0);
 
+		// Draw shape, a texture bind only when the batch texture differs
+		GLuint boundTexture = 0;
+		for (size_t b = 0; b < batches.size(); b++)
+		{
+			GLuint texture = TextureSystem::texture(batches[b].texture);
+			if (texture != boundTexture)
+			{
+				glBindTexture(GL_TEXTURE_2D, texture);
+				boundTexture = texture;
+				changes++;
+			}
+			glDrawArrays(GL_TRIANGLES, batches[b].first, batches[b].count);
+		}
+		drawCount = (int)batches.size();
+		stateChanges = changes;
+
+		glBindTexture(GL_TEXTURE_2D, 0);
 		glUseProgram(0);
 		glBindVertexArray(0);
 	}
+
+	// object.vert/.frag for the software renderer, one batch per submesh
+	struct SoftwareUniforms {
+		const SceneView* view;
+		ClusteredLighting::ShadeParams lighting;
+		glm::vec3 color;
+		glm::vec3 up;       // mv_Mat * (0, 1, 0, 0)
+		const loadObject::Material* material;
+		const TextureSystem::Image* diffuseMap;
+	};
+	std::vector<SoftwareRenderer::Vertex> softwareVertices;
+	std::vector<unsigned int> softwareIndices;
+	std::vector<SoftwareUniforms> softwareUniforms;
+
+	void loadSoftwareMaps()
+	{
+		if (softwareMaps.size() == materials.size())
+			return;
+		softwareMaps.resize(materials.size());
+		for (size_t m = 0; m < materials.size(); m++)
+		{
+			if (!materials[m].diffuseMap.empty() && !TextureSystem::decodeFile(materials[m].diffuseMap.c_str(), softwareMaps[m]))
+				LogConsole::log(LogConsole::Error, "Error Object: could not decode %s\n", materials[m].diffuseMap.c_str());
+		}
+	}
+
+	// Varyings: view space normal (3), uv (2), view space position (3)
+	glm::vec4 shadeSoftware(const void* uniforms, const float* v, float x, float y)
+	{
+		const SoftwareUniforms& u = *(const SoftwareUniforms*)uniforms;
+		const glm::vec3 normal(v[0], v[1], v[2]);
+		glm::vec3 texel(1.f);
+		if (u.diffuseMap)
+			texel = glm::vec3(SoftwareRenderer::sample(*u.diffuseMap, glm::vec2(v[3], v[4])));
+		glm::vec3 albedo = u.color * texel;
+		float lambert = glm::dot(normal, u.up);
+		glm::vec3 lights = ClusteredLighting::shade(*u.view, u.lighting, glm::vec3(v[5], v[6], v[7]), glm::normalize(normal), u.material->diffuse * texel, x, y);
+		return glm::vec4(albedo * (u.material->diffuse * lambert + u.material->ambient * 0.3f) + lights, 1.f);
+	}
+
+	void renderSoftware(const SceneView& view)
+	{
+		loadSoftwareMaps();
+		const glm::mat4 mvp = view.MVP * objMat, mv = view.modelView * objMat;
+		softwareVertices.resize(objVertices.size());
+		for (size_t i = 0; i < objVertices.size(); i++)
+		{
+			SoftwareRenderer::Vertex& out = softwareVertices[i];
+			out.position = mvp * glm::vec4(objVertices[i], 1.f);
+			glm::vec4 normal = mv * glm::vec4(objNormals[i], 0.f);
+			glm::vec4 viewPos = mv * glm::vec4(objVertices[i], 1.f);
+			const float varyings[8] = { normal.x, normal.y, normal.z, objUVs[i].x, objUVs[i].y, viewPos.x, viewPos.y, viewPos.z };
+			memcpy(out.varyings, varyings, sizeof(varyings));
+		}
+		if (softwareIndices.size() < objVertices.size())
+		{
+			softwareIndices.resize(objVertices.size());
+			for (size_t i = 0; i < softwareIndices.size(); i++)
+				softwareIndices[i] = (unsigned int)i;
+		}
+
+		// Same color uniform as render()
+		const float ambientStrength = 0.6f;
+		glm::vec3 lightColor = { 0.9f, 0.1f, 0.1f };
+		glm::vec3 objectColor = { 0.9f, 0.1f, 0.1f };
+		softwareUniforms.resize(submeshes.size());
+		for (size_t s = 0; s < submeshes.size(); s++)
+		{
+			const loadObject::SubMesh& sub = submeshes[s];
+			SoftwareUniforms& u = softwareUniforms[s];
+			u.view = &view;
+			u.lighting = ClusteredLighting::shadeParams(view);
+			u.color = ambientStrength * lightColor * objectColor;
+			u.up = glm::vec3(view.modelView * glm::vec4(0.f, 1.f, 0.f, 0.f));
+			u.material = &materials[sub.material];
+			u.diffuseMap = softwareMaps[sub.material].levels.empty() ? NULL : &softwareMaps[sub.material];
+			SoftwareRenderer::Batch batch = { &shadeSoftware, &u, 8 };
+			SoftwareRenderer::drawTriangles(batch, &softwareVertices[sub.first], &softwareIndices[0], sub.count);
+		}
+	}
 }
 
 ////////////////////////////////////////////////// EXERCISE
 namespace Exercise
 {
-	GLuint program;
+	int shader;
 	GLuint VAO, VBO;
 
 	float vertices[] = {
@@ -359,57 +412,9 @@ namespace Exercise
 		 0.0f,  0.5f, 0.0f
 	};
 
-	// A vertex shader that assigns a static position to the vertex
-	static const GLchar* vertex_shader_source[] = {
-		"#version 330\n"
-		"layout (location = 0) in vec3 aPos;"
-		"\n"
-		"void main(){\n"
-			"gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);"
-			"\n"
-		"}"
-	};
-
-	// A fragment shader that assigns a static color
-	static const GLchar* fragment_shader_source[] = {
-		"#version 330\n"
-		"\n"
-		"out vec4 color;\n"
-		"uniform vec4 triangleColor;\n"
-		"void main(){\n"
-			"color = triangleColor;\n"
-		"}"
-	};
-
-
 	void init()
 	{
-		//Inicialitzar ID del Shader 
-		GLuint vertex_shader;
-		GLuint fragment_shader;
-
-		//Crear ID Shader 
-		vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-		fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-
-		//Cargar datos del Shader en la ID
-		glShaderSource(vertex_shader, 1, vertex_shader_source, NULL);
-		glShaderSource(fragment_shader, 1, fragment_shader_source, NULL);
-
-		//Operar con el Shader -> Pilla la string que te paso y traducelo a binario
-		compileShader(vertex_shader_source[0], GL_VERTEX_SHADER, "vertex");
-		compileShader(fragment_shader_source[0], GL_FRAGMENT_SHADER, "fragment");
-
-		//Crear programa y enlazarlo con los Shaders (Operaciones Bind())
-		program = glCreateProgram();
-		glAttachShader(program, vertex_shader);
-		glAttachShader(program, fragment_shader);
-
-		linkProgram(program);
-
-		// Destroy
-		glDeleteShader(vertex_shader);
-		glDeleteShader(fragment_shader);
+		shader = ShaderLibrary::create("exercise", "exercise.vert", "exercise.frag");
 
 		//Create the vertex array object
 		//This object maintains the state related to the input of the OpenGL
@@ -426,6 +431,7 @@ namespace Exercise
 
 		// Copy the data to the array buffer
 		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(VBO, sizeof(vertices));
 
 		// Specify the layout of the arbitrary data setting
 		glVertexAttribPointer(
@@ -446,15 +452,16 @@ namespace Exercise
 
 	void cleanup()
 	{
-		glDeleteProgram(program);
 		glDeleteVertexArrays(1, &VAO);
 		glDeleteBuffers(1, &VBO);
+		MemoryTracker::gpuBuffersDeleted(1, &VBO);
 	}
 
 	void render()
 	{
 		glPointSize(40.0f);
 		glBindVertexArray(VAO);
+		GLuint program = ShaderLibrary::program(shader);
 		glUseProgram(program);
 
 		time_t currentTime = SDL_GetTicks() / 1000;
@@ -477,8 +484,7 @@ namespace Axis
 {
 	GLuint AxisVao;
 	GLuint AxisVbo[3];
-	GLuint AxisShader[2];
-	GLuint AxisProgram;
+	int AxisShader;
 
 	float AxisVerts[] = {
 		0.0, 0.0, 0.0,
@@ -504,79 +510,74 @@ namespace Axis
 		4, 5
 	};
 
-	const char* Axis_vertShader =
-		"#version 330\n\
-		in vec3 in_Position;\n\
-		in vec4 in_Color;\n\
-		out vec4 vert_color;\n\
-		uniform mat4 mvpMat;\n\
-		void main() {\n\
-			vert_color = in_Color;\n\
-			gl_Position = mvpMat * vec4(in_Position, 1.0);\n\
-		}";
-
-	const char* Axis_fragShader =
-		"#version 330\n\
-		in vec4 vert_color;\n\
-		out vec4 out_Color;\n\
-		void main() {\n\
-			out_Color = vert_color;\n\
-		}";
-
 	void setupAxis() 
 	{
+		MemoryTracker::Scope memory(MemoryTracker::Scene, "Axis::setupAxis");
 		glGenVertexArrays(1, &AxisVao);
 		glBindVertexArray(AxisVao);
 		glGenBuffers(3, AxisVbo);
 
 		glBindBuffer(GL_ARRAY_BUFFER, AxisVbo[0]);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 24, AxisVerts, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(AxisVbo[0], sizeof(float) * 24);
 		glVertexAttribPointer((GLuint)0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 		glEnableVertexAttribArray(0);
 
 		glBindBuffer(GL_ARRAY_BUFFER, AxisVbo[1]);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 24, AxisColors, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(AxisVbo[1], sizeof(float) * 24);
 		glVertexAttribPointer((GLuint)1, 4, GL_FLOAT, false, 0, 0);
 		glEnableVertexAttribArray(1);
 
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, AxisVbo[2]);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLubyte) * 6, AxisIdx, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(AxisVbo[2], sizeof(GLubyte) * 6);
 
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-		AxisShader[0] = compileShader(Axis_vertShader, GL_VERTEX_SHADER, "AxisVert");
-		AxisShader[1] = compileShader(Axis_fragShader, GL_FRAGMENT_SHADER, "AxisFrag");
-
-		AxisProgram = glCreateProgram();
-		glAttachShader(AxisProgram, AxisShader[0]);
-		glAttachShader(AxisProgram, AxisShader[1]);
-		glBindAttribLocation(AxisProgram, 0, "in_Position");
-		glBindAttribLocation(AxisProgram, 1, "in_Color");
-		linkProgram(AxisProgram);
+		const char* attributes[] = { "in_Position", "in_Color", NULL };
+		AxisShader = ShaderLibrary::create("axis", "axis.vert", "axis.frag", attributes);
 	}
 
 	void cleanupAxis() 
 	{
 		glDeleteBuffers(3, AxisVbo);
+		MemoryTracker::gpuBuffersDeleted(3, AxisVbo);
 		glDeleteVertexArrays(1, &AxisVao);
-
-		glDeleteProgram(AxisProgram);
-		glDeleteShader(AxisShader[0]);
-		glDeleteShader(AxisShader[1]);
 	}
 
-	void drawAxis() 
+	void drawAxis(const SceneView& view) 
 	{
 		glBindVertexArray(AxisVao);
+		GLuint AxisProgram = ShaderLibrary::program(AxisShader);
 		glUseProgram(AxisProgram);
-		glUniformMatrix4fv(glGetUniformLocation(AxisProgram, "mvpMat"), 1, GL_FALSE, glm::value_ptr(RV::_MVP));
+		glUniformMatrix4fv(glGetUniformLocation(AxisProgram, "mvpMat"), 1, GL_FALSE, glm::value_ptr(view.MVP));
 		glDrawElements(GL_LINES, 6, GL_UNSIGNED_BYTE, 0);
 
 		glUseProgram(0);
 		glBindVertexArray(0);
 	}
+
+	// axis.vert/.frag for the software renderer, varyings are the vertex color
+	glm::vec4 shadeSoftware(const void*, const float* v, float, float)
+	{
+		return glm::vec4(v[0], v[1], v[2], v[3]);
+	}
+
+	void drawAxisSoftware(const SceneView& view)
+	{
+		static SoftwareRenderer::Vertex vertices[6];
+		for (int i = 0; i < 6; i++)
+		{
+			vertices[i].position = view.MVP * glm::vec4(AxisVerts[i * 3], AxisVerts[i * 3 + 1], AxisVerts[i * 3 + 2], 1.f);
+			memcpy(vertices[i].varyings, &AxisColors[i * 4], 4 * sizeof(float));
+		}
+		const unsigned int indices[6] = { AxisIdx[0], AxisIdx[1], AxisIdx[2], AxisIdx[3], AxisIdx[4], AxisIdx[5] };
+		SoftwareRenderer::Batch batch = { &shadeSoftware, NULL, 4 };
+		SoftwareRenderer::drawLines(batch, vertices, indices, 6);
+	}
 }
 
 ////////////////////////////////////////////////// CUBE
@@ -584,8 +585,7 @@ namespace Cube
 {
 	GLuint cubeVao;
 	GLuint cubeVbo[3];
-	GLuint cubeShaders[2];
-	GLuint cubeProgram;
+	int cubeShader;
 	glm::mat4 objMat = glm::mat4(1.f);
 
 	extern const float halfW = 0.5f;
@@ -646,114 +646,106 @@ namespace Cube
 		20, 21, 22, 23, UCHAR_MAX
 	};
 
-	const char* cube_vertShader =
-		"#version 330\n\
-		in vec3 in_Position;\n\
-		in vec3 in_Normal;\n\
-		out vec4 vert_Normal;\n\
-		uniform mat4 objMat;\n\
-		uniform mat4 mv_Mat;\n\
-		uniform mat4 mvpMat;\n\
-		void main() {\n\
-			gl_Position = mvpMat * objMat * vec4(in_Position, 1.0);\n\
-			vert_Normal = mv_Mat * objMat * vec4(in_Normal, 0.0);\n\
-		}";
-
-	const char* cube_fragShader =
-		"#version 330\n\
-		in vec4 vert_Normal;\n\
-		out vec4 out_Color;\n\
-		uniform mat4 mv_Mat;\n\
-		uniform vec4 color;\n\
-		void main() {\n\
-			out_Color = vec4(color.xyz * dot(vert_Normal, mv_Mat*vec4(0.0, 1.0, 0.0, 0.0)) + color.xyz * 0.3, 1.0 );\n\
-		}";
-
 	void setupCube() 
 	{
+		MemoryTracker::Scope memory(MemoryTracker::Scene, "Cube::setupCube");
 		glGenVertexArrays(1, &cubeVao);
 		glBindVertexArray(cubeVao);
 		glGenBuffers(3, cubeVbo);
 
 		glBindBuffer(GL_ARRAY_BUFFER, cubeVbo[0]);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVerts), cubeVerts, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(cubeVbo[0], sizeof(cubeVerts));
 		glVertexAttribPointer((GLuint)0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 		glEnableVertexAttribArray(0);
 
 		glBindBuffer(GL_ARRAY_BUFFER, cubeVbo[1]);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(cubeNorms), cubeNorms, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(cubeVbo[1], sizeof(cubeNorms));
 		glVertexAttribPointer((GLuint)1, 3, GL_FLOAT, GL_FALSE, 0, 0);
 		glEnableVertexAttribArray(1);
 
 		glPrimitiveRestartIndex(UCHAR_MAX);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeVbo[2]);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIdx), cubeIdx, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(cubeVbo[2], sizeof(cubeIdx));
 
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-		cubeShaders[0] = compileShader(cube_vertShader, GL_VERTEX_SHADER, "cubeVert");
-		cubeShaders[1] = compileShader(cube_fragShader, GL_FRAGMENT_SHADER, "cubeFrag");
-
-		cubeProgram = glCreateProgram();
-		glAttachShader(cubeProgram, cubeShaders[0]);
-		glAttachShader(cubeProgram, cubeShaders[1]);
-		glBindAttribLocation(cubeProgram, 0, "in_Position");
-		glBindAttribLocation(cubeProgram, 1, "in_Normal");
-		linkProgram(cubeProgram);
+		const char* attributes[] = { "in_Position", "in_Normal", NULL };
+		cubeShader = ShaderLibrary::create("cube", "cube.vert", "cube.frag", attributes);
 	}
 
 	void cleanupCube() 
 	{
 		glDeleteBuffers(3, cubeVbo);
+		MemoryTracker::gpuBuffersDeleted(3, cubeVbo);
 		glDeleteVertexArrays(1, &cubeVao);
+	}
+
+	// Cube 02 rotates along the 1st cube: cube01 -> orbit (move up/down + spin) -> cube02 (offset + size)
+	SceneGraph::Graph graph;
+	int cube01Node = -1, orbitNode = -1, cube02Node = -1;
 
-		glDeleteProgram(cubeProgram);
-		glDeleteShader(cubeShaders[0]);
-		glDeleteShader(cubeShaders[1]);
+	void buildGraph() 
+	{
+		cube01Node = SceneGraph::addNode(graph, -1, objMat);
+		orbitNode = SceneGraph::addNode(graph, cube01Node, glm::mat4(1.f));
+		cube02Node = SceneGraph::addNode(graph, orbitNode, glm::mat4(1.f));
 	}
 
 	void updateCube(const glm::mat4& transform) 
 	{
+		if (graph.size() == 0) buildGraph();
 		objMat = transform;
+		SceneGraph::setLocal(graph, cube01Node, transform);
+	}
+
+	void prepare(SceneView& view) 
+	{
+		if (graph.size() == 0) buildGraph();
+		float time = view.time;
+
+		// Change position (transalte) and y-rotation (rotate)
+		glm::mat4 cubeTranslateMatrix = glm::translate(glm::mat4(), glm::vec3(0.0f, cos(time) * 2.0f + 2.0f, 2.0f));
+		float rotateAngle = time; //1.0f * (float)sin(3.0f * time);
+		SceneGraph::setLocal(graph, orbitNode, glm::rotate(cubeTranslateMatrix, rotateAngle, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+		// Rotate along the 1st cube (translate) and change size (scale)
+		float scaleRes = ((sin(time) * 2.0f + 2.0f) + 1) / 2;
+		glm::mat4 cubeToCubeTranslateMatrix = glm::translate(glm::mat4(), glm::vec3(1.0f, 0.0f, 3.0f));
+		SceneGraph::setLocal(graph, cube02Node, glm::scale(cubeToCubeTranslateMatrix, glm::vec3(scaleRes, scaleRes, scaleRes)));
+
+		SceneGraph::update(graph);
+		view.cubeWorld[0] = graph.world[cube01Node];
+		view.cubeWorld[1] = graph.world[cube02Node];
 	}
 
-	void drawCube() 
+	void drawCube(const SceneView& view) 
 	{
 		glEnable(GL_PRIMITIVE_RESTART);
 		glBindVertexArray(cubeVao);
+		GLuint cubeProgram = ShaderLibrary::program(cubeShader);
 		glUseProgram(cubeProgram);
+		ClusteredLighting::bind(cubeProgram, view);
 		
 		// CUBE 01
-		glUniformMatrix4fv(glGetUniformLocation(cubeProgram, "objMat"), 1, GL_FALSE, glm::value_ptr(objMat));
-		glUniformMatrix4fv(glGetUniformLocation(cubeProgram, "mv_Mat"), 1, GL_FALSE, glm::value_ptr(RenderVars::_modelView));
-		glUniformMatrix4fv(glGetUniformLocation(cubeProgram, "mvpMat"), 1, GL_FALSE, glm::value_ptr(RenderVars::_MVP));
+		glUniformMatrix4fv(glGetUniformLocation(cubeProgram, "objMat"), 1, GL_FALSE, glm::value_ptr(view.cubeWorld[0]));
+		glUniformMatrix4fv(glGetUniformLocation(cubeProgram, "mv_Mat"), 1, GL_FALSE, glm::value_ptr(view.modelView));
+		glUniformMatrix4fv(glGetUniformLocation(cubeProgram, "mvpMat"), 1, GL_FALSE, glm::value_ptr(view.MVP));
 		glUniform4f(glGetUniformLocation(cubeProgram, "color"), 0.1f, 1.f, 1.f, 0.f);
 		glDrawElements(GL_TRIANGLE_STRIP, numVerts, GL_UNSIGNED_BYTE, 0);
 
 		// CUBE 02
-		float time = ImGui::GetTime();
-
-		// Change position (transalte)
-		glm::mat4 cubeTranslateMatrix = glm::translate(glm::mat4(), glm::vec3(0.0f, cos(time) * 2.0f + 2.0f, 2.0f));//2.0f, cos(time) * 2.0f + 2.0f, 2.0f));
-
-		// Change size (scale)
-		float scaleRes = ((sin(time) * 2.0f + 2.0f) + 1) / 2;
-		glm::mat4 cubeScaleMatrix = glm::scale(glm::mat4(), glm::vec3(scaleRes, scaleRes, scaleRes));
-
-		// Change y-rotation (rotate)
-		float rotateAngle = time; //1.0f * (float)sin(3.0f * time);
-		glm::mat4 cubeRotateMatrix = glm::rotate(glm::mat4(), rotateAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-		// Rotate along the 1st cube (rotate)
-		glm::mat4 cubeToCubeTranslateMatrix = glm::translate(glm::mat4(), glm::vec3(1.0f, 0.0f, 3.0f));
+		float time = view.time;
 
 		// Set random color
 		const GLfloat cubeColor[] = { sin(time) * 0.5f + 0.5f, cos(time) * 0.5f + 0.5f, 0.0f, 1.0f };
 
-		// "Create" 2nd cube
-		glUniformMatrix4fv(glGetUniformLocation(cubeProgram, "objMat"), 1, GL_FALSE, glm::value_ptr(cubeTranslateMatrix * cubeRotateMatrix * cubeToCubeTranslateMatrix * cubeScaleMatrix));
+		// "Create" 2nd cube, its world matrix comes from the scene graph
+		glUniformMatrix4fv(glGetUniformLocation(cubeProgram, "objMat"), 1, GL_FALSE, glm::value_ptr(view.cubeWorld[1]));
 		glUniform4f(glGetUniformLocation(cubeProgram, "color"), cubeColor[0], cubeColor[1], cubeColor[2], 0.f);
 		glDrawElements(GL_TRIANGLE_STRIP, numVerts, GL_UNSIGNED_BYTE, 0);
 
@@ -761,6 +753,463 @@ namespace Cube
 		glBindVertexArray(0);
 		glDisable(GL_PRIMITIVE_RESTART);
 	}
+
+	// cube.vert/.frag for the software renderer
+	struct SoftwareUniforms 
+	{
+		const SceneView* view;
+		ClusteredLighting::ShadeParams lighting;
+		glm::vec3 color;
+		glm::vec3 up; // mv_Mat * (0, 1, 0, 0)
+	};
+
+	SoftwareUniforms softwareUniforms(const SceneView& view, const glm::vec3& color) 
+	{
+		SoftwareUniforms u = { &view, ClusteredLighting::shadeParams(view), color, glm::vec3(view.modelView * glm::vec4(0.f, 1.f, 0.f, 0.f)) };
+		return u;
+	}
+
+	// Varyings: view space normal (3), view space position (3)
+	glm::vec4 shadeSoftware(const void* uniforms, const float* v, float x, float y) 
+	{
+		const SoftwareUniforms& u = *(const SoftwareUniforms*)uniforms;
+		const glm::vec3 normal(v[0], v[1], v[2]);
+		glm::vec3 lights = ClusteredLighting::shade(*u.view, u.lighting, glm::vec3(v[3], v[4], v[5]), glm::normalize(normal), u.color, x, y);
+		return glm::vec4(u.color * glm::dot(normal, u.up) + u.color * 0.3f + lights, 1.f);
+	}
+
+	// cubeIdx strips as a triangle list, keeping the strip winding
+	std::vector<unsigned int> triangleIndices() 
+	{
+		std::vector<unsigned int> indices;
+		for (int face = 0; face < 6; face++) 
+		{
+			const unsigned int v = face * 4;
+			const unsigned int tris[6] = { v, v + 1, v + 2, v + 2, v + 1, v + 3 };
+			indices.insert(indices.end(), tris, tris + 6);
+		}
+		return indices;
+	}
+
+	// Vertex stage of one cube into 24 vertices
+	void transformSoftware(const SceneView& view, const glm::mat4& world, SoftwareRenderer::Vertex* out) 
+	{
+		const glm::mat4 mvp = view.MVP * world, mv = view.modelView * world;
+		for (int i = 0; i < 24; i++) 
+		{
+			out[i].position = mvp * glm::vec4(cubeVerts[i], 1.f);
+			glm::vec4 normal = mv * glm::vec4(cubeNorms[i], 0.f);
+			glm::vec4 viewPos = mv * glm::vec4(cubeVerts[i], 1.f);
+			const float varyings[6] = { normal.x, normal.y, normal.z, viewPos.x, viewPos.y, viewPos.z };
+			memcpy(out[i].varyings, varyings, sizeof(varyings));
+		}
+	}
+
+	void drawCubeSoftware(const SceneView& view) 
+	{
+		static std::vector<unsigned int> indices = triangleIndices();
+		static SoftwareRenderer::Vertex vertices[2][24];
+		static SoftwareUniforms uniforms[2];
+
+		float time = view.time;
+		const glm::vec3 colors[2] = { glm::vec3(0.1f, 1.f, 1.f), glm::vec3(sin(time) * 0.5f + 0.5f, cos(time) * 0.5f + 0.5f, 0.0f) };
+		for (int c = 0; c < 2; c++) 
+		{
+			transformSoftware(view, view.cubeWorld[c], vertices[c]);
+			uniforms[c] = softwareUniforms(view, colors[c]);
+			SoftwareRenderer::Batch batch = { &shadeSoftware, &uniforms[c], 6 };
+			SoftwareRenderer::drawTriangles(batch, vertices[c], &indices[0], (int)indices.size());
+		}
+	}
+}
+
+////////////////////////////////////////////////// CUBE FIELD
+// Lots of animated cubes. Transform update, frustum and occlusion culling and draw-packet generation
+// run as jobs on the JobSystem and the visible transforms are drawn in a single instanced call.
+// Rows of walls across the field are the occluders.
+namespace CubeField 
+{
+	GLuint fieldVao;
+	GLuint fieldVbo[4];
+	int fieldShader;
+
+	bool enabled = false;
+	int count = 10000;
+	const int chunkSize = 1024;
+	const float cubeScale = 0.3f;
+
+	struct Field 
+	{
+		TransformSystem::Transforms transforms;
+		std::vector<float> baseY;
+		std::vector<float> phases;
+		std::vector<int> visibleIndices; // survivors of each chunk, stored at the chunk's own offset
+		std::vector<int> chunkOffsets;   // visible count per chunk, then prefix sum
+		std::vector<int> occludedInChunk;
+		std::vector<glm::mat4> walls;    // always drawn, after the cubes
+		std::vector<int> wallOccluders;
+	};
+	Field field;
+
+	// Last frame timings (ms)
+	float updateMs, cullMs, packetMs;
+	int visibleCount, occludedCount;
+	OcclusionCulling::CheckResult occlusionCheck;
+
+	// Compose benchmark, matrices per second
+	double composeScalarPerSec, composeSimdPerSec;
+
+	struct BenchResult 
+	{
+		int threads;
+		float ms;
+		float transformsPerSec;
+	};
+	std::vector<BenchResult> benchResults;
+
+	void generate(Field& f, int n) 
+	{
+		f.transforms.resize(n);
+		f.baseY.resize(n);
+		f.phases.resize(n);
+		f.visibleIndices.resize(n);
+		f.chunkOffsets.resize((n + chunkSize - 1) / chunkSize + 1);
+		f.occludedInChunk.resize(f.chunkOffsets.size());
+
+		// Square grid on the XZ plane around the origin
+		int side = (int)ceil(sqrt((float)n));
+		for (int i = 0; i < n; i++) 
+		{
+			glm::vec3 pos((i % side - side * 0.5f) * 1.2f, 0.f, (i / side - side * 0.5f) * 1.2f);
+			f.transforms.set(i, pos, glm::quat(), glm::vec3(cubeScale));
+			f.baseY[i] = pos.y;
+			f.phases[i] = (float)(i % 97) * 0.37f;
+		}
+	}
+
+	// Walls between every fifth row of cubes, registered as occluders
+	void placeWalls(Field& f, int n) 
+	{
+		for (size_t i = 0; i < f.wallOccluders.size(); i++) 
+			OcclusionCulling::removeOccluder(f.wallOccluders[i]);
+		f.walls.clear();
+		f.wallOccluders.clear();
+
+		// Unit box, counter-clockwise seen from outside
+		glm::vec3 corners[8];
+		for (int i = 0; i < 8; i++) 
+			corners[i] = glm::vec3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f);
+		const unsigned int faces[] = { 0, 4, 6, 2,  1, 3, 7, 5,  0, 1, 5, 4,  2, 6, 7, 3,  0, 2, 3, 1,  4, 5, 7, 6 };
+		unsigned int indices[36];
+		for (int q = 0; q < 6; q++) 
+		{
+			const unsigned int* quad = &faces[q * 4];
+			const unsigned int tris[6] = { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] };
+			memcpy(&indices[q * 6], tris, sizeof(tris));
+		}
+
+		const int side = (int)ceil(sqrt((float)n));
+		const float halfSize = side * 0.6f;
+		const float length = 7.2f, gap = 1.2f;
+		for (int row = 2; row < side - 1; row += 5) 
+		{
+			float z = (row - side * 0.5f) * 1.2f + 0.6f;
+			for (float x = -halfSize; x + length <= halfSize; x += length + gap) 
+			{
+				glm::mat4 world = glm::translate(glm::mat4(1.f), glm::vec3(x + length * 0.5f, 0.5f, z));
+				world = glm::scale(world, glm::vec3(length, 2.2f, 0.3f));
+				f.walls.push_back(world);
+				f.wallOccluders.push_back(OcclusionCulling::addOccluder(corners, 8, indices, 36, world));
+			}
+		}
+	}
+
+	// Frustum planes (a, b, c, d) of a world -> clip transform, normals pointing inside
+	void extractPlanes(const glm::mat4& m, glm::vec4 planes[6]) 
+	{
+		glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+		planes[0] = row3 + row0;
+		planes[1] = row3 - row0;
+		planes[2] = row3 + row1;
+		planes[3] = row3 - row1;
+		planes[4] = row3 + row2;
+		planes[5] = row3 - row2;
+		for (int i = 0; i < 6; i++) 
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+
+	bool insideFrustum(const glm::vec4 planes[6], const TransformSystem::Transforms& t, int i, float radius) 
+	{
+		for (int p = 0; p < 6; p++) 
+		{
+			if (planes[p].x * t.posX[i] + planes[p].y * t.posY[i] + planes[p].z * t.posZ[i] + planes[p].w <= -radius) 
+				return false;
+		}
+		return true;
+	}
+
+	// Runs the three stages as jobs; each stage waits on the counter of the previous one
+	void update(Field& f, const glm::mat4& viewProj, float time, std::vector<glm::mat4>& packet, bool occlusion) 
+	{
+		TransformSystem::Transforms& t = f.transforms;
+		const int n = t.size();
+		const int chunks = (n + chunkSize - 1) / chunkSize;
+		Uint64 t0 = SDL_GetPerformanceCounter();
+
+		// 1. Animation: bob up and down and spin around Y, written straight into the SoA arrays
+		JobSystem::parallelFor(n, chunkSize, [&](int begin, int end) 
+		{
+			for (int i = begin; i < end; i++) 
+			{
+				float halfAngle = (time + f.phases[i]) * 0.5f;
+				t.posY[i] = f.baseY[i] + sin(time * 1.5f + f.phases[i]) * 0.5f;
+				t.rotY[i] = sin(halfAngle);
+				t.rotW[i] = cos(halfAngle);
+			}
+		});
+		Uint64 t1 = SDL_GetPerformanceCounter();
+
+		// 2. Culling, bounding sphere against the frustum, then its box against the occlusion Hi-Z.
+		// One job per chunk so the counts can be prefix-summed.
+		if (occlusion) 
+			OcclusionCulling::render(viewProj);
+		glm::vec4 planes[6];
+		extractPlanes(viewProj, planes);
+		const float radius = Cube::halfW * 1.7320508f * cubeScale;
+		JobSystem::parallelFor(chunks, 1, [&](int begin, int end) 
+		{
+			for (int c = begin; c < end; c++) 
+			{
+				int* out = &f.visibleIndices[c * chunkSize];
+				int visibleInChunk = 0, occluded = 0;
+				int last = glm::min(n, (c + 1) * chunkSize);
+				for (int i = c * chunkSize; i < last; i++) 
+				{
+					if (!insideFrustum(planes, t, i, radius)) continue;
+					if (occlusion) 
+					{
+						glm::vec3 center(t.posX[i], t.posY[i], t.posZ[i]);
+						if (!OcclusionCulling::testBox(center - radius, center + radius)) 
+						{
+							occluded++;
+							continue;
+						}
+					}
+					out[visibleInChunk++] = i;
+				}
+				f.chunkOffsets[c] = visibleInChunk;
+				f.occludedInChunk[c] = occluded;
+			}
+		});
+		int total = 0;
+		occludedCount = 0;
+		for (int c = 0; c < chunks; c++) 
+		{
+			occludedCount += f.occludedInChunk[c];
+			int visibleInChunk = f.chunkOffsets[c];
+			f.chunkOffsets[c] = total;
+			total += visibleInChunk;
+		}
+		f.chunkOffsets[chunks] = total;
+		Uint64 t2 = SDL_GetPerformanceCounter();
+
+		// 3. Draw packet: world matrices of the survivors, composed with SIMD straight into the instance data
+		packet.resize(total + f.walls.size());
+		if (!f.walls.empty()) 
+			std::copy(f.walls.begin(), f.walls.end(), packet.begin() + total);
+		JobSystem::parallelFor(chunks, 1, [&](int begin, int end) 
+		{
+			for (int c = begin; c < end; c++) 
+			{
+				int offset = f.chunkOffsets[c];
+				int visibleInChunk = f.chunkOffsets[c + 1] - offset;
+				if (visibleInChunk > 0) 
+					TransformSystem::compose(t, NULL, &f.visibleIndices[c * chunkSize], visibleInChunk, glm::value_ptr(packet[offset]));
+			}
+		});
+		Uint64 t3 = SDL_GetPerformanceCounter();
+
+		const double toMs = 1e3 / (double)SDL_GetPerformanceFrequency();
+		updateMs = (float)((t1 - t0) * toMs);
+		cullMs = (float)((t2 - t1) * toMs);
+		packetMs = (float)((t3 - t2) * toMs);
+		visibleCount = total;
+	}
+
+	void prepare(SceneView& view) 
+	{
+		if (!enabled) 
+		{
+			view.cubeInstances.clear();
+			return;
+		}
+		MemoryTracker::Scope memory(MemoryTracker::Scene, "CubeField::prepare");
+		if (field.transforms.size() != count) 
+		{
+			generate(field, count);
+			placeWalls(field, count);
+		}
+		update(field, view.MVP, view.time, view.cubeInstances, OcclusionCulling::enabled);
+	}
+
+	// Hi-Z results of the cubes inside the frustum against the reference rasterizer
+	void checkOcclusion() 
+	{
+		const TransformSystem::Transforms& t = field.transforms;
+		glm::vec4 planes[6];
+		extractPlanes(RV::_MVP, planes);
+		const float radius = Cube::halfW * 1.7320508f * cubeScale;
+		std::vector<glm::vec3> boxMin, boxMax;
+		for (int i = 0; i < t.size(); i++) 
+		{
+			if (!insideFrustum(planes, t, i, radius)) continue;
+			glm::vec3 center(t.posX[i], t.posY[i], t.posZ[i]);
+			boxMin.push_back(center - radius);
+			boxMax.push_back(center + radius);
+		}
+		occlusionCheck = OcclusionCulling::check(boxMin, boxMax);
+	}
+
+	// 1M transforms with 1..N threads, limiting the live job system to each thread count in turn
+	void runScalingBenchmark() 
+	{
+		const int n = 1000000;
+		const int iterations = 10;
+		const int maxThreads = JobSystem::maxThreadCount();
+
+		Field bench;
+		generate(bench, n);
+		std::vector<glm::mat4> packet;
+		glm::mat4 viewProj = RV::_projection * RV::_modelView;
+
+		benchResults.clear();
+		JobSystem::waitIdle(); // texture decodes still in flight would skew the first runs
+		for (int threads = 1; threads <= maxThreads; threads++) 
+		{
+			JobSystem::setActiveThreads(threads);
+
+			update(bench, viewProj, 0.f, packet, false); // warm up
+			Uint64 start = SDL_GetPerformanceCounter();
+			for (int it = 0; it < iterations; it++) 
+				update(bench, viewProj, it * 0.016f, packet, false);
+			double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+			BenchResult res = { threads, (float)(1e3 * seconds / iterations), (float)(n * iterations / seconds) };
+			benchResults.push_back(res);
+			LogConsole::log(LogConsole::Info, "CubeField benchmark: %d threads, %.2f ms/frame, %.1f M transforms/s\n", threads, res.ms, res.transformsPerSec * 1e-6f);
+		}
+
+		JobSystem::setActiveThreads(0);
+	}
+
+	void setup() 
+	{
+		MemoryTracker::Scope memory(MemoryTracker::Scene, "CubeField::setup");
+		glGenVertexArrays(1, &fieldVao);
+		glBindVertexArray(fieldVao);
+		glGenBuffers(4, fieldVbo);
+
+		glBindBuffer(GL_ARRAY_BUFFER, fieldVbo[0]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Cube::cubeVerts), Cube::cubeVerts, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(fieldVbo[0], sizeof(Cube::cubeVerts));
+		glVertexAttribPointer((GLuint)0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+		glEnableVertexAttribArray(0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, fieldVbo[1]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Cube::cubeNorms), Cube::cubeNorms, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(fieldVbo[1], sizeof(Cube::cubeNorms));
+		glVertexAttribPointer((GLuint)1, 3, GL_FLOAT, GL_FALSE, 0, 0);
+		glEnableVertexAttribArray(1);
+
+		// Per-instance object matrix, one vec4 column per attribute
+		glBindBuffer(GL_ARRAY_BUFFER, fieldVbo[2]);
+		for (int col = 0; col < 4; col++) 
+		{
+			glVertexAttribPointer((GLuint)(2 + col), 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4) * col));
+			glEnableVertexAttribArray(2 + col);
+			glVertexAttribDivisor(2 + col, 1);
+		}
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, fieldVbo[3]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Cube::cubeIdx), Cube::cubeIdx, GL_STATIC_DRAW);
+		MemoryTracker::gpuBuffer(fieldVbo[3], sizeof(Cube::cubeIdx));
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		// Same lighting as the single cubes; the mat4 attribute takes locations 2..5
+		const char* attributes[] = { "in_Position", "in_Normal", "in_ObjMat", NULL };
+		fieldShader = ShaderLibrary::create("field", "field.vert", "cube.frag", attributes);
+	}
+
+	void cleanup() 
+	{
+		glDeleteBuffers(4, fieldVbo);
+		MemoryTracker::gpuBuffersDeleted(4, fieldVbo);
+		glDeleteVertexArrays(1, &fieldVao);
+	}
+
+	void draw(const SceneView& view) 
+	{
+		if (view.cubeInstances.empty()) return;
+
+		MemoryTracker::Scope memory(MemoryTracker::Scene, "CubeField::draw");
+		glBindBuffer(GL_ARRAY_BUFFER, fieldVbo[2]);
+		glBufferData(GL_ARRAY_BUFFER, view.cubeInstances.size() * sizeof(glm::mat4), &view.cubeInstances[0], GL_STREAM_DRAW);
+		MemoryTracker::gpuBuffer(fieldVbo[2], view.cubeInstances.size() * sizeof(glm::mat4));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glEnable(GL_PRIMITIVE_RESTART);
+		glPrimitiveRestartIndex(UCHAR_MAX);
+		glBindVertexArray(fieldVao);
+		GLuint fieldProgram = ShaderLibrary::program(fieldShader);
+		glUseProgram(fieldProgram);
+		ClusteredLighting::bind(fieldProgram, view);
+		glUniformMatrix4fv(glGetUniformLocation(fieldProgram, "mv_Mat"), 1, GL_FALSE, glm::value_ptr(view.modelView));
+		glUniformMatrix4fv(glGetUniformLocation(fieldProgram, "mvpMat"), 1, GL_FALSE, glm::value_ptr(view.MVP));
+		glUniform4f(glGetUniformLocation(fieldProgram, "color"), 0.8f, 0.6f, 0.2f, 0.f);
+		glDrawElementsInstanced(GL_TRIANGLE_STRIP, Cube::numVerts, GL_UNSIGNED_BYTE, 0, (GLsizei)view.cubeInstances.size());
+
+		glUseProgram(0);
+		glBindVertexArray(0);
+		glDisable(GL_PRIMITIVE_RESTART);
+	}
+
+	// Instances expanded on the CPU, the vertex stage runs as jobs
+	std::vector<SoftwareRenderer::Vertex> softwareVertices;
+	std::vector<unsigned int> softwareIndices;
+	Cube::SoftwareUniforms softwareUniforms;
+
+	void drawSoftware(const SceneView& view) 
+	{
+		const int instances = (int)view.cubeInstances.size();
+		if (instances == 0) return;
+
+		softwareVertices.resize(instances * 24);
+		if ((int)softwareIndices.size() < instances * 36) 
+		{
+			std::vector<unsigned int> cube = Cube::triangleIndices();
+			softwareIndices.resize(instances * 36);
+			for (int i = 0; i < instances; i++) 
+			{
+				for (int k = 0; k < 36; k++) 
+					softwareIndices[i * 36 + k] = cube[k] + i * 24;
+			}
+		}
+		JobSystem::parallelFor(instances, 256, [&](int begin, int end) 
+		{
+			for (int i = begin; i < end; i++) 
+				Cube::transformSoftware(view, view.cubeInstances[i], &softwareVertices[i * 24]);
+		});
+
+		softwareUniforms = Cube::softwareUniforms(view, glm::vec3(0.8f, 0.6f, 0.2f));
+		SoftwareRenderer::Batch batch = { &Cube::shadeSoftware, &softwareUniforms, 6 };
+		SoftwareRenderer::drawTriangles(batch, &softwareVertices[0], &softwareIndices[0], instances * 36);
+	}
 }
 
 /////////////////////////////////////////////////
@@ -775,6 +1224,8 @@ void GLinit(int width, int height)
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 
+	RV::_width = width;
+	RV::_height = height;
 	RV::_projection = glm::perspective(RV::FOV, (float)width / (float)height, RV::zNear, RV::zFar);
 	//RV::_projection = glm::ortho(RV::FOV, (float)width / (float)height, RV::zNear, RV::zFar);
 
@@ -782,6 +1233,8 @@ void GLinit(int width, int height)
 	Axis::setupAxis();
 	Object::setup();
 	//Cube::setupCube();
+	CubeField::setup();
+	ClusteredLighting::setup();
 
 
 	/////////////////////////////////////////////////////TODO
@@ -797,6 +1250,10 @@ void GLcleanup()
 	Axis::cleanupAxis();
 	Object::cleanup();
 	//Cube::cleanupCube();
+	CubeField::cleanup();
+	ClusteredLighting::cleanup();
+	TextureSystem::shutdown();
+	ShaderLibrary::shutdown();
 
 	/////////////////////////////////////////////////////TODO
 	// Do your cleanup code here
@@ -806,15 +1263,9 @@ void GLcleanup()
 	/////////////////////////////////////////////////////////
 }
 
-void GLrender(float dt) 
+// CPU side of the frame: camera and scene state. Never issues GL calls, so it can run ahead of GLsubmit.
+void GLprepare(SceneView& view, float dt) 
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	time_t currentTime = SDL_GetTicks() / 1000;
-
-	const GLfloat color[] = { 0.5f, 0.5f, 0.5f, 1.0f }; //{ (float)sin(currentTime) * 0.5f + 0.5f, (float)cos(currentTime) * 0.5f + 0.5f, 0.0f, 1.0f };
-	glClearBufferfv(GL_COLOR, 0, color);
-
 	RV::_modelView = glm::mat4(1.f);
 	RV::_modelView = glm::translate(RV::_modelView, glm::vec3(RV::panv[0], RV::panv[1], RV::panv[2]));
 	RV::_modelView = glm::rotate(RV::_modelView, RV::rota[1], glm::vec3(1.f, 0.f, 0.f));
@@ -822,27 +1273,378 @@ void GLrender(float dt)
 
 	RV::_MVP = RV::_projection * RV::_modelView;
 
-	Axis::drawAxis();
-	//Cube::drawCube();
-	Object::render();
+	view.projection = RV::_projection;
+	view.modelView = RV::_modelView;
+	view.MVP = RV::_MVP;
+	view.time = (float)ImGui::GetTime();
+	view.width = RV::_width;
+	view.height = RV::_height;
+
+	// Texture decodes are queued from here, the main thread belongs to the JobSystem
+	TextureSystem::dispatch();
+
+	ClusteredLighting::build(view, dt);
+	//Cube::prepare(view);
+	CubeField::prepare(view);
+}
+
+// GL side of the frame: must run on the thread that owns the context
+void GLsubmit(const SceneView& view) 
+{
+	static int viewport[2] = { -1, -1 };
+	if (viewport[0] != view.width || viewport[1] != view.height) 
+	{
+		glViewport(0, 0, view.width, view.height);
+		viewport[0] = view.width;
+		viewport[1] = view.height;
+	}
+
+	// Picks up edited shader files, finished rebuilds replace their program before drawing
+	ShaderLibrary::update();
+	TextureSystem::update();
+	ClusteredLighting::upload(view);
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	const GLfloat color[] = { 0.5f, 0.5f, 0.5f, 1.0f }; //{ (float)sin(currentTime) * 0.5f + 0.5f, (float)cos(currentTime) * 0.5f + 0.5f, 0.0f, 1.0f };
+	glClearBufferfv(GL_COLOR, 0, color);
+
+	Axis::drawAxis(view);
+	//Cube::drawCube(view);
+	Object::render(view);
+	CubeField::draw(view);
 
 	/////////////////////////////////////////////////////TODO
 	// Do your render code here
 	//Exercise::render();
 	/////////////////////////////////////////////////////////
+}
+
+// Scene only: the caller draws ImGui's draw data on top
+void GLrender(float dt) 
+{
+	static SceneView view; // keeps its buffers between frames
+	GLprepare(view, dt);
+	GLsubmit(view);
+}
+
+// Whether the scene changes by itself from frame to frame, the idle mode (--idle) keeps drawing while it does
+bool GLanimating() 
+{
+	return CubeField::enabled || ClusteredLighting::animate || ClusteredLighting::benchmarkRunning();
+}
+
+////////////////////////////////////////////////// SOFTWARE BACKEND
+// The GLsubmit scene drawn by SoftwareRenderer, for machines without a GPU (--software)
+namespace Software 
+{
+	struct BenchResult 
+	{
+		int threads;
+		float ms;
+		float megapixelsPerSec;
+		float trianglesPerSec;
+	};
+	std::vector<BenchResult> benchResults;
+
+	void submit(const SceneView& view, SoftwareRenderer::Image& target) 
+	{
+		SoftwareRenderer::begin(target, view.width, view.height, glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+		Axis::drawAxisSoftware(view);
+		//Cube::drawCubeSoftware(view);
+		Object::renderSoftware(view);
+		CubeField::drawSoftware(view);
+		SoftwareRenderer::end();
+	}
+}
+
+// Loads the CPU side of the scene only, no GL calls
+void SWinit(int width, int height) 
+{
+	GLResize(width, height);
+	Object::load();
+	Object::loadSoftwareMaps();
+}
+
+void SWrender(SoftwareRenderer::Image& target, float dt) 
+{
+	static SceneView view;
+	GLprepare(view, dt);
+	Software::submit(view, target);
+}
+
+// Current view with the cube field on, 1..N threads, limiting the live job system to each thread count in turn
+void SWbenchmark() 
+{
+	const int iterations = 10;
+	const int maxThreads = JobSystem::maxThreadCount();
+	const bool fieldWasEnabled = CubeField::enabled;
+	CubeField::enabled = true;
+	SoftwareRenderer::Image target;
+	SceneView view;
+	GLprepare(view, 0.f);
+
+	Software::benchResults.clear();
+	JobSystem::waitIdle();
+	for (int threads = 1; threads <= maxThreads; threads++) 
+	{
+		JobSystem::setActiveThreads(threads);
+
+		Software::submit(view, target); // warm up
+		Uint64 start = SDL_GetPerformanceCounter();
+		for (int it = 0; it < iterations; it++) 
+			Software::submit(view, target);
+		double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+		const int triangles = SoftwareRenderer::getStats().triangles;
+		Software::BenchResult res = { threads, (float)(1e3 * seconds / iterations),
+			(float)(1e-6 * view.width * view.height * iterations / seconds), (float)((double)triangles * iterations / seconds) };
+		Software::benchResults.push_back(res);
+		LogConsole::log(LogConsole::Info, "Software benchmark: %d threads, %dx%d, %d triangles, %.2f ms/frame, %.1f MP/s, %.2f M tris/s\n", threads, view.width, view.height, triangles, res.ms, res.megapixelsPerSec, res.trianglesPerSec * 1e-6f);
+	}
+
+	JobSystem::setActiveThreads(0);
+	CubeField::enabled = fieldWasEnabled;
+}
 
-	ImGui::Render();
+namespace Software 
+{
+	// Scripted cameras for the regression scenes, as {panv, rota}
+	struct Camera 
+	{
+		float panv[3];
+		float rota[2];
+	};
+	const Camera cameras[] = {
+		{ { 0.f, -5.f, -15.f }, { 0.f, 0.f } },
+		{ { 0.f, -2.f, -8.f }, { 0.6f, 0.3f } },
+		{ { 2.f, -6.f, -25.f }, { -0.8f, 0.5f } },
+	};
+	const int cameraCount = sizeof(cameras) / sizeof(cameras[0]);
+
+	void setupObject() 
+	{
+		CubeField::enabled = false;
+		OcclusionCulling::enabled = false;
+		ClusteredLighting::generate(1);
+	}
+	void setupCubeField() 
+	{
+		CubeField::enabled = true;
+		CubeField::count = 10000;
+		OcclusionCulling::enabled = true;
+		ClusteredLighting::generate(1);
+	}
+	void setupLights() 
+	{
+		CubeField::enabled = true;
+		CubeField::count = 10000;
+		OcclusionCulling::enabled = false;
+		ClusteredLighting::generate(1000);
+	}
+
+	// dt = 0 and ImGui time 0 without frames: every run draws the same image
+	void renderCamera(int camera, SoftwareRenderer::Image& target) 
+	{
+		for (int i = 0; i < 3; i++) RV::panv[i] = cameras[camera].panv[i];
+		for (int i = 0; i < 2; i++) RV::rota[i] = cameras[camera].rota[i];
+		SWrender(target, 0.f);
+	}
 }
 
+// Golden images and frame times of the scripted scenes (--regress), returns the number of failures
+int SWregress(const Regression::Options& options) 
+{
+	Regression::Scene scenes[] = {
+		{ "object", Software::cameraCount, Software::setupObject, Software::renderCamera },
+		{ "cubefield", Software::cameraCount, Software::setupCubeField, Software::renderCamera },
+		{ "lights", Software::cameraCount, Software::setupLights, Software::renderCamera },
+	};
+	const float panv[3] = { RV::panv[0], RV::panv[1], RV::panv[2] };
+	const float rota[2] = { RV::rota[0], RV::rota[1] };
+	const bool fieldWasEnabled = CubeField::enabled, occlusionWasEnabled = OcclusionCulling::enabled;
+	const int fieldCount = CubeField::count, lightCount = (int)ClusteredLighting::lights.size();
+
+	int failures = Regression::run(std::vector<Regression::Scene>(scenes, scenes + sizeof(scenes) / sizeof(scenes[0])), options);
+
+	for (int i = 0; i < 3; i++) RV::panv[i] = panv[i];
+	for (int i = 0; i < 2; i++) RV::rota[i] = rota[i];
+	CubeField::enabled = fieldWasEnabled;
+	OcclusionCulling::enabled = occlusionWasEnabled;
+	CubeField::count = fieldCount;
+	ClusteredLighting::generate(glm::max(1, lightCount));
+	return failures;
+}
 
 void GUI() 
 {
+	static bool showConsole = false;
+	static bool showMemory = false;
+	MemoryTracker::Scope memoryScope(MemoryTracker::Gui, "GUI");
 	bool show = true;
 	ImGui::Begin("Physics Parameters", &show, 0);
 
 	{
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 
+		FramePipeline::Stats pipeline = FramePipeline::getStats();
+		ImGui::Text("Render pipeline: %s%s", pipeline.threaded ? "threaded (--threaded-render)" : "serial", pipeline.idle ? ", idle mode (--idle)" : "");
+		ImGui::Text("%.1f presents/s, input latency %.2f ms", pipeline.framesPerSecond, pipeline.inputLatencyMs);
+		if (pipeline.idle) 
+			ImGui::Text("%.1f skipped frames/s, process CPU %.1f%%", pipeline.skippedPerSecond, pipeline.cpuPercent);
+
+		LogConsole::Stats console = LogConsole::getStats();
+		ImGui::Checkbox("Console", &showConsole);
+		ImGui::SameLine();
+		ImGui::Text("%d lines, %lld dropped", console.retained, console.dropped);
+
+		MemorySystem::Stats memory = MemorySystem::getStats();
+		ImGui::Text("Allocations per frame: %d pool, %d frame arena, %d heap", memory.poolAllocs, memory.frameAllocs, memory.heapAllocs);
+		ImGui::Text("Pool %d blocks in %.1f MB, arena %d KB", memory.poolLive, memory.poolReserved / (1024.f * 1024.f), (int)(memory.arenaCapacity >> 10));
+		MemoryTracker::Usage tracked = MemoryTracker::total();
+		ImGui::Checkbox("Memory report", &showMemory);
+		ImGui::SameLine();
+		ImGui::Text("%.1f MB live, %.1f MB on the GPU", tracked.live / (1024.f * 1024.f), (tracked.gpuBuffers + tracked.gpuTextures) / (1024.f * 1024.f));
+
+		if (ImGui::CollapsingHeader("Cube field")) 
+		{
+			ImGui::Checkbox("Enabled", &CubeField::enabled);
+			ImGui::SliderInt("Cubes", &CubeField::count, 1, 200000);
+			ImGui::Text("%d / %d visible, %d threads", CubeField::visibleCount, CubeField::count, JobSystem::threadCount());
+			ImGui::Text("update %.2f ms, cull %.2f ms, packet %.2f ms", CubeField::updateMs, CubeField::cullMs, CubeField::packetMs);
+			ImGui::Checkbox("Occlusion culling", &OcclusionCulling::enabled);
+			if (OcclusionCulling::enabled) 
+			{
+				OcclusionCulling::Stats occlusion = OcclusionCulling::getStats();
+				int tested = CubeField::visibleCount + CubeField::occludedCount;
+				ImGui::Text("%d occluders, %d triangles, %dx%d %s", OcclusionCulling::occluderCount(), occlusion.triangles, OcclusionCulling::width, OcclusionCulling::height, occlusion.avx2 ? "AVX2" : "scalar");
+				ImGui::Text("setup %.2f ms, raster %.2f ms, Hi-Z %.2f ms", occlusion.setupMs, occlusion.rasterMs, occlusion.hizMs);
+				ImGui::Text("%d of %d in frustum occluded (%.1f%%)", CubeField::occludedCount, tested, tested ? 100.f * CubeField::occludedCount / tested : 0.f);
+				if (ImGui::Button("Check against reference")) 
+					CubeField::checkOcclusion();
+				const OcclusionCulling::CheckResult& check = CubeField::occlusionCheck;
+				if (check.tested > 0) 
+				{
+					ImGui::Text("%d false negatives, %d missed culls of %d culled / %d tested", check.falseNegatives, check.missedCulls, check.culled, check.tested);
+					ImGui::Text("raster %.2f ms SIMD, %.2f ms scalar, %d pixels differ", check.simdMs, check.scalarMs, check.mismatchedPixels);
+				}
+			}
+			if (ImGui::Button("Run scaling benchmark (1M transforms)")) 
+				CubeField::runScalingBenchmark();
+			ImGui::SameLine();
+			if (ImGui::Button("Compose benchmark")) 
+				TransformSystem::benchmark(1000000, CubeField::composeScalarPerSec, CubeField::composeSimdPerSec);
+			if (CubeField::composeSimdPerSec > 0.0) 
+				ImGui::Text("compose: glm %.1f M/s, SoA SIMD %.1f M/s (x%.2f)", CubeField::composeScalarPerSec * 1e-6, CubeField::composeSimdPerSec * 1e-6, CubeField::composeSimdPerSec / CubeField::composeScalarPerSec);
+			for (size_t i = 0; i < CubeField::benchResults.size(); i++) 
+			{
+				const CubeField::BenchResult& res = CubeField::benchResults[i];
+				ImGui::Text("%2d threads: %7.2f ms/frame, %6.1f M/s, x%.2f", res.threads, res.ms, res.transformsPerSec * 1e-6f, CubeField::benchResults[0].ms / res.ms);
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Software renderer")) 
+		{
+			static SoftwareRenderer::Image frame;
+			if (ImGui::Button("Render frame to software.tga")) 
+			{
+				SWinit(RV::_width, RV::_height);
+				SWrender(frame, 0.f);
+				SoftwareRenderer::writeTGA(frame, "software.tga");
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Benchmark threads")) 
+			{
+				SWinit(RV::_width, RV::_height);
+				SWbenchmark();
+			}
+			SoftwareRenderer::Stats software = SoftwareRenderer::getStats();
+			ImGui::Text("%d triangles (%d rasterized), setup %.2f ms, raster %.2f ms", software.triangles, software.rasterized, software.setupMs, software.rasterMs);
+			for (size_t i = 0; i < Software::benchResults.size(); i++) 
+			{
+				const Software::BenchResult& res = Software::benchResults[i];
+				ImGui::Text("%2d threads: %7.2f ms/frame, %6.1f MP/s, %6.2f M tris/s, x%.2f", res.threads, res.ms, res.megapixelsPerSec, res.trianglesPerSec * 1e-6f, Software::benchResults[0].ms / res.ms);
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Scene graph")) 
+		{
+			static SceneGraph::BenchResult graphBench = {};
+			if (ImGui::Button("Benchmark 100k nodes, 1% animated")) 
+				graphBench = SceneGraph::benchmark(100000, 0.01f, 60);
+			if (graphBench.nodes > 0) 
+			{
+				ImGui::Text("incremental %.3f ms/frame (%.0f nodes recomputed)", graphBench.incrementalMs, graphBench.nodesRecomputed);
+				ImGui::Text("full update %.3f ms/frame", graphBench.fullMs);
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Lights"))
+		{
+			int lightCount = (int)ClusteredLighting::lights.size();
+			if (ImGui::SliderInt("Lights", &lightCount, 1, 10000) && !ClusteredLighting::benchmarkRunning())
+				ClusteredLighting::generate(lightCount);
+			ImGui::Checkbox("Animate lights", &ClusteredLighting::animate);
+			ClusteredLighting::Stats lighting = ClusteredLighting::getStats();
+			ImGui::Text("%dx%dx%d clusters, binning %.2f ms on %d threads", ClusteredLighting::tilesX, ClusteredLighting::tilesY, ClusteredLighting::slices, lighting.binMs, JobSystem::threadCount());
+			ImGui::Text("%d light references, max %d per cluster", lighting.indexCount, lighting.maxInCluster);
+
+			if (ImGui::Button(ClusteredLighting::benchmarkRunning() ? "Running..." : "Benchmark 1 to 10000 lights"))
+				ClusteredLighting::startBenchmark();
+			const std::vector<ClusteredLighting::BenchPoint>& curve = ClusteredLighting::benchmarkResults();
+			if (!curve.empty())
+			{
+				MemorySystem::FrameVector<float> frameMs(curve.size());
+				for (size_t i = 0; i < curve.size(); i++)
+					frameMs[i] = curve[i].frameMs;
+				ImGui::PlotLines("Frame ms", &frameMs[0], (int)frameMs.size(), 0, NULL, 0.f, FLT_MAX, ImVec2(0, 80));
+				for (size_t i = 0; i < curve.size(); i++)
+					ImGui::Text("%5d lights: %6.2f ms/frame, binning %.2f ms", curve[i].lights, curve[i].frameMs, curve[i].binMs);
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Materials"))
+		{
+			ImGui::Text("%d materials, %d submeshes", (int)Object::materials.size(), (int)Object::submeshes.size());
+			ImGui::Text("%d draws, %d state changes per frame", Object::drawCount.load(), Object::stateChanges.load());
+			// What drawing each submesh with its own material uniforms + texture bind would cost
+			ImGui::Text("(per-material draws: %d draws, %d state changes)", (int)Object::submeshes.size(), 3 + 2 * (int)Object::submeshes.size());
+		}
+
+		if (ImGui::CollapsingHeader("Textures"))
+		{
+			TextureSystem::Stats textures = TextureSystem::getStats();
+			ImGui::Text("%d loaded, %d ready, %d failed", textures.loaded, textures.ready, textures.failed);
+			ImGui::Text("decode %.1f MB/s, mips %.1f MB/s (per worker)", textures.decodeMBs, textures.mipMBs);
+			static int budgetKB = TextureSystem::uploadBudget >> 10;
+			if (ImGui::SliderInt("Upload budget (KB/frame)", &budgetKB, 64, 65536))
+				TextureSystem::uploadBudget = budgetKB << 10;
+			ImGui::Text("uploaded %.1f KB last frame", textures.uploadedLastFrame / 1024.f);
+
+			static TextureSystem::BenchResult textureBench = {};
+			if (ImGui::Button("Benchmark 2048x2048 decode + mips"))
+				textureBench = TextureSystem::benchmark();
+			if (textureBench.mipSimdMBs > 0.f)
+			{
+				ImGui::Text("TGA decode %.1f MB/s on %d threads", textureBench.decodeMBs, JobSystem::threadCount());
+				ImGui::Text("mips: scalar %.1f MB/s, SSE2 %.1f MB/s (x%.2f)", textureBench.mipScalarMBs, textureBench.mipSimdMBs, textureBench.mipSimdMBs / textureBench.mipScalarMBs);
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Shaders"))
+		{
+			ImGui::Text("Edit files in shaders/ to reload, parallel compile: %s", ShaderLibrary::parallelCompileSupported() ? "yes" : "no");
+			static std::vector<ShaderLibrary::ProgramStats> shaders; // keeps its storage
+			ShaderLibrary::getStats(shaders);
+			for (size_t i = 0; i < shaders.size(); i++)
+			{
+				const ShaderLibrary::ProgramStats& s = shaders[i];
+				ImGui::Text("%-8s %2d builds, last %6.2f ms %s", s.name.c_str(), s.builds, s.lastBuildMs, s.pending ? "(building)" : s.lastFailed ? "(FAILED, previous kept)" : "");
+				if (s.lastFailed && !s.log.empty())
+					ImGui::TextWrapped("%s", s.log.c_str());
+			}
+		}
+
 		/////////////////////////////////////////////////////TODO
 		// Do your GUI code here....
 		// ...
@@ -854,6 +1656,14 @@ void GUI()
 
 	ImGui::End();
 
+	// The queue is drained even with the window closed, so it never fills up
+	if (showConsole) 
+		LogConsole::draw(&showConsole);
+	else 
+		LogConsole::drain();
+	if (showMemory) 
+		MemoryTracker::draw(&showMemory);
+
 	// Example code -- ImGui test window. Most of the sample code is in ImGui::ShowTestWindow()
 	bool show_test_window = false;
 	if (show_test_window) 